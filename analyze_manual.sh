@@ -4,8 +4,13 @@
 echo "=== ANÁLISIS MANUAL DE PROCESOS ==="
 echo ""
 
-# Buscar nuestro proceso
-PID=$(pgrep proc_analysis | head -1)
+# Buscar nuestro proceso: si aún no arrancó, se espera su exec unos segundos
+# (conector netlink) en lugar de fallar o reintentar con pgrep
+if [ -x "$(dirname "$0")/proc_analysis" ]; then
+    PID=$("$(dirname "$0")/proc_analysis" --find proc_analysis --wait 5)
+else
+    PID=$(pgrep proc_analysis | head -1)
+fi
 
 if [ -z "$PID" ]; then
     echo "❌ No se encontró proceso proc_analysis"
@@ -78,21 +83,41 @@ while true; do
                 echo "Info de planificación requiere permisos de root"
                 echo "Ejecuta: sudo cat /proc/$PID/sched"
             fi
+            PROC_ANALYSIS="$(dirname "$0")/proc_analysis"
+            if [ -x "$PROC_ANALYSIS" ]; then
+                # Afinidad, última CPU y nodo NUMA de cada hilo
+                echo ""
+                "$PROC_ANALYSIS" --numa $PID
+            fi
             ;;
         6)
             echo ""
             echo "=== HEXDUMP DE SECCIONES ==="
-            echo "Para ver .text del ejecutable:"
-            echo "  objdump -s -j .text proc_analysis | head -30"
-            echo ""
-            echo "Para ver .data (variables inicializadas):"
-            echo "  objdump -s -j .data proc_analysis | head -20"
+            PROC_ANALYSIS="$(dirname "$0")/proc_analysis"
+            if [ -x "$PROC_ANALYSIS" ]; then
+                # Lector ELF propio sobre /proc/$PID/exe: direcciones de ejecución (PIE incluido)
+                "$PROC_ANALYSIS" --elf $PID --dump .text 256
+                echo ""
+                "$PROC_ANALYSIS" --elf $PID --dump .data 128 global_var global_buffer global_const
+            else
+                echo "Para ver .text del ejecutable:"
+                echo "  objdump -s -j .text proc_analysis | head -30"
+                echo ""
+                echo "Para ver .data (variables inicializadas):"
+                echo "  objdump -s -j .data proc_analysis | head -20"
+            fi
             ;;
         7)
             echo ""
             echo "=== COMPARACIÓN CON OTROS PROCESOS ==="
             echo "Procesos similares en el sistema:"
-            ps aux | grep -E "(proc_analysis|PID)" | head -10
+            PROC_ANALYSIS="$(dirname "$0")/proc_analysis"
+            if [ -x "$PROC_ANALYSIS" ]; then
+                # Escaneo paralelo de /proc, sin ps ni grep
+                "$PROC_ANALYSIS" --scan --filter proc_analysis
+            else
+                ps aux | grep -E "(proc_analysis|PID)" | head -10
+            fi
             ;;
         8)
             echo "Saliendo..."
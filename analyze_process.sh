@@ -2,8 +2,12 @@
 # Script para analizar el proceso en ejecución - Versión simplificada
 
 if [ -z "$1" ]; then
-    # Si no se proporciona PID, buscar proc_analysis
-    PID=$(pgrep proc_analysis | head -1)
+    # Si no se proporciona PID, buscar proc_analysis (una pasada por /proc, sin pgrep)
+    if [ -x "$(dirname "$0")/proc_analysis" ]; then
+        PID=$("$(dirname "$0")/proc_analysis" --find proc_analysis)
+    else
+        PID=$(pgrep proc_analysis | head -1)
+    fi
     if [ -z "$PID" ]; then
         echo "❌ No se encontró proceso proc_analysis en ejecución"
         echo ""
@@ -43,9 +47,15 @@ cat /proc/$PID/limits 2>/dev/null | grep "Max address space" || true
 echo ""
 
 echo "Mapas de memoria (resumen):"
-echo "[Code]    $(grep -E "/proc/$PID/exe" /proc/$PID/maps 2>/dev/null | head -1 || echo 'No disponible')"
-echo "[Heap]    $(grep heap /proc/$PID/maps 2>/dev/null || echo 'No disponible')"
-echo "[Stack]   $(grep stack /proc/$PID/maps 2>/dev/null || echo 'No disponible')"
+PROC_ANALYSIS="$(dirname "$0")/proc_analysis"
+if [ -x "$PROC_ANALYSIS" ]; then
+    # Una sola lectura de maps con el parser nativo
+    "$PROC_ANALYSIS" --maps $PID 2>/dev/null || echo "No disponible"
+else
+    echo "[Code]    $(grep -E "/proc/$PID/exe" /proc/$PID/maps 2>/dev/null | head -1 || echo 'No disponible')"
+    echo "[Heap]    $(grep heap /proc/$PID/maps 2>/dev/null || echo 'No disponible')"
+    echo "[Stack]   $(grep stack /proc/$PID/maps 2>/dev/null || echo 'No disponible')"
+fi
 echo ""
 
 # Hilos
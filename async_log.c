@@ -0,0 +1,915 @@
+// async_log.c - Logger asíncrono con anillos SPSC por thread
+//
+// Camino caliente (alog_emit): TLS → anillo propio, timestamp (rdtsc),
+// copia de fmt/args y un store-release de head. Nada de stdio, locks ni
+// syscalls salvo que el anillo esté lleno.
+//
+// Flusher (ALOG-FLUSH): bajo un mutex que solo toman él, alog_sync() y los
+// handlers de fork, toma el head de cada anillo, mezcla los registros por
+// timestamp y los formatea en un buffer de 256 KB que sale con un write().
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ALOG_HAVE_TSC 1
+#endif
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "async_log.h"
+
+#define ALOG_RING_MASK   (ALOG_RING_SIZE - 1)
+#define ALOG_OUT_SIZE    (256 * 1024)
+#define ALOG_OUT_SLACK   (16 * 1024)       // sitio libre mínimo antes de formatear un registro
+#define ALOG_REC_STRS    (ALOG_RING_SIZE / 4)  // bytes de %s por registro: siempre cabe en el anillo
+#define ALOG_IDLE_NS     5000000L          // el flusher duerme como mucho 5 ms
+#define ALOG_MAGIC       "ALOGBIN1"
+
+// Flags de registro
+#define ALOG_REC_LOG  0
+#define ALOG_REC_PAD  1     // relleno hasta el final del anillo
+#define ALOG_REC_STR  2     // (binario) definición de cadena: fmt = id, texto detrás
+
+// Cabecera de registro: size va primero para que un PAD de 8 bytes sea válido.
+// En el anillo ts son ticks crudos; en el fichero binario, ns de CLOCK_REALTIME.
+typedef struct {
+    uint32_t size;                  // bytes totales, múltiplo de 8
+    uint8_t flags;
+    uint8_t nargs;
+    uint16_t reserved;
+    uint32_t tid;
+    uint32_t reserved2;
+    uint64_t ts;
+    uint64_t fmt;                   // puntero al literal (o id en el fichero)
+    uint64_t prefix;                // prefijo de timestamp; 0 = línea sin timestamp
+    uint8_t types[ALOG_MAX_ARGS];
+    uint64_t vals[];                // los %s guardan el offset de la cadena dentro del registro
+} alog_rec_t;
+
+typedef struct alog_ring {
+    _Alignas(64) atomic_size_t head;        // lo escribe solo el productor
+    size_t cached_tail;                     // copia local del productor
+    uint64_t pending_ts;                    // alog_timestamp() pendiente
+    const char *pending_prefix;
+    uint32_t tid;
+    _Alignas(64) atomic_size_t tail;        // lo escribe solo el consumidor
+    struct alog_ring *next;
+    atomic_int owner;                       // 1 mientras un thread lo usa
+    char data[ALOG_RING_SIZE];
+} alog_ring_t;
+
+// Conjunto de cadenas ya definidas en el fichero binario
+typedef struct {
+    uint64_t *slots;
+    size_t cap;
+    size_t used;
+} alog_strset_t;
+
+static struct {
+    atomic_int enabled;
+    alog_mode_t mode;
+    alog_clock_t clock;
+    int fd;
+
+    _Atomic(alog_ring_t *) rings;
+    pthread_key_t key;
+    pthread_mutex_t lock;               // rol de consumidor de todos los anillos
+
+    pthread_t flusher;
+    int flusher_running;
+    atomic_int stop;
+    atomic_int restart;                 // hijo de fork(): arrancar flusher en el primer log
+    atomic_uint wake;                   // palabra futex del flusher
+    atomic_int sleeping;
+
+    // Calibración: ticks → ns monotónicos → ns de CLOCK_REALTIME
+    uint64_t tick0;
+    uint64_t mono0;
+    int64_t real_off;
+    double ns_per_tick;
+
+    char *out;
+    size_t out_len;
+    alog_strset_t strs;
+
+    // Cursores del mezclado (uno por anillo)
+    alog_ring_t **cur_ring;
+    size_t *cur_tail;
+    size_t *cur_head;
+    size_t cur_cap;
+
+    atomic_ulong records;
+    atomic_ulong writes;
+    atomic_ulong stalls;
+} alog;
+
+static __thread alog_ring_t *tls_ring;
+
+// ========== RELOJ ==========
+
+static inline uint64_t alog_ticks(void) {
+    struct timespec ts;
+#ifdef ALOG_HAVE_TSC
+    if (alog.clock == ALOG_CLOCK_TSC) return __rdtsc();
+#endif
+    clock_gettime(alog.clock == ALOG_CLOCK_COARSE ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Sin constant_tsc + nonstop_tsc el TSC no sirve como reloj entre CPUs
+static int tsc_usable(void) {
+#ifdef ALOG_HAVE_TSC
+    proc_file_t f;
+    proc_file_init(&f);
+    int ok = 0;
+    if (proc_file_load(&f, "/proc/cpuinfo") == 0) {
+        // Basta la línea flags de la primera CPU
+        char *line = memmem(f.buf, f.len, "\nflags", 6);
+        if (line) {
+            char *eol = strchr(line + 1, '\n');
+            if (eol) *eol = '\0';
+            ok = strstr(line, " constant_tsc") && strstr(line, " nonstop_tsc");
+        }
+    }
+    proc_file_free(&f);
+    return ok;
+#else
+    return 0;
+#endif
+}
+
+static void calibrate(void) {
+    alog.mono0 = clock_ns(CLOCK_MONOTONIC);
+    alog.real_off = (int64_t)(clock_ns(CLOCK_REALTIME) - alog.mono0);
+    alog.tick0 = alog_ticks();
+    alog.ns_per_tick = 1.0;
+    if (alog.clock != ALOG_CLOCK_TSC) {
+        alog.tick0 = alog.mono0;
+        return;
+    }
+    // Estimación inicial de 2 ms; el flusher la refina con ventanas más largas
+    uint64_t t_end = alog.mono0 + 2000000;
+    uint64_t m;
+    while ((m = clock_ns(CLOCK_MONOTONIC)) < t_end) {}
+    alog.ns_per_tick = (double)(m - alog.mono0) / (double)(alog_ticks() - alog.tick0);
+}
+
+static void recalibrate(void) {
+    if (alog.clock != ALOG_CLOCK_TSC) return;
+    uint64_t m = clock_ns(CLOCK_MONOTONIC);
+    uint64_t t = alog_ticks();
+    if (m - alog.mono0 > 50000000 && t > alog.tick0) {
+        alog.ns_per_tick = (double)(m - alog.mono0) / (double)(t - alog.tick0);
+    }
+}
+
+static uint64_t ticks_to_real_ns(uint64_t t) {
+    int64_t d = (int64_t)(t - alog.tick0);
+    return (uint64_t)((int64_t)alog.mono0 + (int64_t)((double)d * alog.ns_per_tick) + alog.real_off);
+}
+
+// ========== FORMATO ==========
+
+// Entero sin signo en base 10 o 16; devuelve los dígitos escritos
+static size_t fmt_u64(char *out, size_t room, uint64_t v, unsigned base, int upper) {
+    static const char lo[] = "0123456789abcdef", up[] = "0123456789ABCDEF";
+    const char *digits = upper ? up : lo;
+    char tmp[24];
+    size_t n = 0;
+    do {
+        tmp[n++] = digits[v % base];
+        v /= base;
+    } while (v);
+    if (n > room) n = room;
+    for (size_t i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+// Conversión sin flags/ancho/precisión sin pasar por snprintf (el caso común).
+// Devuelve bytes escritos o -1 si no es un caso rápido.
+static long fmt_fast(char *out, size_t room, char conv, uint8_t t, uint64_t v, const char *strbase) {
+    size_t n = 0;
+    switch (conv) {
+    case 'd': case 'i':
+        if (t == ALOG_T_F64) return -1;
+        if ((int64_t)v < 0) {
+            out[n++] = '-';
+            v = (uint64_t)0 - v;
+        }
+        return (long)(n + fmt_u64(out + n, room - n, v, 10, 0));
+    case 'u':
+        if (t == ALOG_T_F64) return -1;
+        return (long)fmt_u64(out, room, v, 10, 0);
+    case 'x': case 'X':
+        if (t == ALOG_T_F64) return -1;
+        return (long)fmt_u64(out, room, v, 16, conv == 'X');
+    case 'p':
+        if (!v || room < 3) return -1;        // "(nil)" como glibc
+        out[0] = '0';
+        out[1] = 'x';
+        return (long)(2 + fmt_u64(out + 2, room - 2, v, 16, 0));
+    case 'c':
+        out[0] = (char)v;
+        return 1;
+    case 's': {
+        if (t != ALOG_T_STR) return -1;
+        const char *str = strbase ? strbase + v : (const char *)(uintptr_t)v;
+        if (!str) return -1;
+        size_t len = strlen(str);
+        if (len > room) len = room;
+        memcpy(out, str, len);
+        return (long)len;
+    }
+    default:
+        return -1;
+    }
+}
+
+size_t alog_format(char *out, size_t cap, const char *fmt, int nargs, const uint8_t *types,
+                   const uint64_t *vals, const char *strbase) {
+    size_t n = 0;
+    int ai = 0;
+    if (cap == 0) return 0;
+    out[0] = '\0';
+
+    for (const char *p = fmt; *p && n < cap - 1; ) {
+        if (*p != '%') {
+            const char *q = strchrnul(p, '%');
+            size_t len = (size_t)(q - p);
+            if (len > cap - 1 - n) len = cap - 1 - n;
+            memcpy(out + n, p, len);
+            n += len;
+            p = q;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][ancho][.precisión][longitud]conv; la longitud se normaliza a ll
+        char spec[40];
+        size_t sl = 0;
+        spec[sl++] = *p++;
+        while (*p && strchr("-+ #0'", *p) && sl < 16) spec[sl++] = *p++;
+        while (isdigit((unsigned char)*p) && sl < 24) spec[sl++] = *p++;
+        if (*p == '.') {
+            spec[sl++] = *p++;
+            while (isdigit((unsigned char)*p) && sl < 32) spec[sl++] = *p++;
+        }
+        int is64 = 0;       // sin l/ll/z/j/t el entero es de 32 bits, como en printf
+        for (; *p && strchr("hlqjztL", *p); p++) is64 |= *p != 'h';
+        char conv = *p;
+        if (!conv) break;
+        p++;
+
+        uint8_t t = ai < nargs ? types[ai] : 0;
+        uint64_t v = ai < nargs ? vals[ai] : 0;
+        ai++;
+        double d;
+        if (t == ALOG_T_F64) memcpy(&d, &v, sizeof(d));
+        else d = t == ALOG_T_U64 ? (double)v : (double)(int64_t)v;
+        if (t == ALOG_T_F64) v = (uint64_t)(int64_t)d;
+        if (!is64 && (conv == 'd' || conv == 'i')) v = (uint64_t)(int64_t)(int32_t)v;
+        else if (!is64 && strchr("ouxXc", conv)) v = (uint32_t)v;
+
+        size_t room = cap - n;
+        if (sl == 1 && room > 24) {
+            long f = fmt_fast(out + n, room - 1, conv, t, v, strbase);
+            if (f >= 0) {
+                n += (size_t)f;
+                continue;
+            }
+        }
+        int w = 0;
+        switch (conv) {
+        case 'd': case 'i':
+        case 'o': case 'u': case 'x': case 'X':
+            spec[sl++] = 'l';
+            spec[sl++] = 'l';
+            spec[sl++] = conv;
+            spec[sl] = '\0';
+            w = snprintf(out + n, room, spec, v);
+            break;
+        case 'c':
+            spec[sl++] = 'c';
+            spec[sl] = '\0';
+            w = snprintf(out + n, room, spec, (int)v);
+            break;
+        case 's': {
+            const char *s = "(?)";
+            if (t == ALOG_T_STR) s = strbase ? strbase + v : (const char *)(uintptr_t)v;
+            if (!s) s = "(null)";
+            spec[sl++] = 's';
+            spec[sl] = '\0';
+            w = snprintf(out + n, room, spec, s);
+            break;
+        }
+        case 'p':
+            spec[sl++] = 'p';
+            spec[sl] = '\0';
+            w = snprintf(out + n, room, spec, (void *)(uintptr_t)v);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec[sl++] = conv;
+            spec[sl] = '\0';
+            w = snprintf(out + n, room, spec, d);
+            break;
+        default:
+            break;
+        }
+        if (w > 0) n += (size_t)w < room ? (size_t)w : room - 1;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Sin logger: formatear y escribir ya (mismo resultado que printf)
+static void emit_direct(const char *fmt, const alog_arg_t *args, int nargs) {
+    uint8_t types[ALOG_MAX_ARGS];
+    uint64_t vals[ALOG_MAX_ARGS];
+    char line[ALOG_OUT_SLACK];
+    for (int i = 0; i < nargs; i++) {
+        types[i] = args[i].type;
+        memcpy(&vals[i], &args[i].v, sizeof(vals[i]));
+    }
+    size_t n = alog_format(line, sizeof(line), fmt, nargs, types, vals, NULL);
+    fwrite(line, 1, n, stdout);
+}
+
+// ========== ESCRITURA ==========
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        buf += w;
+        len -= (size_t)w;
+    }
+}
+
+static void out_flush(void) {
+    if (alog.out_len == 0) return;
+    // Lo que otros módulos dejaron en el buffer de stdio sale antes
+    if (alog.fd == STDOUT_FILENO) fflush(stdout);
+    write_all(alog.fd, alog.out, alog.out_len);
+    alog.out_len = 0;
+    atomic_fetch_add_explicit(&alog.writes, 1, memory_order_relaxed);
+}
+
+static int strset_add(alog_strset_t *s, uint64_t id) {
+    if (s->used * 2 >= s->cap) {
+        size_t ncap = s->cap ? s->cap * 2 : 1024;
+        uint64_t *ns = calloc(ncap, sizeof(*ns));
+        if (!ns) return 0;
+        for (size_t i = 0; i < s->cap; i++) {
+            if (!s->slots[i]) continue;
+            size_t h = (s->slots[i] * 0x9E3779B97F4A7C15ull) >> 20;
+            while (ns[h & (ncap - 1)]) h++;
+            ns[h & (ncap - 1)] = s->slots[i];
+        }
+        free(s->slots);
+        s->slots = ns;
+        s->cap = ncap;
+    }
+    size_t h = (id * 0x9E3779B97F4A7C15ull) >> 20;
+    for (;; h++) {
+        uint64_t *slot = &s->slots[h & (s->cap - 1)];
+        if (*slot == id) return 0;
+        if (!*slot) {
+            *slot = id;
+            s->used++;
+            return 1;
+        }
+    }
+}
+
+// (binario) Define la cadena id la primera vez que aparece
+static void out_define_str(uint64_t id) {
+    if (!id || !strset_add(&alog.strs, id)) return;
+    const char *s = (const char *)(uintptr_t)id;
+    size_t len = strlen(s);
+    if (len > ALOG_OUT_SLACK - sizeof(alog_rec_t) - 8) len = ALOG_OUT_SLACK - sizeof(alog_rec_t) - 8;
+    size_t size = (sizeof(alog_rec_t) + len + 1 + 7) & ~(size_t)7;
+    if (alog.out_len + size > ALOG_OUT_SIZE) out_flush();
+    alog_rec_t *d = (alog_rec_t *)(alog.out + alog.out_len);
+    memset(d, 0, size);
+    d->size = (uint32_t)size;
+    d->flags = ALOG_REC_STR;
+    d->fmt = id;
+    memcpy((char *)(d + 1), s, len);
+    alog.out_len += size;
+}
+
+static void out_record(const alog_rec_t *r) {
+    if (ALOG_OUT_SIZE - alog.out_len < ALOG_OUT_SLACK) out_flush();
+
+    if (alog.mode == ALOG_BINARY) {
+        out_define_str(r->fmt);
+        out_define_str(r->prefix);
+        if (ALOG_OUT_SIZE - alog.out_len < r->size) out_flush();
+        alog_rec_t *d = (alog_rec_t *)(alog.out + alog.out_len);
+        memcpy(d, r, r->size);
+        d->ts = ticks_to_real_ns(r->ts);
+        alog.out_len += r->size;
+        return;
+    }
+
+    char *o = alog.out + alog.out_len;
+    size_t room = ALOG_OUT_SIZE - alog.out_len;
+    size_t n = 0;
+    if (r->prefix) {
+        // "prefix[sss.mmm] " como print_timestamp(), sin snprintf
+        uint64_t ns = ticks_to_real_ns(r->ts);
+        unsigned ms = (unsigned)(ns % 1000000000ull / 1000000);
+        const char *prefix = (const char *)(uintptr_t)r->prefix;
+        size_t plen = strlen(prefix);
+        memcpy(o, prefix, plen);
+        n = plen;
+        o[n++] = '[';
+        n += fmt_u64(o + n, room - n, ns / 1000000000ull % 1000, 10, 0);
+        o[n++] = '.';
+        o[n++] = (char)('0' + ms / 100);
+        o[n++] = (char)('0' + ms / 10 % 10);
+        o[n++] = (char)('0' + ms % 10);
+        o[n++] = ']';
+        o[n++] = ' ';
+    }
+    n += alog_format(o + n, room - n, (const char *)(uintptr_t)r->fmt, r->nargs, r->types,
+                     r->vals, (const char *)r);
+    alog.out_len += n;
+}
+
+// ========== CONSUMIDOR ==========
+
+static int cursors_reserve(size_t n) {
+    if (n <= alog.cur_cap) return 0;
+    size_t ncap = alog.cur_cap ? alog.cur_cap * 2 : 16;
+    while (ncap < n) ncap *= 2;
+    alog_ring_t **cr = realloc(alog.cur_ring, ncap * sizeof(*cr));
+    if (cr) alog.cur_ring = cr;
+    size_t *ct = realloc(alog.cur_tail, ncap * sizeof(*ct));
+    if (ct) alog.cur_tail = ct;
+    size_t *ch = realloc(alog.cur_head, ncap * sizeof(*ch));
+    if (ch) alog.cur_head = ch;
+    if (!cr || !ct || !ch) return -1;
+    alog.cur_cap = ncap;
+    return 0;
+}
+
+// Salta rellenos; devuelve el siguiente registro del anillo i o NULL
+static const alog_rec_t *cursor_peek(size_t i) {
+    alog_ring_t *r = alog.cur_ring[i];
+    while (alog.cur_tail[i] != alog.cur_head[i]) {
+        const alog_rec_t *rec = (const alog_rec_t *)(r->data + (alog.cur_tail[i] & ALOG_RING_MASK));
+        if (rec->flags != ALOG_REC_PAD) return rec;
+        alog.cur_tail[i] += rec->size;
+    }
+    return NULL;
+}
+
+// Drena todos los anillos hasta el head visto al empezar, en orden de
+// timestamp. Llamar con alog.lock tomado. Devuelve registros escritos.
+static size_t drain_locked(void) {
+    size_t nr = 0;
+    for (alog_ring_t *r = atomic_load_explicit(&alog.rings, memory_order_acquire); r; r = r->next) nr++;
+    if (cursors_reserve(nr) < 0) return 0;
+
+    size_t k = 0;
+    for (alog_ring_t *r = atomic_load_explicit(&alog.rings, memory_order_acquire); r && k < nr; r = r->next) {
+        size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        if (head == tail) continue;
+        alog.cur_ring[k] = r;
+        alog.cur_tail[k] = tail;
+        alog.cur_head[k] = head;
+        k++;
+    }
+    if (k == 0) return 0;
+
+    recalibrate();
+    size_t done = 0;
+    for (;;) {
+        size_t best = SIZE_MAX;
+        const alog_rec_t *best_rec = NULL;
+        for (size_t i = 0; i < k; i++) {
+            const alog_rec_t *rec = cursor_peek(i);
+            if (rec && (!best_rec || (int64_t)(rec->ts - best_rec->ts) < 0)) {
+                best = i;
+                best_rec = rec;
+            }
+        }
+        if (!best_rec) break;
+        out_record(best_rec);
+        alog.cur_tail[best] += best_rec->size;
+        done++;
+        // Liberar hueco pronto por si el productor espera
+        if ((done & 255) == 0) {
+            atomic_store_explicit(&alog.cur_ring[best]->tail, alog.cur_tail[best], memory_order_release);
+        }
+    }
+    for (size_t i = 0; i < k; i++) {
+        atomic_store_explicit(&alog.cur_ring[i]->tail, alog.cur_tail[i], memory_order_release);
+    }
+    out_flush();
+    atomic_fetch_add_explicit(&alog.records, done, memory_order_relaxed);
+    return done;
+}
+
+static void *flusher_main(void *arg) {
+    (void)arg;
+    prctl(PR_SET_NAME, "ALOG-FLUSH", 0, 0, 0);
+    // Las señales dirigidas al proceso son para los threads de la aplicación
+    // (p. ej. un signalfd que espera SIGTERM), no para el flusher
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, NULL);
+    struct timespec idle = { 0, ALOG_IDLE_NS };
+
+    while (!atomic_load(&alog.stop)) {
+        unsigned seq = atomic_load(&alog.wake);
+        pthread_mutex_lock(&alog.lock);
+        size_t n = drain_locked();
+        pthread_mutex_unlock(&alog.lock);
+        if (n == 0) {
+            atomic_store(&alog.sleeping, 1);
+            syscall(SYS_futex, &alog.wake, FUTEX_WAIT_PRIVATE, seq, &idle, NULL, 0);
+            atomic_store(&alog.sleeping, 0);
+        }
+    }
+    return NULL;
+}
+
+static void wake_flusher(void) {
+    atomic_fetch_add(&alog.wake, 1);
+    if (atomic_load_explicit(&alog.sleeping, memory_order_relaxed)) {
+        syscall(SYS_futex, &alog.wake, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+static int start_flusher(void) {
+    atomic_store(&alog.stop, 0);
+    if (pthread_create(&alog.flusher, NULL, flusher_main, NULL) != 0) return -1;
+    alog.flusher_running = 1;
+    return 0;
+}
+
+// ========== PRODUCTOR ==========
+
+static void ring_release(void *arg) {
+    alog_ring_t *r = arg;
+    atomic_store_explicit(&r->owner, 0, memory_order_release);
+}
+
+static alog_ring_t *ring_acquire(void) {
+    // Reutilizar el anillo vacío de un thread que ya terminó
+    for (alog_ring_t *r = atomic_load_explicit(&alog.rings, memory_order_acquire); r; r = r->next) {
+        int zero = 0;
+        if (atomic_load_explicit(&r->owner, memory_order_relaxed) == 0 &&
+            atomic_load_explicit(&r->tail, memory_order_acquire) == atomic_load_explicit(&r->head, memory_order_relaxed) &&
+            atomic_compare_exchange_strong(&r->owner, &zero, 1)) {
+            r->tid = (uint32_t)get_kernel_pid();
+            r->cached_tail = atomic_load(&r->tail);
+            r->pending_prefix = NULL;
+            tls_ring = r;
+            pthread_setspecific(alog.key, r);
+            return r;
+        }
+    }
+
+    alog_ring_t *r = aligned_alloc(64, sizeof(*r));
+    if (!r) return NULL;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->owner, 1);
+    r->cached_tail = 0;
+    r->pending_prefix = NULL;
+    r->tid = (uint32_t)get_kernel_pid();
+    r->next = atomic_load(&alog.rings);
+    while (!atomic_compare_exchange_weak(&alog.rings, &r->next, r)) {}
+    tls_ring = r;
+    pthread_setspecific(alog.key, r);
+    return r;
+}
+
+void alog_timestamp(const char *prefix) {
+    alog_ring_t *r = tls_ring ? tls_ring : ring_acquire();
+    if (!r) return;
+    r->pending_ts = alog_ticks();
+    r->pending_prefix = prefix ? prefix : "";
+}
+
+void alog_emit(const char *fmt, const alog_arg_t *args, int nargs) {
+    if (!atomic_load_explicit(&alog.enabled, memory_order_relaxed)) {
+        emit_direct(fmt, args, nargs);
+        return;
+    }
+    if (atomic_load_explicit(&alog.restart, memory_order_relaxed) &&
+        atomic_exchange(&alog.restart, 0)) {
+        start_flusher();
+    }
+    alog_ring_t *r = tls_ring ? tls_ring : ring_acquire();
+    if (!r) {
+        emit_direct(fmt, args, nargs);
+        return;
+    }
+    if (nargs > ALOG_MAX_ARGS) nargs = ALOG_MAX_ARGS;
+
+    size_t slen[ALOG_MAX_ARGS];
+    size_t size = sizeof(alog_rec_t) + (size_t)nargs * sizeof(uint64_t);
+    size_t budget = ALOG_REC_STRS;
+    for (int i = 0; i < nargs; i++) {
+        if (args[i].type != ALOG_T_STR) continue;
+        slen[i] = args[i].v.s ? strnlen(args[i].v.s, ALOG_MAX_STR - 1) : 0;
+        if (slen[i] > budget) slen[i] = budget;
+        budget -= slen[i];
+        size += slen[i] + 1;
+    }
+    size = (size + 7) & ~(size_t)7;
+
+    // Reserva contigua: si no cabe antes del final, relleno y vuelta al principio
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t contig = ALOG_RING_SIZE - (head & ALOG_RING_MASK);
+    size_t need = size + (contig < size ? contig : 0);
+    while (ALOG_RING_SIZE - (head - r->cached_tail) < need) {
+        r->cached_tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (ALOG_RING_SIZE - (head - r->cached_tail) >= need) break;
+        atomic_fetch_add_explicit(&alog.stalls, 1, memory_order_relaxed);
+        wake_flusher();
+        sched_yield();
+    }
+    if (contig < size) {
+        alog_rec_t *pad = (alog_rec_t *)(r->data + (head & ALOG_RING_MASK));
+        pad->size = (uint32_t)contig;
+        pad->flags = ALOG_REC_PAD;
+        head += contig;
+    }
+
+    alog_rec_t *rec = (alog_rec_t *)(r->data + (head & ALOG_RING_MASK));
+    rec->size = (uint32_t)size;
+    rec->flags = ALOG_REC_LOG;
+    rec->nargs = (uint8_t)nargs;
+    rec->tid = r->tid;
+    if (r->pending_prefix) {
+        rec->ts = r->pending_ts;
+        rec->prefix = (uint64_t)(uintptr_t)r->pending_prefix;
+        r->pending_prefix = NULL;
+    } else {
+        rec->ts = alog_ticks();
+        rec->prefix = 0;
+    }
+    rec->fmt = (uint64_t)(uintptr_t)fmt;
+
+    size_t soff = sizeof(alog_rec_t) + (size_t)nargs * sizeof(uint64_t);
+    for (int i = 0; i < nargs; i++) {
+        rec->types[i] = args[i].type;
+        if (args[i].type == ALOG_T_STR) {
+            memcpy((char *)rec + soff, args[i].v.s ? args[i].v.s : "", slen[i]);
+            ((char *)rec)[soff + slen[i]] = '\0';
+            rec->vals[i] = soff;
+            soff += slen[i] + 1;
+        } else {
+            memcpy(&rec->vals[i], &args[i].v, sizeof(uint64_t));
+        }
+    }
+
+    atomic_store_explicit(&r->head, head + size, memory_order_release);
+
+    // Más de medio anillo ocupado: no esperar al siguiente tick del flusher
+    if (head + size - r->cached_tail > ALOG_RING_SIZE / 2) {
+        r->cached_tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head + size - r->cached_tail > ALOG_RING_SIZE / 2) wake_flusher();
+    }
+}
+
+// ========== CICLO DE VIDA ==========
+
+void alog_sync(void) {
+    if (!atomic_load(&alog.enabled)) {
+        fflush(stdout);
+        return;
+    }
+    pthread_mutex_lock(&alog.lock);
+    drain_locked();
+    pthread_mutex_unlock(&alog.lock);
+    fflush(stdout);
+}
+
+static void atfork_prepare(void) {
+    if (!atomic_load(&alog.enabled)) return;
+    alog_sync();
+    pthread_mutex_lock(&alog.lock);
+}
+
+static void atfork_parent(void) {
+    if (!atomic_load(&alog.enabled)) return;
+    pthread_mutex_unlock(&alog.lock);
+}
+
+// En el hijo solo existe el thread que llamó a fork(): lo que quede en los
+// anillos es del padre (lo escribirá él) y el flusher no se copió
+static void atfork_child(void) {
+    if (!atomic_load(&alog.enabled)) return;
+    pthread_mutex_init(&alog.lock, NULL);
+    for (alog_ring_t *r = atomic_load(&alog.rings); r; r = r->next) {
+        size_t head = atomic_load(&r->head);
+        atomic_store(&r->tail, head);
+        r->cached_tail = head;
+        if (r != tls_ring) atomic_store(&r->owner, 0);
+    }
+    if (tls_ring) {
+        tls_ring->tid = (uint32_t)get_kernel_pid();
+        tls_ring->pending_prefix = NULL;
+    }
+    alog.flusher_running = 0;
+    atomic_store(&alog.restart, 1);
+}
+
+int alog_init(alog_mode_t mode, int fd, alog_clock_t clock) {
+    static int registered;
+    if (atomic_load(&alog.enabled)) return 0;
+
+    alog.mode = mode;
+    alog.fd = fd;
+    alog.clock = clock;
+    if (clock == ALOG_CLOCK_TSC && !tsc_usable()) alog.clock = ALOG_CLOCK_MONO;
+    calibrate();
+
+    alog.out = malloc(ALOG_OUT_SIZE);
+    if (!alog.out) return -1;
+    alog.out_len = 0;
+    if (pthread_mutex_init(&alog.lock, NULL) != 0) return -1;
+
+    if (!registered) {
+        if (pthread_key_create(&alog.key, ring_release) != 0) return -1;
+        pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+        atexit(alog_shutdown);
+        registered = 1;
+    }
+
+    if (mode == ALOG_BINARY) write_all(fd, ALOG_MAGIC, 8);
+    if (start_flusher() < 0) return -1;
+    atomic_store(&alog.enabled, 1);
+    return 0;
+}
+
+void alog_shutdown(void) {
+    if (!atomic_load(&alog.enabled)) return;
+    if (alog.flusher_running) {
+        atomic_store(&alog.stop, 1);
+        atomic_fetch_add(&alog.wake, 1);
+        syscall(SYS_futex, &alog.wake, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        pthread_join(alog.flusher, NULL);
+        alog.flusher_running = 0;
+    }
+    alog_sync();
+    atomic_store(&alog.enabled, 0);
+    // Los anillos se quedan: un thread rezagado que aún registre sale por emit_direct
+    free(alog.out);
+    alog.out = NULL;
+    free(alog.strs.slots);
+    memset(&alog.strs, 0, sizeof(alog.strs));
+}
+
+int alog_enabled(void) {
+    return atomic_load_explicit(&alog.enabled, memory_order_relaxed);
+}
+
+void alog_stats(uint64_t *records, uint64_t *writes, uint64_t *stalls) {
+    if (records) *records = atomic_load(&alog.records);
+    if (writes) *writes = atomic_load(&alog.writes);
+    if (stalls) *stalls = atomic_load(&alog.stalls);
+}
+
+// ========== VISOR ==========
+
+// Cadenas definidas en el fichero: id → texto (dentro del mapeo)
+typedef struct {
+    uint64_t id;
+    const char *s;
+} view_str_t;
+
+static const char *view_lookup(const view_str_t *tab, size_t cap, uint64_t id) {
+    if (!id || !cap) return NULL;
+    for (size_t h = (id * 0x9E3779B97F4A7C15ull) >> 20; ; h++) {
+        const view_str_t *e = &tab[h & (cap - 1)];
+        if (e->id == id) return e->s;
+        if (!e->id) return NULL;
+    }
+}
+
+int alog_view_file(const char *path, int fd_out, int show_tid) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 8) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    const char *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    if (memcmp(map, ALOG_MAGIC, 8) != 0) {
+        munmap((void *)map, len);
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Primera pasada: contar definiciones para dimensionar la tabla
+    size_t ndefs = 0;
+    for (size_t off = 8; off + sizeof(alog_rec_t) <= len; ) {
+        const alog_rec_t *r = (const alog_rec_t *)(map + off);
+        if (r->size < sizeof(alog_rec_t) || off + r->size > len) break;
+        ndefs += r->flags == ALOG_REC_STR;
+        off += r->size;
+    }
+    size_t cap = 16;
+    while (cap < ndefs * 2) cap *= 2;
+    view_str_t *tab = calloc(cap, sizeof(*tab));
+    char *out = malloc(ALOG_OUT_SIZE);
+    if (!tab || !out) {
+        free(tab);
+        free(out);
+        munmap((void *)map, len);
+        return -1;
+    }
+
+    size_t out_len = 0;
+    for (size_t off = 8; off + sizeof(alog_rec_t) <= len; ) {
+        const alog_rec_t *r = (const alog_rec_t *)(map + off);
+        if (r->size < sizeof(alog_rec_t) || off + r->size > len) break;
+        off += r->size;
+
+        if (r->flags == ALOG_REC_STR) {
+            size_t h = (r->fmt * 0x9E3779B97F4A7C15ull) >> 20;
+            while (tab[h & (cap - 1)].id && tab[h & (cap - 1)].id != r->fmt) h++;
+            tab[h & (cap - 1)].id = r->fmt;
+            tab[h & (cap - 1)].s = (const char *)(r + 1);
+            continue;
+        }
+        if (r->flags != ALOG_REC_LOG) continue;
+
+        if (ALOG_OUT_SIZE - out_len < ALOG_OUT_SLACK) {
+            write_all(fd_out, out, out_len);
+            out_len = 0;
+        }
+        char *o = out + out_len;
+        size_t room = ALOG_OUT_SIZE - out_len;
+        size_t n = 0;
+        int w = 0;
+        const char *fmt = view_lookup(tab, cap, r->fmt);
+        const char *prefix = view_lookup(tab, cap, r->prefix);
+        if (r->prefix) {
+            w = snprintf(o, room, "%s[%ld.%03ld] ", prefix ? prefix : "",
+                         (long)(r->ts / 1000000000ull % 1000), (long)(r->ts % 1000000000ull / 1000000));
+        }
+        if (w > 0) n += (size_t)w;
+        if (show_tid) {
+            w = snprintf(o + n, room - n, "(%u %lu.%09lu) ", r->tid,
+                         (unsigned long)(r->ts / 1000000000ull), (unsigned long)(r->ts % 1000000000ull));
+            if (w > 0) n += (size_t)w;
+        }
+        if (fmt) {
+            n += alog_format(o + n, room - n, fmt, r->nargs, r->types, r->vals, (const char *)r);
+        } else {
+            w = snprintf(o + n, room - n, "<formato %#llx desconocido>\n", (unsigned long long)r->fmt);
+            if (w > 0) n += (size_t)w;
+        }
+        out_len += n;
+    }
+    write_all(fd_out, out, out_len);
+
+    free(tab);
+    free(out);
+    munmap((void *)map, len);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// async_log.h - Logger asíncrono: un anillo SPSC por thread y un flusher en segundo plano
+//
+// El thread que registra solo copia fmt + argumentos a su anillo (sin
+// formatear, sin locks, sin syscalls); el thread ALOG-FLUSH drena todos los
+// anillos, ordena por timestamp y emite con write() en lotes grandes:
+//   - ALOG_TEXT:   texto ya formateado (sustituye a printf)
+//   - ALOG_BINARY: registros crudos que luego decodifica alog_view_file()
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+#define ALOG_RING_SIZE  (64 * 1024)     // bytes por thread, potencia de 2
+#define ALOG_MAX_ARGS   8
+#define ALOG_MAX_STR    PATH_MAX        // los %s se copian truncados a esto (rutas enteras)
+
+typedef enum { ALOG_TEXT, ALOG_BINARY } alog_mode_t;
+
+// TSC: exacto y barato (x86 con constant_tsc), si no CLOCK_MONOTONIC.
+// COARSE: CLOCK_MONOTONIC_COARSE, aún más barato pero con resolución de tick.
+typedef enum { ALOG_CLOCK_TSC, ALOG_CLOCK_MONO, ALOG_CLOCK_COARSE } alog_clock_t;
+
+// ========== ARGUMENTOS ==========
+
+enum { ALOG_T_I64 = 1, ALOG_T_U64, ALOG_T_F64, ALOG_T_STR, ALOG_T_PTR };
+
+typedef struct {
+    uint8_t type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char *s;
+        const void *p;
+    } v;
+} alog_arg_t;
+
+static inline alog_arg_t alog_arg_i64(long long x)          { alog_arg_t a = { ALOG_T_I64, { .i = x } }; return a; }
+static inline alog_arg_t alog_arg_u64(unsigned long long x) { alog_arg_t a = { ALOG_T_U64, { .u = x } }; return a; }
+static inline alog_arg_t alog_arg_f64(double x)             { alog_arg_t a = { ALOG_T_F64, { .d = x } }; return a; }
+static inline alog_arg_t alog_arg_str(const char *x)        { alog_arg_t a = { ALOG_T_STR, { .s = x } }; return a; }
+static inline alog_arg_t alog_arg_ptr(const void *x)        { alog_arg_t a = { ALOG_T_PTR, { .p = x } }; return a; }
+
+// El tipo de cada argumento se decide en compilación
+#define ALOG_ARG(x) _Generic((x),                                       \
+    char *: alog_arg_str, const char *: alog_arg_str,                   \
+    void *: alog_arg_ptr, const void *: alog_arg_ptr,                   \
+    float: alog_arg_f64, double: alog_arg_f64,                          \
+    unsigned int: alog_arg_u64, unsigned long: alog_arg_u64,            \
+    unsigned long long: alog_arg_u64,                                   \
+    default: alog_arg_i64)(x)
+
+#define ALOG_NARGS(...) ALOG_NARGS_(0 __VA_OPT__(,) __VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define ALOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define ALOG_CAT(a, b)  ALOG_CAT_(a, b)
+#define ALOG_CAT_(a, b) a##b
+#define ALOG_MAP0()
+#define ALOG_MAP1(a)                      ALOG_ARG(a)
+#define ALOG_MAP2(a, b)                   ALOG_ARG(a), ALOG_ARG(b)
+#define ALOG_MAP3(a, b, c)                ALOG_MAP2(a, b), ALOG_ARG(c)
+#define ALOG_MAP4(a, b, c, d)             ALOG_MAP3(a, b, c), ALOG_ARG(d)
+#define ALOG_MAP5(a, b, c, d, e)          ALOG_MAP4(a, b, c, d), ALOG_ARG(e)
+#define ALOG_MAP6(a, b, c, d, e, f)       ALOG_MAP5(a, b, c, d, e), ALOG_ARG(f)
+#define ALOG_MAP7(a, b, c, d, e, f, g)    ALOG_MAP6(a, b, c, d, e, f), ALOG_ARG(g)
+#define ALOG_MAP8(a, b, c, d, e, f, g, h) ALOG_MAP7(a, b, c, d, e, f, g), ALOG_ARG(h)
+
+// Sustituto de printf. fmt debe ser un literal (se guarda solo el puntero).
+// Sin alog_init() formatea y escribe en stdout en el momento.
+#define alog_printf(fmt, ...)                                                        \
+    alog_emit((fmt), (const alog_arg_t[ALOG_NARGS(__VA_ARGS__) + 1]){                \
+                  ALOG_CAT(ALOG_MAP, ALOG_NARGS(__VA_ARGS__))(__VA_ARGS__) },        \
+              ALOG_NARGS(__VA_ARGS__))
+
+// ========== API ==========
+
+// Arranca el flusher hacia fd. Registra alog_shutdown() con atexit y
+// handlers de pthread_atfork para que el hijo de fork() siga registrando.
+int  alog_init(alog_mode_t mode, int fd, alog_clock_t clock);
+
+// Vacía todo lo pendiente y para el flusher
+void alog_shutdown(void);
+
+int  alog_enabled(void);
+
+// El siguiente alog_printf de este thread lleva delante "prefix[sss.mmm] ",
+// igual que print_timestamp(), pero con el instante de esta llamada
+void alog_timestamp(const char *prefix);
+
+void alog_emit(const char *fmt, const alog_arg_t *args, int nargs);
+
+// Escribe ya todo lo pendiente de todos los threads (antes de leer stdin,
+// de bloquearse o de imprimir por otro camino)
+void alog_sync(void);
+
+// Formatea fmt con argumentos ya tipados (lo usan el flusher y el visor).
+// strbase: base de los offsets de los %s; NULL si vals guarda punteros.
+size_t alog_format(char *out, size_t cap, const char *fmt, int nargs, const uint8_t *types,
+                   const uint64_t *vals, const char *strbase);
+
+// Contadores acumulados: registros escritos, write() hechos, esperas por anillo lleno
+void alog_stats(uint64_t *records, uint64_t *writes, uint64_t *stalls);
+
+// Decodifica un fichero de ALOG_BINARY a texto en fd_out
+int  alog_view_file(const char *path, int fd_out, int show_tid);
+
+#endif // ASYNC_LOG_H
@@ -0,0 +1,147 @@
+// bench_addr.c - Clasificación de direcciones por lotes vs buscar en /proc/<pid>/maps cada vez
+//
+// Uso: ./bench_addr [millones de direcciones] [threads]
+//   Crea threads dormidos (stacks propios), un alloc grande (mmap) y construye
+//   el mapa clasificado de este proceso. Después clasifica:
+//     - direcciones aleatorias (sin localidad)
+//     - una traza con localidad (ráfagas dentro de la misma región)
+//   con addr_map_lookup_batch y, como referencia, con proc_maps_find y
+//   releyendo /proc/self/maps por dirección (lo que se hacía a mano).
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_maps.h"
+#include "proc_addr.h"
+
+#define NAIVE_ADDRS 2000
+
+static void *sleeper(void *arg) {
+    (void)arg;
+    pause();
+    return NULL;
+}
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static inline uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Dirección aleatoria dentro de una región aleatoria del mapa
+static inline uintptr_t random_addr(const addr_map_t *m) {
+    size_t r = rng() % m->n;
+    return m->starts[r] + rng() % (m->ends[r] - m->starts[r]);
+}
+
+// Lo que haría un script: abrir maps y recorrer líneas por cada dirección
+static int naive_lookup(uintptr_t addr) {
+    FILE *fp = fopen("/proc/self/maps", "r");
+    if (!fp) return -1;
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long lo, hi;
+        if (sscanf(line, "%lx-%lx", &lo, &hi) == 2 && addr >= lo && addr < hi) {
+            found = 1;
+            break;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+static void report(const char *name, size_t n, uint64_t ns, unsigned long hits) {
+    printf("  %-34s %10.2f ns/dir %8.2f GB/s  (%lu mapeadas)\n", name, (double)ns / (double)n,
+           (double)n * sizeof(uintptr_t) / (double)ns, hits);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = (size_t)(argc > 1 ? atof(argv[1]) : 16) * 1000000;
+    int nthreads = argc > 2 ? atoi(argv[2]) : 64;
+    if (n < NAIVE_ADDRS) n = NAIVE_ADDRS;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 64 << 10);
+    for (int i = 0; i < nthreads; i++) {
+        pthread_t th;
+        if (pthread_create(&th, &attr, sleeper, NULL) != 0) break;
+    }
+    pthread_attr_destroy(&attr);
+    usleep(100000);
+    void *big = malloc(64 << 20);   // región anónima extra
+
+    uintptr_t *addrs = malloc(n * sizeof(*addrs));
+    int32_t *out = malloc(n * sizeof(*out));
+    if (!addrs || !out || !big) return 1;
+
+    addr_map_t am;
+    addr_map_init(&am);
+    uint64_t t0 = now_ns();
+    if (addr_map_build(&am, getpid()) < 0) {
+        perror("addr_map_build");
+        return 1;
+    }
+    uint64_t build_ns = now_ns() - t0;
+
+    printf("%s=== BENCHMARK DEL CLASIFICADOR DE DIRECCIONES ===%s\n", COLOR_BOLD, COLOR_RESET);
+    printf("  %zu regiones (%zu en maps), %d threads, construcción %.1f µs\n",
+           am.n, am.maps.nregions, nthreads, build_ns / 1e3);
+    printf("  %zu M direcciones por prueba\n\n", n / 1000000);
+
+    // 1. Aleatorias
+    for (size_t i = 0; i < n; i++) addrs[i] = random_addr(&am);
+    t0 = now_ns();
+    addr_map_lookup_batch(&am, addrs, n, out);
+    uint64_t dt = now_ns() - t0;
+    unsigned long hits = 0;
+    for (size_t i = 0; i < n; i++) hits += out[i] >= 0;
+    report("lote, aleatorias", n, dt, hits);
+
+    hits = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) hits += proc_maps_find(&am.maps, addrs[i]) != NULL;
+    report("proc_maps_find, aleatorias", n, now_ns() - t0, hits);
+
+    // 2. Traza con localidad: ráfagas de 64 direcciones en la misma región
+    for (size_t i = 0; i < n; i += 64) {
+        size_t r = rng() % am.n;
+        uintptr_t span = am.ends[r] - am.starts[r];
+        for (size_t j = i; j < i + 64 && j < n; j++) addrs[j] = am.starts[r] + rng() % span;
+    }
+    t0 = now_ns();
+    addr_map_lookup_batch(&am, addrs, n, out);
+    dt = now_ns() - t0;
+    hits = 0;
+    for (size_t i = 0; i < n; i++) hits += out[i] >= 0;
+    report("lote, traza con localidad", n, dt, hits);
+
+    // 3. Releyendo maps por dirección (solo unas pocas: es órdenes de magnitud más lento)
+    hits = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < NAIVE_ADDRS; i++) hits += naive_lookup(addrs[i * (n / NAIVE_ADDRS)]) == 1;
+    report("fopen+sscanf de maps por dirección", NAIVE_ADDRS, now_ns() - t0, hits);
+
+    // Ancho de banda de referencia: solo leer las direcciones
+    uint64_t sum = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) sum += addrs[i];
+    dt = now_ns() - t0;
+    printf("  %-34s %10.2f ns/dir %8.2f GB/s  (checksum %lx)\n", "referencia: solo leer el lote",
+           (double)dt / (double)n, (double)n * sizeof(uintptr_t) / (double)dt, (unsigned long)(sum & 0xfff));
+
+    addr_map_free(&am);
+    free(addrs);
+    free(out);
+    free(big);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// bench_elf.c - Resolución de símbolos con proc_elf vs lanzar objdump por consulta
+//
+// Uso: ./bench_elf [fichero ELF] [consultas]
+//   Abre el ELF (mmap, sin copias), elige símbolos al azar de su .symtab y mide:
+//     - elf_open (validación + localización de tablas)
+//     - primera búsqueda por nombre (recorrido de .symtab en su sitio)
+//     - construcción del hash por nombre y búsquedas con él
+//     - construcción del índice por dirección (radix sort) y búsquedas por dirección
+//     - como referencia, "objdump -t fichero" + buscar el nombre, por consulta
+//   Sin argumentos usa el propio ejecutable.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_elf.h"
+
+#define OBJDUMP_QUERIES 3
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static inline uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Lo que se hacía a mano: objdump -t entero y buscar la línea del símbolo
+static int objdump_lookup(const char *path, const char *name) {
+    char cmd[8192], real[4096];
+    // /proc/self/exe sería el del shell de popen
+    if (!realpath(path, real)) return -1;
+    snprintf(cmd, sizeof(cmd), "objdump -t '%s' 2>/dev/null", real);
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return -1;
+    char line[4096];
+    size_t nlen = strlen(name);
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        size_t len = strcspn(line, "\n");
+        if (!found && len >= nlen && memcmp(line + len - nlen, name, nlen) == 0) found = 1;
+    }
+    pclose(fp);
+    return found;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "/proc/self/exe";
+    size_t nq = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+    if (nq == 0) nq = 1;
+
+    elf_file_t e;
+    uint64_t t0 = now_ns();
+    if (elf_open(&e, path) < 0) {
+        perror(path);
+        return 1;
+    }
+    uint64_t open_ns = now_ns() - t0;
+    if (e.nsyms == 0) {
+        fprintf(stderr, "%s no tiene tabla de símbolos\n", path);
+        return 1;
+    }
+
+    // Símbolos definidos con nombre, elegidos al azar
+    const Elf64_Sym **picks = malloc(nq * sizeof(*picks));
+    if (!picks) return 1;
+    for (size_t i = 0; i < nq;) {
+        const Elf64_Sym *s = &e.syms[rng() % e.nsyms];
+        uint8_t t = ELF64_ST_TYPE(s->st_info);
+        if (s->st_shndx == SHN_UNDEF || s->st_value == 0 || !*elf_symbol_name(&e, s) ||
+            (t != STT_FUNC && t != STT_OBJECT)) continue;
+        picks[i++] = s;
+    }
+
+    printf("%s=== BENCHMARK DE SÍMBOLOS ELF ===%s\n", COLOR_BOLD, COLOR_RESET);
+    printf("  %s: %.1f MB, %zu secciones, %zu símbolos\n", path, e.size / 1e6, e.nsections, e.nsyms);
+    printf("  %-36s %12.1f µs\n", "elf_open", open_ns / 1e3);
+
+    t0 = now_ns();
+    elf_find_symbol(&e, elf_symbol_name(&e, picks[0]));
+    printf("  %-36s %12.1f µs\n", "1ª por nombre (recorre .symtab)", (now_ns() - t0) / 1e3);
+    t0 = now_ns();
+    elf_find_symbol(&e, elf_symbol_name(&e, picks[0]));
+    printf("  %-36s %12.1f µs\n", "2ª por nombre (construye el hash)", (now_ns() - t0) / 1e3);
+
+    unsigned long ok = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < nq; i++) ok += elf_find_symbol(&e, elf_symbol_name(&e, picks[i])) != NULL;
+    uint64_t dt = now_ns() - t0;
+    printf("  %-36s %12.1f ns/consulta  (%lu/%zu encontrados)\n", "por nombre (hash)",
+           (double)dt / (double)nq, ok, nq);
+
+    uint64_t off;
+    t0 = now_ns();
+    elf_symbol_at(&e, picks[0]->st_value, &off);
+    printf("  %-36s %12.1f µs  (%zu símbolos con dirección)\n", "índice por dirección (radix sort)",
+           (now_ns() - t0) / 1e3, e.nsym_addrs);
+
+    ok = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < nq; i++) {
+        ok += elf_symbol_at(&e, picks[i]->st_value + picks[i]->st_size / 2, &off) != NULL;
+    }
+    dt = now_ns() - t0;
+    printf("  %-36s %12.1f ns/consulta  (%lu/%zu resueltas)\n", "por dirección (búsqueda binaria)",
+           (double)dt / (double)nq, ok, nq);
+
+    // Referencia: un proceso objdump por consulta (solo unas pocas)
+    if (system("command -v objdump >/dev/null 2>&1") == 0) {
+        ok = 0;
+        t0 = now_ns();
+        for (size_t i = 0; i < OBJDUMP_QUERIES; i++) {
+            ok += objdump_lookup(path, elf_symbol_name(&e, picks[i])) == 1;
+        }
+        dt = now_ns() - t0;
+        printf("  %-36s %12.1f µs/consulta  (%lu/%d encontrados)\n", "objdump -t por consulta",
+               dt / 1e3 / OBJDUMP_QUERIES, ok, OBJDUMP_QUERIES);
+    }
+
+    free(picks);
+    elf_close(&e);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// bench_events.c - Latencia de aviso de salida: pidfd y netlink vs sondear /proc
+//
+// Uso: ./bench_events [hijos]
+//   Cada hijo apunta now_ns() en una página compartida justo antes de _exit();
+//   el padre mide cuánto tarda en enterarse:
+//     - solo pidfd (epoll)
+//     - pidfd + conector netlink (si hay permiso)
+//   Como referencia mide el coste de una pasada de sondeo estilo pgrep
+//   (leer /proc/<pid>/stat de todos los procesos) y lo extrapola a 30000 PID.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_events.h"
+
+#define POLL_PIDS 30000
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Latencias (ns) de n salidas; devuelve cuántas se midieron
+static int measure(unsigned flags, int n, volatile uint64_t *shared, uint64_t *lat, int *netlink) {
+    proc_tracker_t t;
+    if (proc_tracker_init(&t, flags) < 0) return 0;
+    *netlink = proc_tracker_has_netlink(&t);
+    int got = 0;
+    for (int i = 0; i < n; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            usleep(2000);               // que el padre ya esté esperando
+            *shared = now_ns();
+            _exit(0);
+        }
+        if (pid < 0 || proc_tracker_watch(&t, pid) < 0) break;
+        proc_event_t ev;
+        int r;
+        while ((r = proc_tracker_wait(&t, &ev, 1, 1000)) == 1 && !(ev.kind == PEV_EXIT && ev.pid == pid)) {
+        }
+        if (r == 1) lat[got++] = ev.recv_ns - *shared;
+        waitpid(pid, NULL, WNOHANG);
+    }
+    proc_tracker_free(&t);
+    return got;
+}
+
+static void report(const char *name, uint64_t *lat, int n) {
+    if (n == 0) {
+        printf("  %-28s %s\n", name, "no disponible");
+        return;
+    }
+    qsort(lat, (size_t)n, sizeof(*lat), cmp_u64);
+    printf("  %-28s p50 %8.1f µs   p99 %8.1f µs   máx %8.1f µs  (%d salidas)\n", name,
+           lat[n / 2] / 1e3, lat[(size_t)n * 99 / 100] / 1e3, lat[n - 1] / 1e3, n);
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 200;
+    if (n <= 0) n = 1;
+    volatile uint64_t *shared = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    uint64_t *lat = malloc((size_t)n * sizeof(*lat));
+    if (shared == MAP_FAILED || !lat) return 1;
+
+    printf("%s=== BENCHMARK DE AVISO DE SALIDA ===%s\n", COLOR_BOLD, COLOR_RESET);
+    int netlink;
+    int got = measure(0, n, shared, lat, &netlink);
+    report("pidfd + epoll", lat, got);
+    got = measure(PTRACK_NETLINK, n, shared, lat, &netlink);
+    report(netlink ? "pidfd + netlink" : "pidfd + netlink (sin permiso)", lat, netlink ? got : 0);
+
+    // Sondeo: una pasada leyendo el stat de cada proceso, como pgrep
+    proc_dir_buf_t db = { 0 };
+    proc_file_t f;
+    proc_file_init(&f);
+    pid_t *pids = NULL;
+    size_t cap = 0;
+    char path[64];
+    uint64_t best = UINT64_MAX;
+    ssize_t np = 0;
+    for (int rep = 0; rep < 5; rep++) {
+        uint64_t t0 = now_ns();
+        np = proc_list_pids("/proc", &db, &pids, &cap);
+        for (ssize_t i = 0; i < np; i++) {
+            snprintf(path, sizeof(path), "/proc/%d/stat", pids[i]);
+            proc_file_load(&f, path);
+        }
+        uint64_t dt = now_ns() - t0;
+        if (dt < best) best = dt;
+    }
+    double per_pid = np > 0 ? (double)best / (double)np : 0;
+    printf("  %-28s %8.1f µs/PID (%zd procesos) → %d PID cada 1 s: %.0f%% de un core,\n",
+           "sondeo de /proc", per_pid / 1e3, np, POLL_PIDS, per_pid * POLL_PIDS / 1e7);
+    printf("  %-28s latencia media de aviso 500000 µs\n", "");
+
+    free(pids);
+    proc_dir_buf_free(&db);
+    proc_file_free(&f);
+    free(lat);
+    return 0;
+}
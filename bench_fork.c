@@ -0,0 +1,198 @@
+// bench_fork.c - Latencia de fork/vfork/posix_spawn/clone(CLONE_VM) según el RSS del padre
+//
+// Uso: ./bench_fork [max_mb] [iteraciones]
+//   Para cada tamaño de RSS (1 MB, 16 MB, 256 MB, 1 GB, 8 GB, limitado por
+//   max_mb y por MemAvailable) y cada modo de páginas (4 KB / THP), mide:
+//     - latencia de cada primitiva hasta que vuelve al padre (p50/p90/p99/max)
+//     - ida y vuelta completa (i+v): creación + _exit del hijo + waitpid
+//     - coste de la primera escritura por página tras fork() (minflt de getrusage)
+//   Es el mismo camino que proc_analysis: fork() y el hijo sigue vivo mientras
+//   el padre escribe en memoria compartida por COW.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+
+extern char **environ;
+
+#define CLONE_STACK_SIZE (64 * 1024)
+#define TOUCH_MAX_PAGES  65536   // páginas escritas tras fork() (muestra)
+
+typedef enum { PRIM_FORK, PRIM_VFORK, PRIM_SPAWN, PRIM_CLONE_VM, PRIM_COUNT } primitive_t;
+
+static const char *prim_names[PRIM_COUNT] = { "fork", "vfork", "posix_spawn", "clone(CLONE_VM)" };
+
+static char *clone_stack;
+
+static int clone_child(void *arg) {
+    (void)arg;
+    return 0;
+}
+
+// Crea un hijo con la primitiva indicada. *call_ns = tiempo hasta que la
+// llamada vuelve al padre. Devuelve el PID del hijo o -1.
+static pid_t create_child(primitive_t prim, uint64_t *call_ns) {
+    static char *const spawn_argv[] = { "/bin/true", NULL };
+    pid_t pid = -1;
+    uint64_t t0 = now_ns();
+
+    switch (prim) {
+    case PRIM_FORK:
+        pid = fork();
+        if (pid == 0) _exit(0);
+        break;
+    case PRIM_VFORK:
+        pid = vfork();
+        if (pid == 0) _exit(0);
+        break;
+    case PRIM_SPAWN:
+        if (posix_spawn(&pid, spawn_argv[0], NULL, NULL, spawn_argv, environ) != 0) pid = -1;
+        break;
+    case PRIM_CLONE_VM:
+        pid = clone(clone_child, clone_stack + CLONE_STACK_SIZE, CLONE_VM | SIGCHLD, NULL);
+        break;
+    default:
+        break;
+    }
+
+    *call_ns = now_ns() - t0;
+    return pid;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t pct(const uint64_t *sorted, int n, double p) {
+    int idx = (int)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+static unsigned long mem_available_mb(void) {
+    proc_file_t f;
+    proc_file_init(&f);
+    unsigned long kb = 0;
+    if (proc_file_load(&f, "/proc/meminfo") == 0) {
+        const char *p = memmem(f.buf, f.len, "MemAvailable:", 13);
+        if (p) kb = strtoul(p + 13, NULL, 10);
+    }
+    proc_file_free(&f);
+    return kb / 1024;
+}
+
+// Mide cada primitiva con el RSS actual del padre
+static void bench_primitives(int iters, uint64_t *call, uint64_t *total) {
+    for (int p = 0; p < PRIM_COUNT; p++) {
+        for (int i = 0; i < iters; i++) {
+            uint64_t t0 = now_ns();
+            pid_t pid = create_child((primitive_t)p, &call[i]);
+            if (pid > 0) waitpid(pid, NULL, 0);
+            total[i] = now_ns() - t0;
+        }
+        qsort(call, (size_t)iters, sizeof(*call), cmp_u64);
+        qsort(total, (size_t)iters, sizeof(*total), cmp_u64);
+        printf("    %-16s %9.1f %9.1f %9.1f %9.1f   %9.1f %9.1f\n", prim_names[p],
+               pct(call, iters, 0.50) / 1e3, pct(call, iters, 0.90) / 1e3,
+               pct(call, iters, 0.99) / 1e3, call[iters - 1] / 1e3,
+               pct(total, iters, 0.50) / 1e3, pct(total, iters, 0.99) / 1e3);
+    }
+}
+
+// fork() con el hijo vivo y escritura de una muestra de páginas en el padre
+static void bench_first_touch(volatile char *mem, size_t len, long page) {
+    size_t npages = len / (size_t)page;
+    size_t step = npages > TOUCH_MAX_PAGES ? npages / TOUCH_MAX_PAGES : 1;
+    size_t touched = 0;
+
+    pid_t child = fork();
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+    if (child < 0) return;
+
+    struct rusage r0, r1;
+    getrusage(RUSAGE_SELF, &r0);
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < npages; i += step) {
+        mem[i * (size_t)page] ^= 1;
+        touched++;
+    }
+    uint64_t dt = now_ns() - t0;
+    getrusage(RUSAGE_SELF, &r1);
+
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+
+    long faults = r1.ru_minflt - r0.ru_minflt;
+    printf("    primera escritura tras fork: %zu págs, %.0f ns/pág, %.2f minflt/pág\n",
+           touched, (double)dt / (double)touched, (double)faults / (double)touched);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long max_mb = argc > 1 ? strtoul(argv[1], NULL, 10) : 8192;
+    int iters = argc > 2 ? atoi(argv[2]) : 200;
+    if (iters < 2) iters = 2;
+
+    static const unsigned long sizes_mb[] = { 1, 16, 256, 1024, 8192 };
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned long avail = mem_available_mb();
+
+    clone_stack = malloc(CLONE_STACK_SIZE);
+    uint64_t *call = malloc((size_t)iters * sizeof(uint64_t));
+    uint64_t *total = malloc((size_t)iters * sizeof(uint64_t));
+    if (!clone_stack || !call || !total) return 1;
+
+    printf("%s=== BENCHMARK DE CREACIÓN DE PROCESOS (PID %d) ===%s\n", COLOR_BOLD, get_tgid(), COLOR_RESET);
+    printf("MemAvailable: %lu MB, iteraciones: %d\n", avail, iters);
+
+    for (size_t s = 0; s < sizeof(sizes_mb) / sizeof(sizes_mb[0]); s++) {
+        unsigned long mb = sizes_mb[s];
+        if (mb > max_mb) break;
+        if (mb > avail / 2) {
+            printf("\n%s%lu MB: omitido (MemAvailable insuficiente)%s\n", COLOR_YELLOW, mb, COLOR_RESET);
+            continue;
+        }
+        size_t len = mb << 20;
+
+        for (int thp = 0; thp <= 1; thp++) {
+            volatile char *mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) {
+                perror("mmap");
+                continue;
+            }
+            madvise((void *)mem, len, thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+            memset((void *)mem, 1, len);  // RSS real: todas las páginas presentes
+
+            // Las tablas de páginas crecen con el RSS: menos iteraciones para tamaños grandes
+            int n = mb >= 1024 ? (iters / 10 > 2 ? iters / 10 : 2) : iters;
+
+            printf("\n%sRSS extra %lu MB, %s%s\n", COLOR_CYAN, mb,
+                   thp ? "MADV_HUGEPAGE (THP)" : "MADV_NOHUGEPAGE (4 KB)", COLOR_RESET);
+            printf("    %-16s %9s %9s %9s %9s   %9s %9s\n", "primitiva",
+                   "p50 µs", "p90 µs", "p99 µs", "max µs", "i+v p50", "i+v p99");
+            bench_primitives(n, call, total);
+            bench_first_touch(mem, len, page);
+
+            munmap((void *)mem, len);
+        }
+    }
+
+    free(call);
+    free(total);
+    free(clone_stack);
+    return 0;
+}
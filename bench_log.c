@@ -0,0 +1,152 @@
+// bench_log.c - Coste por línea: print_timestamp + printf vs logger asíncrono
+//
+// Uso: ./bench_log [líneas] [threads]
+//   ráfaga:    lotes de 256 líneas que caben en el anillo (el vaciado queda
+//              fuera de la medición) → coste del camino caliente
+//   sostenido: todas las líneas seguidas, tiempo de pared total / líneas
+//              (incluye el trabajo del flusher y el vaciado final)
+//   Todo se escribe en /dev/null. Para el logger también se cuentan los
+//   write() hechos y las esperas por anillo lleno.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "async_log.h"
+
+#define BURST 256
+
+typedef enum { OUT_PRINTF, OUT_ALOG } out_kind_t;
+
+static FILE *null_fp;
+static pthread_barrier_t barrier;
+
+// Misma forma que las líneas de proc_analysis: timestamp + 3 argumentos
+static inline void one_line(out_kind_t kind, long i) {
+    if (kind == OUT_PRINTF) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        fprintf(null_fp, "[%ld.%03ld] ", ts.tv_sec % 1000, ts.tv_nsec / 1000000);
+        fprintf(null_fp, "%s línea %ld de %s%s\n", COLOR_GREEN, i, "THREAD", COLOR_RESET);
+    } else {
+        alog_timestamp("");
+        alog_printf("%s línea %ld de %s%s\n", COLOR_GREEN, i, "THREAD", COLOR_RESET);
+    }
+}
+
+typedef struct {
+    out_kind_t kind;
+    long lines;
+    int burst;
+    uint64_t ns;        // ráfaga: tiempo medido dentro de este thread
+} worker_arg_t;
+
+static void *worker(void *arg) {
+    worker_arg_t *w = arg;
+    w->ns = 0;
+    pthread_barrier_wait(&barrier);
+    if (!w->burst) {
+        for (long i = 0; i < w->lines; i++) one_line(w->kind, i);
+    } else {
+        for (long done = 0; done < w->lines; done += BURST) {
+            long n = w->lines - done < BURST ? w->lines - done : BURST;
+            uint64_t t0 = now_ns();
+            for (long i = 0; i < n; i++) one_line(w->kind, done + i);
+            w->ns += now_ns() - t0;
+            if (w->kind == OUT_ALOG) alog_sync();
+        }
+    }
+    pthread_barrier_wait(&barrier);
+    return NULL;
+}
+
+// Ráfaga: suma de lo medido en cada thread / líneas. Sostenido: pared / líneas
+// (con 1 CPU la suma por thread contaría también el tiempo de los demás).
+static double run(out_kind_t kind, long lines, int nthreads, int burst) {
+    pthread_t th[64];
+    worker_arg_t args[64];
+    uint64_t t0 = now_ns();
+    pthread_barrier_init(&barrier, NULL, (unsigned)nthreads);
+    for (int t = 0; t < nthreads; t++) {
+        args[t].kind = kind;
+        args[t].lines = lines / nthreads;
+        args[t].burst = burst;
+        if (t > 0) pthread_create(&th[t], NULL, worker, &args[t]);
+    }
+    worker(&args[0]);
+    for (int t = 1; t < nthreads; t++) pthread_join(th[t], NULL);
+    pthread_barrier_destroy(&barrier);
+    if (kind == OUT_PRINTF) fflush(null_fp);
+    else alog_sync();
+    uint64_t wall = now_ns() - t0;
+
+    uint64_t ns = 0;
+    long done = 0;
+    for (int t = 0; t < nthreads; t++) {
+        ns += args[t].ns;
+        done += args[t].lines;
+    }
+    return (double)(burst ? ns : wall) / (double)done;
+}
+
+int main(int argc, char *argv[]) {
+    long lines = argc > 1 ? atol(argv[1]) : 1000000;
+    int maxthreads = argc > 2 ? atoi(argv[2]) : 4;
+    if (lines < BURST) lines = BURST;
+    if (maxthreads < 1) maxthreads = 1;
+    if (maxthreads > 64) maxthreads = 64;
+
+    null_fp = fopen("/dev/null", "w");
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (!null_fp || null_fd < 0) {
+        perror("/dev/null");
+        return 1;
+    }
+
+    printf("%s=== BENCHMARK DEL LOGGER (%ld líneas → /dev/null) ===%s\n", COLOR_BOLD, lines, COLOR_RESET);
+    printf("  %-28s %8s %12s %12s %10s %8s\n", "salida", "threads", "ráfaga ns", "sostenido ns", "líneas/write", "esperas");
+
+    static const struct {
+        const char *name;
+        out_kind_t kind;
+        alog_mode_t mode;
+        alog_clock_t clock;
+    } cases[] = {
+        { "print_timestamp + printf", OUT_PRINTF, ALOG_TEXT, ALOG_CLOCK_MONO },
+        { "alog texto (TSC)", OUT_ALOG, ALOG_TEXT, ALOG_CLOCK_TSC },
+        { "alog texto (MONOTONIC)", OUT_ALOG, ALOG_TEXT, ALOG_CLOCK_MONO },
+        { "alog texto (MONOTONIC_COARSE)", OUT_ALOG, ALOG_TEXT, ALOG_CLOCK_COARSE },
+        { "alog binario (TSC)", OUT_ALOG, ALOG_BINARY, ALOG_CLOCK_TSC },
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int nt = 1; nt <= maxthreads; nt *= 2) {
+            uint64_t r0 = 0, w0 = 0, s0 = 0, r1 = 0, w1 = 0, s1 = 0;
+            if (cases[c].kind == OUT_ALOG) {
+                alog_init(cases[c].mode, null_fd, cases[c].clock);
+                alog_stats(&r0, &w0, &s0);
+            }
+            double burst_ns = run(cases[c].kind, lines, nt, 1);
+            if (cases[c].kind == OUT_ALOG) alog_stats(&r0, &w0, &s0);
+            double sust_ns = run(cases[c].kind, lines, nt, 0);
+
+            if (cases[c].kind == OUT_ALOG) {
+                alog_stats(&r1, &w1, &s1);
+                alog_shutdown();
+                printf("  %-28s %8d %12.1f %12.1f %10.0f %8lu\n", cases[c].name, nt, burst_ns, sust_ns,
+                       w1 > w0 ? (double)(r1 - r0) / (double)(w1 - w0) : 0.0, (unsigned long)(s1 - s0));
+            } else {
+                printf("  %-28s %8d %12.1f %12.1f %10s %8s\n", cases[c].name, nt, burst_ns, sust_ns, "-", "-");
+            }
+        }
+    }
+
+    fclose(null_fp);
+    close(null_fd);
+    return 0;
+}
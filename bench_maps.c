@@ -0,0 +1,121 @@
+// bench_maps.c - Microbenchmark del parser de maps sobre un archivo sintético
+//
+// Uso: ./bench_maps [lineas] [busquedas]
+//   Genera /tmp/bench_maps.<pid> con N líneas (por defecto 100000), lo parsea
+//   con proc_maps y con el patrón antiguo fgets+sscanf, y mide el
+//   coste de "¿qué región contiene la dirección X?" en ambos casos.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_maps.h"
+
+#define PAGE 4096ul
+
+// Genera un maps con huecos entre regiones y rutas de longitud variable
+static int generate_maps(const char *path, size_t lines, uintptr_t *base_out) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+
+    uintptr_t addr = 0x7f0000000000ul;
+    *base_out = addr;
+    for (size_t i = 0; i < lines; i++) {
+        uintptr_t len = PAGE * (1 + (i % 16));
+        const char *perms = (i % 3 == 0) ? "r-xp" : (i % 3 == 1) ? "r--p" : "rw-p";
+        if (i % 4 == 0) {
+            fprintf(fp, "%lx-%lx %s 00000000 00:00 0 \n",
+                    (unsigned long)addr, (unsigned long)(addr + len), perms);
+        } else {
+            fprintf(fp, "%lx-%lx %s %08lx fd:01 %zu                       "
+                        "/opt/app/lib/very/long/path/component/libmodule_%zu.so\n",
+                    (unsigned long)addr, (unsigned long)(addr + len), perms,
+                    (unsigned long)(i * PAGE), 1000000 + i, i);
+        }
+        addr += len + PAGE;  // hueco de una página
+    }
+    fclose(fp);
+    return 0;
+}
+
+// El patrón antiguo: un recorrido completo con fgets+sscanf por cada búsqueda
+static int legacy_find(const char *path, uintptr_t target) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx", &start, &end) == 2 && target >= start && target < end) {
+            found = 1;
+            break;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t queries = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    size_t legacy_queries = 20;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench_maps.%d", getpid());
+    uintptr_t base;
+    if (generate_maps(path, lines, &base) < 0) {
+        perror("generando maps sintético");
+        return 1;
+    }
+
+    printf("%s=== BENCHMARK DEL PARSER DE MAPS (%zu líneas) ===%s\n\n", COLOR_BOLD, lines, COLOR_RESET);
+
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+
+    // Primera carga (reserva buffers) y cargas siguientes (reutilizan)
+    uint64_t t0 = now_ns();
+    if (proc_maps_load_path(&maps, path) < 0) {
+        perror("proc_maps_load_path");
+        return 1;
+    }
+    uint64_t first_ns = now_ns() - t0;
+
+    int reloads = 10;
+    t0 = now_ns();
+    for (int i = 0; i < reloads; i++) proc_maps_load_path(&maps, path);
+    uint64_t reload_ns = (now_ns() - t0) / (uint64_t)reloads;
+
+    uintptr_t span = maps.regions[maps.nregions - 1].end - base;
+    uint64_t seed = 88172645463325252ull;
+    size_t hits = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;  // xorshift64
+        if (proc_maps_find(&maps, base + (uintptr_t)(seed % span))) hits++;
+    }
+    uint64_t find_ns = now_ns() - t0;
+
+    size_t legacy_hits = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < legacy_queries; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        legacy_hits += (size_t)legacy_find(path, base + (uintptr_t)(seed % span));
+    }
+    uint64_t legacy_ns = now_ns() - t0;
+
+    printf("  Regiones parseadas:            %zu\n", maps.nregions);
+    printf("  Carga inicial:                 %8.2f ms\n", first_ns / 1e6);
+    printf("  Recarga (buffers reutilizados):%8.2f ms\n", reload_ns / 1e6);
+    printf("  Búsqueda indexada:             %8.1f ns/consulta (%zu consultas, %zu aciertos)\n",
+           (double)find_ns / (double)queries, queries, hits);
+    printf("  Búsqueda fgets+sscanf:         %8.0f ns/consulta (%zu consultas, %zu aciertos)\n",
+           (double)legacy_ns / (double)legacy_queries, legacy_queries, legacy_hits);
+
+    proc_maps_free(&maps);
+    unlink(path);
+    return 0;
+}
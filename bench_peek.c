@@ -0,0 +1,109 @@
+// bench_peek.c - Leer variables de otro proceso: process_vm_readv en lote vs alternativas
+//
+// Uso: ./bench_peek [variables] [rondas]
+//   El hijo (fork) comparte direcciones con el padre, así que las variables se
+//   leen en las mismas direcciones de un array global. Compara:
+//     - peek_read: un process_vm_readv para todas
+//     - un process_vm_readv por variable
+//     - pread de /proc/<pid>/mem por variable
+//     - PTRACE_ATTACH + espera + DETACH (lo que paga gdb -p solo por engancharse)
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_peek.h"
+
+#define MAX_VARS 1024
+
+static long vars[MAX_VARS];
+
+static void report(const char *name, uint64_t ns, int rounds, int nvars) {
+    printf("  %-34s %9.2f µs/ronda  (%6.0f ns/variable)\n", name,
+           ns / 1e3 / rounds, (double)ns / rounds / nvars);
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 64;
+    int rounds = argc > 2 ? atoi(argv[2]) : 2000;
+    if (n <= 0) n = 1;
+    if (n > MAX_VARS) n = MAX_VARS;
+    if (rounds <= 0) rounds = 1;
+
+    for (int i = 0; i < n; i++) vars[i] = i;
+    pid_t child = fork();
+    if (child == 0) {
+        for (;;) {
+            for (int i = 0; i < MAX_VARS; i++) vars[i]++;
+            usleep(1000);
+        }
+    }
+    if (child < 0) return 1;
+
+    printf("%s=== BENCHMARK DE LECTURA REMOTA (%d variables, %d rondas) ===%s\n",
+           COLOR_BOLD, n, rounds, COLOR_RESET);
+
+    peek_t p;
+    peek_init(&p, child);
+    for (int i = 0; i < n; i++) peek_add(&p, "v", (uintptr_t)&vars[i], sizeof(long), 0);
+    uint64_t t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        if (peek_read(&p) != n) {
+            printf("  %sprocess_vm_readv falló (¿ptrace_scope?)%s\n", COLOR_RED, COLOR_RESET);
+            break;
+        }
+    }
+    report("process_vm_readv en lote", now_ns() - t0, rounds, n);
+
+    long v;
+    t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < n; i++) {
+            struct iovec l = { &v, sizeof(v) }, rm = { &vars[i], sizeof(v) };
+            process_vm_readv(child, &l, 1, &rm, 1, 0);
+        }
+    }
+    report("process_vm_readv por variable", now_ns() - t0, rounds, n);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/mem", child);
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        t0 = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < n; i++) pread(fd, &v, sizeof(v), (off_t)(uintptr_t)&vars[i]);
+        }
+        report("pread /proc/pid/mem por variable", now_ns() - t0, rounds, n);
+        close(fd);
+    }
+
+    // Engancharse con ptrace detiene al proceso entero hasta el DETACH
+    int attaches = rounds < 200 ? rounds : 200;
+    uint64_t stopped = 0;
+    int done = 0;
+    for (int r = 0; r < attaches; r++) {
+        t0 = now_ns();
+        if (ptrace(PTRACE_ATTACH, child, NULL, NULL) < 0) break;
+        waitpid(child, NULL, 0);
+        ptrace(PTRACE_DETACH, child, NULL, NULL);
+        stopped += now_ns() - t0;
+        done++;
+    }
+    if (done) {
+        printf("  %-34s %9.2f µs con el proceso parado (sin contar gdb cargando símbolos)\n",
+               "ptrace attach + detach", stopped / 1e3 / done);
+    }
+
+    peek_free(&p);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// bench_scan.c - Escalado del escaneo del host con 1→N workers
+//
+// Uso: ./bench_scan [max_workers] [repeticiones]
+//   Por defecto max_workers = número de CPUs. Para cada tamaño de pool se
+//   crea el pool una vez y se repite el escaneo (el caso "cada segundo").
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_scan.h"
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char *argv[]) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned max_workers = argc > 1 ? (unsigned)atoi(argv[1]) : (unsigned)(ncpu > 0 ? ncpu : 1);
+    unsigned reps = argc > 2 ? (unsigned)atoi(argv[2]) : 20;
+    if (max_workers == 0) max_workers = 1;
+    if (reps == 0) reps = 1;
+
+    uint64_t *samples = malloc(reps * sizeof(*samples));
+    if (!samples) return 1;
+
+    printf("%s=== ESCALADO DEL ESCANEO DE /proc (%ld CPUs) ===%s\n\n", COLOR_BOLD, ncpu, COLOR_RESET);
+    printf("  %8s %10s %10s %10s %10s\n", "workers", "procesos", "p50 (ms)", "min (ms)", "speedup");
+
+    double base_ms = 0;
+    // 1, 2, 4, ... y siempre max_workers como último punto
+    for (unsigned w = 1; ; w = w * 2 < max_workers ? w * 2 : max_workers) {
+        proc_scanner_t s;
+        if (proc_scanner_init(&s, w) < 0) {
+            fprintf(stderr, "❌ No se pudo crear el pool con %u workers\n", w);
+            break;
+        }
+        proc_scanner_run(&s);  // calentamiento: buffers y dentries
+
+        for (unsigned r = 0; r < reps; r++) {
+            uint64_t t0 = now_ns();
+            proc_scanner_run(&s);
+            samples[r] = now_ns() - t0;
+        }
+        qsort(samples, reps, sizeof(*samples), cmp_u64);
+
+        double p50 = samples[reps / 2] / 1e6;
+        if (w == 1) base_ms = p50;
+        printf("  %8u %10zu %10.2f %10.2f %9.2fx\n",
+               s.nworkers, s.nentries, p50, samples[0] / 1e6, base_ms / p50);
+        proc_scanner_free(&s);
+
+        if (w == max_workers) break;
+    }
+
+    free(samples);
+    return 0;
+}
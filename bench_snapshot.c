@@ -0,0 +1,69 @@
+// bench_snapshot.c - Coste por snapshot: motor proc_snapshot vs system("cat|grep; ps|grep; pstree")
+//
+// Uso: ./bench_snapshot [pid] [iteraciones]
+//   Sin pid se usa el propio proceso (con 4 threads extra para que haya task/*).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+
+static void *idle_thread(void *arg) {
+    (void)arg;
+    pause();
+    return NULL;
+}
+
+// El camino antiguo de proc_analysis.c, con la salida descartada
+static void system_path(pid_t pid) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+             "{ cat /proc/%d/status | grep -E '^(Pid|Tgid|PPid|Threads|State|VmSize|VmRSS):'; "
+             "ps -eLf | grep -E \"(%d)\" | head -15; "
+             "pstree -p %d; } >/dev/null 2>&1",
+             pid, pid, pid);
+    if (system(cmd) < 0) perror("system");
+}
+
+int main(int argc, char *argv[]) {
+    pid_t pid = argc > 1 ? (pid_t)atoi(argv[1]) : get_tgid();
+    int iters = argc > 2 ? atoi(argv[2]) : 1000;
+    int sys_iters = iters / 50 > 0 ? iters / 50 : 1;  // el camino system() es mucho más lento
+
+    pthread_t extra[4];
+    if (argc <= 1) {
+        for (int i = 0; i < 4; i++) pthread_create(&extra[i], NULL, idle_thread, NULL);
+    }
+
+    printf("%s=== BENCHMARK DE SNAPSHOT DE /proc (PID %d) ===%s\n\n", COLOR_BOLD, pid, COLOR_RESET);
+
+    proc_snapshot_t snap;
+    if (proc_snapshot_init(&snap, pid) < 0 || proc_snapshot_take(&snap) < 0) {
+        fprintf(stderr, "❌ No se pudo leer /proc/%d\n", pid);
+        return 1;
+    }
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++) proc_snapshot_take(&snap);
+    uint64_t native_ns = (now_ns() - t0) / (uint64_t)iters;
+
+    t0 = now_ns();
+    for (int i = 0; i < sys_iters; i++) system_path(pid);
+    uint64_t system_ns = (now_ns() - t0) / (uint64_t)sys_iters;
+
+    printf("  Procesos en el árbol:  %zu\n", snap.nnodes);
+    printf("  Threads en el árbol:   %zu\n\n", snap.nthreads);
+    printf("  %-28s %12s %10s\n", "Camino", "ns/snapshot", "iter");
+    printf("  %-28s %12llu %10d\n", "proc_snapshot (pread)", (unsigned long long)native_ns, iters);
+    printf("  %-28s %12llu %10d\n", "system(cat|grep, ps, pstree)", (unsigned long long)system_ns, sys_iters);
+    if (native_ns > 0) {
+        printf("\n  %sAceleración: %.1fx%s\n", COLOR_GREEN, (double)system_ns / (double)native_ns, COLOR_RESET);
+    }
+
+    proc_snapshot_free(&snap);
+    return 0;
+}
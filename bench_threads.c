@@ -0,0 +1,256 @@
+// bench_threads.c - Coste de crear/terminar threads y overhead por tarea del pool
+//
+// Uso: ./bench_threads [max_threads] [tareas]
+//   1. pthread_create + pthread_join con 2 → max_threads (por defecto 10000)
+//   2. Tamaño de stack y guard page (1024 threads)
+//   3. Parada: pthread_cancel sobre pause() vs parada cooperativa con futex
+//   4. thread_pool: ns por tarea enviada desde fuera y desde un worker
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+#include "proc_common.h"
+#include "thread_pool.h"
+
+static atomic_int ready_count;
+static atomic_uint stop_word;
+
+static void *empty_thread(void *arg) {
+    (void)arg;
+    return NULL;
+}
+
+static void *pause_thread(void *arg) {
+    (void)arg;
+    atomic_fetch_add(&ready_count, 1);
+    for (;;) pause();  // punto de cancelación
+    return NULL;
+}
+
+static void *futex_thread(void *arg) {
+    (void)arg;
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load(&stop_word)) {
+        syscall(SYS_futex, &stop_word, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+    }
+    return NULL;
+}
+
+// ========== 1 y 2: CREACIÓN / JOIN ==========
+
+// Crea n threads con attr y los une. Devuelve cuántos se crearon.
+static int create_join(pthread_t *th, int n, pthread_attr_t *attr, uint64_t *create_ns, uint64_t *join_ns) {
+    int created = 0;
+    uint64_t t0 = now_ns();
+    for (; created < n; created++) {
+        if (pthread_create(&th[created], attr, empty_thread, NULL) != 0) break;
+    }
+    uint64_t t1 = now_ns();
+    for (int i = 0; i < created; i++) pthread_join(th[i], NULL);
+    uint64_t t2 = now_ns();
+    *create_ns = t1 - t0;
+    *join_ns = t2 - t1;
+    return created;
+}
+
+static void bench_create_join(pthread_t *th, int max_threads) {
+    printf("\n%s1. pthread_create + pthread_join (attr por defecto)%s\n", COLOR_BOLD, COLOR_RESET);
+    printf("  %8s %10s %14s %14s\n", "threads", "creados", "create ns/th", "join ns/th");
+    for (int n = 2; ; n = n * 8 < max_threads ? n * 8 : max_threads) {
+        uint64_t c, j;
+        int created = create_join(th, n, NULL, &c, &j);
+        if (created > 0) {
+            printf("  %8d %10d %14.0f %14.0f\n", n, created, (double)c / created, (double)j / created);
+        }
+        if (n == max_threads) break;
+    }
+}
+
+static void bench_stack_guard(pthread_t *th) {
+    static const size_t stacks[] = { 16 << 10, 64 << 10, 256 << 10, 1 << 20, 8 << 20 };
+    static const size_t guards[] = { 0, 4 << 10, 64 << 10 };
+    const int n = 1024;
+
+    printf("\n%s2. Tamaño de stack y guard page (%d threads)%s\n", COLOR_BOLD, n, COLOR_RESET);
+    printf("  %10s %8s %14s %14s\n", "stack", "guard", "create ns/th", "join ns/th");
+    for (size_t s = 0; s < sizeof(stacks) / sizeof(stacks[0]); s++) {
+        for (size_t g = 0; g < sizeof(guards) / sizeof(guards[0]); g++) {
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_setstacksize(&attr, stacks[s]);
+            pthread_attr_setguardsize(&attr, guards[g]);
+            uint64_t c, j;
+            int created = create_join(th, n, &attr, &c, &j);
+            pthread_attr_destroy(&attr);
+            if (created > 0) {
+                printf("  %8zuKB %6zuKB %14.0f %14.0f\n", stacks[s] >> 10, guards[g] >> 10,
+                       (double)c / created, (double)j / created);
+            }
+        }
+    }
+}
+
+// ========== 3: PARADA ==========
+
+static int start_waiters(pthread_t *th, int n, void *(*fn)(void *)) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 64 << 10);
+    atomic_store(&ready_count, 0);
+    atomic_store(&stop_word, 0);
+
+    int created = 0;
+    for (; created < n; created++) {
+        if (pthread_create(&th[created], &attr, fn, NULL) != 0) break;
+    }
+    pthread_attr_destroy(&attr);
+    while (atomic_load(&ready_count) < created) sched_yield();
+    usleep(10000);  // que todos lleguen a bloquearse
+    return created;
+}
+
+static void bench_shutdown(pthread_t *th, int max_threads) {
+    printf("\n%s3. Parada: pthread_cancel vs cooperativa (futex)%s\n", COLOR_BOLD, COLOR_RESET);
+    printf("  %8s %16s %16s\n", "threads", "cancel µs", "futex µs");
+    for (int n = 2; ; n = n * 8 < max_threads ? n * 8 : max_threads) {
+        int created = start_waiters(th, n, pause_thread);
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < created; i++) pthread_cancel(th[i]);
+        for (int i = 0; i < created; i++) pthread_join(th[i], NULL);
+        uint64_t cancel_ns = now_ns() - t0;
+
+        created = start_waiters(th, n, futex_thread);
+        t0 = now_ns();
+        atomic_store(&stop_word, 1);
+        syscall(SYS_futex, &stop_word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+        for (int i = 0; i < created; i++) pthread_join(th[i], NULL);
+        uint64_t futex_ns = now_ns() - t0;
+
+        printf("  %8d %16.1f %16.1f\n", created, cancel_ns / 1e3, futex_ns / 1e3);
+        if (n == max_threads) break;
+    }
+}
+
+// ========== 4: POOL ==========
+
+static atomic_long task_counter;
+
+static void empty_task(void *arg) {
+    (void)arg;
+    atomic_fetch_add_explicit(&task_counter, 1, memory_order_relaxed);
+}
+
+typedef struct {
+    thread_pool_t *pool;
+    tp_task_t *children;
+    long n;
+} fanout_t;
+
+// Tarea raíz que envía n hijas desde dentro del pool (van a su propia deque)
+static void fanout_task(void *arg) {
+    fanout_t *f = arg;
+    for (long i = 0; i < f->n; i++) thread_pool_submit(f->pool, &f->children[i]);
+}
+
+static void bench_pool(long ntasks) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned workers = ncpu > 0 ? (unsigned)ncpu : 1;
+    tp_task_t *tasks = malloc((size_t)ntasks * sizeof(*tasks));
+    if (!tasks) return;
+    for (long i = 0; i < ntasks; i++) {
+        tasks[i].fn = empty_task;
+        tasks[i].arg = NULL;
+    }
+
+    thread_pool_t pool;
+    if (thread_pool_init(&pool, workers, "BENCH") < 0) {
+        free(tasks);
+        return;
+    }
+
+    printf("\n%s4. thread_pool (%u workers, %ld tareas vacías)%s\n", COLOR_BOLD, workers, ntasks, COLOR_RESET);
+
+    // Desde fuera: por lotes que caben en la inbox
+    atomic_store(&task_counter, 0);
+    uint64_t t0 = now_ns();
+    for (long done = 0; done < ntasks; ) {
+        long batch = ntasks - done < TP_INBOX_CAP / 2 ? ntasks - done : TP_INBOX_CAP / 2;
+        for (long i = 0; i < batch; i++) thread_pool_submit(&pool, &tasks[done + i]);
+        thread_pool_wait(&pool);
+        done += batch;
+    }
+    uint64_t ext_ns = now_ns() - t0;
+
+    // Desde un worker: una tarea raíz reparte las demás (push a su deque + robo)
+    atomic_store(&task_counter, 0);
+    long per_root = TP_DEQUE_CAP / 2;
+    long roots = (ntasks + per_root - 1) / per_root;
+    fanout_t *fans = malloc((size_t)roots * sizeof(*fans));
+    tp_task_t *root_tasks = malloc((size_t)roots * sizeof(*root_tasks));
+    if (!fans || !root_tasks) {
+        free(fans);
+        free(root_tasks);
+        thread_pool_shutdown(&pool);
+        free(tasks);
+        return;
+    }
+    t0 = now_ns();
+    for (long r = 0; r < roots; r++) {
+        long first = r * per_root;
+        fans[r].pool = &pool;
+        fans[r].children = &tasks[first];
+        fans[r].n = ntasks - first < per_root ? ntasks - first : per_root;
+        root_tasks[r].fn = fanout_task;
+        root_tasks[r].arg = &fans[r];
+        thread_pool_submit(&pool, &root_tasks[r]);
+        if ((r + 1) % 8 == 0) thread_pool_wait(&pool);  // acotar lo que hay en vuelo
+    }
+    thread_pool_wait(&pool);
+    uint64_t int_ns = now_ns() - t0;
+
+    printf("  envío externo (inbox MPMC):   %7.1f ns/tarea  (%ld ejecutadas)\n",
+           (double)ext_ns / (double)ntasks, ntasks);
+    printf("  envío interno (deque propia): %7.1f ns/tarea  (%ld ejecutadas)\n",
+           (double)int_ns / (double)ntasks, atomic_load(&task_counter));
+
+    t0 = now_ns();
+    thread_pool_shutdown(&pool);
+    printf("  parada cooperativa del pool:  %7.1f µs\n", (now_ns() - t0) / 1e3);
+
+    free(fans);
+    free(root_tasks);
+    free(tasks);
+}
+
+int main(int argc, char *argv[]) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 10000;
+    long ntasks = argc > 2 ? atol(argv[2]) : 1000000;
+    if (max_threads < 2) max_threads = 2;
+    if (ntasks < 1) ntasks = 1;
+
+    pthread_t *th = malloc((size_t)max_threads * sizeof(*th));
+    if (!th) return 1;
+
+    struct rlimit rl;
+    getrlimit(RLIMIT_NPROC, &rl);
+    printf("%s=== BENCHMARK DE THREADS (PID %d, RLIMIT_NPROC=%ld) ===%s\n",
+           COLOR_BOLD, get_tgid(), (long)rl.rlim_cur, COLOR_RESET);
+
+    bench_create_join(th, max_threads);
+    bench_stack_guard(th);
+    bench_shutdown(th, max_threads);
+    bench_pool(ntasks);
+
+    free(th);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// lat_hist.c - Histograma de latencias log-lineal (estilo HDR) en nanosegundos
+//
+// Registrar es un incremento en un array fijo: sin ordenar ni guardar las
+// muestras, así que sirve igual para mil que para mil millones de medidas y
+// los percentiles altos (p99.99) salen con la misma precisión relativa.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lat_hist.h"
+
+void lat_hist_init(lat_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void lat_hist_merge(lat_hist_t *dst, const lat_hist_t *src) {
+    if (src->count == 0) return;
+    for (unsigned i = 0; i < LH_BUCKETS; i++) dst->buckets[i] += src->buckets[i];
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+// Mayor valor que cae en la cubeta idx
+static uint64_t bucket_upper(unsigned idx) {
+    if (idx < LH_SUB) return idx;
+    unsigned group = idx / LH_SUB;
+    uint64_t base = (uint64_t)(LH_SUB + idx % LH_SUB) << (group - 1);
+    return base + ((1ull << (group - 1)) - 1);
+}
+
+uint64_t lat_hist_percentile(const lat_hist_t *h, double p) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->count + 0.5);
+    if (rank == 0) rank = 1;
+    if (rank >= h->count) return h->max;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < LH_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t v = bucket_upper(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+int lat_format_ns(uint64_t ns, char *buf, size_t len) {
+    if (ns < 1000) return snprintf(buf, len, "%lu ns", (unsigned long)ns);
+    if (ns < 1000000) return snprintf(buf, len, "%.1f µs", ns / 1e3);
+    if (ns < 1000000000) return snprintf(buf, len, "%.2f ms", ns / 1e6);
+    return snprintf(buf, len, "%.2f s", ns / 1e9);
+}
+
+int lat_hist_format(const lat_hist_t *h, char *buf, size_t len) {
+    static const struct { const char *name; double p; } pct[] = {
+        { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "p99.9", 99.9 }, { "p99.99", 99.99 },
+    };
+    size_t off = 0;
+    char v[24];
+    buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(pct) / sizeof(pct[0]) && off + 1 < len; i++) {
+        lat_format_ns(lat_hist_percentile(h, pct[i].p), v, sizeof(v));
+        int w = snprintf(buf + off, len - off, "%s%s %s", off ? "  " : "", pct[i].name, v);
+        if (w < 0 || (size_t)w >= len - off) return (int)off;
+        off += (size_t)w;
+    }
+    lat_format_ns(h->max, v, sizeof(v));
+    int w = snprintf(buf + off, len - off, "  máx %s", v);
+    if (w > 0 && (size_t)w < len - off) off += (size_t)w;
+    return (int)off;
+}
@@ -0,0 +1,53 @@
+// lat_hist.h - Histograma de latencias log-lineal (estilo HDR) en nanosegundos
+#ifndef LAT_HIST_H
+#define LAT_HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Cada potencia de 2 se divide en 2^LH_SUB_BITS cubetas lineales: error
+// relativo < 1/128 en cualquier rango. Valores hasta 2^LH_MAX_BITS ns (~18 min).
+#define LH_SUB_BITS  7
+#define LH_SUB       (1u << LH_SUB_BITS)
+#define LH_MAX_BITS  40
+#define LH_BUCKETS   ((LH_MAX_BITS - LH_SUB_BITS + 1) * LH_SUB)
+
+typedef struct {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t buckets[LH_BUCKETS];
+} lat_hist_t;
+
+void lat_hist_init(lat_hist_t *h);
+
+static inline unsigned lat_hist_index(uint64_t v) {
+    if (v < LH_SUB) return (unsigned)v;
+    if (v >> LH_MAX_BITS) return LH_BUCKETS - 1;
+    unsigned msb = 63u - (unsigned)__builtin_clzll(v);
+    unsigned group = msb - LH_SUB_BITS + 1;
+    return group * LH_SUB + (unsigned)(v >> (msb - LH_SUB_BITS)) - LH_SUB;
+}
+
+// Sin atómicos: un histograma por thread y lat_hist_merge al final
+static inline void lat_hist_record(lat_hist_t *h, uint64_t ns) {
+    h->buckets[lat_hist_index(ns)]++;
+    if (h->count == 0 || ns < h->min) h->min = ns;
+    if (ns > h->max) h->max = ns;
+    h->count++;
+    h->sum += ns;
+}
+
+void     lat_hist_merge(lat_hist_t *dst, const lat_hist_t *src);
+
+// Valor (límite superior de su cubeta) por debajo del cual queda el p% de las muestras
+uint64_t lat_hist_percentile(const lat_hist_t *h, double p);
+
+// "p50 12.3 µs  p90 ...  p99.99 ...  máx ..." con unidades adaptadas
+int      lat_hist_format(const lat_hist_t *h, char *buf, size_t len);
+
+// "850 ns", "12.3 µs", "4.56 ms"
+int      lat_format_ns(uint64_t ns, char *buf, size_t len);
+
+#endif // LAT_HIST_H
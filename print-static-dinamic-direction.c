@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <unistd.h>
+
+#include "proc_maps.h"
+#include "proc_elf.h"
+#include "proc_stack.h"
 
 /* Variables globales inicializadas -> .data */
 int variable_data = 42;
@@ -21,6 +26,33 @@ extern char etext[], _etext[], __etext[];
 extern char edata[], _edata[];
 extern char end[], _end[];
 
+/* Busca la dirección en las secciones de /proc/self/exe y, si tiene nombre, en
+   la tabla de símbolos; devuelve 1 si todo cuadra con la sección esperada */
+static int comprobar(elf_file_t *elf, uintptr_t bias, const char *etiqueta, const char *simbolo,
+                     const void *dir, const char *esperada) {
+    uint64_t vaddr = (uintptr_t)dir - bias;
+    long sec = elf_section_at(elf, vaddr);
+    const char *seccion = sec >= 0 ? elf_section_name(elf, sec) : "(ninguna)";
+    int ok = strcmp(seccion, esperada) == 0;
+    
+    printf("   %-18s %p  %-8s", etiqueta, dir, seccion);
+    if (simbolo) {
+        const Elf64_Sym *sym = elf_find_symbol(elf, simbolo);
+        elf_symbol_info_t info;
+        if (sym) {
+            elf_symbol_info(elf, sym, bias, &info);
+            ok = ok && info.runtime == (uintptr_t)dir;
+            printf("  símbolo %s+%#lx → %#lx", info.section, (unsigned long)info.sec_offset,
+                   (unsigned long)info.runtime);
+        } else {
+            ok = 0;
+            printf("  (sin símbolo)");
+        }
+    }
+    printf("  %s\n", ok ? "✓" : "✗");
+    return ok;
+}
+
 void funcion_stack() {
     /* Variables locales -> stack/pila */
     int local_stack = 10;
@@ -34,6 +66,21 @@ void funcion_stack() {
     local_stack = 20;
     strcpy(array_stack, "Texto en stack");
     printf("  Array en stack: %s\n", array_stack);
+    
+    /* Tamaño del stack y cuánto se ha usado: páginas tocadas según pagemap */
+    proc_maps_t maps;
+    pagemap_t pm;
+    stack_usage_t su;
+    proc_maps_init(&maps);
+    int have_pm = pagemap_open(&pm, getpid()) == 0;
+    if (proc_maps_load(&maps, getpid()) == 0 &&
+        stack_usage_measure(getpid(), getpid(), &maps, have_pm ? &pm : NULL, &su) == 0) {
+        printf("  Stack [%#lx, %#lx): %zu KB mapeados, crece hasta %zu KB (RLIMIT_STACK)\n",
+               (unsigned long)su.lo, (unsigned long)su.hi, (su.hi - su.lo) >> 10, su.limit >> 10);
+        printf("  Marca de agua: %zu KB desde el tope (%zu KB residentes)\n", su.hwm >> 10, su.resident >> 10);
+    }
+    if (have_pm) pagemap_close(&pm);
+    proc_maps_free(&maps);
 }
 
 int main() {
@@ -99,9 +146,32 @@ int main() {
     printf("   buffer_bss:        %p (debería estar en .bss)\n\n", (void*)buffer_bss);
     
     printf("=== COMPROBACIÓN FINAL ===\n");
-    printf("1. Ejecuta: objdump -h example4 | grep -E '\\.data|\\.bss|\\.rodata'\n");
-    printf("2. Compara las direcciones impresas arriba con los rangos que muestra objdump\n");
-    printf("3. Todas deberían estar dentro de sus secciones correspondientes\n");
+    /* Sin objdump: secciones y símbolos de nuestro propio ejecutable, con el
+       desplazamiento de carga (PIE) sacado de /proc/self/maps */
+    proc_maps_t maps;
+    elf_file_t elf;
+    uintptr_t bias;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, getpid()) < 0 || elf_open_process(&elf, getpid(), &maps, &bias) < 0) {
+        printf("No se pudo leer /proc/self/exe; compara a mano con:\n");
+        printf("  objdump -h /proc/%d/exe | grep -E '\\.data|\\.bss|\\.rodata'\n", getpid());
+        proc_maps_free(&maps);
+        return 0;
+    }
+    printf("Ejecutable cargado en bias %#lx (%zu símbolos)\n", (unsigned long)bias, elf.nsyms);
+    
+    int bien = 0;
+    bien += comprobar(&elf, bias, "variable_data", "variable_data", &variable_data, ".data");
+    bien += comprobar(&elf, bias, "mensaje_data", "mensaje_data", mensaje_data, ".rodata");
+    bien += comprobar(&elf, bias, "constante_rodata", "constante_rodata", &constante_rodata, ".rodata");
+    bien += comprobar(&elf, bias, "*mensaje_rodata", NULL, mensaje_rodata, ".rodata");
+    bien += comprobar(&elf, bias, "&mensaje_rodata", "mensaje_rodata", &mensaje_rodata, ".data");
+    bien += comprobar(&elf, bias, "variable_bss", "variable_bss", &variable_bss, ".bss");
+    bien += comprobar(&elf, bias, "buffer_bss", "buffer_bss", buffer_bss, ".bss");
+    printf("%d de 7 direcciones dentro de su sección\n", bien);
+    
+    elf_close(&elf);
+    proc_maps_free(&maps);
     
     return 0;
 }
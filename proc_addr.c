@@ -0,0 +1,325 @@
+// proc_addr.c - Clasificación de direcciones de un proceso
+//
+// Se construye una vez por proceso un array ordenado de intervalos disjuntos:
+//   1. regiones de /proc/<pid>/maps (heap, stack, anónimas, ficheros, vdso)
+//   2. encima, las secciones del ejecutable: para este proceso con los
+//      símbolos del enlazador (__executable_start, etext, edata, end); para
+//      otros con las cabeceras de sección de /proc/<pid>/exe + bias de carga
+//   3. encima, los stacks: startstack de /proc/<pid>/stat para el principal y
+//      el SP de task/<tid>/syscall para cada thread (la región que lo contiene
+//      es su stack; la región ---p justo debajo, su guarda)
+// Después cada dirección es una búsqueda binaria en memoria, sin E/S.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_elf.h"
+#include "proc_addr.h"
+
+// Límites de secciones definidos por el enlazador
+extern char __executable_start[], etext[], __data_start[], edata[], __bss_start[], end[];
+
+static const char *class_names[ADDR_CLASS_COUNT] = {
+    [ADDR_UNMAPPED]     = "no mapeada",
+    [ADDR_TEXT]         = "código",
+    [ADDR_RODATA]       = "solo lectura",
+    [ADDR_DATA]         = "datos",
+    [ADDR_BSS]          = "bss",
+    [ADDR_HEAP]         = "heap",
+    [ADDR_STACK]        = "stack principal",
+    [ADDR_THREAD_STACK] = "stack de thread",
+    [ADDR_GUARD]        = "guarda de stack",
+    [ADDR_ANON]         = "mmap anónimo",
+    [ADDR_FILE]         = "fichero mapeado",
+    [ADDR_VDSO]         = "vdso",
+    [ADDR_OTHER]        = "otra",
+};
+
+const char *addr_class_name(addr_class_t cls) {
+    return cls < ADDR_CLASS_COUNT ? class_names[cls] : "?";
+}
+
+void addr_map_init(addr_map_t *m) {
+    memset(m, 0, sizeof(*m));
+    proc_maps_init(&m->maps);
+}
+
+void addr_map_free(addr_map_t *m) {
+    free(m->regions);
+    free(m->starts);
+    free(m->ends);
+    free(m->names);
+    proc_maps_free(&m->maps);
+    memset(m, 0, sizeof(*m));
+}
+
+// ========== CONSTRUCCIÓN ==========
+
+static int add_name(addr_map_t *m, const char *name, uint32_t *off) {
+    size_t len = strlen(name);
+    if (m->names_len + len + 1 > m->names_cap) {
+        size_t ncap = m->names_cap ? m->names_cap * 2 : 4096;
+        while (ncap < m->names_len + len + 1) ncap *= 2;
+        char *nn = realloc(m->names, ncap);
+        if (!nn) return -1;
+        m->names = nn;
+        m->names_cap = ncap;
+    }
+    memcpy(m->names + m->names_len, name, len + 1);
+    *off = (uint32_t)m->names_len;
+    m->names_len += len + 1;
+    return 0;
+}
+
+static int reserve(addr_map_t *m, size_t n) {
+    if (n <= m->cap) return 0;
+    size_t ncap = m->cap ? m->cap * 2 : 256;
+    while (ncap < n) ncap *= 2;
+    addr_region_t *nr = realloc(m->regions, ncap * sizeof(*nr));
+    if (!nr) return -1;
+    m->regions = nr;
+    m->cap = ncap;
+    return 0;
+}
+
+// Primera región con end > addr
+static size_t first_after(const addr_map_t *m, uintptr_t addr) {
+    size_t lo = 0, hi = m->n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (m->regions[mid].end <= addr) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Pinta [lo, hi) con cls sobre las regiones existentes: solo donde ya hay
+// algo mapeado, partiendo las regiones que quedan a medias. Los permisos
+// reales mandan: "código" sobre páginas sin X es solo lectura (cabeceras ELF),
+// "solo lectura" sobre páginas escribibles son datos (.got.plt sin relro) y
+// datos en páginas r--p (relro: .got, .dynamic tras reubicar) son solo lectura.
+static int paint(addr_map_t *m, uintptr_t lo, uintptr_t hi, uint8_t cls, pid_t tid, uint32_t name_off) {
+    if (lo >= hi) return 0;
+    size_t i = first_after(m, lo);
+    while (i < m->n && m->regions[i].start < hi) {
+        addr_region_t old = m->regions[i];
+        uintptr_t a = old.start > lo ? old.start : lo;
+        uintptr_t b = old.end < hi ? old.end : hi;
+        size_t pieces = (old.start < a) + 1 + (b < old.end);
+        if (reserve(m, m->n + pieces - 1) < 0) return -1;
+        memmove(&m->regions[i + pieces], &m->regions[i + 1], (m->n - i - 1) * sizeof(addr_region_t));
+        m->n += pieces - 1;
+
+        size_t k = i;
+        if (old.start < a) {
+            m->regions[k] = old;
+            m->regions[k++].end = a;
+        }
+        addr_region_t mid = old;
+        mid.start = a;
+        mid.end = b;
+        mid.cls = cls;
+        if (cls == ADDR_TEXT && !(old.perms & MAPS_PERM_EXEC)) mid.cls = ADDR_RODATA;
+        if (cls == ADDR_RODATA && (old.perms & MAPS_PERM_WRITE)) mid.cls = ADDR_DATA;
+        if (cls == ADDR_DATA && !(old.perms & MAPS_PERM_WRITE)) mid.cls = ADDR_RODATA;
+        mid.tid = tid;
+        mid.name_off = name_off;
+        m->regions[k++] = mid;
+        if (b < old.end) {
+            m->regions[k] = old;
+            m->regions[k++].start = b;
+        }
+        i = k;
+    }
+    return 0;
+}
+
+static int paint_named(addr_map_t *m, uintptr_t lo, uintptr_t hi, uint8_t cls, pid_t tid, const char *name) {
+    uint32_t off;
+    if (add_name(m, name, &off) < 0) return -1;
+    return paint(m, lo, hi, cls, tid, off);
+}
+
+static uint8_t class_of_kind(const maps_region_t *r) {
+    switch (r->kind) {
+    case MAPS_KIND_HEAP:  return ADDR_HEAP;
+    case MAPS_KIND_STACK: return ADDR_STACK;
+    case MAPS_KIND_VDSO:  return ADDR_VDSO;
+    case MAPS_KIND_FILE:  return ADDR_FILE;
+    case MAPS_KIND_ANON:  return ADDR_ANON;
+    default:              return ADDR_OTHER;
+    }
+}
+
+static int add_maps_regions(addr_map_t *m) {
+    if (reserve(m, m->maps.nregions) < 0) return -1;
+    uint32_t empty;
+    if (add_name(m, "", &empty) < 0) return -1;
+    for (size_t i = 0; i < m->maps.nregions; i++) {
+        const maps_region_t *r = &m->maps.regions[i];
+        addr_region_t *d = &m->regions[m->n++];
+        d->start = r->start;
+        d->end = r->end;
+        d->tid = r->kind == MAPS_KIND_STACK ? m->pid : 0;
+        d->cls = class_of_kind(r);
+        d->perms = r->perms;
+        d->name_off = empty;
+        if (r->name_len && add_name(m, proc_maps_name(&m->maps, r), &d->name_off) < 0) return -1;
+    }
+    return 0;
+}
+
+// Este proceso: rangos entre símbolos del enlazador, sin abrir ningún fichero
+static int add_self_sections(addr_map_t *m) {
+    return paint_named(m, (uintptr_t)__executable_start, (uintptr_t)etext, ADDR_TEXT, 0, ".text") ||
+           paint_named(m, (uintptr_t)etext, (uintptr_t)__data_start, ADDR_RODATA, 0, ".rodata") ||
+           paint_named(m, (uintptr_t)__data_start, (uintptr_t)edata, ADDR_DATA, 0, ".data") ||
+           paint_named(m, (uintptr_t)__bss_start, (uintptr_t)end, ADDR_BSS, 0, ".bss") ? -1 : 0;
+}
+
+// Otro proceso: cabeceras de sección de /proc/<pid>/exe
+static int add_exe_sections(addr_map_t *m) {
+    elf_file_t e;
+    uintptr_t bias;
+    if (elf_open_process(&e, m->pid, &m->maps, &bias) < 0) return -1;
+    for (size_t i = 0; i < e.nsections; i++) {
+        const Elf64_Shdr *s = &e.shdrs[i];
+        if (!(s->sh_flags & SHF_ALLOC) || (s->sh_flags & SHF_TLS) || s->sh_size == 0) continue;
+        uint8_t cls = s->sh_type == SHT_NOBITS ? ADDR_BSS :
+                      (s->sh_flags & SHF_EXECINSTR) ? ADDR_TEXT :
+                      (s->sh_flags & SHF_WRITE) ? ADDR_DATA : ADDR_RODATA;
+        uintptr_t lo = (uintptr_t)s->sh_addr + bias;
+        if (paint_named(m, lo, lo + s->sh_size, cls, 0, elf_section_name(&e, i)) < 0) {
+            elf_close(&e);
+            return -1;
+        }
+    }
+    elf_close(&e);
+    return 0;
+}
+
+static int paint_region_at(addr_map_t *m, uintptr_t addr, uint8_t cls, pid_t tid, int with_guard) {
+    const maps_region_t *r = proc_maps_find(&m->maps, addr);
+    if (!r) return -1;
+    if (paint(m, r->start, r->end, cls, tid, m->regions[first_after(m, r->start)].name_off) < 0) return -1;
+    // Guarda: región sin permisos pegada por debajo
+    if (with_guard && r > m->maps.regions && r[-1].end == r->start && r[-1].perms == 0) {
+        return paint(m, r[-1].start, r[-1].end, ADDR_GUARD, tid, m->regions[first_after(m, r[-1].start)].name_off);
+    }
+    return 0;
+}
+
+static int add_stacks(addr_map_t *m) {
+    char path[64];
+    proc_file_t f;
+    proc_file_init(&f);
+
+    // Stack principal: startstack es del mm entero (igual en todos los task/*/stat)
+    snprintf(path, sizeof(path), "/proc/%d/stat", m->pid);
+    proc_stat_t st;
+    if (proc_file_load(&f, path) == 0 && proc_parse_stat(f.buf, f.len, &st) == 0 && st.startstack) {
+        paint_region_at(m, (uintptr_t)st.startstack, ADDR_STACK, m->pid, 0);
+    }
+
+    snprintf(path, sizeof(path), "/proc/%d/task", m->pid);
+    proc_dir_buf_t db = { 0 };
+    pid_t *tids = NULL;
+    size_t tids_cap = 0;
+    ssize_t n = proc_list_pids(path, &db, &tids, &tids_cap);
+    for (ssize_t i = 0; i < n; i++) {
+        uintptr_t sp;
+        if (tids[i] == m->pid || proc_task_sp(m->pid, tids[i], &f, &sp) < 0) continue;
+        const maps_region_t *r = proc_maps_find(&m->maps, sp);
+        if (r && r->kind == MAPS_KIND_ANON) paint_region_at(m, sp, ADDR_THREAD_STACK, tids[i], 1);
+    }
+    free(tids);
+    proc_dir_buf_free(&db);
+    proc_file_free(&f);
+    return 0;
+}
+
+static int finish(addr_map_t *m) {
+    free(m->starts);
+    free(m->ends);
+    m->starts = malloc((m->n ? m->n : 1) * sizeof(uintptr_t));
+    m->ends = malloc((m->n ? m->n : 1) * sizeof(uintptr_t));
+    if (!m->starts || !m->ends) return -1;
+    for (size_t i = 0; i < m->n; i++) {
+        m->starts[i] = m->regions[i].start;
+        m->ends[i] = m->regions[i].end;
+    }
+    return 0;
+}
+
+int addr_map_build(addr_map_t *m, pid_t pid) {
+    m->pid = pid;
+    m->n = 0;
+    m->names_len = 0;
+    if (proc_maps_load(&m->maps, pid) < 0 || add_maps_regions(m) < 0) return -1;
+
+    // Sin permiso para /proc/<pid>/exe se sigue sin secciones
+    if (pid == getpid()) {
+        if (add_self_sections(m) < 0) return -1;
+    } else {
+        add_exe_sections(m);
+    }
+    add_stacks(m);
+    return finish(m);
+}
+
+int addr_map_add_stack(addr_map_t *m, pid_t tid, uintptr_t lo, uintptr_t hi) {
+    size_t i = first_after(m, lo);
+    uint32_t name_off = i < m->n ? m->regions[i].name_off : 0;
+    if (paint(m, lo, hi, tid == m->pid ? ADDR_STACK : ADDR_THREAD_STACK, tid, name_off) < 0) return -1;
+    return finish(m);
+}
+
+int addr_map_add_current_thread(addr_map_t *m) {
+    if (m->pid != getpid() || m->n == 0) return -1;
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return -1;
+    int rc = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) return -1;
+    return addr_map_add_stack(m, get_kernel_pid(), (uintptr_t)addr, (uintptr_t)addr + size);
+}
+
+// ========== CONSULTA ==========
+
+void addr_map_lookup_batch(const addr_map_t *m, const uintptr_t *addrs, size_t n, int32_t *out) {
+    long last = -1;
+    uintptr_t last_lo = 0, last_hi = 0;     // intervalo vacío: a - lo < hi - lo = 0 nunca se cumple
+    for (size_t i = 0; i < n; i++) {
+        uintptr_t a = addrs[i];
+        if (a - last_lo < last_hi - last_lo) {
+            out[i] = (int32_t)last;
+            continue;
+        }
+        long idx = addr_map_lookup(m, a);
+        out[i] = (int32_t)idx;
+        if (idx >= 0) {
+            last = idx;
+            last_lo = m->starts[idx];
+            last_hi = m->ends[idx];
+        }
+    }
+}
+
+int addr_map_describe(const addr_map_t *m, long idx, char *buf, size_t len) {
+    if (idx < 0 || (size_t)idx >= m->n) return snprintf(buf, len, "%s", class_names[ADDR_UNMAPPED]);
+    const addr_region_t *r = &m->regions[idx];
+    const char *name = addr_region_name(m, r);
+    if (r->tid && (r->cls == ADDR_THREAD_STACK || r->cls == ADDR_GUARD)) {
+        return snprintf(buf, len, "%s (TID %d)", class_names[r->cls], r->tid);
+    }
+    return snprintf(buf, len, "%s%s%s", class_names[r->cls], *name ? " " : "", name);
+}
@@ -0,0 +1,95 @@
+// proc_addr.h - Clasificación de direcciones: sección ELF, heap, stacks y mmap
+#ifndef PROC_ADDR_H
+#define PROC_ADDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_maps.h"
+
+typedef enum {
+    ADDR_UNMAPPED = 0,
+    ADDR_TEXT,              // código ejecutable del programa (.text, .plt, .init, ...)
+    ADDR_RODATA,            // solo lectura del programa (.rodata, .eh_frame, relro, cabeceras)
+    ADDR_DATA,              // .data, .got.plt y demás datos inicializados
+    ADDR_BSS,               // .bss
+    ADDR_HEAP,              // [heap] (brk)
+    ADDR_STACK,             // stack del thread principal
+    ADDR_THREAD_STACK,      // stack de otro thread
+    ADDR_GUARD,             // página de guarda de un stack de thread
+    ADDR_ANON,              // mmap anónimo (arenas de malloc, allocs grandes, ...)
+    ADDR_FILE,              // otro fichero mapeado (bibliotecas, mmap de ficheros)
+    ADDR_VDSO,              // [vdso], [vvar], [vsyscall]
+    ADDR_OTHER,             // resto de pseudo-regiones
+    ADDR_CLASS_COUNT
+} addr_class_t;
+
+typedef struct {
+    uintptr_t start;
+    uintptr_t end;          // exclusivo
+    pid_t tid;              // dueño de un stack (0 si no aplica)
+    uint32_t name_off;      // sección ELF, ruta o pseudo-nombre en addr_map_t.names
+    uint8_t cls;
+    uint8_t perms;          // MAPS_PERM_*
+} addr_region_t;
+
+// Intervalos ordenados y disjuntos. starts/ends van aparte (SoA) para que la
+// búsqueda binaria solo recorra un array compacto.
+typedef struct {
+    pid_t pid;
+    addr_region_t *regions;
+    uintptr_t *starts;
+    uintptr_t *ends;
+    size_t n;
+    size_t cap;
+
+    char *names;
+    size_t names_len;
+    size_t names_cap;
+
+    proc_maps_t maps;
+} addr_map_t;
+
+void addr_map_init(addr_map_t *m);
+void addr_map_free(addr_map_t *m);
+
+// Construye el mapa de pid: maps + secciones del ejecutable (símbolos del
+// enlazador si pid es este proceso, cabeceras de /proc/<pid>/exe si no) +
+// stacks del thread principal (startstack) y de cada thread (SP de task/*/syscall).
+int  addr_map_build(addr_map_t *m, pid_t pid);
+
+// Marca [lo, hi) como stack del thread tid (p. ej. con pthread_getattr_np)
+int  addr_map_add_stack(addr_map_t *m, pid_t tid, uintptr_t lo, uintptr_t hi);
+
+// Atajo para el thread que llama (pthread_getattr_np); solo si m->pid es este proceso
+int  addr_map_add_current_thread(addr_map_t *m);
+
+// Índice de la región que contiene addr, o -1. O(log n), sin E/S.
+static inline long addr_map_lookup(const addr_map_t *m, uintptr_t addr) {
+    if (m->n == 0) return -1;
+    const uintptr_t *base = m->starts;
+    size_t len = m->n;
+    while (len > 1) {
+        size_t half = len / 2;
+        base = base[half] <= addr ? base + half : base;   // sin salto: cmov
+        len -= half;
+    }
+    size_t i = (size_t)(base - m->starts);
+    return m->starts[i] <= addr && addr < m->ends[i] ? (long)i : -1;
+}
+
+// Lote: out[i] = índice de región de addrs[i] o -1. Reutiliza la región
+// anterior cuando la traza tiene localidad.
+void addr_map_lookup_batch(const addr_map_t *m, const uintptr_t *addrs, size_t n, int32_t *out);
+
+static inline const char *addr_region_name(const addr_map_t *m, const addr_region_t *r) {
+    return m->names + r->name_off;
+}
+
+const char *addr_class_name(addr_class_t cls);
+
+// "clase nombre [tid N]" de la región idx (o "no mapeada")
+int addr_map_describe(const addr_map_t *m, long idx, char *buf, size_t len);
+
+#endif // PROC_ADDR_H
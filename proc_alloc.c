@@ -0,0 +1,580 @@
+// proc_alloc.c - Arena bump y pool de tamaño fijo por thread frente a malloc de glibc
+//
+// Arenas y pools salen de una única reserva de ALLOC_RESERVE con MAP_NORESERVE,
+// repartida en chunks de ALLOC_CHUNK: pfree sabe con una resta si el bloque es
+// nuestro o de glibc, y el dueño de un chunk es un índice en un array. Cada
+// chunk se nombra con PR_SET_VMA_ANON_NAME, así que en /proc/<pid>/maps sale
+// como [anon:proc_alloc arena THREAD-1] (kernel >= 5.17; si no, anónimo).
+//
+// glibc, en cambio, da a cada thread una arena propia (hasta 8 por CPU) en
+// heaps de 64 MB alineados: lo que libera un thread solo lo reutiliza quien
+// use esa arena, y la memoria bajo un bloque vivo no vuelve al sistema. Con
+// muchos threads el RSS crece aunque lo vivo sea poco.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_pagemap.h"
+#include "proc_alloc.h"
+
+#ifndef PR_SET_VMA
+#define PR_SET_VMA            0x53564d41
+#define PR_SET_VMA_ANON_NAME  0
+#endif
+
+#define ALLOC_CHUNKS  (ALLOC_RESERVE / ALLOC_CHUNK)
+#define CHUNK_NONE    UINT32_MAX
+#define ARENA_ALIGN   16
+#define ARENA_MAX_REQ (ALLOC_CHUNK / 4)
+
+enum { SLOT_FREE = 0, SLOT_LIVE, SLOT_DEAD };
+
+// Estado de un thread. Los slots no se liberan nunca: un free remoto puede
+// llegar después de que el dueño termine, y el siguiente thread hereda el
+// slot con sus chunks (como hace glibc con las arenas).
+typedef struct {
+    _Alignas(64) _Atomic int state;
+    pid_t tid;
+    char name[16];
+
+    // Arena: lista de chunks enlazada por chunk_next, se llena en orden
+    uint32_t arena_first;
+    uint32_t arena_cur;
+    size_t arena_off;
+
+    // Pool: lista libre local, más la de bloques liberados desde otros threads
+    void *pool_free;
+    uint8_t *carve;             // resto sin estrenar del último chunk
+    uint8_t *carve_end;
+    uint32_t pool_first;
+    long pool_live;             // solo el dueño; los remotos se restan al recogerlos
+    _Alignas(64) _Atomic(void *) pool_remote;
+    _Atomic long pool_remote_freed;
+} alloc_slot_t;
+
+static _Atomic int cur_mode = ALLOC_GLIBC;
+static _Atomic uintptr_t reserve_base;
+static _Atomic uint32_t chunk_top;
+static pthread_once_t alloc_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slot_key;
+
+// Por chunk: siguiente en su lista (del thread o de libres), slot y modo
+static uint32_t chunk_next[ALLOC_CHUNKS];
+static uint16_t chunk_slot[ALLOC_CHUNKS];
+static uint8_t chunk_kind[ALLOC_CHUNKS];
+static uint32_t free_chunks = CHUNK_NONE;
+static pthread_mutex_t chunk_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static alloc_slot_t slots[ALLOC_MAX_THREADS];
+static __thread alloc_slot_t *my_slot;
+
+static const char *const mode_names[ALLOC_NMODES] = { "glibc", "arena", "pool" };
+
+void alloc_set_mode(alloc_mode_t mode) {
+    atomic_store_explicit(&cur_mode, mode, memory_order_relaxed);
+}
+
+alloc_mode_t alloc_get_mode(void) {
+    return (alloc_mode_t)atomic_load_explicit(&cur_mode, memory_order_relaxed);
+}
+
+const char *alloc_mode_name(alloc_mode_t mode) {
+    return mode < ALLOC_NMODES ? mode_names[mode] : "?";
+}
+
+int alloc_parse_mode(const char *s, alloc_mode_t *out) {
+    for (int i = 0; i < ALLOC_NMODES; i++) {
+        if (strcmp(s, mode_names[i]) == 0) {
+            *out = (alloc_mode_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ========== RESERVA Y CHUNKS ==========
+
+static void slot_destructor(void *arg) {
+    (void)arg;
+    alloc_thread_release();
+}
+
+static void alloc_init(void) {
+    void *p = mmap(NULL, ALLOC_RESERVE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return;
+    for (int i = 0; i < ALLOC_MAX_THREADS; i++) {
+        slots[i].arena_first = slots[i].arena_cur = slots[i].pool_first = CHUNK_NONE;
+    }
+    pthread_key_create(&slot_key, slot_destructor);
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, p, ALLOC_RESERVE, "proc_alloc libre");
+    atomic_store_explicit(&reserve_base, (uintptr_t)p, memory_order_release);
+}
+
+static inline uint8_t *chunk_addr(uint32_t c) {
+    return (uint8_t *)atomic_load_explicit(&reserve_base, memory_order_relaxed) + (size_t)c * ALLOC_CHUNK;
+}
+
+static void name_chunk(uint32_t c, const char *what, const char *owner) {
+    char name[64];
+    snprintf(name, sizeof(name), "proc_alloc %s%s%s", what, *owner ? " " : "", owner);
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, chunk_addr(c), ALLOC_CHUNK, name);
+}
+
+static uint32_t chunk_acquire(alloc_slot_t *s, alloc_mode_t kind) {
+    pthread_mutex_lock(&chunk_lock);
+    uint32_t c = free_chunks;
+    if (c != CHUNK_NONE) free_chunks = chunk_next[c];
+    pthread_mutex_unlock(&chunk_lock);
+    if (c == CHUNK_NONE) {
+        c = atomic_fetch_add_explicit(&chunk_top, 1, memory_order_relaxed);
+        if (c >= ALLOC_CHUNKS) return CHUNK_NONE;
+    }
+    chunk_next[c] = CHUNK_NONE;
+    chunk_slot[c] = (uint16_t)(s - slots);
+    chunk_kind[c] = (uint8_t)kind;
+    name_chunk(c, mode_names[kind], s->name);
+    return c;
+}
+
+// Devuelve una lista de chunks a la reserva y sus páginas al sistema
+static void chunk_release_list(uint32_t c) {
+    while (c != CHUNK_NONE) {
+        uint32_t next = chunk_next[c];
+        madvise(chunk_addr(c), ALLOC_CHUNK, MADV_DONTNEED);
+        name_chunk(c, "libre", "");
+        chunk_kind[c] = ALLOC_GLIBC;
+        pthread_mutex_lock(&chunk_lock);
+        chunk_next[c] = free_chunks;
+        free_chunks = c;
+        pthread_mutex_unlock(&chunk_lock);
+        c = next;
+    }
+}
+
+static alloc_slot_t *slot_get(void) {
+    if (my_slot) return my_slot;
+    pthread_once(&alloc_once, alloc_init);
+    if (!atomic_load_explicit(&reserve_base, memory_order_acquire)) return NULL;
+    for (int i = 0; i < ALLOC_MAX_THREADS; i++) {
+        alloc_slot_t *s = &slots[i];
+        int st = atomic_load_explicit(&s->state, memory_order_relaxed);
+        if (st == SLOT_LIVE) continue;
+        if (!atomic_compare_exchange_strong(&s->state, &st, SLOT_LIVE)) continue;
+        s->tid = get_kernel_pid();
+        if (prctl(PR_GET_NAME, s->name, 0, 0, 0) < 0) s->name[0] = '\0';
+        s->name[15] = '\0';
+        my_slot = s;
+        pthread_setspecific(slot_key, s);
+        return s;
+    }
+    return NULL;
+}
+
+// ========== ARENA ==========
+
+static void *arena_alloc(alloc_slot_t *s, size_t n) {
+    n = (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    for (;;) {
+        if (s->arena_cur != CHUNK_NONE && s->arena_off + n <= ALLOC_CHUNK) {
+            void *p = chunk_addr(s->arena_cur) + s->arena_off;
+            s->arena_off += n;
+            return p;
+        }
+        // Siguiente chunk de la lista (tras un reset ya existen) o uno nuevo
+        uint32_t next = s->arena_cur == CHUNK_NONE ? s->arena_first : chunk_next[s->arena_cur];
+        if (next == CHUNK_NONE) {
+            next = chunk_acquire(s, ALLOC_ARENA);
+            if (next == CHUNK_NONE) return NULL;
+            if (s->arena_cur == CHUNK_NONE) s->arena_first = next;
+            else chunk_next[s->arena_cur] = next;
+        }
+        s->arena_cur = next;
+        s->arena_off = 0;
+    }
+}
+
+void alloc_thread_reset(void) {
+    alloc_slot_t *s = my_slot;
+    if (!s || s->arena_first == CHUNK_NONE) return;
+    s->arena_cur = s->arena_first;
+    s->arena_off = 0;
+}
+
+// ========== POOL ==========
+
+static void *pool_alloc(alloc_slot_t *s) {
+    void *p = s->pool_free;
+    if (!p) {
+        p = atomic_exchange_explicit(&s->pool_remote, NULL, memory_order_acquire);
+        if (p) s->pool_live -= atomic_exchange_explicit(&s->pool_remote_freed, 0, memory_order_relaxed);
+    }
+    if (p) {
+        s->pool_free = *(void **)p;
+        s->pool_live++;
+        return p;
+    }
+    if (s->carve == s->carve_end) {
+        uint32_t c = chunk_acquire(s, ALLOC_POOL);
+        if (c == CHUNK_NONE) return NULL;
+        chunk_next[c] = s->pool_first;
+        s->pool_first = c;
+        s->carve = chunk_addr(c);
+        s->carve_end = s->carve + ALLOC_CHUNK;
+    }
+    p = s->carve;
+    s->carve += POOL_BLOCK;
+    s->pool_live++;
+    return p;
+}
+
+static void pool_free(uint32_t c, void *p) {
+    alloc_slot_t *owner = &slots[chunk_slot[c]];
+    if (owner == my_slot) {
+        *(void **)p = owner->pool_free;
+        owner->pool_free = p;
+        owner->pool_live--;
+        return;
+    }
+    // Desde otro thread: a la lista remota del dueño. El contador sube después
+    // de publicar el bloque, así el dueño nunca cree que hay menos vivos.
+    void *head = atomic_load_explicit(&owner->pool_remote, memory_order_relaxed);
+    do {
+        *(void **)p = head;
+    } while (!atomic_compare_exchange_weak_explicit(&owner->pool_remote, &head, p,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_fetch_add_explicit(&owner->pool_remote_freed, 1, memory_order_release);
+}
+
+void alloc_thread_release(void) {
+    alloc_slot_t *s = my_slot;
+    if (!s) return;
+    chunk_release_list(s->arena_first);
+    s->arena_first = s->arena_cur = CHUNK_NONE;
+    s->arena_off = 0;
+
+    // Como en pool_alloc: primero la lista y luego el contador, que sube
+    // después de publicar cada bloque. La lista va a pool_free, que es lo
+    // que usa quien herede el slot
+    void *remote = atomic_exchange_explicit(&s->pool_remote, NULL, memory_order_acquire);
+    if (remote) {
+        void *tail = remote;
+        while (*(void **)tail) tail = *(void **)tail;
+        *(void **)tail = s->pool_free;
+        s->pool_free = remote;
+        s->pool_live -= atomic_exchange_explicit(&s->pool_remote_freed, 0, memory_order_relaxed);
+    }
+    int state = SLOT_DEAD;
+    if (s->pool_live == 0) {
+        chunk_release_list(s->pool_first);
+        s->pool_first = CHUNK_NONE;
+        s->pool_free = NULL;
+        s->carve = s->carve_end = NULL;
+        state = SLOT_FREE;
+    }
+    my_slot = NULL;
+    atomic_store_explicit(&s->state, state, memory_order_release);
+}
+
+// ========== API ==========
+
+void *palloc(size_t n) {
+    alloc_mode_t mode = alloc_get_mode();
+    void *p = NULL;
+    if (mode == ALLOC_ARENA && n <= ARENA_MAX_REQ) {
+        alloc_slot_t *s = slot_get();
+        if (s) p = arena_alloc(s, n ? n : 1);
+    } else if (mode == ALLOC_POOL && n <= POOL_BLOCK) {
+        alloc_slot_t *s = slot_get();
+        if (s) p = pool_alloc(s);
+    }
+    return p ? p : malloc(n);
+}
+
+void pfree(void *p) {
+    if (!p) return;
+    uintptr_t base = atomic_load_explicit(&reserve_base, memory_order_relaxed);
+    uintptr_t off = (uintptr_t)p - base;
+    if (!base || off >= ALLOC_RESERVE) {
+        free(p);
+        return;
+    }
+    uint32_t c = (uint32_t)(off / ALLOC_CHUNK);
+    if (chunk_kind[c] == ALLOC_POOL) pool_free(c, p);
+    // Arena: se libera en bloque con alloc_thread_reset
+}
+
+// ========== ORIGEN ==========
+
+// Bits bajos del campo size de un chunk de malloc (malloc/malloc.c)
+#define CHUNK_IS_MMAPPED    0x2
+#define CHUNK_NON_MAIN      0x4
+#define CHUNK_FLAGS         0x7
+
+int alloc_origin(const void *p, alloc_origin_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!p) return -1;
+    uintptr_t base = atomic_load_explicit(&reserve_base, memory_order_acquire);
+    uintptr_t off = (uintptr_t)p - base;
+    if (base && off < ALLOC_RESERVE) {
+        uint32_t c = (uint32_t)(off / ALLOC_CHUNK);
+        if (chunk_kind[c] == ALLOC_GLIBC) return -1;
+        const alloc_slot_t *s = &slots[chunk_slot[c]];
+        out->kind = chunk_kind[c] == ALLOC_POOL ? AORIG_POOL : AORIG_ARENA;
+        out->owner_tid = s->tid;
+        memcpy(out->owner, s->name, sizeof(out->owner));
+        out->region = (uintptr_t)chunk_addr(c);
+        return 0;
+    }
+#ifdef __GLIBC__
+    // Cabecera del chunk: el size está justo antes del puntero de usuario
+    size_t sz = ((const size_t *)p)[-1];
+    out->size = sz & ~(size_t)CHUNK_FLAGS;
+    if (sz & CHUNK_IS_MMAPPED) {
+        out->kind = AORIG_GLIBC_MMAP;
+    } else if (sz & CHUNK_NON_MAIN) {
+        // heap_info al principio del heap alineado; su primer campo es ar_ptr
+        out->kind = AORIG_GLIBC_THREAD;
+        out->region = (uintptr_t)p & ~(GLIBC_HEAP_MAX - 1);
+        out->arena = *(const uintptr_t *)out->region;
+    } else {
+        out->kind = AORIG_GLIBC_MAIN;   // main_arena no es un símbolo público
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int alloc_origin_format(const alloc_origin_t *o, char *buf, size_t len) {
+    switch (o->kind) {
+    case AORIG_ARENA:
+    case AORIG_POOL:
+        if (o->kind == AORIG_POOL) {
+            return snprintf(buf, len, "pool de %d B de %s (TID %d), chunk 0x%lx de %u KB", POOL_BLOCK,
+                            o->owner[0] ? o->owner : "?", o->owner_tid, (unsigned long)o->region, ALLOC_CHUNK >> 10);
+        }
+        return snprintf(buf, len, "arena bump de %s (TID %d), chunk 0x%lx de %u KB",
+                        o->owner[0] ? o->owner : "?", o->owner_tid, (unsigned long)o->region, ALLOC_CHUNK >> 10);
+    case AORIG_GLIBC_MAIN:
+        return snprintf(buf, len, "arena principal de glibc ([heap], brk), chunk de %zu B", o->size);
+    case AORIG_GLIBC_THREAD:
+        return snprintf(buf, len, "arena de glibc 0x%lx en el heap de thread 0x%lx, chunk de %zu B",
+                        (unsigned long)o->arena, (unsigned long)o->region, o->size);
+    case AORIG_GLIBC_MMAP:
+        return snprintf(buf, len, "mmap propio de malloc (chunk de %zu KB >= M_MMAP_THRESHOLD)", o->size >> 10);
+    default:
+        return snprintf(buf, len, "origen desconocido");
+    }
+}
+
+// ========== ARENAS DE GLIBC EN MAPS ==========
+
+static int anon_region(const proc_maps_t *m, const maps_region_t *r) {
+    // Sin nombre, o [anon: glibc: malloc arena] con glibc.mem.decorate_maps
+    return r->kind == MAPS_KIND_ANON ||
+           (r->kind == MAPS_KIND_OTHER && strncmp(proc_maps_name(m, r), "[anon: glibc", 12) == 0);
+}
+
+int glibc_heaps_scan(const proc_maps_t *m, int self, glibc_heap_t *out, int max) {
+    int n = 0;
+    for (size_t i = 0; i < m->nregions; i++) {
+        const maps_region_t *r = &m->regions[i];
+        if (r->start % GLIBC_HEAP_MAX != 0 || !anon_region(m, r)) continue;
+        if ((r->perms & (MAPS_PERM_READ | MAPS_PERM_WRITE | MAPS_PERM_SHARED)) != (MAPS_PERM_READ | MAPS_PERM_WRITE)) continue;
+        uintptr_t end = r->end;
+        if (i + 1 < m->nregions) {
+            const maps_region_t *g = &m->regions[i + 1];
+            if (g->start == r->end && g->perms == 0 && anon_region(m, g)) end = g->end;
+        }
+        if (end - r->start != GLIBC_HEAP_MAX) continue;
+        if (n < max) {
+            out[n].start = r->start;
+            out[n].committed = r->end - r->start;
+            out[n].reserved = end - r->start;
+            out[n].arena = self ? *(const uintptr_t *)r->start : 0;
+        }
+        n++;
+    }
+    return n;
+}
+
+// ========== BANCO DE PRUEBAS ==========
+
+typedef struct {
+    int id;
+    alloc_mode_t mode;
+    const alloc_bench_cfg_t *cfg;
+    _Atomic int *go;
+    unsigned long live_bytes;
+    int error;
+} bench_thread_t;
+
+static inline uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static void *bench_thread(void *arg) {
+    bench_thread_t *bt = arg;
+    unsigned k = bt->cfg->objs;
+    char name[16];
+    snprintf(name, sizeof(name), "AB-%s-%d", mode_names[bt->mode], bt->id % 1000);
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+
+    // Mismos tamaños y mismo orden de free para todos los modos
+    uint32_t seed = 0x9e3779b9u * (uint32_t)(bt->id + 1);
+    uint16_t *sizes = malloc(k * sizeof(*sizes));
+    uint32_t *order = malloc(k * sizeof(*order));
+    void **ptrs = malloc(k * sizeof(*ptrs));
+    if (!sizes || !order || !ptrs) bt->error = ENOMEM;
+    for (unsigned i = 0; !bt->error && i < k; i++) {
+        sizes[i] = (uint16_t)(16 + xorshift32(&seed) % (POOL_BLOCK - 15));
+        bt->live_bytes += sizes[i];
+        order[i] = i;
+    }
+    for (unsigned i = k; !bt->error && i > 1; i--) {
+        uint32_t j = xorshift32(&seed) % i;
+        uint32_t t = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = t;
+    }
+
+    while (!atomic_load_explicit(bt->go, memory_order_acquire)) sched_yield();
+    if (bt->mode == ALLOC_GLIBC) {
+        // Directo, sin pasar por palloc: el mismo camino con y sin interposición
+        void *(*m)(size_t) = bt->cfg->malloc_fn ? bt->cfg->malloc_fn : malloc;
+        void (*f)(void *) = bt->cfg->free_fn ? bt->cfg->free_fn : free;
+        for (unsigned r = 0; !bt->error && r < bt->cfg->rounds; r++) {
+            for (unsigned i = 0; i < k; i++) {
+                ptrs[i] = m(sizes[i]);
+                *(volatile uint64_t *)ptrs[i] = i;
+            }
+            for (unsigned i = 0; i < k; i++) f(ptrs[order[i]]);
+        }
+    } else {
+        for (unsigned r = 0; !bt->error && r < bt->cfg->rounds; r++) {
+            for (unsigned i = 0; i < k; i++) {
+                ptrs[i] = palloc(sizes[i]);
+                *(volatile uint64_t *)ptrs[i] = i;
+            }
+            for (unsigned i = 0; i < k; i++) pfree(ptrs[order[i]]);
+            alloc_thread_reset();
+        }
+    }
+    free(sizes);
+    free(order);
+    free(ptrs);
+    return NULL;
+}
+
+static unsigned long rss_kb(void) {
+    smaps_rollup_t sr;
+    return smaps_rollup_read(getpid(), &sr) == 0 ? sr.rss_kb : 0;
+}
+
+// Escribir "5" en clear_refs reinicia VmHWM al RSS actual
+static int reset_hwm(void) {
+    int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int ok = write(fd, "5", 1) == 1;
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+static unsigned long read_hwm_kb(void) {
+    proc_file_t f;
+    proc_file_init(&f);
+    unsigned long kb = 0;
+    if (proc_file_load(&f, "/proc/self/status") == 0) {
+        const char *p = memmem(f.buf, f.len, "VmHWM:", 6);
+        if (p) kb = strtoul(p + 6, NULL, 10);
+    }
+    proc_file_free(&f);
+    return kb;
+}
+
+int alloc_bench_run(alloc_mode_t mode, const alloc_bench_cfg_t *cfg, alloc_bench_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (cfg->threads <= 0 || cfg->objs == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_t *th = calloc((size_t)cfg->threads, sizeof(*th));
+    bench_thread_t *bt = calloc((size_t)cfg->threads, sizeof(*bt));
+    if (!th || !bt) {
+        free(th);
+        free(bt);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    alloc_mode_t prev = alloc_get_mode();
+    alloc_set_mode(mode);
+    _Atomic int go = 0;
+
+    out->rss_before_kb = rss_kb();
+    int hwm = reset_hwm() == 0;
+    int created = 0, err = 0;
+    for (; created < cfg->threads; created++) {
+        bt[created] = (bench_thread_t){ .id = created + 1, .mode = mode, .cfg = cfg, .go = &go };
+        if ((err = pthread_create(&th[created], NULL, bench_thread, &bt[created])) != 0) break;
+    }
+    // Todos creados antes de arrancar: la creación no cuenta en el tiempo
+    uint64_t t0 = now_ns();
+    atomic_store_explicit(&go, 1, memory_order_release);
+    for (int i = 0; i < created; i++) pthread_join(th[i], NULL);
+    uint64_t t1 = now_ns();
+
+    out->rss_peak_kb = hwm ? read_hwm_kb() : 0;
+    out->rss_after_kb = rss_kb();
+    malloc_trim(0);
+    out->rss_trim_kb = rss_kb();
+
+    unsigned long ops = 0;
+    for (int i = 0; i < created; i++) {
+        if (bt[i].error) err = bt[i].error;
+        out->live_kb += bt[i].live_bytes >> 10;
+        ops += (unsigned long)cfg->rounds * cfg->objs;
+    }
+    out->mops = t1 > t0 ? ops / ((t1 - t0) / 1e3) : 0;
+
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, getpid()) == 0) {
+        glibc_heap_t heaps[64];
+        out->glibc_heaps = glibc_heaps_scan(&maps, 1, heaps, 64);
+        int nh = out->glibc_heaps < 64 ? out->glibc_heaps : 64;
+        for (int i = 0; i < nh; i++) {
+            int seen = 0;
+            for (int j = 0; j < i && !seen; j++) seen = heaps[j].arena == heaps[i].arena;
+            out->glibc_arenas += !seen;
+        }
+    }
+    proc_maps_free(&maps);
+
+    alloc_set_mode(prev);
+    free(th);
+    free(bt);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
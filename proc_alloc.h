@@ -0,0 +1,111 @@
+// proc_alloc.h - Capa de asignación intercambiable (glibc, arena bump o pool por
+// thread) y origen de cada alloc: arena de glibc, heap de thread, mmap o chunk propio
+#ifndef PROC_ALLOC_H
+#define PROC_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_maps.h"
+
+#define ALLOC_CHUNK       (1u << 20)            // unidad que un thread toma de la reserva
+#define ALLOC_RESERVE     (1024ul * ALLOC_CHUNK) // espacio virtual (MAP_NORESERVE) para arenas y pools
+#define ALLOC_MAX_THREADS 256                   // threads con arena/pool propios a la vez
+#define POOL_BLOCK        512                   // tamaño fijo de los bloques del pool
+
+typedef enum {
+    ALLOC_GLIBC = 0,        // malloc/free tal cual
+    ALLOC_ARENA,            // bump por thread; free no hace nada, se recupera con alloc_thread_reset
+    ALLOC_POOL,             // bloques de POOL_BLOCK por thread con lista libre
+    ALLOC_NMODES,
+} alloc_mode_t;
+
+// El modo vale para todo el proceso. pfree decide por la dirección quién
+// asignó el bloque, así que cambiarlo con allocs vivas es seguro.
+void         alloc_set_mode(alloc_mode_t mode);
+alloc_mode_t alloc_get_mode(void);
+const char  *alloc_mode_name(alloc_mode_t mode);
+int          alloc_parse_mode(const char *s, alloc_mode_t *out);   // -1 si no se reconoce
+
+// Lo que no cabe en el modo actual (más de POOL_BLOCK en el pool, más de
+// ALLOC_CHUNK/4 en la arena, reserva agotada) se sirve con malloc.
+void *palloc(size_t n);
+void  pfree(void *p);
+
+// Arena: todo lo asignado por este thread queda libre de golpe (los chunks
+// se conservan para la siguiente ronda). En glibc y pool no hace nada.
+void  alloc_thread_reset(void);
+
+// Al terminar el thread sus chunks vuelven a la reserva con MADV_DONTNEED
+// (los del pool solo si no queda ningún bloque vivo; si quedan, el siguiente
+// thread hereda la arena). Se llama sola desde el destructor de TLS.
+void  alloc_thread_release(void);
+
+// ========== ORIGEN DE UNA DIRECCIÓN ==========
+
+typedef enum {
+    AORIG_UNKNOWN = 0,
+    AORIG_ARENA,            // chunk de arena bump de un thread
+    AORIG_POOL,             // chunk de pool de un thread
+    AORIG_GLIBC_MAIN,       // arena principal de glibc (brk, [heap])
+    AORIG_GLIBC_THREAD,     // arena secundaria de glibc (heap de 64 MB alineado)
+    AORIG_GLIBC_MMAP,       // chunk servido con mmap propio (>= M_MMAP_THRESHOLD)
+} alloc_origin_kind_t;
+
+typedef struct {
+    alloc_origin_kind_t kind;
+    pid_t owner_tid;        // ARENA/POOL: thread dueño del chunk
+    char owner[16];         // su nombre al reclamarlo
+    uintptr_t region;       // ARENA/POOL: inicio del chunk; GLIBC_THREAD: inicio del heap
+    uintptr_t arena;        // GLIBC_*: dirección de la malloc_state
+    size_t size;            // GLIBC_*: tamaño del chunk de malloc (cabecera incluida)
+} alloc_origin_t;
+
+// p debe venir de palloc (o de malloc): para glibc se lee la cabecera del chunk
+int alloc_origin(const void *p, alloc_origin_t *out);
+int alloc_origin_format(const alloc_origin_t *o, char *buf, size_t len);
+
+// ========== ARENAS DE GLIBC EN MAPS ==========
+
+// Cada arena secundaria vive en heaps de GLIBC_HEAP_MAX alineados a su tamaño:
+// una parte rw-p (ya usada) seguida de ---p reservada
+#define GLIBC_HEAP_MAX (2ul * 4 * 1024 * 1024 * sizeof(long))
+
+typedef struct {
+    uintptr_t start;
+    size_t committed;       // rw-p
+    size_t reserved;        // rw-p + ---p contiguas
+    uintptr_t arena;        // heap_info->ar_ptr (solo si self; si no, 0)
+} glibc_heap_t;
+
+// self != 0 si m es el mapa de este proceso: entonces se lee ar_ptr.
+// Devuelve cuántos heaps hay (puede ser más que max).
+int glibc_heaps_scan(const proc_maps_t *m, int self, glibc_heap_t *out, int max);
+
+// ========== BANCO DE PRUEBAS ==========
+
+typedef struct {
+    int threads;
+    unsigned rounds;        // rondas por thread: objs allocs y luego objs frees
+    unsigned objs;          // vivos a la vez por thread, de 16 a POOL_BLOCK bytes
+    // ALLOC_GLIBC con otras funciones (p. ej. glibc sin interposición); NULL = malloc/free
+    void *(*malloc_fn)(size_t n);
+    void  (*free_fn)(void *p);
+} alloc_bench_cfg_t;
+
+typedef struct {
+    double mops;            // millones de alloc+free por segundo (todos los threads)
+    unsigned long live_kb;  // bytes pedidos vivos en el pico (suma de threads)
+    unsigned long rss_before_kb;
+    unsigned long rss_peak_kb;   // VmHWM tras clear_refs (0 si no se pudo reiniciar)
+    unsigned long rss_after_kb;  // tras el join: lo que el asignador se quedó
+    unsigned long rss_trim_kb;   // y tras malloc_trim(0)
+    int glibc_heaps;        // heaps de arenas secundarias en maps al terminar
+    int glibc_arenas;       // arenas distintas entre ellos
+} alloc_bench_result_t;
+
+// Threads con nombre "AB-<modo>-n"; deja el modo como estaba
+int alloc_bench_run(alloc_mode_t mode, const alloc_bench_cfg_t *cfg, alloc_bench_result_t *out);
+
+#endif // PROC_ALLOC_H
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -11,77 +12,197 @@
 #include <sys/syscall.h>
 #include <errno.h>
 #include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_maps.h"
+#include "proc_monitor.h"
+#include "proc_scan.h"
+#include "proc_pagemap.h"
+#include "thread_pool.h"
+#include "async_log.h"
+#include "proc_addr.h"
+#include "proc_elf.h"
+#include "proc_events.h"
+#include "proc_peek.h"
+#include "proc_numa.h"
+#include "sched_probe.h"
+#include "proc_ipc.h"
+#include "proc_alloc.h"
+#include "proc_stack.h"
+#include "proc_shutdown.h"
+#include "proc_perf.h"
+#include "proc_thp.h"
+#include "proc_tsdb.h"
+#include "proc_mtrack.h"
+#include "proc_scenario.h"
+#include "proc_footprint.h"
 
 // ========== CONSTANTES Y VARIABLES GLOBALES ==========
-#define COLOR_RESET   "\033[0m"
-#define COLOR_RED     "\033[31m"
-#define COLOR_GREEN   "\033[32m"
-#define COLOR_YELLOW  "\033[33m"
-#define COLOR_BLUE    "\033[34m"
-#define COLOR_MAGENTA "\033[35m"
-#define COLOR_CYAN    "\033[36m"
-#define COLOR_BOLD    "\033[1m"
 
 // Variables en diferentes secciones de memoria (para demostración)
-int global_var = 42;                     // .data (inicializada)
+// global_var y global_buffer tienen cada una su página en .data: ninguna otra
+// variable escrita antes comparte esas páginas, así que la primera escritura
+// tras fork() en demonstrate_cow_difference() es la que las copia. Sección
+// propia y no_reorder: global_var abre su página, global_buffer ocupa la
+// siguiente entera y la sección termina alineada.
+#define COW_PAGE 4096
+#define COW_DEMO __attribute__((section(".data.cow_demo"), aligned(COW_PAGE), no_reorder))
+int global_var COW_DEMO = 42;            // .data (inicializada)
 int global_uninit_var;                   // .bss (no inicializada)
 const int global_const = 100;            // .rodata (solo lectura)
-char global_buffer[256] = "Buffer global compartido"; // Para demostrar COW
+char global_buffer[COW_PAGE] COW_DEMO = "Buffer global compartido"; // Para demostrar COW
 
-// ========== FUNCIONES DE UTILIDAD ==========
+// Fijado opcional de la demostración (--pin): [0] = hijo, [1] y [2] = threads
+static struct { int set; numa_pin_t pin; } demo_pins[3];
 
-// Función para obtener PID del kernel (gettid wrapper con nombre correcto)
-static inline pid_t get_kernel_pid(void) {
-    return syscall(SYS_gettid);
-}
+// Alloc de heap de cada thread, publicada para medir su latencia desde el padre
+#define THREAD_HEAP_BYTES (16u << 20)
+static void *thread_heaps[2];
 
-// Función para obtener TGID (getpid wrapper con nombre correcto)
-static inline pid_t get_tgid(void) {
-    return getpid();  // getpid() realmente devuelve TGID
-}
+// Coste por sección (ciclos, fallos de página...) de cada thread: solo en la demostración
+static int phase_costs;
+static __thread perf_group_t phase_perf;
+static __thread perf_counts_t phase_start;
+static __thread char phase_title[48];
+static __thread pid_t phase_tried;      // thread que ya intentó abrir sus contadores
 
-// Obtener timestamp para ver concurrencia
+// ========== FUNCIONES DE UTILIDAD ==========
+
+// Obtener timestamp para ver concurrencia. Con el logger activo solo se
+// anota el instante: la línea la formatea el flusher.
 void print_timestamp(const char *prefix) {
+    if (alog_enabled()) {
+        alog_timestamp(prefix);
+        return;
+    }
     struct timespec ts;
     clock_gettime(CLOCK_REALTIME, &ts);
     printf("%s[%ld.%03ld] ", prefix, ts.tv_sec % 1000, ts.tv_nsec / 1000000);
 }
 
+// Lectura de los contadores de este thread (los abre la primera vez; tras
+// fork() descarta los heredados, que siguen midiendo al padre)
+static int phase_snapshot(perf_counts_t *out) {
+    if (!phase_costs) return -1;
+    if (perf_group_stale(&phase_perf)) {
+        perf_group_close(&phase_perf);
+        phase_title[0] = '\0';
+    }
+    if (!phase_perf.avail && phase_tried != get_kernel_pid()) {
+        static int warned;
+        phase_tried = get_kernel_pid();
+        if (perf_group_open(&phase_perf, 0) < 0) {
+            if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED)) {
+                alog_printf("  ⚠️  perf_event_open no disponible (%s): sin coste por sección\n", strerror(errno));
+            }
+        } else if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED)) {
+            if (!(phase_perf.avail & PERF_HW_MASK)) {
+                alog_printf("  ℹ️  Sin contadores hardware (%s, ¿VM sin PMU?): solo fallos de página y cambios de contexto\n",
+                            strerror(phase_perf.hw_errno));
+            } else {
+                alog_printf("  ℹ️  Contadores hardware por thread leídos con %s\n",
+                            phase_perf.rdpmc ? "rdpmc (sin syscall)" : "read() (el kernel no deja rdpmc)");
+            }
+        }
+    }
+    return phase_perf.avail ? perf_group_read(&phase_perf, out) : -1;
+}
+
+// Cierra la sección en curso de este thread e imprime lo que costó
+void print_phase_cost(void) {
+    perf_counts_t now, d;
+    if (phase_snapshot(&now) < 0 || !phase_title[0]) return;
+    perf_counts_delta(&phase_start, &now, &d);
+    char buf[160];
+    perf_counts_format(&d, buf, sizeof(buf));
+    alog_printf("  ⏱️  %s[%s]%s %s\n", COLOR_CYAN, phase_title, COLOR_RESET, buf);
+    phase_title[0] = '\0';
+}
+
 // Imprimir cabecera con color
 void print_header(const char *title, char color) {
-    printf("\n%s", color == 'R' ? COLOR_RED : 
+    print_phase_cost();
+    alog_printf("\n%s", color == 'R' ? COLOR_RED : 
                    color == 'G' ? COLOR_GREEN :
                    color == 'Y' ? COLOR_YELLOW :
                    color == 'B' ? COLOR_BLUE :
                    color == 'M' ? COLOR_MAGENTA : COLOR_CYAN);
-    printf("════════════════════════════════════════════════════════════\n");
-    printf("  %s%s\n", COLOR_BOLD, title);
-    printf("%s════════════════════════════════════════════════════════════%s\n", 
+    alog_printf("════════════════════════════════════════════════════════════\n");
+    alog_printf("  %s%s\n", COLOR_BOLD, title);
+    alog_printf("%s════════════════════════════════════════════════════════════%s\n", 
            color == 'R' ? COLOR_RED : 
            color == 'G' ? COLOR_GREEN :
            color == 'Y' ? COLOR_YELLOW :
            color == 'B' ? COLOR_BLUE :
            color == 'M' ? COLOR_MAGENTA : COLOR_CYAN, COLOR_RESET);
+    
+    // Empieza la sección de este thread (la lectura, después de imprimir)
+    if (phase_snapshot(&phase_start) == 0) {
+        snprintf(phase_title, sizeof(phase_title), "%s", title);
+    }
 }
 
 // Imprimir identificadores de forma clara
 void print_identifiers(const char *entity_name, int is_thread) {
-    printf("  🏷️  Identificadores de %s:\n", entity_name);
-    printf("    ┌─────────────────────────────────┐\n");
-    printf("    │ TGID (getpid):    %12d │\n", get_tgid());
-    printf("    │ PID kernel:       %12ld │\n", (long)get_kernel_pid());
+    alog_printf("  🏷️  Identificadores de %s:\n", entity_name);
+    alog_printf("    ┌─────────────────────────────────┐\n");
+    alog_printf("    │ TGID (getpid):    %12d │\n", get_tgid());
+    alog_printf("    │ PID kernel:       %12ld │\n", (long)get_kernel_pid());
     if (is_thread) {
-        printf("    │ pthread ID:      %12ld │\n", pthread_self());
+        alog_printf("    │ pthread ID:      %12ld │\n", pthread_self());
     }
-    printf("    │ En kernel:        task_struct #%ld │\n", (long)get_kernel_pid());
-    printf("    └─────────────────────────────────┘\n");
+    alog_printf("    │ En kernel:        task_struct #%ld │\n", (long)get_kernel_pid());
+    alog_printf("    └─────────────────────────────────┘\n");
 }
 
 // ========== FUNCIONES DE ANÁLISIS DE MEMORIA MEJORADAS ==========
 
+// De qué arena o mapeo salió un alloc y qué arenas de glibc hay en maps:
+// cada thread que llama a malloc acaba con la suya (hasta 8 por CPU)
+void print_alloc_origin(const proc_maps_t *maps, const void *p) {
+    alloc_origin_t org;
+    char where[192];
+    if (alloc_origin(p, &org) == 0) {
+        alloc_origin_format(&org, where, sizeof(where));
+        alog_printf("    Origen:  %s%s%s (asignador %s)\n", COLOR_YELLOW, where, COLOR_RESET,
+                    alloc_mode_name(alloc_get_mode()));
+    }
+    
+    glibc_heap_t heaps[16];
+    int n = glibc_heaps_scan(maps, 1, heaps, 16);
+    alog_printf("    Arenas:  principal de glibc en [heap] + %s%d%s heap%s de arenas de thread (%lu MB reservados c/u)\n",
+                COLOR_BLUE, n, COLOR_RESET, n == 1 ? "" : "s", GLIBC_HEAP_MAX >> 20);
+    for (int i = 0; i < n && i < 16; i++) {
+        int mine = org.kind == AORIG_GLIBC_THREAD && org.region == heaps[i].start;
+        alog_printf("             %p  arena %p  %5zu KB en uso%s\n", (void *)heaps[i].start,
+                    (void *)heaps[i].arena, heaps[i].committed >> 10, mine ? "  ← nuestro alloc" : "");
+    }
+}
+
+// Contadores de proc_mtrack de este thread y del proceso (con PROC_MTRACK=1)
+void print_mtrack_line(void) {
+    const mtrack_shared_t *s = mtrack_self();
+    if (!s || !mtrack_enabled()) return;
+    mtrack_totals_t t;
+    mtrack_totals(s, &t);
+    const mtrack_thread_t *me = mtrack_thread_find(s, get_kernel_pid());
+    uint64_t ab = me ? atomic_load_explicit(&me->alloc_bytes, memory_order_relaxed) : 0;
+    uint64_t fb = me ? atomic_load_explicit(&me->free_bytes, memory_order_relaxed) : 0;
+    unsigned long na = me ? (unsigned long)atomic_load_explicit(&me->allocs, memory_order_relaxed) : 0;
+    unsigned long nf = me ? (unsigned long)atomic_load_explicit(&me->frees, memory_order_relaxed) : 0;
+    alog_printf("    malloc:  este thread %s%lu allocs / %lu frees%s (neto %+.1f KB); ", COLOR_CYAN, na, nf, COLOR_RESET,
+                ((double)ab - (double)fb) / 1024.0);
+    alog_printf("proceso %.1f KB vivos%s (--mtrack %d)\n", t.live_bytes / 1024.0,
+                s->parent ? " con los heredados del padre" : "", get_tgid());
+}
+
 void print_memory_details(const char *entity_name, int is_thread) {
     print_timestamp("");
-    printf("%s%s%s analiza su memoria:\n", 
+    alog_printf("%s%s%s analiza su memoria:\n", 
            COLOR_BOLD, entity_name, COLOR_RESET);
     
     // Identificadores con nombres correctos
@@ -89,88 +210,94 @@ void print_memory_details(const char *entity_name, int is_thread) {
     
     // Variables para análisis
     int stack_var = get_tgid() % 1000;  // Variable local en stack
-    void *heap_var = malloc(128);       // Alloc en heap
+    void *heap_var = palloc(128);       // Alloc con el asignador elegido (--alloc)
     sprintf((char*)heap_var, "Alloc de %s", entity_name);
     
-    printf("\n  📍 Direcciones de variables:\n");
-    printf("    Constante (.rodata):   %s%p%s = %d\n", 
-           COLOR_CYAN, (void*)&global_const, COLOR_RESET, global_const);
-    printf("    Global var (.data):    %s%p%s = %d\n", 
-           COLOR_CYAN, (void*)&global_var, COLOR_RESET, global_var);
-    printf("    Global buffer:         %s%p%s = \"%.20s...\"\n", 
-           COLOR_CYAN, (void*)global_buffer, COLOR_RESET, global_buffer);
-    printf("    Stack local:           %s%p%s = %d\n", 
-           COLOR_YELLOW, (void*)&stack_var, COLOR_RESET, stack_var);
-    printf("    Heap alloc:            %s%p%s = \"%s\"\n", 
-           COLOR_YELLOW, heap_var, COLOR_RESET, (char*)heap_var);
+    // Clasificador de direcciones: secciones, heap, stacks de cada thread y mmap
+    addr_map_t am;
+    char cls[5][96];
+    const void *addrs[5] = { &global_const, &global_var, global_buffer, &stack_var, heap_var };
+    addr_map_init(&am);
+    int have_am = addr_map_build(&am, get_tgid()) == 0;
+    if (have_am) addr_map_add_current_thread(&am);
+    for (int i = 0; i < 5; i++) {
+        long idx = have_am ? addr_map_lookup(&am, (uintptr_t)addrs[i]) : -1;
+        addr_map_describe(&am, idx, cls[i], sizeof(cls[i]));
+    }
+    
+    alog_printf("\n  📍 Direcciones de variables:\n");
+    alog_printf("    Constante (.rodata):   %s%p%s = %d  → %s\n", 
+           COLOR_CYAN, (void*)&global_const, COLOR_RESET, global_const, cls[0]);
+    alog_printf("    Global var (.data):    %s%p%s = %d  → %s\n", 
+           COLOR_CYAN, (void*)&global_var, COLOR_RESET, global_var, cls[1]);
+    alog_printf("    Global buffer:         %s%p%s = \"%.20s...\"  → %s\n", 
+           COLOR_CYAN, (void*)global_buffer, COLOR_RESET, global_buffer, cls[2]);
+    alog_printf("    Stack local:           %s%p%s = %d  → %s\n", 
+           COLOR_YELLOW, (void*)&stack_var, COLOR_RESET, stack_var, cls[3]);
+    alog_printf("    Heap alloc:            %s%p%s = \"%s\"  → %s\n", 
+           COLOR_YELLOW, heap_var, COLOR_RESET, (char*)heap_var, cls[4]);
     
     // Analizar mapas de memoria de ESTE proceso/thread
-    printf("\n  📍 Análisis de /proc/%d/maps:\n", get_tgid());
-    
-    char maps_file[256];
-    snprintf(maps_file, sizeof(maps_file), "/proc/%d/maps", get_tgid());
-    FILE *fp = fopen(maps_file, "r");
-    if (fp) {
-        char line[512];
-        int found_heap = 0;
-        int found_stack = 0;
-        
-        while (fgets(line, sizeof(line), fp)) {
-            // Buscar heap
-            if (strstr(line, "[heap]")) {
-                printf("    Heap:    %s", line);
-                found_heap = 1;
-                
-                // Verificar si nuestro malloc está en esta región
-                unsigned long heap_start, heap_end;
-                if (sscanf(line, "%lx-%lx", &heap_start, &heap_end) == 2) {
-                    unsigned long alloc_addr = (unsigned long)heap_var;
-                    if (alloc_addr >= heap_start && alloc_addr < heap_end) {
-                        printf("            ✅ Nuestro alloc está en este heap\n");
-                    } else {
-                        printf("            ⚠️  Nuestro alloc NO está en este heap\n");
-                        printf("               (probablemente mmap'd por ser grande)\n");
-                    }
-                }
-            }
-            // Buscar stack
-            else if (strstr(line, "[stack]")) {
-                printf("    Stack:   %s", line);
-                found_stack = 1;
-            }
-            // Buscar región de código
-            else if (strstr(line, "/proc/self/exe") || strstr(line, ".so")) {
-                // Mostrar solo la primera línea de código/libs
-                static int code_shown = 0;
-                if (!code_shown) {
-                    printf("    Código:  %.60s...\n", line);
-                    code_shown = 1;
-                }
+    alog_printf("\n  📍 Análisis de /proc/%d/maps:\n", get_tgid());
+    
+    proc_maps_t maps;
+    char line[MAPS_LINE_MAX];
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, get_tgid()) == 0) {
+        // Buscar heap
+        const maps_region_t *heap = proc_maps_find_kind(&maps, MAPS_KIND_HEAP);
+        if (heap) {
+            proc_maps_format_region(&maps, heap, line, sizeof(line));
+            alog_printf("    Heap:    %s\n", line);
+            
+            // Verificar si nuestro malloc está en esta región
+            const maps_region_t *owner = proc_maps_find(&maps, (uintptr_t)heap_var);
+            if (owner == heap) {
+                alog_printf("            ✅ Nuestro alloc está en este heap\n");
+            } else {
+                alog_printf("            ⚠️  Nuestro alloc NO está en este heap: está en %s\n", cls[4]);
             }
+        } else {
+            alog_printf("    Heap:    (no se encontró sección [heap])\n");
+            alog_printf("             Puede que malloc use mmap para allocations grandes\n");
         }
+        print_alloc_origin(&maps, heap_var);
+        print_mtrack_line();
         
-        if (!found_heap) {
-            printf("    Heap:    (no se encontró sección [heap])\n");
-            printf("             Puede que malloc use mmap para allocations grandes\n");
-        }
-        if (!found_stack) {
-            printf("    Stack:   (no se encontró sección [stack])\n");
+        // Buscar stack
+        const maps_region_t *stack = proc_maps_find_kind(&maps, MAPS_KIND_STACK);
+        if (stack) {
+            proc_maps_format_region(&maps, stack, line, sizeof(line));
+            alog_printf("    Stack:   %s\n", line);
+        } else {
+            alog_printf("    Stack:   (no se encontró sección [stack])\n");
         }
         
-        fclose(fp);
+        // Región de código: la que contiene esta misma función
+        const maps_region_t *code = proc_maps_find(&maps, (uintptr_t)&print_memory_details);
+        if (code) {
+            proc_maps_format_region(&maps, code, line, sizeof(line));
+            alog_printf("    Código:  %s\n", line);
+        }
     } else {
-        printf("    ❌ No se pudo abrir %s\n", maps_file);
+        alog_printf("    ❌ No se pudo leer /proc/%d/maps\n", get_tgid());
     }
+    proc_maps_free(&maps);
+    addr_map_free(&am);
     
-    free(heap_var);
+    pfree(heap_var);
 }
 
 // Función especial para mostrar diferencia padre/hijo después de COW
 void demonstrate_cow_difference(int is_child) {
     print_timestamp("");
-    printf("🔬 %s modificando variables para demostrar COW:\n", 
+    alog_printf("🔬 %s modificando variables para demostrar COW:\n", 
            is_child ? "HIJO" : "PADRE");
     
+    // Fallos de página de las escrituras: la primera en cada página compartida copia
+    perf_counts_t before, after, d;
+    int measured = phase_snapshot(&before) == 0;
+    
     // Guardar valores antiguos
     int old_global = global_var;
     char old_buffer[32];
@@ -185,17 +312,780 @@ void demonstrate_cow_difference(int is_child) {
         global_var = 7777;
         strcpy(global_buffer, "MODIFICADO por el PADRE");
     }
+    measured = measured && phase_snapshot(&after) == 0;
     
-    printf("    global_var:    %d → %s%d%s\n", 
+    alog_printf("    global_var:    %d → %s%d%s\n", 
            old_global, COLOR_RED, global_var, COLOR_RESET);
-    printf("    global_buffer: \"%.20s...\" → \"%s%.20s...%s\"\n", 
+    alog_printf("    global_buffer: \"%.20s...\" → \"%s%.20s...%s\"\n", 
            old_buffer, COLOR_RED, global_buffer, COLOR_RESET);
     
+    if (measured) {
+        char buf[160];
+        perf_counts_delta(&before, &after, &d);
+        perf_counts_format(&d, buf, sizeof(buf));
+        alog_printf("    ⏱️  Coste de las escrituras: %s%s%s\n", COLOR_YELLOW, buf, COLOR_RESET);
+    }
+    
     print_timestamp("");
-    printf("✅ %s ahora tiene sus propias páginas (COW activado)\n",
+    alog_printf("✅ %s ahora tiene sus propias páginas (COW activado)\n",
            is_child ? "HIJO" : "PADRE");
 }
 
+// Límites de secciones definidos por el enlazador
+extern char __data_start[], edata[], __bss_start[], end[];
+
+// Mide con pagemap cuántas páginas de .data, .bss y heap siguen compartidas
+// entre padre e hijo (mismo marco físico) y cuántas ya se copiaron
+void measure_cow_pages(pid_t parent, pid_t child) {
+    print_timestamp("");
+    alog_printf("🔬 Páginas compartidas padre↔hijo según /proc/<pid>/pagemap:\n");
+    
+    pagemap_t pm_parent, pm_child;
+    int ok = pagemap_open(&pm_parent, parent) == 0;
+    ok = pagemap_open(&pm_child, child) == 0 && ok;
+    if (!ok) {
+        alog_printf("    ❌ No se pudo abrir pagemap (%s)\n", strerror(errno));
+        pagemap_close(&pm_parent);
+        pagemap_close(&pm_child);
+        return;
+    }
+    
+    struct { const char *name; uintptr_t start, end; } ranges[3] = {
+        { ".data", (uintptr_t)__data_start, (uintptr_t)edata },
+        { ".bss",  (uintptr_t)__bss_start,  (uintptr_t)end },
+        { "heap",  0, 0 },
+    };
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, parent) == 0) {
+        const maps_region_t *heap = proc_maps_find_kind(&maps, MAPS_KIND_HEAP);
+        if (heap) {
+            ranges[2].start = heap->start;
+            ranges[2].end = heap->end;
+        }
+    }
+    proc_maps_free(&maps);
+    
+    alog_printf("    %-6s %7s %10s %12s %12s\n", "Región", "Páginas", "Compartid.", "Privad.padre", "Privad.hijo");
+    int pfn_known = 0;
+    for (int i = 0; i < 3; i++) {
+        cow_stats_t st;
+        if (ranges[i].end <= ranges[i].start) continue;
+        if (cow_compare(&pm_parent, &pm_child, ranges[i].start, ranges[i].end, &st) < 0) continue;
+        pfn_known |= st.pfn_known;
+        alog_printf("    %-6s %7zu %s%10zu%s %12zu %12zu\n", ranges[i].name, st.pages,
+               COLOR_GREEN, st.shared, COLOR_RESET, st.private_a, st.private_b);
+    }
+    if (!pfn_known) {
+        alog_printf("    ⚠️  Sin CAP_SYS_ADMIN los PFN se leen como 0: se usa el bit \"exclusivo\" de pagemap\n");
+    }
+    
+    smaps_rollup_t ra, rb;
+    if (smaps_rollup_read(parent, &ra) == 0 && smaps_rollup_read(child, &rb) == 0) {
+        alog_printf("    smaps_rollup  padre: Rss=%lu kB Pss=%lu kB Shared=%lu kB Private=%lu kB\n",
+               ra.rss_kb, ra.pss_kb, ra.shared_clean_kb + ra.shared_dirty_kb,
+               ra.private_clean_kb + ra.private_dirty_kb);
+        alog_printf("    smaps_rollup  hijo:  Rss=%lu kB Pss=%lu kB Shared=%lu kB Private=%lu kB\n",
+               rb.rss_kb, rb.pss_kb, rb.shared_clean_kb + rb.shared_dirty_kb,
+               rb.private_clean_kb + rb.private_dirty_kb);
+    }
+    
+    pagemap_close(&pm_parent);
+    pagemap_close(&pm_child);
+}
+
+// Tabla lado a lado de las variables de a y b (b puede ser NULL); "≠" donde difieren
+void print_peek_table(const peek_t *a, const peek_t *b) {
+    char va[96], vb[96], ha[32], hb[32];
+    snprintf(ha, sizeof(ha), "PID %d", a->pid);
+    snprintf(hb, sizeof(hb), "PID %d", b ? b->pid : 0);
+    alog_printf("    %-16s %-34s %s\n", "Variable", ha, b ? hb : "");
+    for (size_t i = 0; i < a->nvars; i++) {
+        peek_format_value(a, i, va, sizeof(va));
+        if (!b) {
+            alog_printf("    %-16s %s\n", a->vars[i].name, va);
+            continue;
+        }
+        peek_format_value(b, i, vb, sizeof(vb));
+        int diff = peek_differs(a, b, i);
+        alog_printf("    %-16s %-34s %s%s%s%s\n", a->vars[i].name, va, diff ? COLOR_RED : "", vb,
+                    diff ? "  ≠" : "", diff ? COLOR_RESET : "");
+    }
+}
+
+// Lee global_var y global_buffer de los dos procesos sin detenerlos (en lugar
+// de gdb -p). Devuelve en *child_var el global_var del hijo si se pudo leer.
+int peek_globals(pid_t parent, pid_t child, int *child_var) {
+    static char *const names[] = { "global_var", "global_buffer" };
+    peek_t pp, pc;
+    peek_init(&pp, parent);
+    peek_init(&pc, child);
+    int ok = peek_add_symbols(&pp, names, 2) == 2 && peek_add_symbols(&pc, names, 2) == 2 &&
+             peek_read(&pp) >= 0 && peek_read(&pc) >= 0;
+    
+    print_timestamp("");
+    if (ok) {
+        alog_printf("🔎 Variables leídas con process_vm_readv (1 llamada por proceso, %.1f µs, sin detenerlos):\n",
+                    (pp.read_ns + pc.read_ns) / 1e3);
+        print_peek_table(&pp, &pc);
+        if (pc.vars[0].valid) memcpy(child_var, peek_value(&pc, 0), sizeof(int));
+    } else {
+        alog_printf("    ❌ No se pudieron leer las variables remotas (%s)\n", strerror(errno));
+    }
+    peek_free(&pp);
+    peek_free(&pc);
+    return ok && pc.nvars && pc.vars[0].valid ? 0 : -1;
+}
+
+// Lee el mensaje que el hijo dejó en el anillo y comprueba con pagemap que
+// sus páginas son las mismas en los dos procesos (global_buffer ya no)
+void receive_child_message(ipc_ring_t *chan, pid_t parent, pid_t child) {
+    size_t len;
+    const char *msg = ipc_ring_peek(chan, &len);
+    print_timestamp("");
+    if (!msg) {
+        alog_printf("📭 El hijo aún no publicó nada en el anillo compartido\n");
+        return;
+    }
+    // El hijo lo formateó con snprintf dentro del mensaje: termina en '\0'
+    alog_printf("📬 Mensaje del hijo leído en el sitio del anillo memfd: %s%s%s\n", COLOR_GREEN,
+                len && memchr(msg, '\0', len) ? msg : "(mal formado)", COLOR_RESET);
+    ipc_ring_release(chan);
+    
+    pagemap_t pa, pb;
+    int ok = pagemap_open(&pa, parent) == 0;
+    ok = pagemap_open(&pb, child) == 0 && ok;
+    cow_stats_t ring, buf;
+    if (ok && cow_compare(&pa, &pb, (uintptr_t)chan->hdr, (uintptr_t)chan->hdr + chan->map_len, &ring) == 0 &&
+        cow_compare(&pa, &pb, (uintptr_t)global_buffer, (uintptr_t)global_buffer + sizeof(global_buffer), &buf) == 0) {
+        alog_printf("    Anillo (MAP_SHARED): %s%zu de %zu%s páginas comparten marco físico\n",
+                    COLOR_GREEN, ring.shared, ring.pages, COLOR_RESET);
+        alog_printf("    global_buffer (COW): %s%zu de %zu%s: cada proceso escribió su copia\n",
+                    COLOR_RED, buf.shared, buf.pages, COLOR_RESET);
+    }
+    pagemap_close(&pa);
+    pagemap_close(&pb);
+}
+
+// ========== AFINIDAD Y NUMA ==========
+
+// CPUs permitidas y última CPU del thread que llama, y nodo NUMA de la página
+// de su stack y de otra dirección (move_pages en modo consulta) junto con el
+// reparto de toda su VMA según numa_maps
+void print_numa_placement(const void *stack, const char *other_name, const void *other) {
+    numa_topo_t topo;
+    numa_topo_load(&topo);
+    cpu_set_t allowed;
+    char cpus[128] = "?";
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) cpu_list_format(&allowed, cpus, sizeof(cpus));
+    else CPU_ZERO(&allowed);
+    int cpu = sched_getcpu();
+    int cpu_node = numa_cpu_node(&topo, cpu);
+    
+    print_timestamp("");
+    alog_printf("🧭 Afinidad y ubicación NUMA (%d nodo%s):\n", topo.nnodes, topo.nnodes == 1 ? "" : "s");
+    alog_printf("  CPUs permitidas: %s%s%s (%d)\n", COLOR_BLUE, cpus, COLOR_RESET, CPU_COUNT(&allowed));
+    alog_printf("  Última CPU:      %s%d%s (nodo %d)\n", COLOR_BLUE, cpu, COLOR_RESET, cpu_node);
+    
+    const struct { const char *name; const void *p; } where[2] = { { "Stack", stack }, { other_name, other } };
+    for (int i = 0; i < 2; i++) {
+        numa_vma_t vma;
+        char pages[160] = "?";
+        if (numa_maps_lookup(get_tgid(), (uintptr_t)where[i].p, &vma) == 0) {
+            numa_vma_format(&vma, pages, sizeof(pages));
+        } else {
+            strcpy(vma.policy, "?");
+        }
+        int node = numa_addr_node(0, where[i].p);
+        if (node >= 0) {
+            alog_printf("  %-13s página en nodo %s%d%s %s  · VMA (%s): %s\n", where[i].name, COLOR_BLUE, node,
+                        COLOR_RESET, node == cpu_node ? "(local)" : COLOR_RED "(REMOTA)" COLOR_RESET,
+                        vma.policy, pages);
+        } else {
+            alog_printf("  %-13s página no consultable (%s)  · VMA (%s): %s\n", where[i].name, strerror(-node),
+                        vma.policy, pages);
+        }
+    }
+}
+
+// Aplica el fijado de --pin (si lo hay) al thread que llama
+void apply_demo_pin(int idx, const char *who) {
+    if (!demo_pins[idx].set) return;
+    char desc[160];
+    numa_pin_format(&demo_pins[idx].pin, desc, sizeof(desc));
+    print_timestamp("");
+    if (numa_pin_self(&demo_pins[idx].pin) == 0) {
+        alog_printf("📌 %s fijado a %s%s%s\n", who, COLOR_BLUE, desc, COLOR_RESET);
+    } else {
+        alog_printf("❌ No se pudo fijar %s a %s: %s\n", who, desc, strerror(errno));
+    }
+}
+
+// Latencia de carga desde las CPUs de cada nodo con la memoria en cada nodo:
+// global_buffer (carga tras clflush) y la alloc de heap de un thread
+// (recorrido de punteros). Las páginas se migran con move_pages y al final
+// vuelven a su nodo; la afinidad del thread que llama se restaura.
+void measure_numa_latency(void *heap, size_t heap_len) {
+    numa_topo_t topo;
+    if (numa_topo_load(&topo) < 0) {
+        alog_printf("    ❌ No se pudo leer la topología NUMA\n");
+        return;
+    }
+    cpu_set_t saved;
+    sched_getaffinity(0, sizeof(saved), &saved);
+    int home_g = numa_addr_node(0, global_buffer);
+    int home_h = heap ? numa_addr_node(0, heap) : -1;
+    
+    print_timestamp("");
+    alog_printf("⏱️  Latencia de memoria por nodo (global_buffer: carga tras clflush; heap de THREAD-1: %zu MB en orden aleatorio)\n",
+                heap_len >> 20);
+    alog_printf("    %-10s %-10s %-8s %16s %16s\n", "CPU nodo", "Memoria", "", "global_buffer", "heap thread");
+    
+    double sum[2][2] = { { 0, 0 }, { 0, 0 } };   // [remota][global/heap]
+    int cnt[2] = { 0, 0 };
+    for (int mi = 0; mi < topo.nnodes; mi++) {
+        int mem = topo.nodes[mi];
+        if (!topo.has_memory[mem]) continue;
+        int moved_g = numa_move_range(global_buffer, sizeof(global_buffer), mem) > 0;
+        int moved_h = heap && numa_move_range(heap, heap_len, mem) > 0;
+        for (int ci = 0; ci < topo.nnodes; ci++) {
+            int cn = topo.nodes[ci];
+            if (CPU_COUNT(&topo.cpus[cn]) == 0 || sched_setaffinity(0, sizeof(topo.cpus[cn]), &topo.cpus[cn]) < 0) continue;
+            double g = moved_g ? numa_flush_load_ns(global_buffer, 20000) : 0;
+            double h = moved_h ? numa_chase_ns(heap, heap_len, 2000000) : 0;
+            int remote = cn != mem;
+            sum[remote][0] += g;
+            sum[remote][1] += h;
+            cnt[remote]++;
+            char gs[24] = "no movible", hs[24] = "no movible";
+            if (moved_g) snprintf(gs, sizeof(gs), g > 0 ? "%.1f ns" : "n/d", g);
+            if (moved_h) snprintf(hs, sizeof(hs), "%.1f ns", h);
+            alog_printf("    %-10d %-10d %s%-8s%s %16s %16s\n", cn, mem, remote ? COLOR_RED : COLOR_GREEN,
+                        remote ? "remota" : "local", COLOR_RESET, gs, hs);
+        }
+    }
+    sched_setaffinity(0, sizeof(saved), &saved);
+    if (home_g >= 0) numa_move_range(global_buffer, sizeof(global_buffer), home_g);
+    if (home_h >= 0) numa_move_range(heap, heap_len, home_h);
+    
+    if (cnt[0] && cnt[1] && sum[0][1] > 0) {
+        alog_printf("    Remota/local: global_buffer ×%.2f, heap ×%.2f\n",
+                    sum[0][0] > 0 ? (sum[1][0] / cnt[1]) / (sum[0][0] / cnt[0]) : 0.0,
+                    (sum[1][1] / cnt[1]) / (sum[0][1] / cnt[0]));
+    } else if (topo.nnodes == 1) {
+        alog_printf("    Un solo nodo NUMA: solo hay acceso local (en 2 sockets aparecen las filas remotas)\n");
+    }
+}
+
+// ========== STACKS ==========
+
+// Stack del thread que llama: mapeo, guarda y marca de agua según pagemap
+// (precisión de página) y según el pintado de stack_paint_self (de byte)
+void print_thread_stack(void) {
+    proc_maps_t maps;
+    pagemap_t pm;
+    stack_usage_t su;
+    proc_maps_init(&maps);
+    int have_pm = pagemap_open(&pm, get_tgid()) == 0;
+    int ok = proc_maps_load(&maps, get_tgid()) == 0 &&
+             stack_usage_measure(get_tgid(), get_kernel_pid(), &maps, have_pm ? &pm : NULL, &su) == 0;
+    if (have_pm) pagemap_close(&pm);
+    proc_maps_free(&maps);
+    
+    print_timestamp("");
+    if (!ok) {
+        alog_printf("📏 No se pudo medir el stack (%s)\n", strerror(errno));
+        return;
+    }
+    alog_printf("📏 Stack: %s%zu KB%s mapeados + %zu KB de guarda, %zu KB residentes\n",
+                COLOR_BLUE, (su.hi - su.lo) >> 10, COLOR_RESET, su.guard >> 10, su.resident >> 10);
+    alog_printf("   Marca de agua (%s%s): %s%zu KB%s desde el tope\n", su.method == STACK_BY_PAGEMAP ? "pagemap" : "mincore",
+                su.painted ? " sin lo que tocó el pintado" : "", COLOR_YELLOW, su.hwm >> 10, COLOR_RESET);
+    stack_paint_t paint;
+    if (stack_painted_usage(&paint) == 0) {
+        alog_printf("   Pintado: %zu KB bajo el SP inicial (marca antes de pintar %zu KB); profundidad máxima %s%zu B%s%s\n",
+                    paint.painted >> 10, paint.hwm_before >> 10, COLOR_YELLOW, paint.depth, COLOR_RESET,
+                    paint.overflow ? " (se usó toda la ventana: cota inferior)" : "");
+    }
+}
+
+// Tabla de stacks de todos los threads de pid y cuánto se ahorraría con un
+// tamaño ajustado a la mayor marca de agua en project threads
+void print_stack_table(pid_t pid, int project) {
+    stack_usage_t *su = NULL;
+    size_t cap = 0;
+    ssize_t n = stack_usage_scan(pid, &su, &cap);
+    if (n < 0) {
+        alog_printf("    ❌ No se pudieron leer los stacks de %d (%s)\n", pid, strerror(errno));
+        return;
+    }
+    alog_printf("    %-8s %-16s %10s %8s %10s %10s  %s\n", "TID", "Nombre", "Mapeo KB", "Guarda", "Resid. KB", "Marca KB", "");
+    size_t vsz = 0, rss = 0, max_hwm = 0, thread_map = 0;
+    int measured = 0, threads = 0;
+    for (ssize_t i = 0; i < n; i++) {
+        const stack_usage_t *s = &su[i];
+        if (!s->lo) {
+            alog_printf("    %-8d %-16s %10s %8s %10s %10s  corriendo: SP no visible\n", s->tid, s->comm, "-", "-", "-", "-");
+            continue;
+        }
+        char note[64] = "";
+        if (s->main && s->limit) snprintf(note, sizeof(note), "principal, crece hasta %zu KB", s->limit >> 10);
+        else if (s->main) snprintf(note, sizeof(note), "principal, sin límite");
+        if (s->painted) snprintf(note + strlen(note), sizeof(note) - strlen(note), "%spintado: %zu KB",
+                                 note[0] ? "; " : "", s->painted >> 10);
+        alog_printf("    %-8d %-16s %10zu %8zu %10zu ", s->tid, s->comm, (s->hi - s->lo) >> 10,
+                    s->guard >> 10, s->resident >> 10);
+        alog_printf("%s%10zu%s  %s\n", COLOR_YELLOW, s->hwm >> 10, COLOR_RESET, note);
+        measured++;
+        vsz += s->hi - s->lo + s->guard;
+        rss += s->resident;
+        if (s->hwm > max_hwm) max_hwm = s->hwm;
+        if (!s->main && s->hi - s->lo + s->guard > thread_map) thread_map = s->hi - s->lo + s->guard;
+        threads += !s->main;
+    }
+    alog_printf("    %d stacks medidos: %zu KB virtuales, %s%zu KB%s residentes, marca máxima %zu KB\n",
+                measured, vsz >> 10, COLOR_GREEN, rss >> 10, COLOR_RESET, max_hwm >> 10);
+    if (threads > 0 && project > 0) {
+        size_t suggest = stack_suggest_size(max_hwm);
+        size_t guard = (size_t)sysconf(_SC_PAGESIZE);
+        alog_printf("    Sugerencia: pthread_attr_setstacksize(%zu KB) (2× la marca máxima). Con %d threads:\n",
+                    suggest >> 10, project);
+        alog_printf("      %zu MB virtuales de stack ahora → %s%zu MB%s ajustado\n",
+                    thread_map * (size_t)project >> 20, COLOR_GREEN, (suggest + guard) * (size_t)project >> 20, COLOR_RESET);
+    }
+    free(su);
+}
+
+// ========== HUGE PAGES ==========
+
+// Nombre legible de una región: stack de qué thread, [heap], .data de qué binario...
+static void thp_region_label(const proc_maps_t *maps, const smaps_vma_t *v, const stack_usage_t *su, ssize_t nsu,
+                             char *out, size_t len) {
+    for (ssize_t i = 0; i < nsu; i++) {
+        if (su[i].lo == v->start) {
+            snprintf(out, len, su[i].main ? "[stack]" : "stack %s", su[i].comm);
+            return;
+        }
+    }
+    const maps_region_t *r = proc_maps_find(maps, v->start);
+    if (!r) {
+        snprintf(out, len, "?");
+        return;
+    }
+    const char *name = proc_maps_name(maps, r);
+    const char *base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    switch (r->kind) {
+        case MAPS_KIND_HEAP:  snprintf(out, len, "[heap]"); break;
+        case MAPS_KIND_STACK: snprintf(out, len, "[stack]"); break;
+        case MAPS_KIND_ANON:  snprintf(out, len, "anon"); break;
+        case MAPS_KIND_FILE:
+            if ((r->perms & (MAPS_PERM_WRITE | MAPS_PERM_SHARED)) == MAPS_PERM_WRITE) snprintf(out, len, ".data %s", base);
+            else snprintf(out, len, "%s", base);
+            break;
+        default:              snprintf(out, len, "%s", name); break;
+    }
+}
+
+// Cobertura de huge pages de cada región de pid según smaps. Sin all solo
+// las escribibles con algo residente: heap, stacks, .data/.bss y mmaps.
+void print_thp_table(pid_t pid, int all) {
+    thp_config_t cfg;
+    thp_config_read(&cfg);
+    smaps_vma_t *v = NULL;
+    size_t cap = 0;
+    ssize_t n = smaps_load(pid, &v, &cap);
+    if (n < 0) {
+        alog_printf("    ❌ No se pudo leer /proc/%d/smaps (%s)\n", pid, strerror(errno));
+        return;
+    }
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    proc_maps_load(&maps, pid);
+    stack_usage_t *su = NULL;
+    size_t su_cap = 0;
+    ssize_t nsu = stack_usage_scan(pid, &su, &su_cap);
+    
+    alog_printf("    THP: enabled=%s%s%s defrag=%s, PMD de %lu KB\n", COLOR_BOLD, cfg.enabled, COLOR_RESET,
+                cfg.defrag, (cfg.pmd_size ? cfg.pmd_size : THP_PMD_SIZE) >> 10);
+    alog_printf("    hugetlbfs: %lu de %lu páginas de %lu KB libres (vm.nr_hugepages)\n\n",
+                cfg.hugetlb_free, cfg.hugetlb_total, cfg.hugetlb_kb);
+    alog_printf("    %-22s %-14s %9s %9s %9s %7s ", "Región", "Inicio", "Tam. KB", "Rss KB", "Pss KB", "Swap KB");
+    alog_printf("%9s %5s %-4s\n", "Huge KB", "%", "Flag");
+    unsigned long rss = 0, huge = 0, eligible_rss = 0;
+    for (ssize_t i = 0; i < n; i++) {
+        const smaps_vma_t *x = &v[i];
+        const maps_region_t *r = proc_maps_find(&maps, x->start);
+        if (!all && (!r || !(r->perms & MAPS_PERM_WRITE) || x->rss_kb == 0)) continue;
+        char label[40];
+        thp_region_label(&maps, x, su, nsu > 0 ? nsu : 0, label, sizeof(label));
+        unsigned long hk = smaps_huge_kb(x);
+        const char *reason = thp_gap_reason(x, &cfg);
+        const char *flag = x->vmflags & SMAPS_VM_HT ? "ht" : x->vmflags & SMAPS_VM_HG ? "hg" :
+                           x->vmflags & SMAPS_VM_NH ? "nh" : "";
+        alog_printf("    %-22.22s 0x%012lx %9lu %9lu %9lu %7lu ", label, (unsigned long)x->start,
+                    (unsigned long)((x->end - x->start) >> 10), x->rss_kb, x->pss_kb, x->swap_kb);
+        alog_printf("%s%9lu %4lu%%%s %-4s %s\n", hk ? COLOR_GREEN : "", hk, x->rss_kb ? hk * 100 / x->rss_kb : 0,
+                    COLOR_RESET, flag, reason ? reason : "");
+        rss += x->rss_kb;
+        huge += hk;
+        if (x->thp_eligible > 0) eligible_rss += x->rss_kb;
+    }
+    alog_printf("    Total: %lu KB residentes, %s%lu KB en huge pages (%lu%%)%s; %lu KB en regiones elegibles para THP\n",
+                rss, COLOR_GREEN, huge, rss ? huge * 100 / rss : 0, COLOR_RESET, eligible_rss);
+    free(su);
+    proc_maps_free(&maps);
+    free(v);
+}
+
+// ========== HUELLA DE MEMORIA (PSS/USS) ==========
+
+// USS, PSS y compartido de cada proceso del árbol de root frente a la suma
+// de RSS. Con regions, también las top regiones por PSS y, si kpagecount es
+// legible, qué parte de cada una comparte el árbol solo consigo mismo.
+void print_footprint_table(pid_t root, int regions, int top) {
+    fp_tree_t t;
+    if (fp_tree_measure(&t, root) < 0) {
+        alog_printf("    ❌ No se pudo leer el árbol de %d (%s)\n", root, strerror(errno));
+        return;
+    }
+    if (regions) fp_tree_regions(&t);
+    int deep = regions && t.deep;
+    alog_printf("    %-18s %-16s %9s %9s %9s %9s %8s", "PID", "Nombre", "RSS MB", "PSS MB", "USS MB", "Comp. MB", "Swap MB");
+    if (deep) alog_printf(" %9s %9s %9s", "Excl. MB", "Árbol MB", "Fuera MB");
+    alog_printf("\n");
+    unsigned long child_uss = 0;
+    int children = 0;
+    for (size_t i = 0; i < t.n; i++) {
+        const fp_proc_t *p = &t.procs[i];
+        char pid[32];
+        // Sangría por nivel; relleno a mano: "└" ocupa 3 bytes y una columna
+        int len = snprintf(pid, sizeof(pid), "%*s%s%d", p->depth * 2, "", p->depth ? "└ " : "", p->pid);
+        for (int w = len - (p->depth ? 2 : 0); w < 18 && len < (int)sizeof(pid) - 1; w++) pid[len++] = ' ';
+        pid[len] = '\0';
+        if (!p->ok) {
+            alog_printf("    %s %-16s  (terminó o sin permiso)\n", pid, p->comm);
+            continue;
+        }
+        unsigned long uss = smaps_uss_kb(&p->mem);
+        alog_printf("    %s %-16s %9.1f %9.1f ", pid, p->comm, p->mem.rss_kb / 1024.0, p->mem.pss_kb / 1024.0);
+        alog_printf("%s%9.1f%s %9.1f %8.1f", COLOR_GREEN, uss / 1024.0, COLOR_RESET,
+                    (p->mem.rss_kb - uss) / 1024.0, p->mem.swap_kb / 1024.0);
+        if (deep) alog_printf(" %9.1f %9.1f %9.1f", p->excl_kb / 1024.0, p->tree_kb / 1024.0, p->outside_kb / 1024.0);
+        alog_printf("\n");
+        if (p->depth > 0) {
+            child_uss += uss;
+            children++;
+        }
+    }
+    unsigned long tuss = smaps_uss_kb(&t.total);
+    alog_printf("    %-18s %-16s %9.1f %9.1f ", "Total", "", t.total.rss_kb / 1024.0, t.total.pss_kb / 1024.0);
+    alog_printf("%s%9.1f%s %9.1f %8.1f\n", COLOR_GREEN, tuss / 1024.0, COLOR_RESET,
+                (t.total.rss_kb - tuss) / 1024.0, t.total.swap_kb / 1024.0);
+    
+    alog_printf("    Suma de RSS %s%.1f MB%s = %.1f× la PSS (%.1f MB): cada página compartida cuenta en cada proceso\n",
+                COLOR_RED, t.total.rss_kb / 1024.0, COLOR_RESET,
+                t.total.pss_kb ? (double)t.total.rss_kb / t.total.pss_kb : 0, t.total.pss_kb / 1024.0);
+    alog_printf("    PSS: anónima %.1f MB, archivos %.1f MB, shmem %.1f MB\n", t.total.pss_anon_kb / 1024.0,
+                t.total.pss_file_kb / 1024.0, t.total.pss_shmem_kb / 1024.0);
+    if (children > 0) {
+        alog_printf("    USS medio por hijo: %s%.2f MB%s (lo que añade cada worker más a un pool prefork)\n",
+                    COLOR_GREEN, child_uss / 1024.0 / children, COLOR_RESET);
+    }
+    alog_printf("    %zu smaps_rollup leídos en %.2f ms\n", t.n, t.rollup_ms);
+    if (!regions) {
+        fp_tree_free(&t);
+        return;
+    }
+    
+    if (deep) {
+        alog_printf("    Marcos del árbol (kpagecount): %s%.1f MB solo del árbol%s (se liberan si termina entero), ",
+                    COLOR_GREEN, t.tree_unique_kb / 1024.0, COLOR_RESET);
+        alog_printf("%.1f MB compartidos con procesos de fuera\n", t.tree_outside_kb / 1024.0);
+    } else {
+        alog_printf("    Sin kpagecount (%s): solo smaps por región; hace falta CAP_SYS_ADMIN para PFN\n",
+                    strerror(t.deep_errno));
+    }
+    alog_printf("\n    %-30s %5s %9s %9s %9s", "Región", "Proc.", "RSS MB", "PSS MB", "USS MB");
+    if (deep) alog_printf(" %9s %9s %9s", "Excl. MB", "Árbol MB", "Fuera MB");
+    alog_printf("\n");
+    for (size_t i = 0; i < t.nmaps && (int)i < top; i++) {
+        const fp_map_t *m = &t.maps[i];
+        alog_printf("    %-30.30s %5d %9.1f %9.1f %9.1f", m->name, m->nprocs, m->mem.rss_kb / 1024.0,
+                    m->mem.pss_kb / 1024.0, smaps_uss_kb(&m->mem) / 1024.0);
+        if (deep) alog_printf(" %9.1f %9.1f %9.1f", m->excl_kb / 1024.0, m->tree_kb / 1024.0, m->outside_kb / 1024.0);
+        alog_printf("\n");
+    }
+    alog_printf("    %zu regiones distintas; smaps%s en %.2f ms\n", t.nmaps, deep ? " + pagemap + kpagecount" : "",
+                t.regions_ms);
+    fp_tree_free(&t);
+}
+
+// ========== ASIGNACIONES (MALLOC) ==========
+
+// Símbolos de direcciones de otro proceso: región de maps → ELF abierto una
+// vez por fichero → símbolo. Sin addr2line ni gdb.
+#define SYM_CACHE_MAX 16
+
+typedef struct {
+    char path[256];
+    elf_file_t elf;
+    uintptr_t bias;
+    int ok;
+} sym_cache_t;
+
+typedef struct {
+    const proc_maps_t *maps;
+    sym_cache_t files[SYM_CACHE_MAX];
+    int n;
+} symbolizer_t;
+
+static void symbolize_pc(symbolizer_t *sy, uintptr_t pc, char *out, size_t len) {
+    // pc es una dirección de retorno: la llamada está en el byte anterior
+    const maps_region_t *r = sy->maps ? proc_maps_find(sy->maps, pc - 1) : NULL;
+    if (!r || r->kind != MAPS_KIND_FILE) {
+        snprintf(out, len, "%#lx", (unsigned long)pc);
+        return;
+    }
+    const char *path = proc_maps_name(sy->maps, r);
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    sym_cache_t *c = NULL;
+    for (int i = 0; i < sy->n && !c; i++) {
+        if (strcmp(sy->files[i].path, path) == 0) c = &sy->files[i];
+    }
+    if (!c && sy->n < SYM_CACHE_MAX) {
+        c = &sy->files[sy->n++];
+        snprintf(c->path, sizeof(c->path), "%s", path);
+        c->ok = elf_open(&c->elf, path) == 0;
+        if (c->ok && elf_load_bias(&c->elf, sy->maps, path, &c->bias) < 0) {
+            elf_close(&c->elf);
+            c->ok = 0;
+        }
+    }
+    uint64_t off = 0;
+    const Elf64_Sym *sym = c && c->ok ? elf_symbol_at(&c->elf, pc - 1 - c->bias, &off) : NULL;
+    if (sym) snprintf(out, len, "%s+%#lx", elf_symbol_name(&c->elf, sym), (unsigned long)off + 1);
+    else snprintf(out, len, "%s+%#lx", base, (unsigned long)(pc - r->start + r->offset));
+}
+
+static void symbolizer_free(symbolizer_t *sy) {
+    for (int i = 0; i < sy->n; i++) {
+        if (sy->files[i].ok) elf_close(&sy->files[i].elf);
+    }
+    sy->n = 0;
+}
+
+// "f1 ← f2 ← f3": quien llamó a malloc y sus dos llamadores
+static void format_stack(symbolizer_t *sy, const mtrack_site_t *st, char *out, size_t len) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (uint32_t i = 0; i < st->depth && i < 3 && used + 1 < len; i++) {
+        char fn[96];
+        symbolize_pc(sy, st->pc[i], fn, sizeof(fn));
+        used += (size_t)snprintf(out + used, len - used, "%s%s", i ? " ← " : "", fn);
+    }
+}
+
+// Pilas iguales de threads distintos se suman para el total del proceso
+typedef struct {
+    uint64_t hash;          // de la pila sin el tid
+    int site;               // representante
+    int threads;
+    uint64_t samples, live, est_bytes, est_live, bytes;
+    uint64_t est_rate;      // est_bytes en el intervalo
+} mtrack_agg_t;
+
+static int cmp_agg_hash(const void *a, const void *b) {
+    uint64_t x = ((const mtrack_agg_t *)a)->hash, y = ((const mtrack_agg_t *)b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_agg_live(const void *a, const void *b) {
+    const mtrack_agg_t *x = a, *y = b;
+    if (x->est_live != y->est_live) return x->est_live < y->est_live ? 1 : -1;
+    return x->est_rate < y->est_rate ? 1 : x->est_rate > y->est_rate ? -1 : 0;
+}
+
+typedef struct {
+    pid_t tid;
+    uint64_t allocs, frees, alloc_bytes, free_bytes;
+} mtrack_tsnap_t;
+
+static size_t mtrack_snap_threads(const mtrack_shared_t *s, mtrack_tsnap_t *out) {
+    size_t n = 0;
+    for (int i = 0; i < MTRACK_MAX_THREADS; i++) {
+        const mtrack_thread_t *t = &s->threads[i];
+        pid_t tid = atomic_load_explicit(&t->tid, memory_order_acquire);
+        if (!tid) continue;
+        out[n++] = (mtrack_tsnap_t){ tid, atomic_load_explicit(&t->allocs, memory_order_relaxed),
+                                     atomic_load_explicit(&t->frees, memory_order_relaxed),
+                                     atomic_load_explicit(&t->alloc_bytes, memory_order_relaxed),
+                                     atomic_load_explicit(&t->free_bytes, memory_order_relaxed) };
+    }
+    return n;
+}
+
+// Tasas de malloc/free por thread en interval_ms, vivos del proceso y las
+// pilas muestreadas con más bytes vivos (si el proceso terminó: sus fugas)
+void print_mtrack_report(pid_t pid, unsigned interval_ms, int top) {
+    const mtrack_shared_t *s;
+    if (mtrack_open(pid, &s) < 0) {
+        alog_printf("    ❌ %d no exporta %s/%s%d (%s): ¿arrancó con PROC_MTRACK=1 o LD_PRELOAD=libproc_mtrack.so?\n",
+                    pid, MTRACK_DIR, MTRACK_PREFIX, pid, strerror(errno));
+        return;
+    }
+    int alive = kill(pid, 0) == 0 || errno == EPERM;
+    int exited = !alive || atomic_load_explicit(&s->exited, memory_order_acquire);
+    
+    static mtrack_tsnap_t a[MTRACK_MAX_THREADS], b[MTRACK_MAX_THREADS];
+    static uint64_t site_est0[MTRACK_SITES];
+    mtrack_totals_t ta, tb;
+    mtrack_totals(s, &ta);
+    size_t na = mtrack_snap_threads(s, a);
+    for (int i = 0; i < MTRACK_SITES; i++) site_est0[i] = atomic_load_explicit(&s->sites[i].est_bytes, memory_order_relaxed);
+    uint64_t t0 = now_ns();
+    if (!exited) usleep(interval_ms * 1000);
+    uint64_t t1 = now_ns();
+    mtrack_totals(s, &tb);
+    size_t nb = mtrack_snap_threads(s, b);
+    double secs = exited ? 0 : (t1 - t0) / 1e9;
+    
+    alog_printf("    Periodo de muestreo: %lu KB; %d threads con ranura; %s\n", (unsigned long)(s->period >> 10),
+                tb.threads, exited ? "proceso terminado: lo vivo no se liberó" : "activo");
+    if (s->parent) {
+        alog_printf("    Hijo de %d: %.1f KB vivos heredados en el fork\n", s->parent,
+                    atomic_load_explicit(&s->inherited_bytes, memory_order_relaxed) / 1024.0);
+    }
+    alog_printf("    Vivos: %s%.1f MB%s  asignados %.1f MB en %lu allocs, liberados %.1f MB en %lu frees\n",
+                COLOR_BOLD, tb.live_bytes / 1048576.0, COLOR_RESET, tb.alloc_bytes / 1048576.0,
+                (unsigned long)tb.allocs, tb.free_bytes / 1048576.0, (unsigned long)tb.frees);
+    if (secs > 0) {
+        alog_printf("    Ritmo: %s%.0f allocs/s, %.2f MB/s%s, %.0f frees/s; vivos %+.1f KB/s en %.1f s\n",
+                    COLOR_CYAN, (tb.allocs - ta.allocs) / secs, (tb.alloc_bytes - ta.alloc_bytes) / 1048576.0 / secs,
+                    COLOR_RESET, (tb.frees - ta.frees) / secs, (tb.live_bytes - ta.live_bytes) / 1024.0 / secs, secs);
+    }
+    
+    // Por thread
+    char path[64], comm[32];
+    alog_printf("\n    %-8s %-16s %12s %10s %12s %12s %12s\n", "TID", "Nombre", "allocs/s", "MB/s", "frees/s",
+                "Neto KB", "allocs");
+    for (size_t i = 0; i < nb; i++) {
+        const mtrack_tsnap_t *x = &b[i], *p = NULL;
+        for (size_t j = 0; j < na && !p; j++) {
+            if (a[j].tid == x->tid) p = &a[j];
+        }
+        const mtrack_thread_t *slot = mtrack_thread_find(s, x->tid);
+        snprintf(comm, sizeof(comm), "%s", slot ? slot->comm : "?");
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/comm", pid, x->tid);
+        FILE *f = fopen(path, "r");
+        if (f) {
+            if (fgets(comm, sizeof(comm), f)) comm[strcspn(comm, "\n")] = '\0';
+            fclose(f);
+        }
+        double ra = secs > 0 ? (x->allocs - (p ? p->allocs : 0)) / secs : 0;
+        double rb = secs > 0 ? (x->alloc_bytes - (p ? p->alloc_bytes : 0)) / 1048576.0 / secs : 0;
+        double rf = secs > 0 ? (x->frees - (p ? p->frees : 0)) / secs : 0;
+        alog_printf("    %-8d %-16s %12.0f %10.2f %12.0f ", x->tid, comm, ra, rb, rf);
+        alog_printf("%12.1f %12lu\n", ((double)x->alloc_bytes - (double)x->free_bytes) / 1024.0,
+                    (unsigned long)x->allocs);
+    }
+    uint64_t oa = atomic_load_explicit(&s->overflow.allocs, memory_order_relaxed);
+    uint64_t da = atomic_load_explicit(&s->dead_allocs, memory_order_relaxed);
+    if (oa || da) {
+        alog_printf("    %-8s %-16s %12s %10s %12s %12.1f %12lu\n", "-", "terminados/otros", "", "", "",
+                    ((double)atomic_load_explicit(&s->dead_alloc_bytes, memory_order_relaxed) +
+                     (double)atomic_load_explicit(&s->overflow.alloc_bytes, memory_order_relaxed) -
+                     (double)atomic_load_explicit(&s->dead_free_bytes, memory_order_relaxed) -
+                     (double)atomic_load_explicit(&s->overflow.free_bytes, memory_order_relaxed)) / 1024.0,
+                    (unsigned long)(oa + da));
+    }
+    
+    // Pilas: por proceso (sumando threads) y las de cada thread
+    mtrack_agg_t *agg = calloc(MTRACK_SITES, sizeof(*agg));
+    size_t ns = 0;
+    for (int i = 0; agg && i < MTRACK_SITES; i++) {
+        const mtrack_site_t *st = &s->sites[i];
+        if (!atomic_load_explicit(&st->ready, memory_order_acquire)) continue;
+        uint64_t h = 1469598103934665603ull;
+        for (uint32_t k = 0; k < st->depth && k < MTRACK_DEPTH; k++) h = (h ^ st->pc[k]) * 1099511628211ull;
+        uint64_t est = atomic_load_explicit(&st->est_bytes, memory_order_relaxed);
+        agg[ns++] = (mtrack_agg_t){ h, i, 1, atomic_load_explicit(&st->samples, memory_order_relaxed),
+                                    atomic_load_explicit(&st->live, memory_order_relaxed), est,
+                                    atomic_load_explicit(&st->est_live, memory_order_relaxed),
+                                    atomic_load_explicit(&st->bytes, memory_order_relaxed),
+                                    est - site_est0[i] };
+    }
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    // Si ya terminó, con la copia de maps que dejó al salir (PROC_MTRACK_KEEP)
+    snprintf(path, sizeof(path), "%s/%s%d%s", MTRACK_DIR, MTRACK_PREFIX, pid, MTRACK_MAPS_SUFFIX);
+    int have_maps = exited ? proc_maps_load_path(&maps, path) == 0 : proc_maps_load(&maps, pid) == 0;
+    symbolizer_t sy = { .maps = have_maps ? &maps : NULL };
+    char stack[320];
+    
+    mtrack_agg_t *per = agg ? calloc(ns ? ns : 1, sizeof(*per)) : NULL;
+    if (per) memcpy(per, agg, ns * sizeof(*agg));
+    qsort(agg, ns, sizeof(*agg), cmp_agg_hash);
+    size_t nu = 0;
+    for (size_t i = 0; i < ns; i++) {
+        if (nu && agg[nu - 1].hash == agg[i].hash) {
+            mtrack_agg_t *d = &agg[nu - 1];
+            d->threads++;
+            d->samples += agg[i].samples;
+            d->live += agg[i].live;
+            d->est_bytes += agg[i].est_bytes;
+            d->est_live += agg[i].est_live;
+            d->bytes += agg[i].bytes;
+            d->est_rate += agg[i].est_rate;
+        } else {
+            agg[nu++] = agg[i];
+        }
+    }
+    qsort(agg, nu, sizeof(*agg), cmp_agg_live);
+    alog_printf("\n    %sPilas del proceso%s (estimación: cada muestra ≈ %lu KB; %lu muestras vivas):\n", COLOR_BOLD,
+                COLOR_RESET, (unsigned long)(s->period >> 10),
+                (unsigned long)atomic_load_explicit(&s->live_samples, memory_order_relaxed));
+    alog_printf("    %10s %10s %9s %8s %8s %3s  %s\n", "Vivo MB", "Total MB", "MB/s", "Muestras", "Media B", "Th",
+                "Pila (quien llamó a malloc ← ...)");
+    for (size_t i = 0; i < nu && (int)i < top; i++) {
+        const mtrack_agg_t *g = &agg[i];
+        format_stack(&sy, &s->sites[g->site], stack, sizeof(stack));
+        alog_printf("    %s%10.2f%s %10.2f %9.2f %8lu %8lu %3d  ", g->est_live ? COLOR_YELLOW : "",
+                    g->est_live / 1048576.0, COLOR_RESET, g->est_bytes / 1048576.0,
+                    secs > 0 ? g->est_rate / 1048576.0 / secs : 0, (unsigned long)g->samples,
+                    (unsigned long)(g->samples ? g->bytes / g->samples : 0), g->threads);
+        alog_printf("%s\n", stack);
+    }
+    if (nu == 0) alog_printf("    (sin muestras todavía)\n");
+    
+    // Por thread: sus 3 pilas con más bytes vivos
+    if (per) {
+        qsort(per, ns, sizeof(*per), cmp_agg_live);
+        for (size_t i = 0; i < nb; i++) {
+            int shown = 0;
+            for (size_t j = 0; j < ns && shown < 3; j++) {
+                if (s->sites[per[j].site].tid != b[i].tid || per[j].samples == 0) continue;
+                if (!shown++) alog_printf("\n    TID %d:\n", b[i].tid);
+                format_stack(&sy, &s->sites[per[j].site], stack, sizeof(stack));
+                alog_printf("      vivo %8.2f MB  total %8.2f MB  %s\n", per[j].est_live / 1048576.0,
+                            per[j].est_bytes / 1048576.0, stack);
+            }
+        }
+    }
+    uint64_t ds = atomic_load_explicit(&s->dropped_sites, memory_order_relaxed);
+    uint64_t dl = atomic_load_explicit(&s->dropped_live, memory_order_relaxed);
+    if (ds || dl) {
+        alog_printf("\n    ⚠️  %lu muestras sin pila (tabla llena), %lu sin seguimiento hasta su free\n",
+                    (unsigned long)ds, (unsigned long)dl);
+    }
+    symbolizer_free(&sy);
+    proc_maps_free(&maps);
+    free(per);
+    free(agg);
+    mtrack_close(s);
+}
+
 // ========== FUNCIÓN DE THREAD ==========
 
 void *thread_function(void *arg) {
@@ -206,15 +1096,20 @@ void *thread_function(void *arg) {
     // Cambiar nombre del thread (visible en ps)
     prctl(PR_SET_NAME, thread_name, 0, 0, 0);
     
+    // Patrón bajo el SP para medir después la profundidad exacta alcanzada
+    stack_paint_self(STACK_PAINT_WINDOW);
+    
     usleep((rand() % 500) * 1000); // Delay aleatorio para demostrar concurrencia
     
     print_header(thread_name, 'M');
     
+    if (thread_id >= 1 && thread_id <= 2) apply_demo_pin(thread_id, thread_name);
+    
     print_memory_details(thread_name, 1);
     
     // Información de planificación
     print_timestamp("");
-    printf("📊 Información de planificación:\n");
+    alog_printf("📊 Información de planificación:\n");
     
     int policy = sched_getscheduler(0);
     const char *policy_name = "Desconocida";
@@ -227,254 +1122,2260 @@ void *thread_function(void *arg) {
     struct sched_param param;
     sched_getparam(0, &param);
     
-    printf("  Política:   %s%s%s (%d)\n", COLOR_BLUE, policy_name, COLOR_RESET, policy);
-    printf("  Prioridad:  %s%d%s\n", COLOR_BLUE, param.sched_priority, COLOR_RESET);
+    alog_printf("  Política:   %s%s%s (%d)\n", COLOR_BLUE, policy_name, COLOR_RESET, policy);
+    alog_printf("  Prioridad:  %s%d%s\n", COLOR_BLUE, param.sched_priority, COLOR_RESET);
     
     errno = 0;
     int nice_val = getpriority(PRIO_PROCESS, 0);
     if (errno == 0) {
-        printf("  Nice value: %s%d%s\n", COLOR_BLUE, nice_val, COLOR_RESET);
+        alog_printf("  Nice value: %s%d%s\n", COLOR_BLUE, nice_val, COLOR_RESET);
     }
     
+    // Alloc propia tocada por este thread: con la política por defecto sus
+    // páginas caen en el nodo donde corre ahora (first touch)
+    int stack_var = thread_id;
+    void *heap = malloc(THREAD_HEAP_BYTES);
+    if (heap) memset(heap, thread_id, THREAD_HEAP_BYTES);
+    print_numa_placement(&stack_var, "Heap", heap ? heap : (void *)&stack_var);
+    if (heap && thread_id >= 1 && thread_id <= 2) __atomic_store_n(&thread_heaps[thread_id - 1], heap, __ATOMIC_RELEASE);
+    
+    print_thread_stack();
+    print_phase_cost();
+    
     print_timestamp("");
-    printf("⏸️  %s en pausa (esperando señal)...\n", thread_name);
+    alog_printf("⏸️  %s en pausa (esperando terminación)...\n", thread_name);
     
-    // Esperar señal de terminación
-    while(1) {
-        pause(); // Esperar señal
-        break;
+    // Esperar terminación: parada cooperativa dentro del pool, señal si es un pthread suelto
+    if (thread_pool_current()) {
+        thread_pool_wait_for_stop();
+    } else {
+        while(1) {
+            pause(); // Esperar señal
+            break;
+        }
     }
     
+    if (heap && thread_id >= 1 && thread_id <= 2) __atomic_store_n(&thread_heaps[thread_id - 1], NULL, __ATOMIC_RELEASE);
+    free(heap);
+    perf_group_close(&phase_perf);
+    phase_tried = 0;                // el worker del pool puede correr otra tarea
+    
     print_timestamp("");
-    printf("✅ %s terminando.\n", thread_name);
+    alog_printf("✅ %s terminando.\n", thread_name);
     return NULL;
 }
 
+// Adaptador para ejecutar thread_function como tarea del pool
+void thread_task(void *arg) {
+    thread_function(arg);
+}
+
 // ========== FUNCIÓN DE PROCESO HIJO ==========
 
-void child_process_code() {
+void child_process_code(ipc_ring_t *chan) {
     prctl(PR_SET_NAME, "PROCESO-HIJO", 0, 0, 0);
     
     print_header("PROCESO HIJO (fork)", 'G');
+    apply_demo_pin(0, "PROCESO-HIJO");
     
     print_timestamp("");
-    printf("👶 Proceso hijo creado:\n");
-    printf("  TGID:  %s%d%s  (Thread Group ID)\n", COLOR_GREEN, get_tgid(), COLOR_RESET);
-    printf("  PPID:  %s%d%s  (Parent TGID)\n", COLOR_GREEN, getppid(), COLOR_RESET);
+    alog_printf("👶 Proceso hijo creado:\n");
+    alog_printf("  TGID:  %s%d%s  (Thread Group ID)\n", COLOR_GREEN, get_tgid(), COLOR_RESET);
+    alog_printf("  PPID:  %s%d%s  (Parent TGID)\n", COLOR_GREEN, getppid(), COLOR_RESET);
     
     // Mostrar memoria inicial (compartida via COW)
     print_memory_details("PROCESO-HIJO (inicial)", 0);
     
+    // Dónde quedaron su stack y global_buffer (aún compartido con el padre)
+    int stack_var = 0;
+    print_numa_placement(&stack_var, "global_buffer", global_buffer);
+    
     // Demostrar COW modificando variables
     demonstrate_cow_difference(1); // 1 = es hijo
     
     // Mostrar estado después de COW
     print_timestamp("");
-    printf("\n📊 Estado después de COW:\n");
-    printf("  El hijo ve: global_var = %d\n", global_var);
-    printf("  El padre debería seguir viendo: global_var = 42\n");
+    alog_printf("\n📊 Estado después de COW:\n");
+    alog_printf("  El hijo ve: global_var = %d\n", global_var);
+    alog_printf("  El padre debería seguir viendo: global_var = 42\n");
+    
+    // Lo que sí ve el padre: el anillo memfd es MAP_SHARED, el mensaje se
+    // formatea directamente en la memoria común (sin copias ni syscalls)
+    char *msg = chan ? ipc_ring_reserve(chan, 128) : NULL;
+    if (msg) {
+        snprintf(msg, 128, "global_var=%d, global_buffer=\"%.64s\"", global_var, global_buffer);
+        ipc_ring_commit(chan);
+        print_timestamp("");
+        alog_printf("📨 Hijo publica su estado en el anillo compartido (memfd + MAP_SHARED)\n");
+    }
     
+    print_phase_cost();
     print_timestamp("");
-    printf("⏸️  Proceso hijo en pausa (esperando SIGTERM)...\n");
+    alog_printf("⏸️  Proceso hijo en pausa (esperando SIGTERM)...\n");
+    alog_sync();
     
-    // Esperar señal del padre
-    while(1) {
-        pause();
-        break;
-    }
+    // Esperar señal del padre: signalfd en lugar de pause(), sin handler y sin
+    // perder una señal que llegue antes de dormirse
+    static const int stop_signals[] = { SIGTERM, SIGINT };
+    int sig = sd_wait_signals(stop_signals, 2);
     
     print_timestamp("");
-    printf("✅ Proceso hijo terminando.\n");
+    alog_printf("✅ Proceso hijo terminando (%s).\n", sig > 0 ? strsignal(sig) : "signalfd no disponible");
     exit(0);
 }
 
-// ========== FUNCIÓN PRINCIPAL ==========
+// ========== MODOS DE LÍNEA DE COMANDOS ==========
 
-int main() {
-    srand(time(NULL));
-    
-    print_header("PROCESO PADRE INICIADO", 'B');
-    
-    print_timestamp("");
-    printf("TGID (getpid): %s%d%s, PID kernel (gettid): %s%ld%s\n", 
-           COLOR_GREEN, get_tgid(), COLOR_RESET,
-           COLOR_GREEN, (long)get_kernel_pid(), COLOR_RESET);
+static int run_demo(void);
+
+// --maps <pid> [addr...]: resumen de regiones y búsqueda de direcciones
+static int mode_maps(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --maps <pid> [addr...]\n");
+        return 1;
+    }
+    pid_t pid = (pid_t)atoi(argv[0]);
     
-    // ========== 1. CREAR PROCESO HIJO CON fork() ==========
-    print_header("CREANDO PROCESO HIJO (fork)", 'R');
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, pid) < 0) {
+        fprintf(stderr, "❌ No se pudo leer /proc/%d/maps\n", pid);
+        return 1;
+    }
     
-    print_timestamp("");
-    printf("Ejecutando fork()...\n");
-    pid_t child_pid = fork();
+    printf("Regiones: %zu\n", maps.nregions);
+    
+    // Primera región respaldada por archivo (normalmente el ejecutable)
+    const maps_region_t *code = proc_maps_find_kind(&maps, MAPS_KIND_FILE);
+    const maps_region_t *heap = proc_maps_find_kind(&maps, MAPS_KIND_HEAP);
+    const maps_region_t *stack = proc_maps_find_kind(&maps, MAPS_KIND_STACK);
+    printf("[Code]    ");
+    if (code) proc_maps_print_region(&maps, code); else printf("No disponible\n");
+    printf("[Heap]    ");
+    if (heap) proc_maps_print_region(&maps, heap); else printf("No disponible\n");
+    printf("[Stack]   ");
+    if (stack) proc_maps_print_region(&maps, stack); else printf("No disponible\n");
+    
+    for (int i = 1; i < argc; i++) {
+        uintptr_t addr = (uintptr_t)strtoull(argv[i], NULL, 16);
+        const maps_region_t *r = proc_maps_find(&maps, addr);
+        printf("%#lx → ", (unsigned long)addr);
+        if (r) proc_maps_print_region(&maps, r); else printf("(no mapeada)\n");
+    }
     
-    if (child_pid == 0) {
-        child_process_code();
+    proc_maps_free(&maps);
+    return 0;
+}
+
+// --addr <pid> [--count] [addr... | -]: clasifica direcciones (de argv o de
+// stdin, una por línea en hex). Sin direcciones lista el mapa clasificado.
+static int mode_addr(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --addr <pid> [--count] [addr... | -]\n");
+        return 1;
+    }
+    pid_t pid = (pid_t)atoi(argv[0]);
+    int count = argc > 1 && strcmp(argv[1], "--count") == 0;
+    int first = 1 + count;
+    
+    addr_map_t am;
+    addr_map_init(&am);
+    if (addr_map_build(&am, pid) < 0) {
+        fprintf(stderr, "❌ No se pudo leer /proc/%d/maps\n", pid);
+        addr_map_free(&am);
+        return 1;
     }
     
-    print_timestamp("");
-    printf("🔄 Proceso padre continúa\n");
-    printf("   Hijo creado con TGID: %s%d%s\n", COLOR_GREEN, child_pid, COLOR_RESET);
+    char desc[256];
+    if (first >= argc) {
+        printf("%s%zu regiones clasificadas de PID %d%s\n", COLOR_BOLD, am.n, pid, COLOR_RESET);
+        for (size_t i = 0; i < am.n; i++) {
+            addr_map_describe(&am, (long)i, desc, sizeof(desc));
+            printf("  %012lx-%012lx  %s\n", (unsigned long)am.starts[i], (unsigned long)am.ends[i], desc);
+        }
+        addr_map_free(&am);
+        return 0;
+    }
     
-    usleep(500000); // Dar tiempo al hijo para que muestre su info
+    // Por lotes: las direcciones se leen y clasifican de BATCH en BATCH
+    enum { BATCH = 65536 };
+    uintptr_t *addrs = malloc(BATCH * sizeof(*addrs));
+    int32_t *idx = malloc(BATCH * sizeof(*idx));
+    unsigned long per_class[ADDR_CLASS_COUNT] = { 0 };
+    unsigned long total = 0;
+    uint64_t lookup_ns = 0;
+    int from_stdin = strcmp(argv[first], "-") == 0;
+    int next = first;
+    char line[128];
+    
+    while (addrs && idx) {
+        size_t n = 0;
+        if (from_stdin) {
+            while (n < BATCH && fgets(line, sizeof(line), stdin)) {
+                char *endp;
+                uintptr_t a = (uintptr_t)strtoull(line, &endp, 16);
+                if (endp != line) addrs[n++] = a;
+            }
+        } else {
+            while (n < BATCH && next < argc) addrs[n++] = (uintptr_t)strtoull(argv[next++], NULL, 16);
+        }
+        if (n == 0) break;
+        
+        uint64_t t0 = now_ns();
+        addr_map_lookup_batch(&am, addrs, n, idx);
+        lookup_ns += now_ns() - t0;
+        total += n;
+        
+        for (size_t i = 0; i < n; i++) {
+            per_class[idx[i] >= 0 ? am.regions[idx[i]].cls : ADDR_UNMAPPED]++;
+            if (count) continue;
+            addr_map_describe(&am, idx[i], desc, sizeof(desc));
+            printf("%#018lx  %s\n", (unsigned long)addrs[i], desc);
+        }
+    }
     
-    // ========== 2. CREAR THREADS CON pthread_create() ==========
-    print_header("CREANDO THREADS (pthread_create)", 'Y');
+    if (count) {
+        printf("%s%lu direcciones de PID %d (%.1f ns/dirección)%s\n", COLOR_BOLD, total, pid,
+               total ? (double)lookup_ns / (double)total : 0.0, COLOR_RESET);
+        for (int c = 0; c < ADDR_CLASS_COUNT; c++) {
+            if (per_class[c]) printf("  %-18s %12lu\n", addr_class_name((addr_class_t)c), per_class[c]);
+        }
+    }
+    free(addrs);
+    free(idx);
+    addr_map_free(&am);
+    return 0;
+}
+
+// Volcado estilo "objdump -s": dirección, 4 grupos de 4 bytes y ASCII
+static void print_hexdump(uintptr_t addr, const uint8_t *p, size_t n) {
+    for (size_t off = 0; off < n; off += 16) {
+        char hex[48], ascii[17];
+        size_t h = 0;
+        for (size_t j = 0; j < 16; j++) {
+            if (off + j < n) h += (size_t)snprintf(hex + h, sizeof(hex) - h, "%02x", p[off + j]);
+            else h += (size_t)snprintf(hex + h, sizeof(hex) - h, "  ");
+            if (j % 4 == 3) hex[h++] = ' ';
+            ascii[j] = off + j < n ? (p[off + j] >= 0x20 && p[off + j] < 0x7f ? (char)p[off + j] : '.') : ' ';
+        }
+        hex[h] = '\0';
+        ascii[16] = '\0';
+        printf("  %012lx %s %s\n", (unsigned long)(addr + off), hex, ascii);
+    }
+}
+
+// --elf <pid|fichero> [--dump sección [bytes]] [símbolo | 0xdir ...]
+// Secciones, volcado y símbolos del ejecutable sin objdump. Con un PID se lee
+// /proc/<pid>/exe y las direcciones son las de ejecución (con el bias de PIE).
+static int mode_elf(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --elf <pid|fichero> [--dump sección [bytes]] [símbolo | 0xdir ...]\n");
+        return 1;
+    }
+    char *endp;
+    long pid = strtol(argv[0], &endp, 10);
+    int is_pid = *endp == '\0' && pid > 0;
+    
+    elf_file_t e;
+    uintptr_t bias = 0;
+    uint64_t t0 = now_ns();
+    if (is_pid) {
+        proc_maps_t maps;
+        proc_maps_init(&maps);
+        int ok = proc_maps_load(&maps, (pid_t)pid) == 0 && elf_open_process(&e, (pid_t)pid, &maps, &bias) == 0;
+        proc_maps_free(&maps);
+        if (!ok) {
+            fprintf(stderr, "❌ No se pudo abrir /proc/%ld/exe: %s\n", pid, strerror(errno));
+            return 1;
+        }
+    } else if (elf_open(&e, argv[0]) < 0) {
+        fprintf(stderr, "❌ No se pudo abrir %s: %s\n", argv[0], strerror(errno));
+        return 1;
+    }
+    uint64_t open_ns = now_ns() - t0;
+    
+    if (argc == 1) {
+        printf("%s%s: %zu secciones, %zu símbolos, bias %#lx (abierto en %.1f µs)%s\n", COLOR_BOLD, argv[0],
+               e.nsections, e.nsyms, (unsigned long)bias, open_ns / 1e3, COLOR_RESET);
+        printf("  %3s %-20s %10s %14s %14s %10s %s\n", "Idx", "Nombre", "Tamaño", "VMA", "Ejecución", "Offset", "Flags");
+        for (size_t i = 1; i < e.nsections; i++) {
+            const Elf64_Shdr *sh = &e.shdrs[i];
+            int alloc = (sh->sh_flags & SHF_ALLOC) != 0;
+            printf("  %3zu %-20.20s %10lx %14lx %14lx %10lx %s%s%s%s\n", i, elf_section_name(&e, i),
+                   (unsigned long)sh->sh_size, (unsigned long)sh->sh_addr,
+                   alloc ? (unsigned long)(sh->sh_addr + bias) : 0ul, (unsigned long)sh->sh_offset,
+                   alloc ? "A" : "-", (sh->sh_flags & SHF_WRITE) ? "W" : "-",
+                   (sh->sh_flags & SHF_EXECINSTR) ? "X" : "-", sh->sh_type == SHT_NOBITS ? " NOBITS" : "");
+        }
+        elf_close(&e);
+        return 0;
+    }
     
-    pthread_t threads[2];
-    int thread_ids[2] = {1, 2};
+    int i = 1;
+    if (strcmp(argv[1], "--dump") == 0 && argc > 2) {
+        long sec = elf_find_section(&e, argv[2]);
+        size_t max = argc > 3 ? strtoul(argv[3], NULL, 0) : 256;
+        i = argc > 3 ? 4 : 3;
+        const void *data = sec >= 0 ? elf_section_data(&e, (size_t)sec) : NULL;
+        if (sec < 0) {
+            printf("❌ No existe la sección %s\n", argv[2]);
+        } else if (!data) {
+            printf("⚠️  %s no tiene contenido en el fichero (NOBITS)\n", argv[2]);
+        } else {
+            const Elf64_Shdr *sh = &e.shdrs[sec];
+            size_t n = sh->sh_size < max ? sh->sh_size : max;
+            printf("%sContenido de %s (%zu de %lu bytes):%s\n", COLOR_BOLD, argv[2], n,
+                   (unsigned long)sh->sh_size, COLOR_RESET);
+            print_hexdump((uintptr_t)sh->sh_addr + bias, data, n);
+        }
+    }
     
-    for (int i = 0; i < 2; i++) {
-        print_timestamp("");
-        printf("Creando thread %d...\n", thread_ids[i]);
-        if (pthread_create(&threads[i], NULL, thread_function, &thread_ids[i]) != 0) {
-            perror("Error creando thread");
+    // Argumentos "0x...": dirección → símbolo; el resto: símbolo → sección y dirección
+    uint64_t lookup_ns = 0;
+    int nlookups = 0;
+    for (; i < argc; i++) {
+        elf_symbol_info_t info;
+        if (strncmp(argv[i], "0x", 2) == 0) {
+            uintptr_t addr = (uintptr_t)strtoull(argv[i], NULL, 16);
+            uint64_t off = 0;
+            t0 = now_ns();
+            const Elf64_Sym *sym = elf_symbol_at(&e, addr - bias, &off);
+            lookup_ns += now_ns() - t0;
+            nlookups++;
+            long sec = elf_section_at(&e, addr - bias);
+            printf("%#018lx  ", (unsigned long)addr);
+            if (sym) {
+                elf_symbol_info(&e, sym, bias, &info);
+                printf("%s%s%s+%#lx (%s)\n", COLOR_CYAN, info.name, COLOR_RESET, (unsigned long)off, info.section);
+            } else {
+                printf("sin símbolo (%s)\n", sec >= 0 ? elf_section_name(&e, (size_t)sec) : "fuera del ejecutable");
+            }
+            continue;
         }
-        usleep(100000); // Pequeña pausa entre creación
+        t0 = now_ns();
+        const Elf64_Sym *sym = elf_find_symbol(&e, argv[i]);
+        lookup_ns += now_ns() - t0;
+        nlookups++;
+        if (!sym) {
+            printf("%-20s ❌ no está en la tabla de símbolos\n", argv[i]);
+            continue;
+        }
+        elf_symbol_info(&e, sym, bias, &info);
+        printf("%s%-20s%s %-6s %-6s %s+%#lx  %lu bytes  fichero %#lx  vaddr %#lx → %s%#lx%s\n",
+               COLOR_CYAN, info.name, COLOR_RESET, elf_symbol_type_name(info.type),
+               elf_symbol_bind_name(info.bind), *info.section ? info.section : "ABS",
+               (unsigned long)info.sec_offset, (unsigned long)info.size, (unsigned long)info.file_offset,
+               (unsigned long)info.vaddr, COLOR_GREEN, (unsigned long)info.runtime, COLOR_RESET);
+    }
+    if (nlookups) {
+        printf("  %d consultas sobre %zu símbolos en %.1f µs (apertura %.1f µs)\n", nlookups, e.nsyms,
+               lookup_ns / 1e3, open_ns / 1e3);
+    }
+    elf_close(&e);
+    return 0;
+}
+
+// --monitor <pid> [--interval ms] [--count n] [--top n] [--stat-every n]
+static int mode_monitor(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --monitor <pid> [--interval ms] [--count n] [--top n] [--stat-every n]\n");
+        return 1;
+    }
+    pid_t pid = (pid_t)atoi(argv[0]);
+    unsigned interval_ms = 1000;
+    unsigned long count = 0;
+    size_t top = 20;
+    unsigned stat_every = 10;
+    
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--interval") == 0) interval_ms = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--count") == 0) count = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--top") == 0) top = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--stat-every") == 0) stat_every = (unsigned)atoi(argv[i + 1]);
     }
+    if (interval_ms == 0) interval_ms = 1;
     
-    // Dar tiempo a los threads para ejecutarse
-    sleep(1);
+    print_header("MONITOR DE THREADS", 'M');
+    printf("PID %d, intervalo %u ms, threads sin CPU leídos cada %u muestras (Ctrl+C para salir)\n",
+           pid, interval_ms, stat_every);
+    return proc_monitor_run(pid, interval_ms, count, top, stat_every);
+}
+
+// --scan [--workers n] [--repeat n] [--filter comm]: todos los threads del host
+static int mode_scan(int argc, char *argv[]) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned workers = ncpu > 0 ? (unsigned)ncpu : 1;
+    unsigned repeat = 1;
+    const char *filter = NULL;
+    
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--workers") == 0) workers = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--repeat") == 0) repeat = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--filter") == 0) filter = argv[i + 1];
+    }
+    if (repeat == 0) repeat = 1;
     
-    // ========== 3. PADRE MODIFICA DESPUÉS DEL HIJO ==========
-    print_header("PADRE MODIFICA VARIABLES", 'C');
+    proc_scanner_t scanner;
+    if (proc_scanner_init(&scanner, workers) < 0) {
+        fprintf(stderr, "❌ No se pudo crear el pool de escaneo\n");
+        return 1;
+    }
+    scanner.want_tasks = 1;     // una fila por thread, como ps -eLf
+    
+    // Con --repeat el pool se reutiliza: es el caso "escanear cada segundo"
+    uint64_t best_ns = UINT64_MAX;
+    for (unsigned r = 0; r < repeat; r++) {
+        uint64_t t0 = now_ns();
+        if (proc_scanner_run(&scanner) < 0) {
+            fprintf(stderr, "❌ No se pudo leer /proc\n");
+            proc_scanner_free(&scanner);
+            return 1;
+        }
+        uint64_t dt = now_ns() - t0;
+        if (dt < best_ns) best_ns = dt;
+    }
     
-    print_timestamp("");
-    printf("📊 Estado del padre ANTES de modificar:\n");
-    printf("  global_var = %d (¿debería ser 42?)\n", global_var);
-    printf("  global_buffer = \"%.20s...\"\n", global_buffer);
+    print_header("PROCESOS DEL HOST", 'B');
+    proc_scan_print(&scanner, filter);
+    printf("\n  %zu threads, %u workers, mejor escaneo: %s%.2f ms%s\n",
+           scanner.nentries, scanner.nworkers, COLOR_GREEN, best_ns / 1e6, COLOR_RESET);
     
-    // Demostrar que el padre también activa COW
-    demonstrate_cow_difference(0); // 0 = es padre
+    proc_scanner_free(&scanner);
+    return 0;
+}
+
+// Ctrl+C en los modos con bucle (--track, --peek --watch): salir limpiamente
+static volatile sig_atomic_t cli_stop = 0;
+
+static void cli_sigint(int sig) {
+    (void)sig;
+    cli_stop = 1;
+}
+
+// --record <archivo> [--interval ms] [--seconds n] [--span n] [--series n] [--arena-mb n]:
+// muestrea todos los procesos con el pool de escaneo, guarda la historia en
+// el almacén de series y la vuelca a archivo al terminar (Ctrl+C o --seconds)
+static int mode_record(int argc, char *argv[]) {
+    const char *path = NULL;
+    unsigned interval_ms = 1000;
+    unsigned long seconds = 0;
+    uint64_t span = 3600;
+    uint32_t max_series = 5000;
+    uint64_t arena_mb = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) interval_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--span") == 0 && i + 1 < argc) span = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--series") == 0 && i + 1 < argc) max_series = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--arena-mb") == 0 && i + 1 < argc) arena_mb = strtoull(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-') path = argv[i];
+    }
+    if (!path || interval_ms == 0 || span == 0 || max_series == 0) {
+        fprintf(stderr, "Uso: proc_analysis --record <archivo> [--interval ms] [--seconds n] [--span n] [--series n] [--arena-mb n]\n");
+        return 1;
+    }
     
-    // ========== 4. MOSTRAR INFORMACIÓN DEL SISTEMA ==========
-    print_header("INFORMACIÓN DEL SISTEMA", 'B');
+    tsdb_t db;
+    if (tsdb_create(&db, max_series, span, (uint64_t)interval_ms * 1000000ull, arena_mb << 20) < 0) {
+        fprintf(stderr, "❌ No se pudo reservar el almacén: %s\n", strerror(errno));
+        return 1;
+    }
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    proc_scanner_t scanner;
+    if (proc_scanner_init(&scanner, ncpu > 0 ? (unsigned)ncpu : 1) < 0) {
+        fprintf(stderr, "❌ No se pudo crear el pool de escaneo\n");
+        tsdb_free(&db);
+        return 1;
+    }
+    scanner.want_status = 1;
+    
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = cli_sigint;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    
+    print_header("HISTORIAL DE PROCESOS", 'C');
+    printf("  %u series × %llu muestras cada %u ms en %s%.1f MB%s fijos (arena %.1f MB); Ctrl+C para volcar a %s\n\n",
+           max_series, (unsigned long long)db.hdr->span, interval_ms, COLOR_BOLD, db.size / 1048576.0, COLOR_RESET,
+           db.hdr->arena_size / 1048576.0, path);
+    
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    uint64_t scan_ns = 0, append_ns = 0;
+    size_t dropped = 0;
+    while (!cli_stop && (seconds == 0 || db.hdr->tick * interval_ms < seconds * 1000)) {
+        uint64_t t0 = now_ns();
+        if (proc_scanner_run(&scanner) < 0) break;
+        uint64_t t1 = now_ns();
+        struct timespec wall;
+        clock_gettime(CLOCK_REALTIME, &wall);
+        dropped = tsdb_append(&db, scanner.entries, scanner.nentries,
+                              (uint64_t)wall.tv_sec * 1000000000ull + (uint64_t)wall.tv_nsec);
+        uint64_t t2 = now_ns();
+        scan_ns += t1 - t0;
+        append_ns += t2 - t1;
+        if (db.hdr->tick % 10 == 1) {
+            printf("  muestra %6llu: %5zu procesos (%zu sin sitio), escaneo %6.2f ms, almacén %5.1f µs, arena %.1f MB\n",
+                   (unsigned long long)db.hdr->tick, scanner.nentries, dropped, (t1 - t0) / 1e6, (t2 - t1) / 1e3,
+                   tsdb_arena_used(&db) / 1048576.0);
+            fflush(stdout);
+        }
+        
+        next.tv_nsec += (long)(interval_ms % 1000) * 1000000L;
+        next.tv_sec += interval_ms / 1000 + next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        while (!cli_stop && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {}
+    }
+    proc_scanner_free(&scanner);
+    
+    uint64_t ticks = db.hdr->tick ? db.hdr->tick : 1;
+    uint64_t t0 = now_ns();
+    int rc = tsdb_save(&db, path);
+    uint64_t save_ns = now_ns() - t0;
+    printf("\n  %llu muestras, %u series; por muestra: escaneo %.2f ms, almacén %.1f µs\n",
+           (unsigned long long)db.hdr->tick, db.hdr->nseries, scan_ns / 1e6 / ticks, append_ns / 1e3 / ticks);
+    if (rc < 0) {
+        fprintf(stderr, "❌ No se pudo volcar %s: %s\n", path, strerror(errno));
+    } else {
+        printf("  💾 %s: %.1f MB en %.1f ms; consultar con %s./proc_analysis --history %s%s\n", path,
+               db.size / 1048576.0, save_ns / 1e6, COLOR_CYAN, path, COLOR_RESET);
+    }
+    tsdb_free(&db);
+    return rc < 0;
+}
+
+static void print_window_row(const tsdb_t *db, uint32_t s, tsdb_metric_t m, uint64_t window) {
+    tsdb_stats_t st;
+    if (tsdb_window(db, s, m, window, &st) < 0) {
+        printf("  %-12s %s(sin datos retenidos)%s\n", tsdb_metric_name(m), COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+    printf("  %-12s %12llu %12llu %12llu %12llu %12.1f ", tsdb_metric_name(m), (unsigned long long)st.first,
+           (unsigned long long)st.last, (unsigned long long)st.min, (unsigned long long)st.max, st.mean);
+    printf("%+12lld %s%10.2f%s\n", (long long)st.delta, COLOR_GREEN, st.rate, COLOR_RESET);
+}
+
+typedef struct {
+    uint32_t s;
+    double rate;
+    int64_t delta;
+    uint64_t last;
+} history_rank_t;
+
+static int cmp_rank_rate(const void *a, const void *b) {
+    const history_rank_t *x = a, *y = b;
+    return x->rate < y->rate ? 1 : x->rate > y->rate ? -1 : 0;
+}
+
+// --history <archivo> [--pid p] [--window s] [--top n] [--metric m]: consultas
+// sobre un volcado de --record abierto con mmap; no lee /proc
+static int mode_history(int argc, char *argv[]) {
+    const char *path = NULL;
+    pid_t pid = 0;
+    double window_s = 0;
+    size_t top = 15;
+    int metric = TSDB_MINFLT;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--pid") == 0 && i + 1 < argc) pid = (pid_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) window_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) top = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--metric") == 0 && i + 1 < argc) metric = tsdb_metric_parse(argv[++i]);
+        else if (argv[i][0] != '-') path = argv[i];
+    }
+    if (!path || metric < 0) {
+        fprintf(stderr, "Uso: proc_analysis --history <archivo> [--pid p] [--window s] [--top n]\n"
+                        "       [--metric rss|threads|vol_ctxt|nonvol_ctxt|minflt|majflt]\n");
+        return 1;
+    }
+    tsdb_t db;
+    uint64_t t0 = now_ns();
+    if (tsdb_open_file(&db, path) < 0) {
+        fprintf(stderr, "❌ %s: %s\n", path, errno == EINVAL ? "no es un volcado de --record" : strerror(errno));
+        return 1;
+    }
+    uint64_t open_ns = now_ns() - t0;
+    const tsdb_header_t *h = db.hdr;
+    double interval_s = h->interval_ns / 1e9;
+    uint64_t window = window_s > 0 && interval_s > 0 ? (uint64_t)(window_s / interval_s + 0.5) : 0;
+    
+    print_header("HISTORIAL DE PROCESOS", 'C');
+    printf("  %s: %llu muestras cada %.0f ms (ventana retenida %llu), %u series, %.1f MB (mmap en %.1f µs)\n",
+           path, (unsigned long long)h->tick, interval_s * 1e3, (unsigned long long)h->span, h->nseries,
+           db.size / 1048576.0, open_ns / 1e3);
+    if (window) printf("  Ventana de consulta: últimas %llu muestras de cada serie\n", (unsigned long long)window);
+    printf("\n");
+    
+    t0 = now_ns();
+    if (pid > 0) {
+        int s = tsdb_find(&db, pid);
+        if (s < 0) {
+            fprintf(stderr, "❌ PID %d no aparece en el historial\n", pid);
+            tsdb_free(&db);
+            return 1;
+        }
+        const tsdb_series_t *se = &db.series[s];
+        printf("  PID %d (%s): muestras %llu..%llu%s\n\n", se->pid, se->comm, (unsigned long long)se->first_tick,
+               (unsigned long long)se->last_tick, se->active ? ", vivo al volcar" : ", terminó");
+        printf("  %-12s %12s %12s %12s %12s %12s %12s %10s\n", "Métrica", "Inicio", "Final", "Mín", "Máx",
+               "Media", "Delta", "Tasa/s");
+        for (int m = 0; m < TSDB_NMETRICS; m++) print_window_row(&db, (uint32_t)s, (tsdb_metric_t)m, window);
+    } else {
+        history_rank_t *rank = malloc((h->nseries ? h->nseries : 1) * sizeof(*rank));
+        size_t n = 0;
+        for (uint32_t s = 0; rank && s < h->nseries; s++) {
+            tsdb_stats_t st;
+            if (tsdb_window(&db, s, (tsdb_metric_t)metric, window, &st) < 0) continue;
+            rank[n++] = (history_rank_t){ s, metric == TSDB_RSS_KB || metric == TSDB_THREADS ? (double)st.last : st.rate,
+                                          st.delta, st.last };
+        }
+        if (rank) qsort(rank, n, sizeof(*rank), cmp_rank_rate);
+        int level = metric == TSDB_RSS_KB || metric == TSDB_THREADS;
+        printf("  Top %zu por %s %s:\n\n", top, tsdb_metric_name((tsdb_metric_t)metric), level ? "(último valor)" : "(tasa/s)");
+        printf("  %7s %-16s %12s %12s %12s\n", "PID", "COMM", level ? "Valor" : "Tasa/s", "Delta", "Último");
+        for (size_t i = 0; i < n && i < top; i++) {
+            const tsdb_series_t *se = &db.series[rank[i].s];
+            printf("  %7d %-16s %s%12.2f%s %+12lld %12llu%s\n", se->pid, se->comm, COLOR_GREEN, rank[i].rate,
+                   COLOR_RESET, (long long)rank[i].delta, (unsigned long long)rank[i].last, se->active ? "" : "  (terminó)");
+        }
+        free(rank);
+    }
+    printf("\n  Consulta en %.1f µs sobre el archivo mapeado (sin leer /proc)\n", (now_ns() - t0) / 1e3);
+    tsdb_free(&db);
+    return 0;
+}
+
+// --track <pid...> [--all] [--no-follow] [--count n]: ciclo de vida por eventos
+// (pidfd + conector netlink), sin recorrer /proc. Termina cuando no queda
+// ningún proceso vigilado (salvo con --all), tras n eventos o con Ctrl+C.
+static int mode_track(int argc, char *argv[]) {
+    unsigned flags = PTRACK_NETLINK | PTRACK_FOLLOW;
+    unsigned long count = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--all") == 0) flags |= PTRACK_ALL;
+        else if (strcmp(argv[i], "--no-follow") == 0) flags &= ~PTRACK_FOLLOW;
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = strtoul(argv[++i], NULL, 10);
+    }
+    
+    proc_tracker_t t;
+    if (proc_tracker_init(&t, flags) < 0) {
+        perror("epoll");
+        return 1;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0) {
+            i++;
+            continue;
+        }
+        if (argv[i][0] == '-') continue;
+        if (proc_tracker_watch(&t, (pid_t)atoi(argv[i])) < 0) {
+            fprintf(stderr, "⚠️  No se puede vigilar %s: %s\n", argv[i], strerror(errno));
+        }
+    }
+    if (t.nwatch == 0 && !(flags & PTRACK_ALL)) {
+        fprintf(stderr, "Uso: proc_analysis --track <pid...> [--all] [--no-follow] [--count n]\n");
+        proc_tracker_free(&t);
+        return 1;
+    }
+    if ((flags & PTRACK_ALL) && !proc_tracker_has_netlink(&t)) {
+        fprintf(stderr, "❌ --all necesita el conector de procesos (root / CAP_NET_ADMIN)\n");
+        proc_tracker_free(&t);
+        return 1;
+    }
+    
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = cli_sigint;
+    sigaction(SIGINT, &sa, NULL);
+    
+    print_header("SEGUIMIENTO DE PROCESOS", 'C');
+    printf("  %zu procesos vigilados, fuentes: pidfd%s\n", t.nwatch,
+           proc_tracker_has_netlink(&t) ? " + conector netlink (fork/exec/exit con marca del kernel)"
+                                        : " (sin conector netlink: solo salidas de los vigilados)");
+    
+    proc_event_t evs[64];
+    char line[160];
+    unsigned long seen = 0;
+    uint64_t t0 = now_ns();
+    while (!cli_stop && (count == 0 || seen < count) && (t.nwatch > 0 || (flags & PTRACK_ALL))) {
+        int n = proc_tracker_wait(&t, evs, 64, -1);
+        if (n < 0) break;
+        for (int i = 0; i < n && (count == 0 || seen < count); i++, seen++) {
+            proc_event_format(&evs[i], line, sizeof(line));
+            printf("  [%10.3f ms] %s", (evs[i].recv_ns - t0) / 1e6, line);
+            if (evs[i].kernel_ns) printf("  %s(+%.1f µs)%s", COLOR_CYAN, (evs[i].recv_ns - evs[i].kernel_ns) / 1e3, COLOR_RESET);
+            else printf("  %s(pidfd)%s", COLOR_CYAN, COLOR_RESET);
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+    printf("  %lu eventos, %lu mensajes netlink del host, %lu desbordamientos\n", seen, t.nl_messages, t.lost);
+    proc_tracker_free(&t);
+    return 0;
+}
+
+// Primer PID (el menor) cuyo comm contiene name, 0 si no hay ninguno
+static pid_t find_by_comm(const char *name) {
+    proc_dir_buf_t db = { 0 };
+    proc_file_t f;
+    proc_file_init(&f);
+    pid_t *pids = NULL;
+    size_t cap = 0;
+    pid_t found = 0;
+    char path[64];
+    ssize_t n = proc_list_pids("/proc", &db, &pids, &cap);
+    for (ssize_t i = 0; i < n; i++) {
+        if (pids[i] == getpid() || (found && pids[i] > found)) continue;
+        snprintf(path, sizeof(path), "/proc/%d/comm", pids[i]);
+        if (proc_file_load(&f, path) < 0 || f.len == 0) continue;
+        f.buf[f.len - 1] = '\0';    // '\n' final
+        if (strstr(f.buf, name)) found = pids[i];
+    }
+    free(pids);
+    proc_dir_buf_free(&db);
+    proc_file_free(&f);
+    return found;
+}
+
+// --find <comm> [--wait s]: PID del primer proceso cuyo comm contiene <comm>
+// (sustituye a "pgrep | head -1"). Con --wait espera su exec por el conector
+// netlink en vez de reintentar: una sola pasada por /proc.
+static int mode_find(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --find <comm> [--wait s]\n");
+        return 1;
+    }
+    int wait_s = argc > 2 && strcmp(argv[1], "--wait") == 0 ? atoi(argv[2]) : 0;
+    
+    // Suscribirse antes de mirar /proc: un exec entre las dos cosas no se pierde
+    proc_tracker_t t;
+    int tracking = wait_s > 0 && proc_tracker_init(&t, PTRACK_NETLINK | PTRACK_ALL) == 0;
+    pid_t pid = find_by_comm(argv[0]);
+    if (pid == 0 && tracking && proc_tracker_has_netlink(&t)) {
+        uint64_t deadline = now_ns() + (uint64_t)wait_s * 1000000000ull;
+        proc_event_t evs[64];
+        proc_file_t f;
+        proc_file_init(&f);
+        char path[64];
+        while (pid == 0 && now_ns() < deadline) {
+            int n = proc_tracker_wait(&t, evs, 64, (int)((deadline - now_ns()) / 1000000) + 1);
+            if (n <= 0) break;
+            for (int i = 0; i < n && pid == 0; i++) {
+                if (evs[i].kind != PEV_EXEC) continue;
+                snprintf(path, sizeof(path), "/proc/%d/comm", evs[i].tgid);
+                if (proc_file_load(&f, path) < 0 || f.len == 0) continue;
+                f.buf[f.len - 1] = '\0';
+                if (strstr(f.buf, argv[0])) pid = evs[i].tgid;
+            }
+        }
+        proc_file_free(&f);
+    } else if (pid == 0 && wait_s > 0) {
+        fprintf(stderr, "⚠️  Sin conector netlink (root / CAP_NET_ADMIN) no se puede esperar el exec\n");
+    }
+    if (tracking) proc_tracker_free(&t);
+    if (pid == 0) return 1;
+    printf("%d\n", pid);
+    return 0;
+}
+
+// --peek <pid> [pid_b] [--watch hz] [--count n] símbolo...: valores de variables
+// globales de uno o dos procesos con process_vm_readv, sin detenerlos. Con
+// --watch muestrea a hz lecturas por segundo e imprime solo los cambios.
+static int mode_peek(int argc, char *argv[]) {
+    pid_t pids[2] = { 0, 0 };
+    unsigned hz = 0;
+    unsigned long count = 0;
+    char **names = calloc((size_t)argc + 1, sizeof(*names));
+    size_t nnames = 0;
+    int npids = 0;
+    for (int i = 0; i < argc && names; i++) {
+        char *endp;
+        long v = strtol(argv[i], &endp, 10);
+        if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) hz = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = strtoul(argv[++i], NULL, 10);
+        else if (*endp == '\0' && v > 0 && npids < 2 && nnames == 0) pids[npids++] = (pid_t)v;
+        else names[nnames++] = argv[i];
+    }
+    if (npids == 0 || nnames == 0) {
+        fprintf(stderr, "Uso: proc_analysis --peek <pid> [pid_b] [--watch hz] [--count n] símbolo...\n");
+        free(names);
+        return 1;
+    }
+    
+    peek_t p[2];
+    int ret = 0;
+    for (int k = 0; k < npids; k++) {
+        peek_init(&p[k], pids[k]);
+        if (peek_add_symbols(&p[k], names, nnames) < 0) {
+            fprintf(stderr, "❌ No se pudo leer /proc/%d/exe: %s\n", pids[k], strerror(errno));
+            ret = 1;
+        }
+    }
+    for (int k = 0; k < npids && ret == 0; k++) {
+        if (peek_read(&p[k]) < 0) {
+            fprintf(stderr, "❌ process_vm_readv en %d: %s\n", pids[k], strerror(errno));
+            ret = 1;
+        }
+    }
+    if (ret == 0) {
+        print_peek_table(&p[0], npids > 1 ? &p[1] : NULL);
+        printf("  %zu variables, %lu process_vm_readv por proceso, %.1f µs\n", nnames, p[0].syscalls,
+               (p[0].read_ns + (npids > 1 ? p[1].read_ns : 0)) / 1e3);
+    }
+    
+    if (ret == 0 && hz > 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = cli_sigint;
+        sigaction(SIGINT, &sa, NULL);
+        
+        // Copia de la última lectura y su texto, para imprimir "antes → después"
+        uint8_t *prev[2] = { NULL, NULL };
+        char (*prev_txt)[96] = calloc((size_t)npids * nnames, sizeof(*prev_txt));
+        for (int k = 0; k < npids; k++) {
+            prev[k] = malloc(p[k].buf_len ? p[k].buf_len : 1);
+            if (prev[k]) memcpy(prev[k], p[k].buf, p[k].buf_len);
+            for (size_t i = 0; i < nnames && prev_txt; i++) {
+                peek_format_value(&p[k], i, prev_txt[k * nnames + i], sizeof(prev_txt[0]));
+            }
+        }
+        printf("  Vigilando a %u Hz (Ctrl+C para salir)...\n", hz);
+        
+        struct timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        uint64_t t0 = now_ns();
+        unsigned long samples = 0, changes = 0;
+        for (; !cli_stop && (count == 0 || samples < count) && prev_txt && prev[0]; samples++) {
+            for (int k = 0; k < npids; k++) {
+                if (peek_read(&p[k]) < 0) {
+                    printf("  Proceso %d terminado o inaccesible.\n", pids[k]);
+                    cli_stop = 1;
+                    break;
+                }
+                for (size_t i = 0; i < nnames; i++) {
+                    const peek_var_t *v = &p[k].vars[i];
+                    if (!prev[k] || memcmp(prev[k] + v->off, peek_value(&p[k], i), v->size) == 0) continue;
+                    char *old = prev_txt[k * nnames + i];
+                    char now_txt[96];
+                    peek_format_value(&p[k], i, now_txt, sizeof(now_txt));
+                    printf("  [%10.3f ms] PID %d %s: %s → %s%s%s\n", (now_ns() - t0) / 1e6, pids[k], v->name,
+                           old, COLOR_RED, now_txt, COLOR_RESET);
+                    memcpy(prev[k] + v->off, peek_value(&p[k], i), v->size);
+                    memcpy(old, now_txt, sizeof(now_txt));
+                    changes++;
+                }
+            }
+            fflush(stdout);
+            
+            next.tv_nsec += 1000000000L / (long)hz;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR && !cli_stop) {
+            }
+        }
+        double secs = (now_ns() - t0) / 1e9;
+        printf("  %lu muestras en %.2f s (%.0f Hz reales), %lu cambios, %.2f µs por lectura\n", samples, secs,
+               secs > 0 ? samples / secs : 0.0, changes, p[0].reads ? p[0].read_ns / 1e3 / (double)p[0].reads : 0.0);
+        free(prev[0]);
+        free(prev[1]);
+        free(prev_txt);
+    }
+    
+    for (int k = 0; k < npids; k++) peek_free(&p[k]);
+    free(names);
+    return ret;
+}
+
+// Puntero de pila actual de un thread (penúltimo campo de /proc/<pid>/task/<tid>/syscall);
+// 0 si está corriendo o no hay permiso
+static uintptr_t task_stack_pointer(pid_t pid, pid_t tid) {
+    char path[64], buf[256];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/syscall", pid, tid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    // "nr a1 ... a6 sp pc" o "-1 sp pc"
+    char *tok[9];
+    int ntok = 0;
+    for (char *t = strtok(buf, " \n"); t && ntok < 9; t = strtok(NULL, " \n")) tok[ntok++] = t;
+    return ntok >= 3 ? (uintptr_t)strtoull(tok[ntok - 2], NULL, 16) : 0;
+}
+
+// --numa <pid>: por thread, CPUs permitidas, última CPU y nodo de su stack;
+// reparto por nodo del heap y de la pila principal (numa_maps)
+static int mode_numa(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --numa <pid>\n");
+        return 1;
+    }
+    pid_t pid = (pid_t)atoi(argv[0]);
+    numa_topo_t topo;
+    if (numa_topo_load(&topo) < 0) {
+        fprintf(stderr, "❌ No se pudo leer /sys/devices/system/node\n");
+        return 1;
+    }
+    printf("%s🧭 Topología:%s", COLOR_BOLD, COLOR_RESET);
+    for (int i = 0; i < topo.nnodes; i++) {
+        char cpus[128];
+        cpu_list_format(&topo.cpus[topo.nodes[i]], cpus, sizeof(cpus));
+        printf("  nodo %d: CPUs %s%s", topo.nodes[i], cpus, topo.has_memory[topo.nodes[i]] ? "" : " (sin memoria)");
+    }
+    printf("\n");
+    
+    char dir[64];
+    snprintf(dir, sizeof(dir), "/proc/%d/task", pid);
+    proc_dir_buf_t db = { 0 };
+    pid_t *tids = NULL;
+    size_t cap = 0;
+    ssize_t n = proc_list_pids(dir, &db, &tids, &cap);
+    if (n <= 0) {
+        fprintf(stderr, "❌ No se pudo leer %s\n", dir);
+        proc_dir_buf_free(&db);
+        return 1;
+    }
+    
+    printf("  %-8s %-16s %-16s %8s %5s  %s\n", "TID", "Nombre", "CPUs permitidas", "Últ.CPU", "Nodo", "Stack (VMA por nodo)");
+    for (ssize_t i = 0; i < n; i++) {
+        numa_task_t t;
+        if (numa_task_info(&topo, pid, tids[i], &t) < 0) continue;
+        char cpus[128], stack[160] = "?";
+        cpu_list_format(&t.allowed, cpus, sizeof(cpus));
+        uintptr_t sp = task_stack_pointer(pid, tids[i]);
+        numa_vma_t vma;
+        if (sp && numa_maps_lookup(pid, sp, &vma) == 0) {
+            numa_vma_format(&vma, stack, sizeof(stack));
+            // Página de la pila fuera del nodo donde corre el thread
+            if (t.node >= 0 && vma.total > vma.pages[t.node]) strncat(stack, "  " COLOR_RED "remota" COLOR_RESET, sizeof(stack) - strlen(stack) - 1);
+        }
+        printf("  %-8d %-16s %-16s %8d %5d  %s\n", t.tid, t.comm, cpus, t.last_cpu, t.node, stack);
+    }
+    
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, pid) == 0) {
+        const maps_region_t *regs[2] = { proc_maps_find_kind(&maps, MAPS_KIND_HEAP), proc_maps_find_kind(&maps, MAPS_KIND_STACK) };
+        const char *names[2] = { "[heap]", "[stack]" };
+        for (int i = 0; i < 2; i++) {
+            numa_vma_t vma;
+            char pages[160];
+            if (!regs[i] || numa_maps_lookup(pid, regs[i]->start, &vma) < 0) continue;
+            numa_vma_format(&vma, pages, sizeof(pages));
+            printf("  %-8s política %-12s %s\n", names[i], vma.policy, pages);
+        }
+    }
+    proc_maps_free(&maps);
+    free(tids);
+    proc_dir_buf_free(&db);
+    return 0;
+}
+
+// --sched-probe [--threads n] [--period us] [--samples n] [--hogs n] [--eventfd] [clase...]:
+// latencia despertar → correr de threads de este TGID con cada política/nice
+static int mode_sched_probe(int argc, char *argv[]) {
+    sprobe_cfg_t cfg;
+    sprobe_default_config(&cfg);
+    int custom = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) cfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) cfg.period_us = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) cfg.samples = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--hogs") == 0 && i + 1 < argc) cfg.hogs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--eventfd") == 0) cfg.wake = SPROBE_EVENTFD;
+        else {
+            if (!custom) cfg.nclasses = 0;
+            custom = 1;
+            if (cfg.nclasses == SPROBE_MAX_CLASSES || sprobe_parse_class(argv[i], &cfg.classes[cfg.nclasses]) < 0) {
+                fprintf(stderr, "Uso: proc_analysis --sched-probe [--threads n] [--period us] [--samples n] [--hogs n] [--eventfd] [clase...]\n"
+                                "     clase: other:<nice> batch:<nice> idle fifo:<prio> rr:<prio> (máx. %d)\n", SPROBE_MAX_CLASSES);
+                return 1;
+            }
+            cfg.nclasses++;
+        }
+    }
+    if (cfg.threads <= 0 || cfg.period_us == 0 || cfg.samples == 0 || cfg.hogs < 0) {
+        fprintf(stderr, "❌ --threads, --period y --samples deben ser positivos\n");
+        return 1;
+    }
+    
+    print_header("LATENCIA DE DESPERTAR POR POLÍTICA", 'M');
+    printf("  %d clases × %d threads, %lu despertares cada %u µs por %s, %d hogs: ~%.1f s\n",
+           cfg.nclasses, cfg.threads, cfg.samples, cfg.period_us,
+           cfg.wake == SPROBE_EVENTFD ? "eventfd" : "futex", cfg.hogs, cfg.samples * cfg.period_us / 1e6);
+    fflush(stdout);
+    
+    sprobe_result_t res;
+    if (sprobe_run(&cfg, &res) < 0) {
+        fprintf(stderr, "❌ No se pudieron crear los threads: %s\n", strerror(errno));
+        return 1;
+    }
+    
+    char line[256], tids[96];
+    printf("  TGID %s%d%s · temporizador TID %d (%s)", COLOR_GREEN, res.tgid, COLOR_RESET, res.driver_tid,
+           sprobe_policy_name(res.driver_policy));
+    if (res.nhogs > 0) {
+        printf(" · hogs TID %d-%d", res.hog_tids[0], res.hog_tids[res.nhogs - 1]);
+    }
+    printf("\n\n");
+    lat_hist_format(&res.timer, line, sizeof(line));
+    printf("  %-16s %-16s %8s %8s  %s\n", "Clase", "TIDs", "Muestras", "Perdidos", "Despertar → correr");
+    printf("  %-16s %-16d %8lu %8s  %s\n", "temporizador", res.driver_tid, (unsigned long)res.timer.count, "-", line);
+    for (int c = 0; c < res.nclasses; c++) {
+        const sprobe_class_result_t *cr = &res.cls[c];
+        size_t off = 0;
+        tids[0] = '\0';
+        for (int t = 0; t < cfg.threads && off + 8 < sizeof(tids); t++) {
+            off += (size_t)snprintf(tids + off, sizeof(tids) - off, "%s%d", t ? "," : "", cr->tids[t]);
+        }
+        lat_hist_format(&cr->hist, line, sizeof(line));
+        printf("  %s%-16s%s %-16s %8lu %8lu  %s\n", COLOR_BOLD, cfg.classes[c].label, COLOR_RESET, tids,
+               (unsigned long)cr->hist.count, cr->missed, line);
+        if (cr->error) {
+            printf("  %s  ⚠️  no aplicada (%s): medida como la política heredada%s\n", COLOR_YELLOW,
+                   strerror(cr->error), COLOR_RESET);
+        }
+    }
+    printf("\n  Temporizador: retraso de clock_nanosleep sobre el instante pedido.\n");
+    printf("  Resto: desde el FUTEX_WAKE/write del temporizador hasta que el thread vuelve a correr.\n");
+    sprobe_result_free(&res);
+    return 0;
+}
+
+// --stacks <pid> [--project n]: mapeo, guarda y marca de agua del stack de
+// cada thread, y el ahorro de ajustar el tamaño si hubiera n threads
+static int mode_stacks(int argc, char *argv[]) {
+    int project = 8192;
+    pid_t pid = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--project") == 0 && i + 1 < argc) project = atoi(argv[++i]);
+        else pid = (pid_t)atoi(argv[i]);
+    }
+    if (pid <= 0) {
+        fprintf(stderr, "Uso: proc_analysis --stacks <pid> [--project n]\n");
+        return 1;
+    }
+    print_header("STACKS POR THREAD", 'M');
+    printf("  Marca de agua: distancia desde el tope hasta la página tocada más baja (pagemap).\n");
+    printf("  Incluye TCB y TLS de glibc, que viven en la parte alta del stack de cada thread.\n\n");
+    print_stack_table(pid, project);
+    return 0;
+}
+
+// --thp <pid> [--all]: cobertura de huge pages por región y por qué no la hay
+static int mode_thp(int argc, char *argv[]) {
+    pid_t pid = 0;
+    int all = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--all") == 0) all = 1;
+        else pid = (pid_t)atoi(argv[i]);
+    }
+    if (pid <= 0) {
+        fprintf(stderr, "Uso: proc_analysis --thp <pid> [--all]\n");
+        return 1;
+    }
+    print_header("HUGE PAGES POR REGIÓN", 'Y');
+    printf("  Huge KB: AnonHugePages + Shmem/FilePmdMapped + hugetlbfs. Flag: hg = MADV_HUGEPAGE,\n");
+    printf("  nh = MADV_NOHUGEPAGE, ht = hugetlbfs. %s\n\n", all ? "Todas las regiones." : "Solo escribibles con Rss (--all: todas).");
+    print_thp_table(pid, all);
+    return 0;
+}
+
+// --footprint [pid] [--regions] [--top n]: USS/PSS/compartido del árbol de pid
+// (por defecto este proceso); --regions añade la atribución por región
+static int mode_footprint(int argc, char *argv[]) {
+    pid_t pid = get_tgid();
+    int regions = 0, top = 15;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--regions") == 0) regions = 1;
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) top = atoi(argv[++i]);
+        else if (atoi(argv[i]) > 0) pid = (pid_t)atoi(argv[i]);
+        else {
+            fprintf(stderr, "Uso: proc_analysis --footprint [pid] [--regions] [--top n]\n");
+            return 1;
+        }
+    }
+    print_header("HUELLA DE MEMORIA DEL ÁRBOL", 'G');
+    printf("  USS: páginas solo de ese proceso (Private_*). PSS: cada página compartida dividida entre\n");
+    printf("  quienes la mapean; la suma de PSS del árbol es su huella real, la de RSS la sobreestima.\n\n");
+    print_footprint_table(pid, regions, top);
+    return 0;
+}
+
+// --thp-bench [--mb n] [--accesses n]: lecturas aleatorias sobre un array
+// grande con páginas de 4 KB, THP por madvise y hugetlbfs
+static int mode_thp_bench(int argc, char *argv[]) {
+    size_t mb = 512;
+    uint64_t accesses = 20000000;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc) mb = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--accesses") == 0 && i + 1 < argc) accesses = strtoull(argv[++i], NULL, 10);
+        else {
+            fprintf(stderr, "Uso: proc_analysis --thp-bench [--mb n] [--accesses n]\n");
+            return 1;
+        }
+    }
+    if (mb == 0) {
+        fprintf(stderr, "❌ --mb debe ser positivo\n");
+        return 1;
+    }
+    thp_config_t cfg;
+    thp_config_read(&cfg);
+    
+    print_header("TLB: 4 KB vs THP vs HUGETLB", 'Y');
+    printf("  Array de %zu MB (como global_buffer, pero mayor que lo que cubre la TLB con 4 KB),\n", mb);
+    printf("  %llu lecturas aleatorias dependientes. THP enabled=%s defrag=%s\n\n",
+           (unsigned long long)accesses, cfg.enabled, cfg.defrag);
+    printf("  %-26s %9s %10s %9s %10s %11s %9s\n", "Páginas", "Fallos", "Tocar ms", "Huge MB", "Sec. GB/s",
+           "Aleat. ns", "Macc/s");
+    double base_ns = 0;
+    for (int m = 0; m < THP_BENCH_NMODES; m++) {
+        thp_bench_result_t r;
+        if (thp_bench_run((thp_bench_mode_t)m, mb << 20, accesses, &r) < 0) {
+            printf("  %-26s ❌ %s\n", thp_bench_name((thp_bench_mode_t)m), strerror(errno));
+            if (m == THP_BENCH_HUGETLB && errno == ENOMEM) {
+                printf("  %-26s    reservar antes: echo %zu > /proc/sys/vm/nr_hugepages\n", "", (mb + 1) / 2 + 1);
+            }
+            continue;
+        }
+        if (m == THP_BENCH_4K) base_ns = r.access_ns;
+        char ratio[24] = "";
+        if (m != THP_BENCH_4K && base_ns > 0 && r.access_ns > 0) snprintf(ratio, sizeof(ratio), "×%.2f", base_ns / r.access_ns);
+        printf("  %-26s %9ld %10.1f %9lu %10.2f ", thp_bench_name((thp_bench_mode_t)m), r.minflt, r.touch_ms,
+               r.huge_kb >> 10, r.seq_gbs);
+        printf("%s%11.1f%s %9.1f %s\n", m == THP_BENCH_4K ? COLOR_RED : COLOR_GREEN, r.access_ns, COLOR_RESET,
+               r.maccess_s, ratio);
+        fflush(stdout);
+    }
+    printf("\n  Huge MB: lo que smaps ve en huge pages tras tocar (THP cae a 4 KB sin memoria contigua).\n");
+    printf("  Sec.: apenas cambia; lo que gana con huge pages es el acceso aleatorio (menos page walks).\n");
+    return 0;
+}
+
+// --shutdown-bench [--iters n] [--children n,n,...] [--threads n]: latencia de
+// cada mecanismo de aviso y parada de un pool prefork en serie vs en paralelo
+static int mode_shutdown_bench(int argc, char *argv[]) {
+    unsigned long iters = 2000;
+    int children[8] = { 16, 128, 500 };
+    int nchildren = 3;
+    int nthreads = 64;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) iters = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) nthreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--children") == 0 && i + 1 < argc) {
+            nchildren = 0;
+            for (char *t = strtok(argv[++i], ","); t && nchildren < 8; t = strtok(NULL, ",")) {
+                children[nchildren++] = atoi(t);
+            }
+        } else {
+            fprintf(stderr, "Uso: proc_analysis --shutdown-bench [--iters n] [--children n,n,...] [--threads n]\n");
+            return 1;
+        }
+    }
+    if (iters == 0 || nthreads < 0) {
+        fprintf(stderr, "❌ --iters debe ser positivo y --threads no negativo\n");
+        return 1;
+    }
+    
+    print_header("AVISOS Y PARADA DE PROCESOS", 'R');
+    printf("  %sLatencia de aviso%s (envío → el hijo de fork() vuelve a correr, %lu avisos):\n\n",
+           COLOR_BOLD, COLOR_RESET, iters);
+    printf("  %-30s %10s %10s %10s %10s\n", "Mecanismo", "p50", "p99", "p99.9", "máx");
+    lat_hist_t *lat = malloc(sizeof(*lat));
+    if (!lat) return 1;
+    for (int m = 0; m < SD_NMECH; m++) {
+        lat_hist_init(lat);
+        if (sd_wake_bench((sd_mech_t)m, iters, lat) < 0) {
+            printf("  %-30s ❌ %s\n", sd_mech_name((sd_mech_t)m), strerror(errno));
+            continue;
+        }
+        char p50[24], p99[24], p999[24], max[24];
+        lat_format_ns(lat_hist_percentile(lat, 50), p50, sizeof(p50));
+        lat_format_ns(lat_hist_percentile(lat, 99), p99, sizeof(p99));
+        lat_format_ns(lat_hist_percentile(lat, 99.9), p999, sizeof(p999));
+        lat_format_ns(lat->max, max, sizeof(max));
+        printf("  %-30s %10s %10s %10s %10s\n", sd_mech_name((sd_mech_t)m), p50, p99, p999, max);
+        fflush(stdout);
+    }
+    free(lat);
+    
+    printf("\n  %sParada%s: hijos bloqueados en pause() (o en un futex compartido) + %d threads en este proceso\n\n",
+           COLOR_BOLD, COLOR_RESET, nthreads);
+    printf("  %-22s %7s %12s %12s %12s %12s\n", "Estrategia", "Hijos", "Arranque ms", "Hijos ms", "Threads ms", "Total ms");
+    for (int c = 0; c < nchildren; c++) {
+        double serial_ms = 0;
+        for (int h = 0; h < SD_NSTOP; h++) {
+            sd_stop_result_t r;
+            if (sd_stop_bench((sd_stop_t)h, children[c], nthreads, &r) < 0 && r.children == 0) {
+                printf("  %-22s %7d  ❌ %s\n", sd_stop_name((sd_stop_t)h), children[c], strerror(errno));
+                continue;
+            }
+            if (h == SD_STOP_SERIAL) serial_ms = r.stop_ms;
+            char speedup[24] = "";
+            if (h != SD_STOP_SERIAL && r.stop_ms > 0 && serial_ms > 0) {
+                snprintf(speedup, sizeof(speedup), "×%.1f", serial_ms / r.stop_ms);
+            }
+            printf("  %-22s %7d %12.1f %12.2f %12.2f %s%12.2f%s %s\n", sd_stop_name((sd_stop_t)h), r.children,
+                   r.spawn_ms, r.children_ms, r.threads_ms, h == SD_STOP_SERIAL ? COLOR_RED : COLOR_GREEN,
+                   r.stop_ms, COLOR_RESET, speedup);
+            fflush(stdout);
+        }
+    }
+    printf("\n  Hijos/Threads ms: desde la orden hasta el último waitpid/join de cada grupo.\n");
+    return 0;
+}
+
+// --scenario [--depth n] [--fanout n,n,...] [--threads n,n,...] [--private-kb n] [--shared-kb n]
+// [--cow-kb n] [--stack-kb n] [--timeout s] [--file f] [--workers n] [--force]: árboles de
+// procesos y threads a medida; tiempo de preparación, memoria del kernel, PSS y coste de escanear /proc
+#define SCN_MAX_RUNS 64
+
+static int mode_scenario(int argc, char *argv[]) {
+    scn_config_t base, runs[SCN_MAX_RUNS];
+    scn_config_default(&base);
+    int fanouts[8], nfanouts = 0, threads[8], nthreads = 0;
+    const char *file = NULL;
+    int force = 0;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned workers = ncpu > 0 ? (unsigned)ncpu : 1;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--force") == 0) {
+            force = 1;
+            continue;
+        }
+        if (strncmp(argv[i], "--", 2) != 0 || i + 1 >= argc) goto usage;
+        const char *val = argv[++i];
+        if (strcmp(argv[i - 1], "--file") == 0) file = val;
+        else if (strcmp(argv[i - 1], "--workers") == 0) workers = (unsigned)atoi(val);
+        else if (strcmp(argv[i - 1], "--fanout") == 0 || strcmp(argv[i - 1], "--threads") == 0) {
+            const char *key = argv[i - 1] + 2;
+            int is_fanout = strcmp(key, "fanout") == 0;
+            int *list = is_fanout ? fanouts : threads;
+            int *n = is_fanout ? &nfanouts : &nthreads;
+            char buf[128];
+            snprintf(buf, sizeof(buf), "%s", val);
+            *n = 0;
+            for (char *t = strtok(buf, ","); t && *n < 8; t = strtok(NULL, ",")) {
+                if (scn_config_set(&base, key, t) < 0) goto usage;
+                list[(*n)++] = atoi(t);
+            }
+        } else {
+            // --private-kb → private_kb
+            char key[32];
+            snprintf(key, sizeof(key), "%s", argv[i - 1] + 2);
+            for (char *c = key; *c; c++) if (*c == '-') *c = '_';
+            if (scn_config_set(&base, key, val) < 0) goto usage;
+        }
+    }
+    if (workers == 0) workers = 1;
+    
+    // Escenarios: uno por línea del archivo (sobre la base de la línea de
+    // comandos) o el producto de las listas de --fanout y --threads
+    int nruns = 0;
+    if (file) {
+        FILE *f = fopen(file, "r");
+        if (!f) {
+            fprintf(stderr, "❌ %s: %s\n", file, strerror(errno));
+            return 1;
+        }
+        char line[PATH_MAX];
+        int lineno = 0;
+        while (fgets(line, sizeof(line), f) && nruns < SCN_MAX_RUNS) {
+            lineno++;
+            runs[nruns] = base;
+            int r = scn_config_parse_line(&runs[nruns], line);
+            if (r < 0) {
+                fprintf(stderr, "❌ %s:%d: clave o valor inválido (depth, fanout, threads, private_kb, "
+                        "shared_kb, cow_kb, stack_kb, timeout)\n", file, lineno);
+                fclose(f);
+                return 1;
+            }
+            nruns += r;
+        }
+        fclose(f);
+    } else {
+        if (nfanouts == 0) fanouts[nfanouts++] = base.fanout;
+        if (nthreads == 0) threads[nthreads++] = base.threads;
+        for (int a = 0; a < nfanouts; a++) {
+            for (int b = 0; b < nthreads; b++) {
+                runs[nruns] = base;
+                runs[nruns].fanout = fanouts[a];
+                runs[nruns].threads = threads[b];
+                nruns++;
+            }
+        }
+    }
+    
+    print_header("ESCENARIOS: ÁRBOLES DE PROCESOS Y THREADS", 'M');
+    scn_limits_t lim;
+    scn_limits_read(&lim);
+    long room = scn_limits_headroom(&lim);
+    printf("  Límites: pid_max=%ld threads-max=%ld max_map_count=%ld RLIMIT_NPROC=%ld ", lim.pid_max,
+           lim.threads_max, lim.max_map_count, lim.nproc);
+    if (lim.cgroup_pids_cur >= 0) printf("cgroup pids.max=%ld (usados %ld)\n", lim.cgroup_pids_max, lim.cgroup_pids_cur);
+    else printf("cgroup pids: sin límite\n");
+    printf("  Tareas en el sistema: %ld; caben %s%ld%s más (-1 = sin límite)\n\n", lim.tasks_now, COLOR_BOLD,
+           room, COLOR_RESET);
+    
+    scn_result_t *res = calloc((size_t)nruns + 1, sizeof(*res));
+    if (!res) return 1;
+    printf("  %-5s %6s %6s %9s %9s %12s %11s %10s  %s\n", "Prof.", "Hijos", "Thr", "Procesos", "Tareas",
+           "Prep. ms", "Tareas/s", "Parada ms", "Fallos");
+    for (int r = 0; r < nruns; r++) {
+        const scn_config_t *c = &runs[r];
+        uint64_t procs, tasks;
+        if (scn_tree_size(c, &procs, &tasks) < 0) {
+            printf("  %-5d %6d %6d  ❌ más de %u tareas\n", c->depth, c->fanout, c->threads, SCN_MAX_TASKS);
+            continue;
+        }
+        // Cada thread extra son 2 mapeos (stack + guarda) en su proceso
+        long maps = 2L * (c->threads - 1) + 64;
+        if (!force && ((room >= 0 && (long)tasks > room) || (lim.max_map_count > 0 && maps > lim.max_map_count))) {
+            printf("  %-5d %6d %6d %9lu %9lu  ⚠️  no cabe en los límites del host (--force para intentarlo)\n",
+                   c->depth, c->fanout, c->threads, (unsigned long)procs, (unsigned long)tasks);
+            continue;
+        }
+        scn_result_t *x = &res[r];
+        if (scn_run(c, workers, x) < 0 && x->tasks == 0) {
+            printf("  %-5d %6d %6d  ❌ %s\n", c->depth, c->fanout, c->threads, strerror(errno));
+            continue;
+        }
+        char fails[96] = "0";
+        if (x->failed_forks || x->failed_threads || x->timed_out) {
+            snprintf(fails, sizeof(fails), "%s%u fork, %u threads (%s)%s%s", COLOR_RED, x->failed_forks,
+                     x->failed_threads, strerror(x->first_errno), x->timed_out ? " plazo agotado" : "", COLOR_RESET);
+        }
+        printf("  %-5d %6d %6d %9lu %9lu %12.1f %11.0f %10.1f  %s\n", c->depth, c->fanout, c->threads,
+               (unsigned long)x->procs, (unsigned long)x->tasks, x->setup_ms,
+               x->setup_ms > 0 ? x->tasks / (x->setup_ms / 1e3) : 0, x->teardown_ms, fails);
+        fflush(stdout);
+    }
+    
+    // Memoria: la del kernel no sale en ningún RSS; la PSS reparte lo compartido
+    printf("\n  %sMemoria%s (diferencia con el árbol arrancado; PSS/USS de smaps_rollup de cada proceso):\n\n",
+           COLOR_BOLD, COLOR_RESET);
+    printf("  %9s %10s %10s %10s %12s %10s %10s %12s %11s %13s\n", "Tareas", "KStack KB", "PTables KB", "Slab KB",
+           "Kernel/tarea", "RSS MB", "PSS MB", "PSS KB/proc", "USS KB/proc", "--footprint");
+    int last = -1;
+    for (int r = 0; r < nruns; r++) {
+        const scn_result_t *x = &res[r];
+        if (x->tasks == 0) continue;
+        last = r;
+        long kern = x->kmem.kstack_kb + x->kmem.pagetables_kb + x->kmem.sunreclaim_kb;
+        printf("  %9lu %10ld %10ld %10ld %9.1f KB ", (unsigned long)x->tasks, x->kmem.kstack_kb,
+               x->kmem.pagetables_kb, x->kmem.sunreclaim_kb, (double)kern / x->tasks);
+        printf("%10.1f %10.1f %12.1f %11.1f ", x->rss_kb / 1024.0, x->pss_kb / 1024.0,
+               x->procs ? (double)x->pss_kb / x->procs : 0, x->procs ? (double)x->uss_kb / x->procs : 0);
+        // Procesos que encuentra el recorrido del árbol frente a los creados
+        char found[32];
+        snprintf(found, sizeof(found), "%lu/%lu", (unsigned long)x->fp_procs, (unsigned long)x->procs);
+        printf("%s%13s%s\n", x->fp_procs == x->procs ? "" : COLOR_RED, found, x->fp_procs == x->procs ? "" : COLOR_RESET);
+    }
+    
+    // Lo que cuesta observarlo: escaneo de /proc con el pool y smaps_rollup de cada proceso
+    printf("\n  %sCoste de leer /proc%s (pool de %u workers, mejor de 3):\n\n", COLOR_BOLD, COLOR_RESET, workers);
+    printf("  %9s %9s %14s %14s %12s %16s\n", "Procesos", "Tareas", "Escaneo base", "Con el árbol",
+           "µs/proceso", "smaps_rollup ms");
+    for (int r = 0; r < nruns; r++) {
+        const scn_result_t *x = &res[r];
+        if (x->tasks == 0) continue;
+        size_t added = x->scan_n > x->scan_base_n ? x->scan_n - x->scan_base_n : 0;
+        char base_s[32], tree_s[32];
+        snprintf(base_s, sizeof(base_s), "%.2f (%zu)", x->scan_base_ms, x->scan_base_n);
+        snprintf(tree_s, sizeof(tree_s), "%.2f (%zu)", x->scan_ms, x->scan_n);
+        if (x->scan_ms < 0) snprintf(tree_s, sizeof(tree_s), "sin pool");     // no quedaban PIDs para sus threads
+        printf("  %9lu %9lu %14s %14s %12.2f %16.1f\n", (unsigned long)x->procs, (unsigned long)x->tasks, base_s,
+               tree_s, added && x->scan_ms >= 0 ? (x->scan_ms - x->scan_base_ms) * 1e3 / added : 0, x->pss_ms);
+    }
+    
+    // Desglose por caché de slab del escenario más grande que se pudo medir
+    if (last >= 0 && res[last].kmem.slab_readable) {
+        const scn_result_t *x = &res[last];
+        printf("\n  %sSlab por caché%s (%lu tareas en %lu procesos):\n\n", COLOR_BOLD, COLOR_RESET,
+               (unsigned long)x->tasks, (unsigned long)x->procs);
+        printf("  %-16s %10s %10s %12s\n", "Caché", "Objetos", "KB", "Bytes/tarea");
+        for (int i = 0; i < SCN_NSLABS; i++) {
+            if (x->kmem.slab_objs[i] == 0 && x->kmem.slab_kb[i] == 0) continue;
+            printf("  %-16s %10ld %10ld %12.0f\n", scn_slab_name(i), x->kmem.slab_objs[i], x->kmem.slab_kb[i],
+                   x->kmem.slab_kb[i] * 1024.0 / x->tasks);
+        }
+    } else if (last >= 0) {
+        printf("\n  /proc/slabinfo no es legible (hace falta root): solo totales de /proc/meminfo.\n");
+    }
+    printf("\n  Kernel/tarea: (KernelStack + PageTables + SUnreclaim) / tareas; ningún RSS lo incluye.\n");
+    printf("  PSS reparte lo compartido (shmem y COW) entre quienes lo mapean; USS es solo lo propio.\n");
+    free(res);
+    return 0;
+    
+usage:
+    fprintf(stderr, "Uso: proc_analysis --scenario [--depth n] [--fanout n,n,...] [--threads n,n,...] "
+            "[--private-kb n] [--shared-kb n] [--cow-kb n] [--stack-kb n] [--timeout s] [--file f] "
+            "[--workers n] [--force]\n");
+    return 1;
+}
+
+// --ipc-bench [--count n] [--sizes b,b,...] [--huge]: mensajes/s y latencia entre
+// padre e hijo de fork() con cada transporte y tamaño de mensaje
+static int mode_ipc_bench(int argc, char *argv[]) {
+    unsigned long count = 100000;
+    size_t sizes[16] = { 64, 1024, 16384, 262144 };
+    int nsizes = 4;
+    int huge = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--huge") == 0) huge = 1;
+        else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            nsizes = 0;
+            for (char *t = strtok(argv[++i], ","); t && nsizes < 16; t = strtok(NULL, ",")) {
+                sizes[nsizes++] = strtoul(t, NULL, 10);
+            }
+        } else {
+            fprintf(stderr, "Uso: proc_analysis --ipc-bench [--count n] [--sizes b,b,...] [--huge]\n");
+            return 1;
+        }
+    }
+    if (count == 0 || nsizes == 0) {
+        fprintf(stderr, "❌ --count y --sizes deben ser positivos\n");
+        return 1;
+    }
+    
+    print_header("IPC PADRE ↔ HIJO (fork)", 'C');
+    printf("  Flujo: padre → hijo, el hijo confirma al final. Latencia: ida y vuelta / 2.\n");
+    printf("  Como mucho 512 MB por medida: con mensajes grandes se envían menos.\n\n");
+    printf("  %-24s %8s %12s %10s %10s %10s %10s %s\n", "Transporte", "Tamaño", "Mensajes/s", "MB/s",
+           "p50", "p99", "p99.9", "");
+    
+    lat_hist_t *lat = malloc(sizeof(*lat));
+    if (!lat) return 1;
+    int huge_reported = 0;
+    for (int si = 0; si < nsizes; si++) {
+        size_t size = sizes[si] < 8 ? 8 : sizes[si];
+        unsigned long n = count;
+        if ((double)n * size > 512e6) n = (unsigned long)(512e6 / size);
+        if (n < 100) n = 100;
+        for (int pass = 0; pass < 1 + huge; pass++) {
+            for (int k = 0; k < IPC_NKINDS; k++) {
+                int shm = k == IPC_SHM_SPIN || k == IPC_SHM_EVENTFD;
+                if (pass == 1 && !shm) continue;
+                char name[40];
+                snprintf(name, sizeof(name), "%s%s", ipc_kind_name((ipc_kind_t)k), pass ? " (2 MB)" : "");
+                ipc_bench_result_t r;
+                lat_hist_init(lat);
+                if (ipc_bench_run((ipc_kind_t)k, size, n, pass ? IPC_RING_HUGE : 0, &r, lat) < 0) {
+                    if (pass && !huge_reported) {
+                        printf("  %-24s %8zu  %shuge pages no disponibles (%s): reservar con\n"
+                               "  %-24s %8s  echo 8 > /proc/sys/vm/nr_hugepages%s\n", name, size, COLOR_YELLOW,
+                               strerror(r.error), "", "", COLOR_RESET);
+                        huge_reported = 1;
+                    } else if (!pass) {
+                        printf("  %-24s %8zu  ❌ %s\n", name, size, strerror(r.error));
+                    }
+                    continue;
+                }
+                char p50[24], p99[24], p999[24];
+                lat_format_ns(lat_hist_percentile(lat, 50), p50, sizeof(p50));
+                lat_format_ns(lat_hist_percentile(lat, 99), p99, sizeof(p99));
+                lat_format_ns(lat_hist_percentile(lat, 99.9), p999, sizeof(p999));
+                printf("  %s%-24s%s %8zu %12.0f %10.1f %10s %10s %10s %s\n", shm ? COLOR_GREEN : "", name,
+                       shm ? COLOR_RESET : "", size, r.msgs_per_s, r.mb_per_s, p50, p99, p999,
+                       r.bad ? "⚠️  desordenados" : "");
+                fflush(stdout);
+            }
+        }
+    }
+    free(lat);
+    return 0;
+}
+
+// --cow <pid_a> <pid_b>: páginas compartidas en todas las regiones escribibles privadas
+static int mode_cow(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: proc_analysis --cow <pid_a> <pid_b>\n");
+        return 1;
+    }
+    pid_t a = (pid_t)atoi(argv[0]);
+    pid_t b = (pid_t)atoi(argv[1]);
+    
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    pagemap_t pa, pb;
+    int ok = pagemap_open(&pa, a) == 0;
+    ok = pagemap_open(&pb, b) == 0 && ok;
+    if (!ok || proc_maps_load(&maps, a) < 0) {
+        fprintf(stderr, "❌ No se pudo leer maps/pagemap de %d o %d\n", a, b);
+        pagemap_close(&pa);
+        pagemap_close(&pb);
+        proc_maps_free(&maps);
+        return 1;
+    }
+    
+    cow_stats_t total;
+    memset(&total, 0, sizeof(total));
+    printf("  %-40s %8s %10s %10s %10s\n", "Región (de A)", "Páginas", "Compartid.", "Priv. A", "Priv. B");
+    for (size_t i = 0; i < maps.nregions; i++) {
+        const maps_region_t *r = &maps.regions[i];
+        if (!(r->perms & MAPS_PERM_WRITE) || (r->perms & MAPS_PERM_SHARED)) continue;
+        cow_stats_t st;
+        if (cow_compare(&pa, &pb, r->start, r->end, &st) < 0 || st.present_a == 0) continue;
+        const char *name = proc_maps_name(&maps, r);
+        printf("  %-40.40s %8zu %10zu %10zu %10zu\n", *name ? name : "[anon]",
+               st.pages, st.shared, st.private_a, st.private_b);
+        total.pages += st.pages;
+        total.shared += st.shared;
+        total.private_a += st.private_a;
+        total.private_b += st.private_b;
+        total.pfn_known |= st.pfn_known;
+    }
+    printf("  %-40s %8zu %s%10zu%s %10zu %10zu\n", "TOTAL", total.pages,
+           COLOR_GREEN, total.shared, COLOR_RESET, total.private_a, total.private_b);
+    printf("  Método: %s\n", total.pfn_known ? "comparación de PFN" : "bit exclusivo (sin CAP_SYS_ADMIN)");
+    
+    pagemap_close(&pa);
+    pagemap_close(&pb);
+    proc_maps_free(&maps);
+    return 0;
+}
+
+// --cow-bench [páginas...]: coste de romper COW por página
+static int mode_cow_bench(int argc, char *argv[]) {
+    size_t defaults[] = { 256, 4096, 65536 };
+    int n = argc > 0 ? argc : 3;
+    
+    print_header("COSTE DE ROMPER COW", 'R');
+    printf("  %8s %12s %10s %10s %12s %14s\n",
+           "Páginas", "ns/pág (1ª)", "minflt", "ns/pág (2ª)", "Compart.antes", "Compart.después");
+    for (int i = 0; i < n; i++) {
+        size_t pages = argc > 0 ? strtoul(argv[i], NULL, 10) : defaults[i];
+        cow_break_t r;
+        if (pages == 0 || cow_break_bench(pages, &r) < 0) {
+            fprintf(stderr, "❌ Falló la medición con %zu páginas\n", pages);
+            continue;
+        }
+        printf("  %8zu %12.0f %10ld %10.1f %12zu %14zu\n", r.pages,
+               (double)r.touch_ns / (double)r.pages, r.minflt,
+               (double)r.retouch_ns / (double)r.pages, r.shared_before, r.shared_after);
+    }
+    return 0;
+}
+
+static int mode_log_binary(int argc, char *argv[]) {
+    if (argc < 1) {
+        fprintf(stderr, "Uso: proc_analysis --log-binary <fichero>\n");
+        return 1;
+    }
+    // O_APPEND: padre e hijo escriben lotes completos al mismo fichero
+    int fd = open(argv[0], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror(argv[0]);
+        return 1;
+    }
+    if (alog_init(ALOG_BINARY, fd, ALOG_CLOCK_TSC) < 0) {
+        perror("Error iniciando el logger");
+        return 1;
+    }
+    fprintf(stderr, "📝 Registro binario en %s (decodificar con --log-view). ENTER para terminar.\n", argv[0]);
+    return run_demo();
+}
+
+static int mode_log_view(int argc, char *argv[]) {
+    int show_tid = argc > 1 && strcmp(argv[0], "--tid") == 0;
+    if (argc < 1 + show_tid) {
+        fprintf(stderr, "Uso: proc_analysis --log-view [--tid] <fichero>\n");
+        return 1;
+    }
+    if (alog_view_file(argv[show_tid], STDOUT_FILENO, show_tid) < 0) {
+        perror(argv[show_tid]);
+        return 1;
+    }
+    return 0;
+}
+
+static int mode_log_sync(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    return run_demo();  // sin alog_init: printf directo, para comparar
+}
+
+// --pin [child=cpus|nN] [t1=cpus|nN] [t2=cpus|nN]: demostración con el hijo y
+// los threads fijados a CPUs ("0-3,8") o a un nodo NUMA ("n1")
+static int mode_pin(int argc, char *argv[]) {
+    static const char *const keys[3] = { "child=", "t1=", "t2=" };
+    numa_topo_t topo;
+    numa_topo_load(&topo);
+    for (int i = 0; i < argc; i++) {
+        int k = 0;
+        while (k < 3 && strncmp(argv[i], keys[k], strlen(keys[k])) != 0) k++;
+        if (k == 3 || numa_pin_parse(&topo, argv[i] + strlen(keys[k]), &demo_pins[k].pin) < 0) {
+            fprintf(stderr, "Uso: proc_analysis --pin [child=cpus|nN] [t1=cpus|nN] [t2=cpus|nN]\n"
+                            "     cpus en formato cpulist (\"0-3,8\"); nN = CPUs y memoria del nodo N\n");
+            return 1;
+        }
+        demo_pins[k].set = 1;
+    }
+    if (alog_init(ALOG_TEXT, STDOUT_FILENO, ALOG_CLOCK_TSC) < 0) {
+        perror("Error iniciando el logger");
+    }
+    return run_demo();
+}
+
+// --alloc <glibc|arena|pool>: demostración con ese asignador en print_memory_details
+static int mode_alloc(int argc, char *argv[]) {
+    alloc_mode_t mode;
+    if (argc < 1 || alloc_parse_mode(argv[0], &mode) < 0) {
+        fprintf(stderr, "Uso: proc_analysis --alloc <glibc|arena|pool>\n");
+        return 1;
+    }
+    alloc_set_mode(mode);
+    if (alog_init(ALOG_TEXT, STDOUT_FILENO, ALOG_CLOCK_TSC) < 0) {
+        perror("Error iniciando el logger");
+    }
+    return run_demo();
+}
+
+// --alloc-bench [--threads n,n,...] [--rounds n] [--objs n] [--modes m,m,...]:
+// alloc+free por segundo y RSS de glibc frente a arena y pool con N threads
+static int mode_alloc_bench(int argc, char *argv[]) {
+    int threads[16] = { 1, 4, 16, 64 };
+    int nthreads = 4;
+    alloc_mode_t modes[ALLOC_NMODES] = { ALLOC_GLIBC, ALLOC_ARENA, ALLOC_POOL };
+    int nmodes = ALLOC_NMODES;
+    alloc_bench_cfg_t cfg = { .rounds = 200, .objs = 4096 };
+    for (int i = 0; i < argc; i++) {
+        int ok = i + 1 < argc;
+        if (ok && strcmp(argv[i], "--rounds") == 0) cfg.rounds = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--objs") == 0) cfg.objs = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--threads") == 0) {
+            nthreads = 0;
+            for (char *t = strtok(argv[++i], ","); t && nthreads < 16; t = strtok(NULL, ",")) {
+                threads[nthreads++] = atoi(t);
+            }
+        } else if (ok && strcmp(argv[i], "--modes") == 0) {
+            nmodes = 0;
+            for (char *t = strtok(argv[++i], ","); t && nmodes < ALLOC_NMODES; t = strtok(NULL, ",")) {
+                if (alloc_parse_mode(t, &modes[nmodes]) < 0) ok = 0;
+                nmodes++;
+            }
+            if (!ok) i = argc;
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "Uso: proc_analysis --alloc-bench [--threads n,n,...] [--rounds n] [--objs n] [--modes glibc,arena,pool]\n");
+            return 1;
+        }
+    }
+    if (cfg.rounds == 0 || cfg.objs == 0 || nthreads == 0 || nmodes == 0) {
+        fprintf(stderr, "❌ --rounds, --objs, --threads y --modes deben ser positivos\n");
+        return 1;
+    }
+    
+    print_header("ASIGNADORES: GLIBC vs ARENA vs POOL", 'Y');
+    printf("  Por thread y ronda: %u allocs de 16-%d B, escritura, %u frees en orden aleatorio; %u rondas.\n",
+           cfg.objs, POOL_BLOCK, cfg.objs, cfg.rounds);
+    printf("  RSS: antes, pico (VmHWM), tras terminar los threads y tras malloc_trim(0), en MB.\n\n");
+    printf("  %-6s %8s %10s %8s %8s %8s %8s %8s %14s\n", "Modo", "Threads", "Mops/s", "Vivo",
+           "Antes", "Pico", "Después", "Trim", "Heaps/arenas");
+    for (int ti = 0; ti < nthreads; ti++) {
+        cfg.threads = threads[ti];
+        for (int mi = 0; mi < nmodes; mi++) {
+            alloc_bench_result_t r;
+            if (alloc_bench_run(modes[mi], &cfg, &r) < 0) {
+                printf("  %-6s %8d  ❌ %s\n", alloc_mode_name(modes[mi]), cfg.threads, strerror(errno));
+                continue;
+            }
+            char peak[16];
+            if (r.rss_peak_kb) snprintf(peak, sizeof(peak), "%.1f", r.rss_peak_kb / 1024.0);
+            else snprintf(peak, sizeof(peak), "?");
+            long kept = (long)r.rss_after_kb - (long)r.rss_before_kb;
+            printf("  %s%-6s%s %8d %10.1f %8.1f %8.1f %8s %s%8.1f%s %8.1f %8d/%-5d\n",
+                   COLOR_BOLD, alloc_mode_name(modes[mi]), COLOR_RESET, cfg.threads, r.mops,
+                   r.live_kb / 1024.0, r.rss_before_kb / 1024.0, peak,
+                   kept > (long)(r.live_kb / 4) ? COLOR_RED : "", r.rss_after_kb / 1024.0, COLOR_RESET,
+                   r.rss_trim_kb / 1024.0, r.glibc_heaps, r.glibc_arenas);
+            fflush(stdout);
+        }
+    }
+    printf("\n  Vivo: bytes pedidos si todos los threads coinciden en su pico. Pool: cada bloque ocupa %d B.\n", POOL_BLOCK);
+    printf("  Heaps/arenas: heaps de %lu MB de arenas secundarias de glibc en maps al terminar;\n"
+           "  persisten tras el join y su memoria solo vuelve con malloc_trim o si el heap queda vacío.\n",
+           GLIBC_HEAP_MAX >> 20);
+    return 0;
+}
+
+// --mtrack [pid] [--interval ms] [--top n] [--clean]: asignaciones de un
+// proceso con proc_mtrack; sin pid, los procesos que exportan su región
+static int mode_mtrack(int argc, char *argv[]) {
+    pid_t pid = 0;
+    unsigned interval = 1000;
+    int top = 10, clean = 0;
+    for (int i = 0; i < argc; i++) {
+        int ok = i + 1 < argc;
+        if (ok && strcmp(argv[i], "--interval") == 0) interval = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--top") == 0) top = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--clean") == 0) clean = 1;
+        else if (argv[i][0] != '-') pid = (pid_t)atoi(argv[i]);
+        else {
+            fprintf(stderr, "Uso: proc_analysis --mtrack [pid] [--interval ms] [--top n] [--clean]\n");
+            return 1;
+        }
+    }
+    if (pid > 0) {
+        print_header("ASIGNACIONES DE MEMORIA (MALLOC)", 'G');
+        printf("  Contadores exactos por thread (tamaño del chunk de glibc) y pilas muestreadas cada ~periodo bytes.\n");
+        printf("  Neto: bytes que asignó menos los que liberó ese thread (un free de otro thread lo descuenta allí).\n\n");
+        print_mtrack_report(pid, interval, top);
+        return 0;
+    }
+    
+    print_header("PROCESOS CON PROC_MTRACK", 'G');
+    DIR *d = opendir(MTRACK_DIR);
+    if (!d) {
+        printf("  ❌ %s: %s\n", MTRACK_DIR, strerror(errno));
+        return 1;
+    }
+    printf("  %-8s %-8s %-16s %10s %14s %8s\n", "PID", "Padre", "Nombre", "Vivo MB", "allocs", "Threads");
+    struct dirent *de;
+    int found = 0;
+    size_t plen = strlen(MTRACK_PREFIX);
+    while ((de = readdir(d)) != NULL) {
+        if (strncmp(de->d_name, MTRACK_PREFIX, plen) != 0) continue;
+        char *end;
+        pid_t p = (pid_t)strtol(de->d_name + plen, &end, 10);
+        const mtrack_shared_t *s;
+        if (*end != '\0' || p <= 0 || mtrack_open(p, &s) < 0) continue;      // no las copias de maps
+        int alive = kill(p, 0) == 0 || errno == EPERM;
+        char path[64], comm[32] = "(terminado)";
+        snprintf(path, sizeof(path), "/proc/%d/comm", p);
+        FILE *f = alive ? fopen(path, "r") : NULL;
+        if (f) {
+            if (fgets(comm, sizeof(comm), f)) comm[strcspn(comm, "\n")] = '\0';
+            fclose(f);
+        }
+        mtrack_totals_t t;
+        mtrack_totals(s, &t);
+        printf("  %-8d %-8d %-16s %10.2f %14lu %8d%s\n", p, s->parent, comm, t.live_bytes / 1048576.0,
+               (unsigned long)t.allocs, t.threads, !alive && clean ? "  → borrado" : "");
+        mtrack_close(s);
+        if (!alive && clean) {
+            snprintf(path, sizeof(path), "%s/%s%d", MTRACK_DIR, MTRACK_PREFIX, p);
+            unlink(path);
+            snprintf(path, sizeof(path), "%s/%s%d%s", MTRACK_DIR, MTRACK_PREFIX, p, MTRACK_MAPS_SUFFIX);
+            unlink(path);
+        }
+        found++;
+    }
+    closedir(d);
+    if (!found) {
+        printf("  (ninguno) Arrancar con PROC_MTRACK=1 ./proc_analysis o con LD_PRELOAD=./libproc_mtrack.so\n");
+    }
+    return 0;
+}
+
+// --mtrack-bench [--threads n,n,...] [--rounds n] [--objs n] [--period b]:
+// coste de proc_mtrack en el banco de --alloc-bench con glibc
+static int mode_mtrack_bench(int argc, char *argv[]) {
+    int threads[16] = { 1, 4, 16 };
+    int nthreads = 3;
+    uint64_t period = MTRACK_DEFAULT_PERIOD;
+    alloc_bench_cfg_t cfg = { .rounds = 200, .objs = 4096 };
+    for (int i = 0; i < argc; i++) {
+        int ok = i + 1 < argc;
+        if (ok && strcmp(argv[i], "--rounds") == 0) cfg.rounds = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--objs") == 0) cfg.objs = (unsigned)strtoul(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--period") == 0) period = strtoull(argv[++i], NULL, 10);
+        else if (ok && strcmp(argv[i], "--threads") == 0) {
+            nthreads = 0;
+            for (char *t = strtok(argv[++i], ","); t && nthreads < 16; t = strtok(NULL, ",")) {
+                threads[nthreads++] = atoi(t);
+            }
+        } else {
+            fprintf(stderr, "Uso: proc_analysis --mtrack-bench [--threads n,n,...] [--rounds n] [--objs n] [--period b]\n");
+            return 1;
+        }
+    }
+    if (cfg.rounds == 0 || cfg.objs == 0 || nthreads == 0 || period == 0) {
+        fprintf(stderr, "❌ --rounds, --objs, --threads y --period deben ser positivos\n");
+        return 1;
+    }
+    
+    // glibc: __libc_malloc/__libc_free directos, sin interposición (la referencia).
+    // Apagado: solo el salto del hook. Contando: el periodo pedido.
+    // Denso: una muestra cada 4 KB, para ver cuánto cuesta cada backtrace().
+    struct { const char *name; uint64_t period; int raw; } cfgs[] = {
+        { "glibc", 0, 1 }, { "apagado", 0, 0 }, { "contando", period, 0 }, { "denso", 4096, 0 },
+    };
+    int ncfg = sizeof(cfgs) / sizeof(cfgs[0]);
+    int was_on = mtrack_enabled();
+    uint64_t was_period = mtrack_self() ? mtrack_self()->period : 0;
+    
+    print_header("COSTE DEL SEGUIMIENTO DE MALLOC", 'G');
+    printf("  Banco de --alloc-bench con glibc: por thread y ronda %u malloc de 16-%d B y %u free; %u rondas.\n",
+           cfg.objs, POOL_BLOCK, cfg.objs, cfg.rounds);
+    printf("  Mejor de 5 pasadas alternando configuraciones. Contadas: allocs vistas / pedidas por el banco.\n\n");
+    printf("  %-9s %8s %10s %9s %10s %16s %9s\n", "Config", "Threads", "Mops/s", "Coste", "Periodo", "Contadas", "Muestras");
+    for (int ti = 0; ti < nthreads; ti++) {
+        cfg.threads = threads[ti];
+        double best[8] = { 0 };
+        uint64_t counted[8] = { 0 }, samples[8] = { 0 };
+        for (int rep = 0; rep < 5; rep++) {
+            for (int c = 0; c < ncfg; c++) {
+                if (cfgs[c].period) mtrack_start(cfgs[c].period, 0);
+                else mtrack_stop();
+                mtrack_totals_t before, after;
+                if (mtrack_self()) mtrack_totals(mtrack_self(), &before);
+                alloc_bench_result_t r;
+                cfg.malloc_fn = cfgs[c].raw ? mtrack_libc_malloc : NULL;
+                cfg.free_fn = cfgs[c].raw ? mtrack_libc_free : NULL;
+                int rc = alloc_bench_run(ALLOC_GLIBC, &cfg, &r);
+                mtrack_stop();
+                if (rc < 0) {
+                    printf("  ❌ %s\n", strerror(errno));
+                    return 1;
+                }
+                if (mtrack_self() && cfgs[c].period) {
+                    mtrack_totals(mtrack_self(), &after);
+                    counted[c] = after.allocs - before.allocs;
+                    samples[c] = after.samples - before.samples;
+                }
+                if (r.mops > best[c]) best[c] = r.mops;
+            }
+        }
+        uint64_t asked = (uint64_t)cfg.threads * cfg.rounds * cfg.objs;
+        for (int c = 0; c < ncfg; c++) {
+            double cost = best[0] > 0 && c ? (best[0] - best[c]) * 100 / best[0] : 0;
+            char per[24], cnt[48];
+            if (cfgs[c].period) snprintf(per, sizeof(per), "%lu KB", (unsigned long)(cfgs[c].period >> 10));
+            else snprintf(per, sizeof(per), "-");
+            if (cfgs[c].period) snprintf(cnt, sizeof(cnt), "%lu/%lu", (unsigned long)counted[c], (unsigned long)asked);
+            else snprintf(cnt, sizeof(cnt), "-");
+            printf("  %s%-9s%s %8d %10.1f %s%8.1f%%%s %10s %16s %9lu\n", COLOR_BOLD, cfgs[c].name, COLOR_RESET,
+                   cfg.threads, best[c], cost > 5 ? COLOR_RED : COLOR_GREEN, cost, COLOR_RESET, per, cnt,
+                   (unsigned long)samples[c]);
+        }
+        fflush(stdout);
+    }
+    if (was_on) mtrack_start(was_period, 0);
+    printf("\n  Coste: pérdida de Mops/s frente a glibc llamada directamente, sin interposición.\n");
+    printf("  Contadas > pedidas: también cuenta los arrays del propio banco y lo que asigna pthread.\n");
+    return 0;
+}
+
+typedef struct {
+    const char *flag;
+    int (*run)(int argc, char *argv[]);   // recibe los argumentos posteriores al flag
+    const char *help;
+    const char *example;                  // argumentos de una invocación típica (o NULL)
+} cli_mode_t;
+
+static const cli_mode_t cli_modes[] = {
+    { "--maps", mode_maps, "<pid> [addr...]   Resumen de /proc/<pid>/maps y región de cada dirección", NULL },
+    { "--addr", mode_addr, "<pid> [--count] [addr... | -]   Clasifica direcciones: sección ELF, heap, stacks, mmap", NULL },
+    { "--elf", mode_elf, "<pid|fichero> [--dump sección [bytes]] [símbolo | 0xdir ...]   Secciones, volcado y símbolos sin objdump", NULL },
+    { "--monitor", mode_monitor, "<pid> [--interval ms] [--count n] [--top n] [--stat-every n]   CPU%, espera y cambios de contexto por thread", NULL },
+    { "--scan", mode_scan, "[--workers n] [--repeat n] [--filter comm]   Tabla PID/TGID/PPID/threads/RSS/estado de cada thread del host", NULL },
+    { "--record", mode_record, "<archivo> [--interval ms] [--seconds n] [--span n] [--series n] [--arena-mb n]   Historial de todos los procesos en espacio fijo", "/tmp/procs.tsdb --seconds 600   # guardar la historia de todos los procesos" },
+    { "--history", mode_history, "<archivo> [--pid p] [--window s] [--top n] [--metric m]   Deltas y tasas del historial sin leer /proc", "/tmp/procs.tsdb --top 10 --metric minflt   # quién crece o hace más fallos" },
+    { "--track", mode_track, "<pid...> [--all] [--no-follow] [--count n]   fork/exec/exit por eventos (pidfd + netlink)", NULL },
+    { "--find", mode_find, "<comm> [--wait s]   PID del primer proceso con ese comm (espera su exec con netlink)", NULL },
+    { "--peek", mode_peek, "<pid> [pid_b] [--watch hz] [--count n] símbolo...   Variables de uno o dos procesos sin detenerlos", NULL },
+    { "--stacks", mode_stacks, "<pid> [--project n]   Tamaño, guarda y marca de agua del stack de cada thread", "$(pidof -s proc_analysis) --project 8192   # stack real y reservado con 8192 threads" },
+    { "--numa", mode_numa, "<pid>   CPUs permitidas, última CPU y nodo NUMA del stack de cada thread; heap por nodo", NULL },
+    { "--sched-probe", mode_sched_probe, "[--threads n] [--period us] [--samples n] [--hogs n] [--eventfd] [clase...]   Latencia de despertar por política y nice", "--hogs 2 other:0 other:19 fifo:50 rr:50   # latencia de despertar con la CPU ocupada" },
+    { "--thp", mode_thp, "<pid> [--all]   Cobertura de huge pages (THP/hugetlbfs) por región según smaps", "$(pidof -s proc_analysis)   # qué regiones están en huge pages" },
+    { "--footprint", mode_footprint, "[pid] [--regions] [--top n]   USS/PSS/compartido de todo el árbol (smaps_rollup; por región con pagemap + kpagecount)", NULL },
+    { "--thp-bench", mode_thp_bench, "[--mb n] [--accesses n]   Lecturas aleatorias con 4 KB vs MADV_HUGEPAGE vs MAP_HUGETLB", "--mb 512   # cuánto gana el acceso aleatorio con THP" },
+    { "--shutdown-bench", mode_shutdown_bench, "[--iters n] [--children n,n,...] [--threads n]   Latencia de kill/tgkill/pidfd/signalfd/futex/eventfd y parada en paralelo", "--children 500 --threads 64   # avisar a un proceso y parar 500 hijos + 64 threads" },
+    { "--scenario", mode_scenario, "[--depth n] [--fanout n,n,...] [--threads n,n,...] [--private-kb n] [--shared-kb n] [--file f] [--force]   Árbol de N hijos × M threads: preparación, memoria del kernel, PSS y coste de /proc", "--depth 2 --fanout 100 --threads 10 --private-kb 64   # la demostración a escala: 100 hijos × 100 nietos" },
+    { "--ipc-bench", mode_ipc_bench, "[--count n] [--sizes b,b,...] [--huge]   Anillo memfd vs pipe, socket UNIX y eventfd entre padre e hijo", "--huge   # transporte entre padre e hijo: anillo memfd, pipe, socket, eventfd" },
+    { "--alloc-bench", mode_alloc_bench, "[--threads n,n,...] [--rounds n] [--objs n] [--modes glibc,arena,pool]   Throughput y RSS de malloc vs arena y pool", "--threads 1,16,64   # fragmentación de arenas de glibc frente a arena/pool propios" },
+    { "--mtrack", mode_mtrack, "[pid] [--interval ms] [--top n] [--clean]   Ritmo de malloc/free por thread, vivos y pilas (PROC_MTRACK=1 o LD_PRELOAD)", "--top 10   # tras PROC_MTRACK=1 PROC_MTRACK_KEEP=1 ./proc_analysis o LD_PRELOAD=./libproc_mtrack.so <programa>" },
+    { "--mtrack-bench", mode_mtrack_bench, "[--threads n,n,...] [--rounds n] [--objs n] [--period b]   Coste del seguimiento de malloc sobre glibc", NULL },
+    { "--cow", mode_cow, "<pid_a> <pid_b>   Páginas compartidas/privadas entre dos procesos (pagemap)", NULL },
+    { "--cow-bench", mode_cow_bench, "[páginas...]   Coste por página de romper COW tras fork()", NULL },
+    { "--log-binary", mode_log_binary, "<fichero>   Demostración con registro binario en fichero", NULL },
+    { "--log-view", mode_log_view, "[--tid] <fichero>   Decodifica un registro binario a texto", NULL },
+    { "--log-sync", mode_log_sync, "  Demostración con printf síncrono (sin logger)", NULL },
+    { "--alloc", mode_alloc, "<glibc|arena|pool>   Demostración con ese asignador: origen de cada alloc y arenas de glibc", NULL },
+    { "--pin", mode_pin, "[child=cpus|nN] [t1=cpus|nN] [t2=cpus|nN]   Demostración con hijo y threads fijados a CPUs o nodos", NULL },
+};
+
+static int run_cli_mode(int argc, char *argv[]) {
+    for (size_t i = 0; i < sizeof(cli_modes) / sizeof(cli_modes[0]); i++) {
+        if (strcmp(argv[1], cli_modes[i].flag) == 0) {
+            return cli_modes[i].run(argc - 2, argv + 2);
+        }
+    }
+    
+    printf("Uso: %s              # demostración completa\n", argv[0]);
+    for (size_t i = 0; i < sizeof(cli_modes) / sizeof(cli_modes[0]); i++) {
+        printf("     %s %s %s\n", argv[0], cli_modes[i].flag, cli_modes[i].help);
+        if (cli_modes[i].example) {
+            printf("         p. ej.: %s %s %s\n", argv[0], cli_modes[i].flag, cli_modes[i].example);
+        }
+    }
+    return strcmp(argv[1], "--help") == 0 ? 0 : 1;
+}
+
+// ========== EVENTOS DEL KERNEL EN LA DEMOSTRACIÓN ==========
+
+// Imprime los eventos pendientes; devuelve 1 si entre ellos llegó la salida de child
+static int drain_tracker_events(proc_tracker_t *t, pid_t child) {
+    proc_event_t evs[16];
+    char line[160];
+    int child_exited = 0;
+    int n;
+    while ((n = proc_tracker_wait(t, evs, 16, 0)) > 0) {
+        for (int i = 0; i < n; i++) {
+            proc_event_format(&evs[i], line, sizeof(line));
+            print_timestamp("");
+            alog_printf("📡 Kernel: %s%s%s\n", COLOR_CYAN, line, COLOR_RESET);
+            if (evs[i].kind == PEV_EXIT && evs[i].pid == child) child_exited = 1;
+        }
+    }
+    return child_exited;
+}
+
+// Espera la salida de child (pidfd o netlink) hasta timeout_ms; el resto de eventos se descarta
+static int wait_child_exit(proc_tracker_t *t, pid_t child, int timeout_ms, proc_event_t *out) {
+    uint64_t deadline = now_ns() + (uint64_t)timeout_ms * 1000000ull;
+    proc_event_t evs[16];
+    while (now_ns() < deadline) {
+        int n = proc_tracker_wait(t, evs, 16, (int)((deadline - now_ns()) / 1000000) + 1);
+        if (n < 0 && errno != EINTR) return 0;
+        for (int i = 0; i < n; i++) {
+            if (evs[i].kind == PEV_EXIT && evs[i].pid == child) {
+                *out = evs[i];
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// ========== FUNCIÓN PRINCIPAL ==========
+
+static int run_demo(void) {
+    srand(time(NULL));
+    phase_costs = 1;
+    
+    print_header("PROCESO PADRE INICIADO", 'B');
     
     print_timestamp("");
-    printf("📊 Estado desde /proc/%d/status:\n", get_tgid());
-    char status_cmd[512];
-    snprintf(status_cmd, sizeof(status_cmd),
-             "echo '--- /proc/%d/status ---'; "
-             "cat /proc/%d/status | grep -E '^(Pid|Tgid|PPid|Threads|State|VmSize|VmRSS):'",
-             get_tgid(), get_tgid());
-    system(status_cmd);
+    alog_printf("TGID (getpid): %s%d%s, PID kernel (gettid): %s%ld%s\n", 
+           COLOR_GREEN, get_tgid(), COLOR_RESET,
+           COLOR_GREEN, (long)get_kernel_pid(), COLOR_RESET);
+    
+    // ========== 1. CREAR PROCESO HIJO CON fork() ==========
+    print_header("CREANDO PROCESO HIJO (fork)", 'R');
     
     print_timestamp("");
-    printf("\n📊 Procesos y threads activos:\n");
-    char ps_command[512];
-    snprintf(ps_command, sizeof(ps_command),
-             "echo '--- ps con threads ---'; "
-             "ps -eLf | grep -E \"(%d|%d)\" | head -15",
-             get_tgid(), child_pid);
-    system(ps_command);
+    alog_printf("Ejecutando fork()...\n");
+    // Canal creado antes de fork(): a diferencia de global_buffer, sus páginas
+    // no pasan por COW y padre e hijo escriben en la misma memoria física
+    ipc_ring_t chan;
+    int have_chan = ipc_ring_create(&chan, 64 * 1024, IPC_RING_EVENTFD) == 0;
+    // Padre e hijo escriben con flushers distintos: lo pendiente sale antes de fork()
+    alog_sync();
+    pid_t child_pid = fork();
+    
+    if (child_pid < 0) {
+        alog_printf("❌ fork() falló: %s\n", strerror(errno));
+        alog_sync();
+        if (have_chan) ipc_ring_destroy(&chan);
+        return 1;
+    }
+    if (child_pid == 0) {
+        child_process_code(have_chan ? &chan : NULL);
+    }
+    
+    // Para la parada: la señal va por el pidfd, no por un PID que podría reutilizarse
+    int child_pidfd = sd_pidfd_open(child_pid);
     
     print_timestamp("");
-    printf("\n🌳 Árbol de procesos:\n");
-    char tree_command[256];
-    snprintf(tree_command, sizeof(tree_command),
-             "pstree -p %d 2>/dev/null", get_tgid());
-    system(tree_command);
+    alog_printf("🔄 Proceso padre continúa\n");
+    alog_printf("   Hijo creado con TGID: %s%d%s\n", COLOR_GREEN, child_pid, COLOR_RESET);
+    
+    // El hijo se vigila con un pidfd y, si hay permiso, nuestros threads con el
+    // conector netlink: su muerte se ve al momento, no tras el getchar() final
+    proc_tracker_t tracker;
+    int tracking = proc_tracker_init(&tracker, PTRACK_NETLINK) == 0;
+    int child_alive = 1;
+    if (tracking) {
+        proc_tracker_watch(&tracker, child_pid);
+        proc_tracker_watch(&tracker, get_tgid());
+        print_timestamp("");
+        alog_printf("📡 Vigilando al hijo con pidfd%s\n",
+                    proc_tracker_has_netlink(&tracker) ? " y a nuestros threads con el conector netlink" : "");
+    }
     
-    // ========== 5. DEMOSTRACIÓN PEDAGÓGICA ==========
-    print_header("RESUMEN DE LA DEMOSTRACIÓN", 'G');
+    usleep(500000); // Dar tiempo al hijo para que muestre su info
     
-    printf("\n%s🎯 DIFERENCIAS CLAVE DEMOSTRADAS:%s\n", COLOR_BOLD, COLOR_RESET);
+    // ========== 2. CREAR THREADS CON pthread_create() ==========
+    print_header("CREANDO THREADS (pthread_create)", 'Y');
     
-    printf("\n%s🏷️  NOMENCLATURA CORRECTA:%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("  • getpid() → Thread Group ID (TGID) = \"Process ID\" para userspace\n");
-    printf("  • gettid() → PID kernel = Identificador único de tarea en el kernel\n");
-    printf("  • MISMO TGID = mismo grupo de threads = memoria compartida\n");
-    printf("  • TGID DIFERENTE = proceso diferente = memoria separada (COW)\n");
+    // Los threads son los workers de un pool (pthread_create dentro de
+    // thread_pool_init) y cada uno ejecuta thread_function como tarea
+    thread_pool_t pool;
+    tp_task_t thread_tasks[2];
+    int thread_ids[2] = {1, 2};
     
-    printf("\n%s1. PROCESOS (fork()):%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("   • %sTGID diferente%s: Padre=%d, Hijo=%d\n", COLOR_GREEN, COLOR_RESET, get_tgid(), child_pid);
-    printf("   • %sCopy-On-Write (COW)%s: Memoria separada al modificar\n", COLOR_GREEN, COLOR_RESET);
-    printf("   • %sAislamiento%s: Hijo ve global_var=%d, Padre ve global_var=%d\n", 
-           COLOR_GREEN, COLOR_RESET, 9999, global_var);
+    if (thread_pool_init(&pool, 2, "THREAD") < 0) {
+        perror("Error creando pool de threads");
+        return 1;
+    }
+    for (int i = 0; i < 2; i++) {
+        print_timestamp("");
+        alog_printf("Creando thread %d...\n", thread_ids[i]);
+        thread_tasks[i].fn = thread_task;
+        thread_tasks[i].arg = &thread_ids[i];
+        thread_pool_submit(&pool, &thread_tasks[i]);
+        usleep(100000); // Pequeña pausa entre creación
+    }
     
-    printf("\n%s2. THREADS (pthread_create()):%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("   • %sMismo TGID%s: Todos comparten TGID=%d\n", COLOR_GREEN, COLOR_RESET, get_tgid());
-    printf("   • %sPIDs kernel diferentes%s: Cada thread tiene PID único\n", COLOR_GREEN, COLOR_RESET);
-    printf("   • %sMemoria compartida%s: Mismas direcciones de variables globales\n", COLOR_GREEN, COLOR_RESET);
-    printf("   • %sStacks separados%s: Cada thread tiene stack propio\n", COLOR_GREEN, COLOR_RESET);
+    // Dar tiempo a los threads para ejecutarse
+    sleep(1);
+    if (tracking && drain_tracker_events(&tracker, child_pid)) child_alive = 0;
     
-    printf("\n%s3. VERIFICACIÓN DESDE OTRA TERMINAL:%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("   # Ver threads del proceso padre:\n");
-    printf("   %sls -la /proc/%d/task/%s\n", COLOR_CYAN, get_tgid(), COLOR_RESET);
+    // ========== 3. PADRE MODIFICA DESPUÉS DEL HIJO ==========
+    print_header("PADRE MODIFICA VARIABLES", 'C');
     
-    printf("   \n   # Comparar heaps (deberían ser diferentes):\n");
-    printf("   %scat /proc/%d/maps | grep heap%s\n", COLOR_CYAN, get_tgid(), COLOR_RESET);
-    printf("   %scat /proc/%d/maps | grep heap%s\n", COLOR_CYAN, child_pid, COLOR_RESET);
+    print_timestamp("");
+    alog_printf("📊 Estado del padre ANTES de modificar:\n");
+    alog_printf("  global_var = %d (¿debería ser 42?)\n", global_var);
+    alog_printf("  global_buffer = \"%.20s...\"\n", global_buffer);
     
-    printf("   \n   # Ver valores de variables en cada proceso:\n");
-    printf("   %ssudo gdb -p %d -ex \"p global_var\" -ex \"p global_buffer\" -ex \"q\"%s\n", 
-           COLOR_CYAN, get_tgid(), COLOR_RESET);
-    printf("   %ssudo gdb -p %d -ex \"p global_var\" -ex \"p global_buffer\" -ex \"q\"%s\n", 
-           COLOR_CYAN, child_pid, COLOR_RESET);
+    // Demostrar que el padre también activa COW
+    demonstrate_cow_difference(0); // 0 = es padre
     
-    // ========== 6. INTERACCIÓN DEL USUARIO ==========
-    print_header("CONTROL DEL PROGRAMA", 'R');
+    // Medir en lugar de suponer: páginas que siguen compartidas tras las escrituras
+    measure_cow_pages(get_tgid(), child_pid);
+    
+    // Y los valores que ve cada uno, leídos de su memoria
+    int child_global_var = 9999;    // lo que escribió demonstrate_cow_difference(1)
+    peek_globals(get_tgid(), child_pid, &child_global_var);
+    
+    // global_buffer ya es una página privada del padre: se puede migrar entre nodos
+    void *heap = __atomic_load_n(&thread_heaps[0], __ATOMIC_ACQUIRE);
+    measure_numa_latency(heap, heap ? THREAD_HEAP_BYTES : 0);
     
-    printf("\n%s🎯 PROCESOS ACTIVOS:%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("   • Proceso Padre:  TGID %s%d%s\n", COLOR_GREEN, get_tgid(), COLOR_RESET);
-    printf("   • Proceso Hijo:   TGID %s%d%s (en pausa)\n", COLOR_GREEN, child_pid, COLOR_RESET);
-    printf("   • Threads:        2 threads activos\n");
+    // Y lo que el hijo publicó en el anillo compartido
+    if (have_chan) receive_child_message(&chan, get_tgid(), child_pid);
     
-    printf("\n%s🛑 OPCIONES DE TERMINACIÓN:%s\n", COLOR_BOLD, COLOR_RESET);
-    printf("   1. %sPresiona ENTER%s - Terminar limpiamente (recomendado)\n", COLOR_GREEN, COLOR_RESET);
-    printf("   2. %sCtrl+C%s - Terminación forzada\n", COLOR_RED, COLOR_RESET);
-    printf("   3. %sDesde otra terminal%s:\n", COLOR_YELLOW, COLOR_RESET);
-    printf("      kill %d          # Terminar proceso padre\n", get_tgid());
-    printf("      kill -TERM -%d   # Terminar todo el árbol de procesos\n", get_tgid());
+    // ========== 4. MOSTRAR INFORMACIÓN DEL SISTEMA ==========
+    print_header("INFORMACIÓN DEL SISTEMA", 'B');
+    
+    // Un único snapshot leído directamente de /proc (sin fork/exec de cat/ps/pstree)
+    proc_snapshot_t snap;
+    if (proc_snapshot_init(&snap, get_tgid()) < 0 || proc_snapshot_take(&snap) < 0) {
+        perror("Error leyendo /proc");
+    }
+    
+    print_timestamp("");
+    alog_printf("📊 Estado desde /proc/%d/status:\n", get_tgid());
+    // Los printers escriben con stdio: antes debe salir todo lo del logger
+    alog_sync();
+    proc_snapshot_print_status(&snap);
+    
+    // VmRSS cuenta en padre e hijo las páginas COW que aún comparten
+    print_timestamp("");
+    alog_printf("\n📊 Huella real del árbol (smaps_rollup; ver --footprint %d --regions):\n", get_tgid());
+    print_footprint_table(get_tgid(), 0, 0);
+    
+    print_timestamp("");
+    alog_printf("\n📊 Procesos y threads activos:\n");
+    alog_sync();
+    proc_snapshot_print_threads(&snap);
+    
+    print_timestamp("");
+    alog_printf("\n🌳 Árbol de procesos:\n");
+    alog_sync();
+    proc_snapshot_print_tree(&snap);
+    
+    // Threads de padre e hijo según las mismas listas que se acaban de imprimir;
+    // el flusher del logger (ALOG-FLUSH) aparece en las dos tras el fork
+    size_t parent_threads = 0, child_threads = 0, logger_threads = 0;
+    for (size_t i = 0; i < snap.nnodes; i++) {
+        const proc_node_t *n = &snap.nodes[i];
+        if (n->status.tgid == get_tgid()) parent_threads = n->nthreads;
+        else if (n->status.tgid == child_pid) child_threads = n->nthreads;
+        else continue;
+        for (size_t t = 0; t < n->nthreads; t++) {
+            logger_threads += strcmp(snap.threads[n->first_thread + t].comm, "ALOG-FLUSH") == 0;
+        }
+    }
+    proc_snapshot_free(&snap);
+    
+    // ========== 5. DEMOSTRACIÓN PEDAGÓGICA ==========
+    print_header("RESUMEN DE LA DEMOSTRACIÓN", 'G');
     
-    printf("\n%s⏎ Presiona ENTER para terminar limpiamente...%s\n", COLOR_BOLD, COLOR_RESET);
-    getchar();
+    alog_printf("\n%s🎯 DIFERENCIAS CLAVE DEMOSTRADAS:%s\n", COLOR_BOLD, COLOR_RESET);
+    
+    alog_printf("\n%s🏷️  NOMENCLATURA CORRECTA:%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("  • getpid() → Thread Group ID (TGID) = \"Process ID\" para userspace\n");
+    alog_printf("  • gettid() → PID kernel = Identificador único de tarea en el kernel\n");
+    alog_printf("  • MISMO TGID = mismo grupo de threads = memoria compartida\n");
+    alog_printf("  • TGID DIFERENTE = proceso diferente = memoria separada (COW)\n");
+    
+    alog_printf("\n%s1. PROCESOS (fork()):%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("   • %sTGID diferente%s: Padre=%d, Hijo=%d\n", COLOR_GREEN, COLOR_RESET, get_tgid(), child_pid);
+    alog_printf("   • %sCopy-On-Write (COW)%s: Memoria separada al modificar\n", COLOR_GREEN, COLOR_RESET);
+    alog_printf("   • %sAislamiento%s: Hijo ve global_var=%d, Padre ve global_var=%d\n", 
+           COLOR_GREEN, COLOR_RESET, child_global_var, global_var);
+    
+    alog_printf("\n%s2. THREADS (pthread_create()):%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("   • %sMismo TGID%s: Todos comparten TGID=%d\n", COLOR_GREEN, COLOR_RESET, get_tgid());
+    alog_printf("   • %sPIDs kernel diferentes%s: Cada thread tiene PID único\n", COLOR_GREEN, COLOR_RESET);
+    alog_printf("   • %sMemoria compartida%s: Mismas direcciones de variables globales\n", COLOR_GREEN, COLOR_RESET);
+    alog_printf("   • %sStacks separados%s: Cada thread tiene stack propio (mapeo, guarda y marca de agua):\n", COLOR_GREEN, COLOR_RESET);
+    print_stack_table(get_tgid(), 0);
+    alog_printf("   • %sHuge pages%s: cobertura THP de lo que escribe el programa (smaps):\n", COLOR_GREEN, COLOR_RESET);
+    print_thp_table(get_tgid(), 0);
+    
+    alog_printf("\n%s3. VERIFICACIÓN DESDE OTRA TERMINAL:%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("   # Ver threads del proceso padre:\n");
+    alog_printf("   %sls -la /proc/%d/task/%s\n", COLOR_CYAN, get_tgid(), COLOR_RESET);
+    
+    alog_printf("   \n   # Stack que usa realmente cada thread y regiones en huge pages:\n");
+    alog_printf("   %s./proc_analysis --stacks %d && ./proc_analysis --thp %d%s\n", COLOR_CYAN, get_tgid(), get_tgid(), COLOR_RESET);
+    
+    alog_printf("   \n   # Bancos y modos que no dependen de este proceso (con un ejemplo de cada uno):\n");
+    alog_printf("   %s./proc_analysis --help%s\n", COLOR_CYAN, COLOR_RESET);
+    
+    alog_printf("   \n   # Comparar heaps (deberían ser diferentes):\n");
+    alog_printf("   %scat /proc/%d/maps | grep heap%s\n", COLOR_CYAN, get_tgid(), COLOR_RESET);
+    alog_printf("   %scat /proc/%d/maps | grep heap%s\n", COLOR_CYAN, child_pid, COLOR_RESET);
+    
+    alog_printf("   \n   # Ver valores de variables en cada proceso (sin detenerlos, como gdb -p):\n");
+    alog_printf("   %s./proc_analysis --peek %d %d global_var global_buffer%s\n",
+           COLOR_CYAN, get_tgid(), child_pid, COLOR_RESET);
+    alog_printf("   %s./proc_analysis --peek %d %d --watch 1000 global_var%s   # cambios a 1 kHz\n",
+           COLOR_CYAN, get_tgid(), child_pid, COLOR_RESET);
+    
+    // ========== 6. INTERACCIÓN DEL USUARIO ==========
+    print_header("CONTROL DEL PROGRAMA", 'R');
+    
+    alog_printf("\n%s🎯 PROCESOS ACTIVOS:%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("   • Proceso Padre:  TGID %s%d%s\n", COLOR_GREEN, get_tgid(), COLOR_RESET);
+    alog_printf("   • Proceso Hijo:   TGID %s%d%s (en pausa)\n", COLOR_GREEN, child_pid, COLOR_RESET);
+    alog_printf("   • Threads:        %zu en el padre y %zu en el hijo (%zu de ellos ALOG-FLUSH, el del logger)\n",
+                parent_threads, child_threads, logger_threads);
+    
+    alog_printf("\n%s🛑 OPCIONES DE TERMINACIÓN:%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_printf("   1. %sPresiona ENTER%s - Terminar limpiamente (recomendado)\n", COLOR_GREEN, COLOR_RESET);
+    alog_printf("   2. %sCtrl+C%s - Terminación forzada\n", COLOR_RED, COLOR_RESET);
+    alog_printf("   3. %sDesde otra terminal%s:\n", COLOR_YELLOW, COLOR_RESET);
+    alog_printf("      kill %d          # Terminar proceso padre\n", get_tgid());
+    alog_printf("      kill -TERM -%d   # Terminar todo el árbol de procesos\n", get_tgid());
+    
+    alog_printf("\n%s⏎ Presiona ENTER para terminar limpiamente...%s\n", COLOR_BOLD, COLOR_RESET);
+    alog_sync();
+    // ENTER o eventos del kernel, lo que llegue antes
+    for (;;) {
+        struct pollfd pfds[2] = {
+            { .fd = STDIN_FILENO, .events = POLLIN },
+            { .fd = tracking ? tracker.epfd : -1, .events = POLLIN },
+        };
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            getchar();
+            break;
+        }
+        if ((pfds[1].revents & POLLIN) && drain_tracker_events(&tracker, child_pid) && child_alive) {
+            child_alive = 0;
+            print_timestamp("");
+            alog_printf("⚠️  El hijo %d terminó antes de tiempo (nadie le envió SIGTERM desde aquí)\n", child_pid);
+            alog_sync();
+        }
+        if (pfds[0].revents & (POLLIN | POLLHUP)) {
+            getchar();
+            break;
+        }
+    }
     
     // ========== 7. LIMPIEZA ==========
     print_header("TERMINANDO PROCESOS", 'R');
     
     print_timestamp("");
-    printf("🧹 Limpiando recursos...\n");
+    alog_printf("🧹 Limpiando recursos...\n");
     
-    // Terminar proceso hijo
-    if (child_pid > 0) {
-        print_timestamp("");
-        printf("Enviando SIGTERM al proceso hijo %d...\n", child_pid);
-        kill(child_pid, SIGTERM);
-        waitpid(child_pid, NULL, 0);
+    // Parada en paralelo: primero las órdenes (señal al hijo, parada
+    // cooperativa a los threads) y luego se espera a todos, no uno tras otro
+    uint64_t t_stop = now_ns();
+    if (child_alive) {
         print_timestamp("");
-        printf("✅ Proceso hijo terminado\n");
+        alog_printf("Enviando SIGTERM al proceso hijo %d (%s)...\n", child_pid,
+                    child_pidfd >= 0 ? "pidfd_send_signal" : "kill");
+        alog_sync();        // antes que el "terminando" que imprime el hijo al recibirla
+        if (child_pidfd < 0 || sd_pidfd_send_signal(child_pidfd, SIGTERM) < 0) kill(child_pid, SIGTERM);
     }
     
-    // Terminar threads
+    // Terminar threads mientras el hijo sale: sin pthread_cancel, cada thread
+    // sale de su espera y termina
     print_timestamp("");
-    printf("Terminando threads...\n");
-    for (int i = 0; i < 2; i++) {
-        print_timestamp("");
-        printf("  Enviando señal al thread %d...\n", i+1);
-        pthread_cancel(threads[i]);
-        pthread_join(threads[i], NULL);
-        print_timestamp("");
-        printf("  ✅ Thread %d terminado\n", i+1);
+    alog_printf("Terminando threads...\n");
+    print_timestamp("");
+    alog_printf("  Pidiendo parada cooperativa a %u threads...\n", pool.nworkers);
+    thread_pool_shutdown(&pool);
+    print_timestamp("");
+    alog_printf("  ✅ Threads terminados (%.1f µs)\n", (now_ns() - t_stop) / 1e3);
+    
+    if (child_alive) {
+        proc_event_t ev;
+        if (tracking && wait_child_exit(&tracker, child_pid, 5000, &ev)) {
+            char st[64];
+            proc_event_format_status(ev.status, st, sizeof(st));
+            print_timestamp("");
+            alog_printf("✅ Proceso hijo terminado (%s, aviso por %s %.1f µs después de la señal)\n", st,
+                        ev.source == PEV_SRC_PIDFD ? "pidfd" : "netlink", (ev.recv_ns - t_stop) / 1e3);
+        } else {
+            waitpid(child_pid, NULL, 0);
+            print_timestamp("");
+            alog_printf("✅ Proceso hijo terminado\n");
+        }
     }
+    // Recoge al hijo si netlink avisó antes de que el pidfd fuera legible
+    if (tracking) proc_tracker_free(&tracker);
+    if (child_pidfd >= 0) close(child_pidfd);
+    if (have_chan) ipc_ring_destroy(&chan);
+    print_timestamp("");
+    alog_printf("🧹 Parada completa en %.1f µs (hijo y threads a la vez; ver --shutdown-bench)\n",
+                (now_ns() - t_stop) / 1e3);
     
     print_header("DEMOSTRACIÓN COMPLETADA", 'G');
     print_timestamp("");
-    printf("✅ Todos los procesos e hilos terminados limpiamente.\n\n");
+    alog_printf("✅ Todos los procesos e hilos terminados limpiamente.\n\n");
     
     print_timestamp("");
-    printf("📚 RESUMEN DE LO APRENDIDO:\n");
+    alog_printf("📚 RESUMEN DE LO APRENDIDO:\n");
     print_timestamp("");
-    printf("  1. fork() crea procesos con memoria separada (COW)\n");
+    alog_printf("  1. fork() crea procesos con memoria separada (COW)\n");
     print_timestamp("");
-    printf("  2. pthread_create() crea threads que comparten memoria\n");
+    alog_printf("  2. pthread_create() crea threads que comparten memoria\n");
     print_timestamp("");
-    printf("  3. getpid() devuelve TGID (igual para todos los threads)\n");
+    alog_printf("  3. getpid() devuelve TGID (igual para todos los threads)\n");
     print_timestamp("");
-    printf("  4. gettid() devuelve PID kernel (único para cada thread)\n");
+    alog_printf("  4. gettid() devuelve PID kernel (único para cada thread)\n");
     print_timestamp("");
-    printf("  5. TGID diferente = procesos diferentes\n");
+    alog_printf("  5. TGID diferente = procesos diferentes\n");
     print_timestamp("");
-    printf("  6. Mismo TGID = threads del mismo proceso\n");
+    alog_printf("  6. Mismo TGID = threads del mismo proceso\n");
     
+    print_phase_cost();
+    perf_group_close(&phase_perf);
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        return run_cli_mode(argc, argv);
+    }
+    
+    // Toda la salida de la demostración pasa por el logger asíncrono
+    if (alog_init(ALOG_TEXT, STDOUT_FILENO, ALOG_CLOCK_TSC) < 0) {
+        perror("Error iniciando el logger");
+    }
+    return run_demo();
+}
@@ -0,0 +1,42 @@
+// proc_common.h - Utilidades compartidas por proc_analysis y sus módulos
+#ifndef PROC_COMMON_H
+#define PROC_COMMON_H
+
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+
+// ========== COLORES ==========
+#define COLOR_RESET   "\033[0m"
+#define COLOR_RED     "\033[31m"
+#define COLOR_GREEN   "\033[32m"
+#define COLOR_YELLOW  "\033[33m"
+#define COLOR_BLUE    "\033[34m"
+#define COLOR_MAGENTA "\033[35m"
+#define COLOR_CYAN    "\033[36m"
+#define COLOR_BOLD    "\033[1m"
+
+// ========== IDENTIFICADORES ==========
+
+// Función para obtener PID del kernel (gettid wrapper con nombre correcto)
+static inline pid_t get_kernel_pid(void) {
+    return syscall(SYS_gettid);
+}
+
+// Función para obtener TGID (getpid wrapper con nombre correcto)
+static inline pid_t get_tgid(void) {
+    return getpid();  // getpid() realmente devuelve TGID
+}
+
+// ========== MEDICIÓN DE TIEMPO ==========
+
+// Nanosegundos monotónicos (para benchmarks y deltas entre muestras)
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#endif // PROC_COMMON_H
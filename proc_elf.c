@@ -0,0 +1,377 @@
+// proc_elf.c - Lectura de ELF64 mapeado en memoria
+//
+// El fichero se mapea entero con PROT_READ y todas las tablas se leen en su
+// sitio: no se copia nada y solo se tocan las páginas que se consultan.
+// Solo ELF64 little endian (x86-64 / aarch64), que es lo que ejecuta este host.
+//
+// La primera búsqueda por nombre recorre .symtab directamente; a partir de la
+// segunda se construye una tabla hash (4 bytes por hueco). La búsqueda por
+// dirección necesita un índice ordenado (12 bytes por símbolo), que se
+// construye con radix sort la primera vez: con cientos de miles de símbolos
+// qsort es unas 7 veces más lento.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "proc_elf.h"
+
+// ¿[off, off + len) está dentro del fichero?
+static int in_file(const elf_file_t *e, uint64_t off, uint64_t len) {
+    return off <= e->size && len <= e->size - off;
+}
+
+// .symtab o, en binarios stripped, .dynsym; con su tabla de cadenas (sh_link)
+static void load_symtab(elf_file_t *e) {
+    const Elf64_Shdr *sym = NULL;
+    for (size_t i = 0; i < e->nsections; i++) {
+        const Elf64_Shdr *s = &e->shdrs[i];
+        if (s->sh_type == SHT_SYMTAB || (s->sh_type == SHT_DYNSYM && !sym)) sym = s;
+    }
+    if (!sym || sym->sh_entsize != sizeof(Elf64_Sym) || sym->sh_link >= e->nsections ||
+        !in_file(e, sym->sh_offset, sym->sh_size)) return;
+    const Elf64_Shdr *str = &e->shdrs[sym->sh_link];
+    // Tabla de cadenas terminada en '\0': así strcmp nunca se sale del fichero
+    if (str->sh_size == 0 || !in_file(e, str->sh_offset, str->sh_size) ||
+        e->base[str->sh_offset + str->sh_size - 1] != '\0') return;
+    e->syms = (const Elf64_Sym *)(e->base + sym->sh_offset);
+    e->nsyms = sym->sh_size / sizeof(Elf64_Sym);
+    e->strtab = (const char *)(e->base + str->sh_offset);
+    e->strtab_size = str->sh_size;
+}
+
+int elf_open(elf_file_t *e, const char *path) {
+    memset(e, 0, sizeof(*e));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Elf64_Ehdr)) {
+        close(fd);
+        errno = ENOEXEC;
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    e->base = map;
+    e->size = (size_t)st.st_size;
+    e->ehdr = map;
+
+    const Elf64_Ehdr *h = e->ehdr;
+    if (memcmp(h->e_ident, ELFMAG, SELFMAG) != 0 || h->e_ident[EI_CLASS] != ELFCLASS64 ||
+        h->e_ident[EI_DATA] != ELFDATA2LSB) {
+        elf_close(e);
+        errno = ENOEXEC;
+        return -1;
+    }
+
+    if (h->e_phnum && h->e_phentsize == sizeof(Elf64_Phdr) &&
+        in_file(e, h->e_phoff, (uint64_t)h->e_phnum * sizeof(Elf64_Phdr))) {
+        e->phdrs = (const Elf64_Phdr *)(e->base + h->e_phoff);
+        e->nphdrs = h->e_phnum;
+    }
+
+    if (h->e_shnum && h->e_shentsize == sizeof(Elf64_Shdr) &&
+        in_file(e, h->e_shoff, (uint64_t)h->e_shnum * sizeof(Elf64_Shdr))) {
+        e->shdrs = (const Elf64_Shdr *)(e->base + h->e_shoff);
+        e->nsections = h->e_shnum;
+        if (h->e_shstrndx < e->nsections) {
+            const Elf64_Shdr *s = &e->shdrs[h->e_shstrndx];
+            if (in_file(e, s->sh_offset, s->sh_size)) {
+                e->shstrtab = (const char *)(e->base + s->sh_offset);
+                e->shstrtab_size = s->sh_size;
+            }
+        }
+        load_symtab(e);
+    }
+    return 0;
+}
+
+void elf_close(elf_file_t *e) {
+    if (e->base) munmap((void *)e->base, e->size);
+    free(e->sym_addrs);
+    free(e->sym_index);
+    free(e->name_slots);
+    memset(e, 0, sizeof(*e));
+}
+
+const char *elf_section_name(const elf_file_t *e, size_t i) {
+    if (i >= e->nsections || !e->shstrtab) return "";
+    uint32_t off = e->shdrs[i].sh_name;
+    if (off >= e->shstrtab_size) return "";
+    // Cadena terminada dentro de la tabla
+    if (!memchr(e->shstrtab + off, '\0', e->shstrtab_size - off)) return "";
+    return e->shstrtab + off;
+}
+
+const void *elf_section_data(const elf_file_t *e, size_t i) {
+    if (i >= e->nsections) return NULL;
+    const Elf64_Shdr *s = &e->shdrs[i];
+    if (s->sh_type == SHT_NOBITS || !in_file(e, s->sh_offset, s->sh_size)) return NULL;
+    return e->base + s->sh_offset;
+}
+
+long elf_find_section(const elf_file_t *e, const char *name) {
+    for (size_t i = 0; i < e->nsections; i++) {
+        if (strcmp(elf_section_name(e, i), name) == 0) return (long)i;
+    }
+    return -1;
+}
+
+long elf_section_at(const elf_file_t *e, uint64_t vaddr) {
+    for (size_t i = 0; i < e->nsections; i++) {
+        const Elf64_Shdr *s = &e->shdrs[i];
+        // .tbss/.tdata son plantillas por thread: sus direcciones se solapan con otras secciones
+        if (!(s->sh_flags & SHF_ALLOC) || (s->sh_flags & SHF_TLS)) continue;
+        if (vaddr >= s->sh_addr && vaddr - s->sh_addr < s->sh_size) return (long)i;
+    }
+    return -1;
+}
+
+uint64_t elf_min_load_vaddr(const elf_file_t *e) {
+    const Elf64_Phdr *first = NULL;
+    for (size_t i = 0; i < e->nphdrs; i++) {
+        const Elf64_Phdr *p = &e->phdrs[i];
+        if (p->p_type == PT_LOAD && (!first || p->p_vaddr < first->p_vaddr)) first = p;
+    }
+    // El mapping con offset 0 empieza en la vaddr de ese offset, alineada a página
+    return first ? (first->p_vaddr - first->p_offset) & ~(uint64_t)0xfff : 0;
+}
+
+int elf_load_bias(const elf_file_t *e, const proc_maps_t *maps, const char *path, uintptr_t *bias) {
+    *bias = 0;
+    if (e->ehdr->e_type != ET_DYN) return 0;
+    for (size_t i = 0; i < maps->nregions; i++) {
+        const maps_region_t *r = &maps->regions[i];
+        if (r->kind == MAPS_KIND_FILE && r->offset == 0 && strcmp(proc_maps_name(maps, r), path) == 0) {
+            *bias = r->start - (uintptr_t)elf_min_load_vaddr(e);
+            return 0;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int elf_open_process(elf_file_t *e, pid_t pid, const proc_maps_t *maps, uintptr_t *bias) {
+    char path[64], exe[4096];
+    snprintf(path, sizeof(path), "/proc/%d/exe", pid);
+    ssize_t n = readlink(path, exe, sizeof(exe) - 1);
+    if (n < 0) return -1;
+    exe[n] = '\0';
+    if (elf_open(e, path) < 0) return -1;
+    // maps nombra el fichero por la ruta del enlace (incluido " (deleted)")
+    if (elf_load_bias(e, maps, exe, bias) < 0) {
+        elf_close(e);
+        return -1;
+    }
+    return 0;
+}
+
+// ========== SÍMBOLOS ==========
+
+const char *elf_symbol_name(const elf_file_t *e, const Elf64_Sym *s) {
+    return s->st_name < e->strtab_size ? e->strtab + s->st_name : "";
+}
+
+static int is_defined(const Elf64_Sym *s) {
+    return s->st_shndx != SHN_UNDEF && ELF64_ST_TYPE(s->st_info) != STT_SECTION &&
+           ELF64_ST_TYPE(s->st_info) != STT_FILE;
+}
+
+// Hash de 8 en 8 bytes: los nombres C++ decorados miden fácilmente 100 bytes
+// y un hash byte a byte domina la construcción del índice
+static uint32_t name_hash(const char *s) {
+    size_t len = strlen(s);
+    uint64_t h = len * 0x9e3779b97f4a7c15ull;
+    for (; len >= 8; s += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, s, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+    uint64_t w = 0;
+    memcpy(&w, s, len);
+    h = (h ^ w) * 0xc4ceb9fe1a85ec53ull;
+    return (uint32_t)(h ^ (h >> 29));
+}
+
+static int build_name_index(elf_file_t *e) {
+    size_t cap = 16;
+    while (cap < e->nsyms * 2) cap <<= 1;
+    e->name_slots = calloc(cap, sizeof(*e->name_slots));
+    if (!e->name_slots) return -1;
+    e->name_mask = cap - 1;
+    // En orden de tabla: los duplicados quedan en la secuencia de sondeo en ese orden
+    for (size_t i = 0; i < e->nsyms; i++) {
+        const Elf64_Sym *s = &e->syms[i];
+        if (!is_defined(s) || s->st_name == 0 || s->st_name >= e->strtab_size) continue;
+        size_t slot = name_hash(e->strtab + s->st_name) & e->name_mask;
+        while (e->name_slots[slot]) slot = (slot + 1) & e->name_mask;
+        e->name_slots[slot] = (uint32_t)i + 1;
+    }
+    return 0;
+}
+
+const Elf64_Sym *elf_find_symbol(elf_file_t *e, const char *name) {
+    const Elf64_Sym *local = NULL;
+    if (!e->name_slots && e->name_queries++ > 0 && e->nsyms) build_name_index(e);
+
+    if (e->name_slots) {
+        for (size_t slot = name_hash(name) & e->name_mask; e->name_slots[slot];
+             slot = (slot + 1) & e->name_mask) {
+            const Elf64_Sym *s = &e->syms[e->name_slots[slot] - 1];
+            if (strcmp(e->strtab + s->st_name, name) != 0) continue;
+            if (ELF64_ST_BIND(s->st_info) != STB_LOCAL) return s;
+            if (!local) local = s;
+        }
+        return local;
+    }
+
+    const char c0 = name[0];
+    for (size_t i = 0; i < e->nsyms; i++) {
+        const Elf64_Sym *s = &e->syms[i];
+        if (s->st_name >= e->strtab_size) continue;
+        const char *sn = e->strtab + s->st_name;
+        // El primer byte descarta casi todos los candidatos sin llamar a strcmp
+        if (sn[0] != c0 || !is_defined(s) || strcmp(sn, name) != 0) continue;
+        if (ELF64_ST_BIND(s->st_info) != STB_LOCAL) return s;
+        if (!local) local = s;
+    }
+    return local;
+}
+
+// Radix sort LSD de (dirección, índice) por bytes; se saltan los bytes que son
+// iguales en todas las claves (los altos, casi siempre)
+static int radix_sort(uint64_t *keys, uint32_t *vals, size_t n) {
+    uint64_t *tk = malloc(n * sizeof(*tk));
+    uint32_t *tv = malloc(n * sizeof(*tv));
+    size_t (*hist)[256] = calloc(8, sizeof(*hist));
+    if (!tk || !tv || !hist) {
+        free(tk);
+        free(tv);
+        free(hist);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (int b = 0; b < 8; b++) hist[b][(keys[i] >> (b * 8)) & 0xff]++;
+    }
+    uint64_t *sk = keys, *dk = tk;
+    uint32_t *sv = vals, *dv = tv;
+    for (int b = 0; b < 8; b++) {
+        if (hist[b][(sk[0] >> (b * 8)) & 0xff] == n) continue;
+        size_t pos[256], sum = 0;
+        for (int d = 0; d < 256; d++) {
+            pos[d] = sum;
+            sum += hist[b][d];
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t p = pos[(sk[i] >> (b * 8)) & 0xff]++;
+            dk[p] = sk[i];
+            dv[p] = sv[i];
+        }
+        uint64_t *k = sk; sk = dk; dk = k;
+        uint32_t *v = sv; sv = dv; dv = v;
+    }
+    if (sk != keys) {
+        memcpy(keys, sk, n * sizeof(*keys));
+        memcpy(vals, sv, n * sizeof(*vals));
+    }
+    free(tk);
+    free(tv);
+    free(hist);
+    return 0;
+}
+
+static int build_addr_index(elf_file_t *e) {
+    size_t n = 0;
+    for (size_t i = 0; i < e->nsyms; i++) {
+        const Elf64_Sym *s = &e->syms[i];
+        uint8_t t = ELF64_ST_TYPE(s->st_info);
+        n += is_defined(s) && s->st_shndx != SHN_ABS && t != STT_TLS && s->st_value != 0;
+    }
+    e->sym_addrs = malloc((n ? n : 1) * sizeof(*e->sym_addrs));
+    e->sym_index = malloc((n ? n : 1) * sizeof(*e->sym_index));
+    if (!e->sym_addrs || !e->sym_index) return -1;
+    n = 0;
+    for (size_t i = 0; i < e->nsyms; i++) {
+        const Elf64_Sym *s = &e->syms[i];
+        uint8_t t = ELF64_ST_TYPE(s->st_info);
+        if (!is_defined(s) || s->st_shndx == SHN_ABS || t == STT_TLS || s->st_value == 0) continue;
+        e->sym_addrs[n] = s->st_value;
+        e->sym_index[n++] = (uint32_t)i;
+    }
+    if (n > 1 && radix_sort(e->sym_addrs, e->sym_index, n) < 0) return -1;
+    e->nsym_addrs = n;
+    return 0;
+}
+
+const Elf64_Sym *elf_symbol_at(elf_file_t *e, uint64_t vaddr, uint64_t *off) {
+    if (!e->sym_addrs && build_addr_index(e) < 0) return NULL;
+    if (e->nsym_addrs == 0 || vaddr < e->sym_addrs[0]) return NULL;
+
+    // Último símbolo con dirección <= vaddr (búsqueda binaria sin saltos)
+    const uint64_t *base = e->sym_addrs;
+    size_t len = e->nsym_addrs;
+    while (len > 1) {
+        size_t half = len / 2;
+        base = base[half] <= vaddr ? base + half : base;
+        len -= half;
+    }
+    // Hacia atrás: un objeto grande puede contener etiquetas posteriores sin tamaño
+    size_t i = (size_t)(base - e->sym_addrs);
+    for (size_t k = 0; k < 16; k++, i--) {
+        const Elf64_Sym *s = &e->syms[e->sym_index[i]];
+        uint64_t d = vaddr - s->st_value;
+        if (d < s->st_size || (s->st_size == 0 && d == 0)) {
+            *off = d;
+            return s;
+        }
+        if (i == 0) break;
+    }
+    return NULL;
+}
+
+void elf_symbol_info(const elf_file_t *e, const Elf64_Sym *s, uintptr_t bias, elf_symbol_info_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->name = elf_symbol_name(e, s);
+    out->section = "";
+    out->vaddr = s->st_value;
+    out->size = s->st_size;
+    out->runtime = (uintptr_t)s->st_value + bias;
+    out->type = ELF64_ST_TYPE(s->st_info);
+    out->bind = ELF64_ST_BIND(s->st_info);
+    if (s->st_shndx == SHN_UNDEF || s->st_shndx >= e->nsections) return;
+    const Elf64_Shdr *sh = &e->shdrs[s->st_shndx];
+    out->section = elf_section_name(e, s->st_shndx);
+    out->sec_offset = s->st_value - sh->sh_addr;
+    if (sh->sh_type != SHT_NOBITS) out->file_offset = sh->sh_offset + out->sec_offset;
+}
+
+const char *elf_symbol_type_name(uint8_t type) {
+    switch (type) {
+    case STT_NOTYPE:  return "NOTYPE";
+    case STT_OBJECT:  return "OBJECT";
+    case STT_FUNC:    return "FUNC";
+    case STT_SECTION: return "SECTION";
+    case STT_FILE:    return "FILE";
+    case STT_COMMON:  return "COMMON";
+    case STT_TLS:     return "TLS";
+    case STT_GNU_IFUNC: return "IFUNC";
+    default:          return "?";
+    }
+}
+
+const char *elf_symbol_bind_name(uint8_t bind) {
+    switch (bind) {
+    case STB_LOCAL:  return "LOCAL";
+    case STB_GLOBAL: return "GLOBAL";
+    case STB_WEAK:   return "WEAK";
+    case STB_GNU_UNIQUE: return "UNIQUE";
+    default:         return "?";
+    }
+}
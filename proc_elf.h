@@ -0,0 +1,97 @@
+// proc_elf.h - Lectura de ELF64 mapeado en memoria (solo lectura, sin copias)
+#ifndef PROC_ELF_H
+#define PROC_ELF_H
+
+#include <elf.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_maps.h"
+
+typedef struct {
+    const uint8_t *base;        // mmap de todo el fichero
+    size_t size;
+    const Elf64_Ehdr *ehdr;
+    const Elf64_Shdr *shdrs;    // NULL si el fichero no tiene tabla de secciones
+    size_t nsections;
+    const char *shstrtab;
+    size_t shstrtab_size;
+    const Elf64_Phdr *phdrs;
+    size_t nphdrs;
+
+    // Símbolos: .symtab si existe, si no .dynsym (binario stripped)
+    const Elf64_Sym *syms;
+    size_t nsyms;
+    const char *strtab;
+    size_t strtab_size;
+
+    // Índice por dirección (se construye en la primera búsqueda por dirección).
+    // SoA como en addr_map_t: la búsqueda binaria solo recorre sym_addrs.
+    uint64_t *sym_addrs;
+    uint32_t *sym_index;
+    size_t nsym_addrs;
+
+    // Tabla hash por nombre (desde la segunda búsqueda por nombre: una consulta
+    // suelta es más barata recorriendo .symtab que construyendo el índice)
+    uint32_t *name_slots;       // índice de símbolo + 1, 0 = vacío
+    size_t name_mask;
+    unsigned name_queries;
+} elf_file_t;
+
+// Símbolo resuelto a sección, offset y dirección en ejecución
+typedef struct {
+    const char *name;
+    const char *section;        // "" para SHN_ABS/SHN_COMMON/...
+    uint64_t vaddr;             // st_value
+    uint64_t size;
+    uint64_t sec_offset;        // desde el inicio de la sección
+    uint64_t file_offset;       // en el fichero (0 si la sección es NOBITS)
+    uintptr_t runtime;          // vaddr + bias
+    uint8_t type;               // STT_*
+    uint8_t bind;               // STB_*
+} elf_symbol_info_t;
+
+// Abre y valida (ELF64, little endian, tablas dentro del fichero)
+int  elf_open(elf_file_t *e, const char *path);
+void elf_close(elf_file_t *e);
+
+// Nombre de la sección i ("" si no tiene)
+const char *elf_section_name(const elf_file_t *e, size_t i);
+
+// Contenido de la sección i dentro del mapeo (NULL para SHT_NOBITS o fuera de rango)
+const void *elf_section_data(const elf_file_t *e, size_t i);
+
+// Primera sección con ese nombre, o -1
+long elf_find_section(const elf_file_t *e, const char *name);
+
+// Sección SHF_ALLOC que contiene vaddr, o -1
+long elf_section_at(const elf_file_t *e, uint64_t vaddr);
+
+// vaddr que corresponde al offset 0 del fichero (primer PT_LOAD, alineada a página)
+uint64_t elf_min_load_vaddr(const elf_file_t *e);
+
+// Desplazamiento de carga: dirección en ejecución = vaddr del ELF + bias.
+// Para PIE (ET_DYN) sale del mapping de path con offset 0 en maps; ET_EXEC → 0.
+int  elf_load_bias(const elf_file_t *e, const proc_maps_t *maps, const char *path, uintptr_t *bias);
+
+// Abre /proc/<pid>/exe y calcula su bias con maps (ya cargado para pid)
+int  elf_open_process(elf_file_t *e, pid_t pid, const proc_maps_t *maps, uintptr_t *bias);
+
+// ========== SÍMBOLOS ==========
+
+const char *elf_symbol_name(const elf_file_t *e, const Elf64_Sym *s);
+
+// Símbolo definido con ese nombre (prefiere GLOBAL/WEAK sobre LOCAL), o NULL.
+// La primera consulta recorre la tabla en su sitio; las siguientes usan el hash.
+const Elf64_Sym *elf_find_symbol(elf_file_t *e, const char *name);
+
+// Símbolo que contiene vaddr (función u objeto), o NULL; *off = vaddr - st_value
+const Elf64_Sym *elf_symbol_at(elf_file_t *e, uint64_t vaddr, uint64_t *off);
+
+void elf_symbol_info(const elf_file_t *e, const Elf64_Sym *s, uintptr_t bias, elf_symbol_info_t *out);
+
+const char *elf_symbol_type_name(uint8_t type);
+const char *elf_symbol_bind_name(uint8_t bind);
+
+#endif // PROC_ELF_H
@@ -0,0 +1,404 @@
+// proc_events.c - Seguimiento de procesos por eventos
+//
+// Dos fuentes, las dos dentro de un mismo epoll:
+//   - pidfd (pidfd_open): se vuelve legible cuando el proceso termina. Es la
+//     fuente fiable para los PID vigilados y, si son hijos nuestros, permite
+//     recoger el estado con waitid(P_PIDFD) sin bloquear.
+//   - conector de procesos (NETLINK_CONNECTOR, CN_IDX_PROC): fork/exec/exit de
+//     todo el host con marca de tiempo del kernel. Requiere CAP_NET_ADMIN en el
+//     espacio de nombres inicial; sin él se sigue solo con pidfd.
+// Nada de esto recorre /proc periódicamente: solo se lee .../children al
+// empezar a vigilar con PTRACK_FOLLOW y si el socket netlink se desborda.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+#include "proc_common.h"
+#include "proc_events.h"
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+#define NL_RCVBUF   (4 << 20)   // margen para ráfagas de fork en todo el host
+#define ACK_WAIT_MS 100
+
+// ========== CONJUNTO DE VIGILADOS ==========
+
+// Posición de pid en watch (o donde habría que insertarlo)
+static size_t watch_pos(const proc_tracker_t *t, pid_t pid) {
+    size_t lo = 0, hi = t->nwatch;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (t->watch[mid].pid < pid) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static ptrack_watch_t *watch_find(const proc_tracker_t *t, pid_t pid) {
+    size_t i = watch_pos(t, pid);
+    return i < t->nwatch && t->watch[i].pid == pid ? &t->watch[i] : NULL;
+}
+
+static void watch_remove(proc_tracker_t *t, ptrack_watch_t *w) {
+    epoll_ctl(t->epfd, EPOLL_CTL_DEL, w->pidfd, NULL);
+    close(w->pidfd);
+    size_t i = (size_t)(w - t->watch);
+    memmove(&t->watch[i], &t->watch[i + 1], (t->nwatch - i - 1) * sizeof(*w));
+    t->nwatch--;
+}
+
+// Hijos actuales de pid (hilo principal): para PTRACK_FOLLOW al empezar y tras perder eventos
+static void follow_children(proc_tracker_t *t, pid_t pid) {
+    char path[64], buf[4096];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/children", pid, pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return;
+    buf[n] = '\0';
+    char *p = buf;
+    while (*p) {
+        char *end;
+        long child = strtol(p, &end, 10);
+        if (end == p) break;
+        proc_tracker_watch(t, (pid_t)child);
+        p = end;
+    }
+}
+
+int proc_tracker_watch(proc_tracker_t *t, pid_t pid) {
+    size_t i = watch_pos(t, pid);
+    if (i < t->nwatch && t->watch[i].pid == pid) return 0;
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (t->nwatch == t->watch_cap) {
+        size_t cap = t->watch_cap ? t->watch_cap * 2 : 16;
+        ptrack_watch_t *nw = realloc(t->watch, cap * sizeof(*nw));
+        if (!nw) {
+            close(fd);
+            return -1;
+        }
+        t->watch = nw;
+        t->watch_cap = cap;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = (uint64_t)pid };
+    if (epoll_ctl(t->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        return -1;
+    }
+    memmove(&t->watch[i + 1], &t->watch[i], (t->nwatch - i) * sizeof(*t->watch));
+    t->watch[i] = (ptrack_watch_t){ .pid = pid, .pidfd = fd, .status = -1, .reported = 0 };
+    t->nwatch++;
+
+    if (t->flags & PTRACK_FOLLOW) follow_children(t, pid);
+    return 0;
+}
+
+// ========== CONECTOR NETLINK ==========
+
+static int netlink_send_op(int fd, enum proc_cn_mcast_op op) {
+    // nlmsghdr + cn_msg + op, alineado como espera el kernel
+    union {
+        char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(op))];
+        struct nlmsghdr align;
+    } u;
+    memset(&u, 0, sizeof(u));
+    struct nlmsghdr *nl = &u.align;
+    nl->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+    nl->nlmsg_type = NLMSG_DONE;
+    struct cn_msg *cn = NLMSG_DATA(nl);
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(op);
+    memcpy(cn->data, &op, sizeof(op));
+    return send(fd, nl, nl->nlmsg_len, 0) < 0 ? -1 : 0;
+}
+
+// Suscribe y espera el ACK del kernel: sin permiso el ACK trae el error
+// (o no llega nada si el conector no está compilado)
+static int netlink_open(void) {
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0) return -1;
+    int rcv = NL_RCVBUF;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcv, sizeof(rcv)) < 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcv, sizeof(rcv));
+    }
+    struct sockaddr_nl sa = { .nl_family = AF_NETLINK, .nl_groups = CN_IDX_PROC, .nl_pid = 0 };
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || netlink_send_op(fd, PROC_CN_MCAST_LISTEN) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    uint64_t deadline = now_ns() + ACK_WAIT_MS * 1000000ull;
+    union {
+        char buf[4096];
+        struct nlmsghdr align;
+    } u;
+    for (;;) {
+        uint64_t now = now_ns();
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (now >= deadline || poll(&pfd, 1, (int)((deadline - now) / 1000000) + 1) <= 0) break;
+        ssize_t len = recv(fd, u.buf, sizeof(u.buf), 0);
+        if (len <= 0) continue;
+        for (struct nlmsghdr *nl = &u.align; NLMSG_OK(nl, (size_t)len); nl = NLMSG_NEXT(nl, len)) {
+            struct cn_msg *cn = NLMSG_DATA(nl);
+            struct proc_event *pe = (struct proc_event *)cn->data;
+            if (cn->id.idx != CN_IDX_PROC || pe->what != PROC_EVENT_NONE) continue;
+            if (pe->event_data.ack.err == 0) return fd;
+            close(fd);
+            errno = (int)pe->event_data.ack.err;
+            return -1;
+        }
+    }
+    close(fd);
+    errno = ETIMEDOUT;
+    return -1;
+}
+
+static void emit(proc_event_t *ev, uint8_t kind, uint8_t source, pid_t pid, pid_t tgid, pid_t parent,
+                 int status, uint64_t kernel_ns) {
+    ev->kind = kind;
+    ev->source = source;
+    ev->pid = pid;
+    ev->tgid = tgid;
+    ev->parent = parent;
+    ev->status = status;
+    ev->kernel_ns = kernel_ns;
+    ev->recv_ns = now_ns();
+}
+
+// Un mensaje del conector → 0 o 1 eventos
+static int netlink_event(proc_tracker_t *t, const struct proc_event *pe, proc_event_t *ev) {
+    int all = (t->flags & PTRACK_ALL) != 0;
+    switch (pe->what) {
+    case PROC_EVENT_FORK: {
+        pid_t parent = pe->event_data.fork.parent_tgid;
+        pid_t child = pe->event_data.fork.child_pid;
+        pid_t ctgid = pe->event_data.fork.child_tgid;
+        int thread = child != ctgid;
+        // En un thread nuevo parent_* es el padre del proceso (real_parent se comparte)
+        if (thread) parent = ctgid;
+        int watched = watch_find(t, parent) != NULL;
+        if (!thread && watched && (t->flags & PTRACK_FOLLOW)) proc_tracker_watch(t, child);
+        if (!all && !watched) return 0;
+        emit(ev, thread ? PEV_THREAD : PEV_FORK, PEV_SRC_NETLINK, child, ctgid, parent, -1, pe->timestamp_ns);
+        return 1;
+    }
+    case PROC_EVENT_EXEC: {
+        pid_t tgid = pe->event_data.exec.process_tgid;
+        if (!all && !watch_find(t, tgid)) return 0;
+        emit(ev, PEV_EXEC, PEV_SRC_NETLINK, pe->event_data.exec.process_pid, tgid, 0, -1, pe->timestamp_ns);
+        return 1;
+    }
+    case PROC_EVENT_EXIT: {
+        pid_t pid = pe->event_data.exit.process_pid;
+        pid_t tgid = pe->event_data.exit.process_tgid;
+        int status = (int)pe->event_data.exit.exit_code;
+        if (pid != tgid) {
+            if (!all && !watch_find(t, tgid)) return 0;
+            emit(ev, PEV_THREAD_EXIT, PEV_SRC_NETLINK, pid, tgid, 0, status, pe->timestamp_ns);
+            return 1;
+        }
+        // Se entrega ya; el pidfd se cierra (y el hijo se recoge) cuando se vuelva legible
+        ptrack_watch_t *w = watch_find(t, pid);
+        if (w) {
+            if (w->reported) return 0;
+            w->reported = 1;
+            w->status = status;
+        } else if (!all) {
+            return 0;
+        }
+        emit(ev, PEV_EXIT, PEV_SRC_NETLINK, pid, tgid, pe->event_data.exit.parent_tgid, status, pe->timestamp_ns);
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+// Tras perder mensajes: los pidfd siguen siendo fiables para las salidas,
+// pero los fork perdidos solo se recuperan mirando los hijos actuales
+static void resync(proc_tracker_t *t) {
+    if (!(t->flags & PTRACK_FOLLOW) || t->nwatch == 0) return;
+    pid_t *pids = malloc(t->nwatch * sizeof(*pids));
+    if (!pids) return;
+    size_t n = t->nwatch;
+    for (size_t i = 0; i < n; i++) pids[i] = t->watch[i].pid;
+    for (size_t i = 0; i < n; i++) follow_children(t, pids[i]);
+    free(pids);
+}
+
+static size_t netlink_drain(proc_tracker_t *t, proc_event_t *evs, size_t n, size_t max) {
+    union {
+        char buf[4096];
+        struct nlmsghdr align;
+    } u;
+    // El conector manda un mensaje por datagrama: nunca se produce más de un evento por recv
+    while (n < max) {
+        ssize_t len = recv(t->nlfd, u.buf, sizeof(u.buf), 0);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                t->lost++;
+                resync(t);
+                continue;
+            }
+            break;      // EAGAIN: vacío
+        }
+        for (struct nlmsghdr *nl = &u.align; NLMSG_OK(nl, (size_t)len); nl = NLMSG_NEXT(nl, len)) {
+            if (nl->nlmsg_type == NLMSG_ERROR || nl->nlmsg_type == NLMSG_NOOP) continue;
+            struct cn_msg *cn = NLMSG_DATA(nl);
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            t->nl_messages++;
+            n += (size_t)netlink_event(t, (const struct proc_event *)cn->data, &evs[n]);
+        }
+    }
+    return n;
+}
+
+// ========== PIDFD ==========
+
+static int siginfo_status(const siginfo_t *si) {
+    switch (si->si_code) {
+    case CLD_EXITED: return (si->si_status & 0xff) << 8;
+    case CLD_KILLED: return si->si_status & 0x7f;
+    case CLD_DUMPED: return (si->si_status & 0x7f) | 0x80;
+    default:         return -1;
+    }
+}
+
+// El pidfd es legible: el proceso terminó. Si es hijo nuestro se recoge aquí
+static size_t pidfd_event(proc_tracker_t *t, pid_t pid, proc_event_t *evs, size_t n) {
+    ptrack_watch_t *w = watch_find(t, pid);
+    if (!w) return n;
+    int status = w->status;
+    siginfo_t si;
+    memset(&si, 0, sizeof(si));
+    if (waitid((idtype_t)P_PIDFD, (id_t)w->pidfd, &si, WEXITED | WNOHANG) == 0 && si.si_pid == pid) {
+        status = siginfo_status(&si);
+    }
+    int reported = w->reported;
+    watch_remove(t, w);
+    if (reported) return n;
+    emit(&evs[n], PEV_EXIT, PEV_SRC_PIDFD, pid, pid, 0, status, 0);
+    return n + 1;
+}
+
+// ========== API ==========
+
+int proc_tracker_init(proc_tracker_t *t, unsigned flags) {
+    memset(t, 0, sizeof(*t));
+    t->flags = flags;
+    t->nlfd = -1;
+    t->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (t->epfd < 0) return -1;
+    if (flags & PTRACK_NETLINK) {
+        t->nlfd = netlink_open();
+        struct epoll_event ev = { .events = EPOLLIN, .data.u64 = 0 };
+        if (t->nlfd >= 0 && epoll_ctl(t->epfd, EPOLL_CTL_ADD, t->nlfd, &ev) < 0) {
+            close(t->nlfd);
+            t->nlfd = -1;
+        }
+    }
+    return 0;
+}
+
+void proc_tracker_free(proc_tracker_t *t) {
+    if (t->nlfd >= 0) {
+        // El kernel cuenta los oyentes: sin IGNORE seguiría generando eventos
+        netlink_send_op(t->nlfd, PROC_CN_MCAST_IGNORE);
+        close(t->nlfd);
+    }
+    for (size_t i = 0; i < t->nwatch; i++) {
+        // Salida ya entregada por netlink: recoger al hijo (si no es hijo, ECHILD al momento)
+        if (t->watch[i].reported) {
+            siginfo_t si;
+            waitid((idtype_t)P_PIDFD, (id_t)t->watch[i].pidfd, &si, WEXITED);
+        }
+        close(t->watch[i].pidfd);
+    }
+    if (t->epfd >= 0) close(t->epfd);
+    free(t->watch);
+    memset(t, 0, sizeof(*t));
+    t->epfd = -1;
+    t->nlfd = -1;
+}
+
+int proc_tracker_wait(proc_tracker_t *t, proc_event_t *evs, size_t max, int timeout_ms) {
+    uint64_t deadline = timeout_ms >= 0 ? now_ns() + (uint64_t)timeout_ms * 1000000ull : 0;
+    struct epoll_event ready[64];
+    size_t n = 0;
+
+    // Los mensajes de otros procesos no cuentan: se sigue esperando hasta el plazo
+    for (;;) {
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = now_ns();
+            wait_ms = now >= deadline ? 0 : (int)((deadline - now + 999999) / 1000000);
+        }
+        int nr = epoll_wait(t->epfd, ready, 64, wait_ms);
+        if (nr < 0) return -1;
+        // netlink primero: el kernel encola el mensaje de exit (con el código)
+        // antes de que el pidfd se vuelva legible, así que ya está en el socket
+        for (int i = 0; i < nr; i++) {
+            if (ready[i].data.u64 == 0) n = netlink_drain(t, evs, n, max);
+        }
+        for (int i = 0; i < nr && n < max; i++) {
+            if (ready[i].data.u64 != 0) n = pidfd_event(t, (pid_t)ready[i].data.u64, evs, n);
+        }
+        if (n > 0 || nr == 0 || max == 0) return (int)n;
+        if (timeout_ms >= 0 && now_ns() >= deadline) return 0;
+    }
+}
+
+const char *proc_event_kind_name(uint8_t kind) {
+    switch (kind) {
+    case PEV_FORK:        return "fork";
+    case PEV_THREAD:      return "thread";
+    case PEV_EXEC:        return "exec";
+    case PEV_EXIT:        return "exit";
+    case PEV_THREAD_EXIT: return "thread-exit";
+    default:              return "?";
+    }
+}
+
+int proc_event_format(const proc_event_t *ev, char *buf, size_t len) {
+    char st[64];
+    switch (ev->kind) {
+    case PEV_FORK:
+    case PEV_THREAD:
+        return snprintf(buf, len, "%-11s %d (tgid %d) ← %d", proc_event_kind_name(ev->kind), ev->pid, ev->tgid,
+                        ev->parent);
+    case PEV_EXEC:
+        return snprintf(buf, len, "%-11s %d (tgid %d)", proc_event_kind_name(ev->kind), ev->pid, ev->tgid);
+    default:
+        proc_event_format_status(ev->status, st, sizeof(st));
+        return snprintf(buf, len, "%-11s %d (tgid %d) %s", proc_event_kind_name(ev->kind), ev->pid, ev->tgid, st);
+    }
+}
+
+int proc_event_format_status(int status, char *buf, size_t len) {
+    if (status < 0) return snprintf(buf, len, "?");
+    if (WIFSIGNALED(status)) {
+        return snprintf(buf, len, "señal %d (%s)%s", WTERMSIG(status), strsignal(WTERMSIG(status)),
+                        WCOREDUMP(status) ? ", core" : "");
+    }
+    return snprintf(buf, len, "código %d", WEXITSTATUS(status));
+}
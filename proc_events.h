@@ -0,0 +1,81 @@
+// proc_events.h - Seguimiento de procesos por eventos: pidfd + epoll y conector netlink
+#ifndef PROC_EVENTS_H
+#define PROC_EVENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Opciones de proc_tracker_init
+#define PTRACK_NETLINK  0x1     // usar el conector de procesos (root / CAP_NET_ADMIN)
+#define PTRACK_FOLLOW   0x2     // vigilar automáticamente los hijos de los procesos vigilados
+#define PTRACK_ALL      0x4     // entregar los eventos de todo el host, no solo de los vigilados
+
+typedef enum {
+    PEV_FORK = 0,               // nuevo proceso (pid == tgid)
+    PEV_THREAD,                 // nuevo thread dentro de tgid
+    PEV_EXEC,
+    PEV_EXIT,                   // terminó el proceso (thread principal)
+    PEV_THREAD_EXIT,
+} proc_event_kind_t;
+
+// Quién avisó
+#define PEV_SRC_NETLINK 0
+#define PEV_SRC_PIDFD   1
+
+typedef struct {
+    uint8_t kind;               // proc_event_kind_t
+    uint8_t source;             // PEV_SRC_*
+    pid_t pid;                  // tarea afectada (proceso o thread)
+    pid_t tgid;
+    pid_t parent;               // FORK/THREAD: tgid del creador
+    int status;                 // EXIT: estado estilo waitpid, -1 si no se conoce
+    uint64_t kernel_ns;         // marca del kernel (CLOCK_MONOTONIC), 0 si la fuente no la da
+    uint64_t recv_ns;           // cuándo lo leímos (now_ns)
+} proc_event_t;
+
+// Proceso vigilado con su pidfd (ordenados por pid)
+typedef struct {
+    pid_t pid;
+    int pidfd;
+    int status;                 // de netlink si llegó antes que el pidfd
+    int reported;               // la salida ya se entregó (falta reaper/cerrar el pidfd)
+} ptrack_watch_t;
+
+typedef struct {
+    int epfd;                   // epoll: pidfds + socket netlink (se puede meter en otro poll)
+    int nlfd;                   // -1 si el conector no está disponible
+    unsigned flags;
+
+    ptrack_watch_t *watch;
+    size_t nwatch;
+    size_t watch_cap;
+
+    unsigned long nl_messages;  // mensajes netlink leídos (todo el host)
+    unsigned long lost;         // desbordamientos del socket (ENOBUFS)
+} proc_tracker_t;
+
+// Sin PTRACK_NETLINK, o si el conector no está permitido, solo funcionan los pidfd
+int  proc_tracker_init(proc_tracker_t *t, unsigned flags);
+void proc_tracker_free(proc_tracker_t *t);
+
+static inline int proc_tracker_has_netlink(const proc_tracker_t *t) {
+    return t->nlfd >= 0;
+}
+
+// Vigila pid (pidfd_open). 0 ok o ya vigilado, -1 si el proceso no existe.
+int  proc_tracker_watch(proc_tracker_t *t, pid_t pid);
+
+// Espera hasta timeout_ms (-1 = sin límite) y devuelve hasta max eventos, 0 si
+// venció el plazo, -1 en error (EINTR incluido)
+int  proc_tracker_wait(proc_tracker_t *t, proc_event_t *evs, size_t max, int timeout_ms);
+
+const char *proc_event_kind_name(uint8_t kind);
+
+// "fork 1234 (tgid 1234) ← 1200", "exit 1234 código 0", ...
+int  proc_event_format(const proc_event_t *ev, char *buf, size_t len);
+
+// "código 0", "señal 15 (Terminated)" o "?"
+int  proc_event_format_status(int status, char *buf, size_t len);
+
+#endif // PROC_EVENTS_H
@@ -0,0 +1,347 @@
+// proc_footprint.c - USS/PSS/compartido de todo el árbol de un proceso
+//
+// Sumar VmRSS cuenta una vez por proceso cada página COW que padre e hijos
+// siguen compartiendo (y cada biblioteca): con un pool prefork sobreestima
+// varias veces. smaps_rollup da PSS (cada página dividida entre quienes la
+// mapean) y USS (Private_*) en un solo read por proceso; es la pasada barata.
+//
+// La pasada por regiones lee smaps por líneas con un buffer fijo y, con
+// CAP_SYS_ADMIN, el PFN de cada página residente (pagemap) y cuántas veces
+// está mapeado (kpagecount). Contando cuántos procesos del árbol mapean cada
+// marco se separa lo exclusivo, lo compartido solo dentro del árbol y lo
+// compartido con procesos de fuera.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "proc_common.h"
+#include "proc_footprint.h"
+#include "proc_pagemap.h"
+#include "proc_snapshot.h"
+
+// ========== LECTURA INCREMENTAL DE smaps ==========
+
+typedef struct {
+    uintptr_t start, end;
+    char name[FP_NAME_LEN];     // final de la ruta, [heap], [stack] o [anon]
+    smaps_rollup_t mem;
+} fp_vma_t;
+
+// Una región completa se entrega al ver la cabecera de la siguiente (o el final)
+typedef struct {
+    proc_stream_t st;
+    int pending;                // cur tiene cabecera y se están leyendo sus campos
+    fp_vma_t cur;
+} fp_smaps_t;
+
+// "start-end perms offset dev inode   nombre"
+static int parse_header(const char *line, fp_vma_t *v) {
+    unsigned long start, end;
+    int name_off = -1;
+    memset(v, 0, sizeof(*v));
+    if (sscanf(line, "%lx-%lx %*s %*s %*s %*s %n", &start, &end, &name_off) < 2) return -1;
+    v->start = (uintptr_t)start;
+    v->end = (uintptr_t)end;
+    const char *name = name_off >= 0 ? line + name_off : "";
+    const char *base = name[0] == '/' ? strrchr(name, '/') + 1 : name;
+    snprintf(v->name, sizeof(v->name), "%s", base[0] ? base : "[anon]");
+    return 0;
+}
+
+// 1 región, 0 fin, -1 error de lectura
+static int smaps_next(fp_smaps_t *sm, fp_vma_t *out) {
+    char *line;
+    while ((line = proc_stream_line(&sm->st)) != NULL) {
+        // Cabecera: no hay ':' antes del primer espacio (los campos son "Clave:")
+        char *colon = strchr(line, ':');
+        char *space = strchr(line, ' ');
+        if (!colon || (space && space < colon)) {
+            fp_vma_t v;
+            if (parse_header(line, &v) < 0) continue;
+            if (sm->pending) {
+                *out = sm->cur;
+                sm->cur = v;
+                return 1;
+            }
+            sm->cur = v;
+            sm->pending = 1;
+        } else if (sm->pending) {
+            smaps_rollup_field(line, strlen(line), &sm->cur.mem);
+        }
+    }
+    if (sm->pending) {
+        sm->pending = 0;
+        *out = sm->cur;
+        return 1;
+    }
+    return sm->st.err ? -1 : 0;
+}
+
+static void mem_add(smaps_rollup_t *a, const smaps_rollup_t *b) {
+    unsigned long *x = (unsigned long *)a;
+    const unsigned long *y = (const unsigned long *)b;
+    for (size_t i = 0; i < sizeof(*a) / sizeof(unsigned long); i++) x[i] += y[i];
+}
+
+// ========== ÁRBOL ==========
+
+int fp_tree_measure(fp_tree_t *t, pid_t root) {
+    memset(t, 0, sizeof(*t));
+    proc_snapshot_t snap;
+    if (proc_snapshot_init(&snap, root) < 0 || proc_snapshot_take(&snap) < 0) {
+        proc_snapshot_free(&snap);
+        return -1;
+    }
+    t->procs = calloc(snap.nnodes ? snap.nnodes : 1, sizeof(*t->procs));
+    if (!t->procs) {
+        proc_snapshot_free(&snap);
+        return -1;
+    }
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < snap.nnodes; i++) {
+        const proc_node_t *nd = &snap.nodes[i];
+        fp_proc_t *p = &t->procs[t->n++];
+        p->pid = nd->status.pid;
+        p->ppid = nd->status.ppid;
+        p->depth = nd->depth;
+        snprintf(p->comm, sizeof(p->comm), "%s", nd->status.name);
+        p->ok = smaps_rollup_read(p->pid, &p->mem) == 0;       // termina entre snapshot y lectura: se omite
+        if (p->ok) mem_add(&t->total, &p->mem);
+    }
+    t->rollup_ms = (now_ns() - t0) / 1e6;
+    proc_snapshot_free(&snap);
+    return 0;
+}
+
+// ========== REGIONES Y MARCOS FÍSICOS ==========
+
+typedef struct {
+    uint64_t pfn;
+    uint32_t map;               // índice en t->maps
+} fp_page_t;
+
+typedef struct {
+    fp_page_t *v;
+    size_t n, cap;
+} fp_pages_t;
+
+static int map_index(fp_tree_t *t, const char *name, pid_t pid) {
+    for (size_t i = 0; i < t->nmaps; i++) {
+        if (strcmp(t->maps[i].name, name) == 0) {
+            if (t->maps[i].last_pid != pid) t->maps[i].nprocs++;
+            t->maps[i].last_pid = pid;
+            return (int)i;
+        }
+    }
+    if (t->nmaps == t->maps_cap) {
+        size_t ncap = t->maps_cap ? t->maps_cap * 2 : 64;
+        fp_map_t *grown = realloc(t->maps, ncap * sizeof(*grown));
+        if (!grown) return -1;
+        t->maps = grown;
+        t->maps_cap = ncap;
+    }
+    fp_map_t *m = &t->maps[t->nmaps];
+    memset(m, 0, sizeof(*m));
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    m->nprocs = 1;
+    m->last_pid = pid;
+    return (int)t->nmaps++;
+}
+
+// PFN de las páginas residentes de [start, end). 0 ok, -1 error de memoria;
+// *zero se pone si hay páginas presentes con PFN 0 (sin CAP_SYS_ADMIN)
+static int collect_pages(pagemap_t *pm, const fp_vma_t *v, uint32_t map, fp_pages_t *out, int *zero) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t npages = (v->end - v->start) / (uintptr_t)page;
+    for (size_t done = 0; done < npages; done += PAGEMAP_BATCH) {
+        size_t batch = npages - done < PAGEMAP_BATCH ? npages - done : PAGEMAP_BATCH;
+        if (pagemap_read(pm, v->start + done * (uintptr_t)page, batch, NULL) < 0) return 0;   // región que ya no existe
+        for (size_t i = 0; i < batch; i++) {
+            uint64_t e = pm->buf[i];
+            if (!(e & PM_PRESENT)) continue;
+            if (!(e & PM_PFN_MASK)) {
+                *zero = 1;
+                continue;
+            }
+            if (out->n == out->cap) {
+                size_t ncap = out->cap ? out->cap * 2 : 4096;
+                fp_page_t *grown = realloc(out->v, ncap * sizeof(*grown));
+                if (!grown) return -1;
+                out->v = grown;
+                out->cap = ncap;
+            }
+            out->v[out->n++] = (fp_page_t){ e & PM_PFN_MASK, map };
+        }
+    }
+    return 0;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_map_pss(const void *a, const void *b) {
+    const fp_map_t *x = a, *y = b;
+    return x->mem.pss_kb < y->mem.pss_kb ? 1 : x->mem.pss_kb > y->mem.pss_kb ? -1 : 0;
+}
+
+// Marcos distintos del árbol (ordenados), cuántos procesos del árbol mapean
+// cada uno y su número total de mapeos según kpagecount
+typedef struct {
+    uint64_t *pfn;
+    uint32_t *tree;
+    uint32_t *count;
+    size_t n;
+} fp_frames_t;
+
+static int frames_build(const fp_pages_t *pages, size_t nprocs, int kfd, fp_frames_t *fr) {
+    size_t total = 0;
+    for (size_t i = 0; i < nprocs; i++) total += pages[i].n;
+    memset(fr, 0, sizeof(*fr));
+    uint64_t *all = malloc((total ? total : 1) * sizeof(*all));
+    fr->tree = malloc((total ? total : 1) * sizeof(*fr->tree));
+    fr->count = calloc(total ? total : 1, sizeof(*fr->count));
+    if (!all || !fr->tree || !fr->count) {
+        free(all);
+        free(fr->tree);
+        free(fr->count);
+        return -1;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < nprocs; i++) {
+        for (size_t j = 0; j < pages[i].n; j++) all[k++] = pages[i].v[j].pfn;
+    }
+    qsort(all, total, sizeof(*all), cmp_u64);
+    for (size_t i = 0; i < total; i++) {
+        if (fr->n && all[fr->n - 1] == all[i]) {
+            fr->tree[fr->n - 1]++;
+            continue;
+        }
+        all[fr->n] = all[i];
+        fr->tree[fr->n++] = 1;
+    }
+    fr->pfn = all;
+
+    // kpagecount: un u64 por PFN. Ordenados, cada pread de 512 entradas cubre
+    // todos los marcos cercanos (el heap suele estar en PFN contiguos)
+    uint64_t win[512];
+    for (size_t i = 0; i < fr->n;) {
+        uint64_t base = fr->pfn[i];
+        ssize_t got = pread(kfd, win, sizeof(win), (off_t)(base * sizeof(uint64_t)));
+        size_t nw = got > 0 ? (size_t)got / sizeof(uint64_t) : 0;
+        if (nw == 0) {
+            i++;
+            continue;
+        }
+        for (; i < fr->n && fr->pfn[i] < base + nw; i++) {
+            fr->count[i] = win[fr->pfn[i] - base] > UINT32_MAX ? UINT32_MAX : (uint32_t)win[fr->pfn[i] - base];
+        }
+    }
+    return 0;
+}
+
+static void frames_free(fp_frames_t *fr) {
+    free(fr->pfn);
+    free(fr->tree);
+    free(fr->count);
+}
+
+int fp_tree_regions(fp_tree_t *t) {
+    uint64_t t0 = now_ns();
+    unsigned long page_kb = (unsigned long)sysconf(_SC_PAGESIZE) / 1024;
+    int kfd = open("/proc/kpagecount", O_RDONLY | O_CLOEXEC);
+    t->deep = kfd >= 0;
+    t->deep_errno = kfd >= 0 ? 0 : errno;
+    fp_pages_t *pages = t->deep ? calloc(t->n ? t->n : 1, sizeof(*pages)) : NULL;
+    if (t->deep && !pages) {
+        close(kfd);
+        return -1;
+    }
+    fp_smaps_t *sm = malloc(sizeof(*sm));
+    if (!sm) {
+        free(pages);
+        if (kfd >= 0) close(kfd);
+        return -1;
+    }
+
+    int zero = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        fp_proc_t *p = &t->procs[i];
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/smaps", p->pid);
+        if (!p->ok || proc_stream_open(&sm->st, path) < 0) continue;
+        sm->pending = 0;
+        pagemap_t pm;
+        int have_pm = t->deep && pagemap_open(&pm, p->pid) == 0;
+        fp_vma_t v;
+        while (smaps_next(sm, &v) == 1) {
+            int mi = map_index(t, v.name, p->pid);
+            if (mi < 0) break;
+            mem_add(&t->maps[mi].mem, &v.mem);
+            // Solo las regiones con algo residente: las reservas grandes sin tocar no cuestan un pread
+            if (have_pm && v.mem.rss_kb && collect_pages(&pm, &v, (uint32_t)mi, &pages[i], &zero) < 0) break;
+        }
+        if (have_pm) pagemap_close(&pm);
+        proc_stream_close(&sm->st);
+    }
+    free(sm);
+
+    // Con PFN a 0 kpagecount no sirve de nada: solo smaps
+    if (t->deep && zero) {
+        t->deep = 0;
+        t->deep_errno = EPERM;
+    }
+    fp_frames_t fr;
+    if (t->deep && frames_build(pages, t->n, kfd, &fr) == 0) {
+        for (size_t i = 0; i < fr.n; i++) {
+            if (fr.count[i] == 0) continue;         // zero page y similares: no es memoria de nadie
+            if (fr.count[i] <= fr.tree[i]) t->tree_unique_kb += page_kb;
+            else t->tree_outside_kb += page_kb;
+        }
+        // Cada página de cada proceso: exclusiva, compartida dentro del árbol o con fuera.
+        // (Una página mapeada dos veces en el mismo proceso cuenta como del árbol.)
+        for (size_t i = 0; i < t->n; i++) {
+            fp_proc_t *p = &t->procs[i];
+            for (size_t j = 0; j < pages[i].n; j++) {
+                const fp_page_t *pg = &pages[i].v[j];
+                const uint64_t *hit = bsearch(&pg->pfn, fr.pfn, fr.n, sizeof(*fr.pfn), cmp_u64);
+                size_t k = (size_t)(hit - fr.pfn);
+                fp_map_t *m = &t->maps[pg->map];
+                if (fr.count[k] == 0) continue;
+                if (fr.count[k] == 1) {
+                    p->excl_kb += page_kb;
+                    m->excl_kb += page_kb;
+                } else if (fr.count[k] <= fr.tree[k]) {
+                    p->tree_kb += page_kb;
+                    m->tree_kb += page_kb;
+                } else {
+                    p->outside_kb += page_kb;
+                    m->outside_kb += page_kb;
+                }
+            }
+        }
+        frames_free(&fr);
+    } else if (t->deep) {
+        t->deep = 0;
+        t->deep_errno = ENOMEM;
+    }
+    for (size_t i = 0; pages && i < t->n; i++) free(pages[i].v);
+    free(pages);
+    if (kfd >= 0) close(kfd);
+
+    qsort(t->maps, t->nmaps, sizeof(*t->maps), cmp_map_pss);
+    t->regions_ms = (now_ns() - t0) / 1e6;
+    return 0;
+}
+
+void fp_tree_free(fp_tree_t *t) {
+    free(t->procs);
+    free(t->maps);
+    memset(t, 0, sizeof(*t));
+}
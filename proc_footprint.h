@@ -0,0 +1,65 @@
+// proc_footprint.h - Huella real de memoria de un árbol de procesos: USS, PSS
+// y compartido con smaps_rollup, y atribución por región con pagemap +
+// /proc/kpagecount (qué páginas comparte el árbol solo consigo mismo)
+#ifndef PROC_FOOTPRINT_H
+#define PROC_FOOTPRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_pagemap.h"
+
+#define FP_NAME_LEN    48
+
+// ========== ÁRBOL ==========
+
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    int depth;
+    char comm[16];
+    int ok;                     // se pudo leer (puede haber terminado o faltar permiso)
+    smaps_rollup_t mem;
+    // Con kpagecount (fp_tree_t.deep): páginas residentes por quién las mapea
+    unsigned long excl_kb;      // solo este proceso
+    unsigned long tree_kb;      // también otros del árbol y nadie de fuera
+    unsigned long outside_kb;   // también procesos de fuera del árbol
+} fp_proc_t;
+
+// Región agregada por nombre en todo el árbol
+typedef struct {
+    char name[FP_NAME_LEN];
+    int nprocs;                 // procesos que la mapean
+    pid_t last_pid;
+    smaps_rollup_t mem;
+    unsigned long excl_kb, tree_kb, outside_kb;
+} fp_map_t;
+
+typedef struct {
+    fp_proc_t *procs;
+    size_t n;
+    smaps_rollup_t total;
+    double rollup_ms;
+
+    // Solo con fp_tree_regions()
+    fp_map_t *maps;             // ordenadas por PSS
+    size_t nmaps, maps_cap;
+    int deep;                   // pagemap con PFN + kpagecount legibles (CAP_SYS_ADMIN)
+    int deep_errno;             // por qué no
+    unsigned long tree_unique_kb;       // marcos que solo mapea el árbol: lo que libera si termina entero
+    unsigned long tree_outside_kb;      // marcos compartidos con procesos de fuera
+    double regions_ms;
+} fp_tree_t;
+
+// Procesos del árbol de root (proc_snapshot) y smaps_rollup de cada uno
+int  fp_tree_measure(fp_tree_t *t, pid_t root);
+
+// Segunda pasada: smaps de cada proceso por regiones, leído por líneas con
+// un buffer fijo (proc_stream), y, si hay permiso, PFN de cada página
+// residente y su número de mapeos en kpagecount
+int  fp_tree_regions(fp_tree_t *t);
+
+void fp_tree_free(fp_tree_t *t);
+
+#endif // PROC_FOOTPRINT_H
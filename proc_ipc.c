@@ -0,0 +1,416 @@
+// proc_ipc.c - Canal padre↔hijo tras fork(): anillo lock-free en memoria compartida
+//
+// Las variables globales quedan aisladas tras fork() por COW; una región
+// memfd mapeada con MAP_SHARED, en cambio, es la misma memoria física en los
+// dos procesos. Encima va un anillo SPSC: el productor solo escribe head, el
+// consumidor solo tail (cada uno en su línea de caché), y cada mensaje es
+// una cabecera de 8 bytes más el contenido alineado a 8. Si un mensaje no
+// cabe antes del final se deja un marcador de salto y continúa al principio.
+//
+// Con IPC_RING_EVENTFD el consumidor, tras sondear un rato, marca sleeping y
+// se bloquea en read(efd); el productor solo hace write(efd) si ve la marca,
+// así que con tráfico continuo no hay llamadas al sistema.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_ipc.h"
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
+#define IPC_MSG_HDR   8
+#define IPC_WRAP      0xffffffffu   // marcador: el siguiente mensaje está al principio
+#define IPC_SPINS     200           // sondeos antes de dormir o ceder la CPU
+#define HUGE_2M       (2u << 20)
+
+static inline size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// ========== ANILLO ==========
+
+// Con una sola CPU el otro extremo no puede avanzar mientras sondeamos:
+// mejor ceder o dormir enseguida
+static unsigned spin_limit(void) {
+    static unsigned limit = ~0u;
+    if (limit == ~0u) limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? IPC_SPINS : 0;
+    return limit;
+}
+
+int ipc_ring_create(ipc_ring_t *r, size_t size, unsigned flags) {
+    memset(r, 0, sizeof(*r));
+    r->memfd = -1;
+    r->efd = -1;
+    size_t data = 4096;
+    while (data < size) data <<= 1;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t hdr = (size_t)page;
+    r->map_len = hdr + data;
+
+    if (flags & IPC_RING_HUGE) {
+        // hugetlbfs: el tamaño del mapeo tiene que ser múltiplo de 2 MB
+        r->map_len = (r->map_len + HUGE_2M - 1) & ~(size_t)(HUGE_2M - 1);
+        r->memfd = memfd_create("proc_ipc_ring", MFD_CLOEXEC | MFD_HUGETLB);
+    } else {
+        r->memfd = memfd_create("proc_ipc_ring", MFD_CLOEXEC);
+    }
+    if (r->memfd < 0 || ftruncate(r->memfd, (off_t)r->map_len) < 0) goto fail;
+    void *m = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->memfd, 0);
+    if (m == MAP_FAILED) goto fail;   // con huge pages: ENOMEM si no hay reservadas
+
+    r->hdr = m;
+    r->data = (uint8_t *)m + hdr;
+    r->huge = (flags & IPC_RING_HUGE) != 0;
+    r->hdr->size = data;
+    atomic_init(&r->hdr->head, 0);
+    atomic_init(&r->hdr->tail, 0);
+    atomic_init(&r->hdr->sleeping, 0);
+    if ((flags & IPC_RING_EVENTFD) && (r->efd = eventfd(0, EFD_CLOEXEC)) < 0) goto fail;
+    return 0;
+
+fail:;
+    int saved = errno;
+    ipc_ring_destroy(r);
+    errno = saved;
+    return -1;
+}
+
+void ipc_ring_destroy(ipc_ring_t *r) {
+    if (r->hdr) munmap(r->hdr, r->map_len);
+    if (r->memfd >= 0) close(r->memfd);
+    if (r->efd >= 0) close(r->efd);
+    memset(r, 0, sizeof(*r));
+    r->memfd = -1;
+    r->efd = -1;
+}
+
+void *ipc_ring_reserve(ipc_ring_t *r, size_t len) {
+    uint64_t size = r->hdr->size;
+    uint64_t need = IPC_MSG_HDR + align8(len);
+    if (need > size / 2) return NULL;
+    uint64_t head = atomic_load_explicit(&r->hdr->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&r->hdr->tail, memory_order_acquire);
+    uint64_t off = head & (size - 1);
+    uint64_t pad = size - off < need ? size - off : 0;
+    if (head + pad + need - tail > size) return NULL;
+
+    if (pad) {
+        // El consumidor no lo ve hasta el commit, que publica salto y mensaje juntos
+        *(uint32_t *)(r->data + off) = IPC_WRAP;
+        head += pad;
+        off = 0;
+    }
+    *(uint32_t *)(r->data + off) = (uint32_t)len;
+    r->next_head = head + need;
+    return r->data + off + IPC_MSG_HDR;
+}
+
+void ipc_ring_commit(ipc_ring_t *r) {
+    atomic_store_explicit(&r->hdr->head, r->next_head, memory_order_release);
+    if (r->efd < 0) return;
+    // Pareja de la barrera del consumidor: o él ve el head nuevo, o nosotros su sleeping
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&r->hdr->sleeping, memory_order_relaxed)) {
+        atomic_store_explicit(&r->hdr->sleeping, 0, memory_order_relaxed);
+        uint64_t one = 1;
+        if (write(r->efd, &one, sizeof(one)) < 0) return;
+    }
+}
+
+const void *ipc_ring_peek(ipc_ring_t *r, size_t *len) {
+    uint64_t size = r->hdr->size;
+    uint64_t tail = atomic_load_explicit(&r->hdr->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&r->hdr->head, memory_order_acquire);
+    if (tail == head) return NULL;
+    uint64_t off = tail & (size - 1);
+    uint32_t n = *(const uint32_t *)(r->data + off);
+    if (n == IPC_WRAP) {
+        tail += size - off;
+        off = 0;
+        n = *(const uint32_t *)r->data;
+    }
+    *len = n;
+    r->next_tail = tail + IPC_MSG_HDR + align8(n);
+    return r->data + off + IPC_MSG_HDR;
+}
+
+void ipc_ring_release(ipc_ring_t *r) {
+    atomic_store_explicit(&r->hdr->tail, r->next_tail, memory_order_release);
+}
+
+void *ipc_ring_reserve_wait(ipc_ring_t *r, size_t len) {
+    if (IPC_MSG_HDR + align8(len) > r->hdr->size / 2) return NULL;
+    for (unsigned spins = 0;; spins++) {
+        void *p = ipc_ring_reserve(r, len);
+        if (p) return p;
+        if (spins < spin_limit()) cpu_relax();
+        else sched_yield();
+    }
+}
+
+const void *ipc_ring_peek_wait(ipc_ring_t *r, size_t *len) {
+    for (unsigned spins = 0;; spins++) {
+        const void *p = ipc_ring_peek(r, len);
+        if (p) return p;
+        if (spins < spin_limit()) {
+            cpu_relax();
+            continue;
+        }
+        if (r->efd < 0) {
+            sched_yield();
+            continue;
+        }
+        atomic_store_explicit(&r->hdr->sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if ((p = ipc_ring_peek(r, len)) != NULL) {
+            atomic_store_explicit(&r->hdr->sleeping, 0, memory_order_relaxed);
+            return p;
+        }
+        uint64_t v;
+        if (read(r->efd, &v, sizeof(v)) < 0 && errno != EINTR) return NULL;
+        spins = 0;
+    }
+}
+
+// ========== TRANSPORTES DEL BANCO DE PRUEBAS ==========
+
+// Canal bidireccional: sentido 0 padre → hijo, sentido 1 hijo → padre
+typedef struct {
+    ipc_kind_t kind;
+    ipc_ring_t ring[2];
+    int fd[2][2];               // pipes: [sentido][lectura/escritura]; UNIX: fd[0][0] padre, fd[0][1] hijo
+    uint8_t *buf;               // destino de read() para pipes y sockets
+} ipc_chan_t;
+
+static const char *const kind_names[IPC_NKINDS] = {
+    "memfd + sondeo", "memfd + eventfd", "pipe", "socket UNIX",
+};
+
+const char *ipc_kind_name(ipc_kind_t kind) {
+    return kind < IPC_NKINDS ? kind_names[kind] : "?";
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int chan_open(ipc_chan_t *c, ipc_kind_t kind, size_t payload, unsigned flags) {
+    memset(c, 0, sizeof(*c));
+    c->kind = kind;
+    for (int d = 0; d < 2; d++) {
+        c->fd[d][0] = c->fd[d][1] = -1;
+        // Pipe y UNIX no crean anillos: chan_close no debe cerrar el fd 0
+        c->ring[d].memfd = c->ring[d].efd = -1;
+    }
+    c->buf = malloc(payload + 8);
+    if (!c->buf) return -1;
+
+    // Capacidad equivalente en todos: 4 MB de anillo, pipes de 1 MB (el máximo sin privilegios)
+    size_t ring = 4u << 20;
+    while (ring / 2 < payload + 64) ring <<= 1;
+    switch (kind) {
+    case IPC_SHM_SPIN:
+    case IPC_SHM_EVENTFD: {
+        unsigned rf = (flags & IPC_RING_HUGE) | (kind == IPC_SHM_EVENTFD ? IPC_RING_EVENTFD : 0);
+        if (ipc_ring_create(&c->ring[0], ring, rf) < 0) return -1;
+        if (ipc_ring_create(&c->ring[1], ring, rf) < 0) return -1;
+        return 0;
+    }
+    case IPC_PIPE:
+        for (int d = 0; d < 2; d++) {
+            if (pipe2(c->fd[d], O_CLOEXEC) < 0) return -1;
+            fcntl(c->fd[d][1], F_SETPIPE_SZ, 1 << 20);
+        }
+        return 0;
+    case IPC_UNIX: {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) return -1;
+        int sz = 4 << 20;
+        for (int i = 0; i < 2; i++) {
+            setsockopt(sv[i], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+            setsockopt(sv[i], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+        }
+        c->fd[0][0] = sv[0];
+        c->fd[0][1] = sv[1];
+        return 0;
+    }
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+static void chan_close(ipc_chan_t *c) {
+    ipc_ring_destroy(&c->ring[0]);
+    ipc_ring_destroy(&c->ring[1]);
+    for (int d = 0; d < 2; d++) {
+        for (int e = 0; e < 2; e++) {
+            if (c->fd[d][e] >= 0) close(c->fd[d][e]);
+        }
+    }
+    free(c->buf);
+}
+
+// side 0 = padre, 1 = hijo. Los 8 primeros bytes de cada mensaje llevan su número.
+static int chan_send(ipc_chan_t *c, int side, const uint8_t *src, size_t len) {
+    switch (c->kind) {
+    case IPC_SHM_SPIN:
+    case IPC_SHM_EVENTFD: {
+        void *dst = ipc_ring_reserve_wait(&c->ring[side], len);
+        if (!dst) return -1;
+        memcpy(dst, src, len);
+        ipc_ring_commit(&c->ring[side]);
+        return 0;
+    }
+    case IPC_PIPE:
+        return write_full(c->fd[side][1], src, len);
+    default:
+        return write_full(c->fd[0][side], src, len);
+    }
+}
+
+// Devuelve el número de secuencia del mensaje (o ~0 en error). Con el anillo
+// no hay copia: se leen la cabecera y el último byte en el sitio.
+static uint64_t chan_recv(ipc_chan_t *c, int side, size_t len) {
+    uint64_t seq;
+    int from = 1 - side;
+    switch (c->kind) {
+    case IPC_SHM_SPIN:
+    case IPC_SHM_EVENTFD: {
+        size_t n;
+        const uint8_t *p = ipc_ring_peek_wait(&c->ring[from], &n);
+        if (!p || n != len) return ~0ull;
+        memcpy(&seq, p, sizeof(seq));
+        volatile uint8_t last = p[n - 1];
+        (void)last;
+        ipc_ring_release(&c->ring[from]);
+        return seq;
+    }
+    case IPC_PIPE:
+        if (read_full(c->fd[from][0], c->buf, len) < 0) return ~0ull;
+        break;
+    default:
+        if (read_full(c->fd[0][side], c->buf, len) < 0) return ~0ull;
+        break;
+    }
+    memcpy(&seq, c->buf, sizeof(seq));
+    return seq;
+}
+
+// ========== MEDICIÓN ==========
+
+// Un envío falló: el hijo espera mensajes que no llegarán y el padre no
+// debe quedarse en chan_recv esperando sus respuestas
+static int bench_abort(pid_t child, ipc_chan_t *c, uint8_t *src, ipc_bench_result_t *out) {
+    out->error = errno ? errno : EIO;
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    chan_close(c);
+    free(src);
+    return -1;
+}
+
+int ipc_bench_run(ipc_kind_t kind, size_t payload, unsigned long count, unsigned flags,
+                  ipc_bench_result_t *out, lat_hist_t *lat) {
+    memset(out, 0, sizeof(*out));
+    if (payload < 8) payload = 8;
+    ipc_chan_t c;
+    uint8_t *src = calloc(1, payload);
+    if (!src || chan_open(&c, kind, payload, flags) < 0) {
+        out->error = errno ? errno : ENOMEM;
+        if (src) chan_close(&c);
+        free(src);
+        return -1;
+    }
+    out->huge = c.ring[0].huge;
+    unsigned long rounds = lat ? (count / 10 ? count / 10 : 1) : 0;
+
+    pid_t child = fork();
+    if (child < 0) {
+        out->error = errno;
+        chan_close(&c);
+        free(src);
+        return -1;
+    }
+    if (child == 0) {
+        // Hijo: consume el flujo, confirma con el nº de errores y hace de eco
+        uint64_t bad = 0;
+        for (uint64_t i = 0; i < count; i++) bad += chan_recv(&c, 1, payload) != i;
+        memcpy(src, &bad, sizeof(bad));
+        chan_send(&c, 1, src, 8);
+        for (uint64_t i = 0; i < rounds; i++) {
+            uint64_t seq = chan_recv(&c, 1, payload);
+            memcpy(src, &seq, sizeof(seq));
+            chan_send(&c, 1, src, payload);
+        }
+        _exit(0);
+    }
+
+    uint64_t t0 = now_ns();
+    for (uint64_t i = 0; i < count; i++) {
+        memcpy(src, &i, sizeof(i));
+        if (chan_send(&c, 0, src, payload) < 0) return bench_abort(child, &c, src, out);
+    }
+    uint64_t bad = chan_recv(&c, 0, 8);
+    double secs = (now_ns() - t0) / 1e9;
+    out->bad = (unsigned long)bad;
+    out->msgs_per_s = secs > 0 ? count / secs : 0;
+    out->mb_per_s = out->msgs_per_s * (double)payload / 1e6;
+
+    for (uint64_t i = 0; i < rounds; i++) {
+        memcpy(src, &i, sizeof(i));
+        uint64_t ts = now_ns();
+        if (chan_send(&c, 0, src, payload) < 0) return bench_abort(child, &c, src, out);
+        if (chan_recv(&c, 0, payload) != i) out->bad++;
+        lat_hist_record(lat, (now_ns() - ts) / 2);
+    }
+
+    waitpid(child, NULL, 0);
+    chan_close(&c);
+    free(src);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// proc_ipc.h - Canal padre↔hijo tras fork(): anillo lock-free en memoria compartida
+// (memfd + MAP_SHARED) y banco de pruebas frente a pipes, sockets UNIX y eventfd
+#ifndef PROC_IPC_H
+#define PROC_IPC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+#include "lat_hist.h"
+
+// Opciones de ipc_ring_create
+#define IPC_RING_HUGE     0x1   // memfd con MFD_HUGETLB (requiere vm.nr_hugepages)
+#define IPC_RING_EVENTFD  0x2   // el consumidor duerme en un eventfd en lugar de sondear
+
+// Cabecera al principio del mapeo compartido; head y tail en líneas distintas
+typedef struct {
+    _Alignas(64) _Atomic uint64_t head;     // bytes publicados (solo escribe el productor)
+    _Alignas(64) _Atomic uint64_t tail;     // bytes liberados (solo escribe el consumidor)
+    _Alignas(64) _Atomic uint32_t sleeping; // el consumidor está (o va a estar) en read(efd)
+    uint64_t size;                          // capacidad de datos, potencia de 2
+} ipc_ring_hdr_t;
+
+// Anillo SPSC de mensajes de longitud variable. Se crea antes de fork() y
+// padre e hijo ven las mismas páginas físicas: MAP_SHARED no pasa por COW.
+typedef struct {
+    ipc_ring_hdr_t *hdr;
+    uint8_t *data;
+    size_t map_len;
+    int memfd;
+    int efd;                    // -1 sin IPC_RING_EVENTFD
+    int huge;
+    uint64_t next_head;         // productor: fin del mensaje reservado
+    uint64_t next_tail;         // consumidor: fin del mensaje leído
+} ipc_ring_t;
+
+int  ipc_ring_create(ipc_ring_t *r, size_t size, unsigned flags);
+void ipc_ring_destroy(ipc_ring_t *r);
+
+// Cero copias: el productor escribe directamente en el anillo y el
+// consumidor lee en el sitio. reserve/peek devuelven NULL si lleno/vacío.
+void       *ipc_ring_reserve(ipc_ring_t *r, size_t len);
+void        ipc_ring_commit(ipc_ring_t *r);
+const void *ipc_ring_peek(ipc_ring_t *r, size_t *len);
+void        ipc_ring_release(ipc_ring_t *r);
+
+// Versiones que esperan: el productor cede la CPU si está lleno; el
+// consumidor sondea un poco y luego duerme en el eventfd (o cede la CPU)
+void       *ipc_ring_reserve_wait(ipc_ring_t *r, size_t len);
+const void *ipc_ring_peek_wait(ipc_ring_t *r, size_t *len);
+
+// Mensaje más grande que admite un anillo de ese tamaño
+static inline size_t ipc_ring_max_msg(const ipc_ring_t *r) {
+    return r->hdr->size / 2 - 8;
+}
+
+// ========== BANCO DE PRUEBAS ==========
+
+typedef enum {
+    IPC_SHM_SPIN = 0,           // anillo, el consumidor sondea
+    IPC_SHM_EVENTFD,            // anillo, el consumidor duerme en un eventfd
+    IPC_PIPE,
+    IPC_UNIX,                   // socketpair(AF_UNIX, SOCK_STREAM)
+    IPC_NKINDS,
+} ipc_kind_t;
+
+typedef struct {
+    int error;                  // errno si no se pudo montar el transporte
+    double msgs_per_s;          // flujo en un sentido padre → hijo
+    double mb_per_s;
+    unsigned long bad;          // mensajes recibidos con número de secuencia incorrecto
+    int huge;                   // el anillo quedó en huge pages
+} ipc_bench_result_t;
+
+const char *ipc_kind_name(ipc_kind_t kind);
+
+// Hace fork() (misma topología que la demostración): el hijo consume count
+// mensajes de payload bytes y confirma; si lat no es NULL, además count/10
+// idas y vueltas cuyo RTT/2 se registra en lat. flags: IPC_RING_HUGE.
+int ipc_bench_run(ipc_kind_t kind, size_t payload, unsigned long count, unsigned flags,
+                  ipc_bench_result_t *out, lat_hist_t *lat);
+
+#endif // PROC_IPC_H
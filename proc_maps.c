@@ -0,0 +1,250 @@
+// proc_maps.c - Parser de /proc/<pid>/maps por bloques con índice de regiones
+//
+// Reemplaza el patrón fgets(line, 512) + strstr("[heap]") + sscanf("%lx-%lx"):
+//   - lee el archivo en bloques grandes (sin truncar rutas largas)
+//   - parsea los campos hexadecimales a mano, sin sscanf
+//   - guarda las regiones en un array ordenado para búsquedas O(log n)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "proc_maps.h"
+
+#define MAPS_CHUNK_SIZE (256 * 1024)
+
+void proc_maps_init(proc_maps_t *m) {
+    memset(m, 0, sizeof(*m));
+}
+
+void proc_maps_free(proc_maps_t *m) {
+    free(m->regions);
+    free(m->names);
+    free(m->chunk);
+    memset(m, 0, sizeof(*m));
+}
+
+// ========== PARSEO DE UNA LÍNEA ==========
+
+static const signed char hex_value[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};  // valor + 1, para que 0 signifique "no es hex"
+
+static inline uint64_t parse_hex(const char **pp, const char *end) {
+    const char *p = *pp;
+    uint64_t v = 0;
+    int d;
+    while (p < end && (d = hex_value[(unsigned char)*p]) != 0) {
+        v = (v << 4) | (uint64_t)(d - 1);
+        p++;
+    }
+    *pp = p;
+    return v;
+}
+
+static inline uint64_t parse_dec(const char **pp, const char *end) {
+    const char *p = *pp;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (uint64_t)(*p++ - '0');
+    *pp = p;
+    return v;
+}
+
+static int append_name(proc_maps_t *m, const char *name, size_t len, maps_region_t *r) {
+    if (m->names_len + len + 1 > m->names_cap) {
+        size_t ncap = m->names_cap ? m->names_cap : 65536;
+        while (ncap < m->names_len + len + 1) ncap *= 2;
+        char *grown = realloc(m->names, ncap);
+        if (!grown) return -1;
+        m->names = grown;
+        m->names_cap = ncap;
+    }
+    r->name_off = (uint32_t)m->names_len;
+    r->name_len = (uint32_t)len;
+    memcpy(m->names + m->names_len, name, len);
+    m->names[m->names_len + len] = '\0';
+    m->names_len += len + 1;
+    return 0;
+}
+
+static maps_kind_t classify_name(const char *name, size_t len) {
+    if (len == 0) return MAPS_KIND_ANON;
+    if (name[0] != '[') return MAPS_KIND_FILE;
+    if (len == 6 && memcmp(name, "[heap]", 6) == 0) return MAPS_KIND_HEAP;
+    if (len == 7 && memcmp(name, "[stack]", 7) == 0) return MAPS_KIND_STACK;
+    if ((len == 6 && memcmp(name, "[vdso]", 6) == 0) ||
+        (len == 6 && memcmp(name, "[vvar]", 6) == 0) ||
+        (len == 10 && memcmp(name, "[vsyscall]", 10) == 0)) return MAPS_KIND_VDSO;
+    return MAPS_KIND_OTHER;
+}
+
+// Formato: start-end perms offset major:minor inode   nombre
+static int parse_line(proc_maps_t *m, const char *p, const char *end) {
+    if (m->nregions == m->regions_cap) {
+        size_t ncap = m->regions_cap ? m->regions_cap * 2 : 1024;
+        maps_region_t *grown = realloc(m->regions, ncap * sizeof(*grown));
+        if (!grown) return -1;
+        m->regions = grown;
+        m->regions_cap = ncap;
+    }
+    maps_region_t *r = &m->regions[m->nregions];
+
+    r->start = (uintptr_t)parse_hex(&p, end);
+    if (p >= end || *p != '-') return 0;  // línea malformada: ignorar
+    p++;
+    r->end = (uintptr_t)parse_hex(&p, end);
+    if (end - p < 6) return 0;
+    p++;
+
+    r->perms = 0;
+    if (p[0] == 'r') r->perms |= MAPS_PERM_READ;
+    if (p[1] == 'w') r->perms |= MAPS_PERM_WRITE;
+    if (p[2] == 'x') r->perms |= MAPS_PERM_EXEC;
+    if (p[3] == 's') r->perms |= MAPS_PERM_SHARED;
+    p += 5;
+
+    r->offset = parse_hex(&p, end);
+    p++;
+    r->dev_major = (uint32_t)parse_hex(&p, end);
+    p++;
+    r->dev_minor = (uint32_t)parse_hex(&p, end);
+    p++;
+    r->inode = parse_dec(&p, end);
+    while (p < end && *p == ' ') p++;
+
+    size_t name_len = (size_t)(end - p);
+    if (append_name(m, p, name_len, r) < 0) return -1;
+    r->kind = (uint8_t)classify_name(p, name_len);
+
+    m->nregions++;
+    return 0;
+}
+
+// ========== CARGA POR BLOQUES ==========
+
+static int cmp_region(const void *a, const void *b) {
+    const maps_region_t *ra = a, *rb = b;
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+int proc_maps_load_fd(proc_maps_t *m, int fd) {
+    m->nregions = 0;
+    m->names_len = 0;
+
+    if (!m->chunk) {
+        m->chunk_cap = MAPS_CHUNK_SIZE;
+        m->chunk = malloc(m->chunk_cap);
+        if (!m->chunk) return -1;
+    }
+
+    // Lectura por bloques: lo que queda de una línea incompleta se mueve
+    // al principio del buffer y el siguiente read() lo completa.
+    size_t carry = 0;
+    for (;;) {
+        if (carry == m->chunk_cap) {
+            // Una sola línea más larga que el buffer: ampliarlo
+            char *grown = realloc(m->chunk, m->chunk_cap * 2);
+            if (!grown) return -1;
+            m->chunk = grown;
+            m->chunk_cap *= 2;
+        }
+
+        ssize_t n = read(fd, m->chunk + carry, m->chunk_cap - carry);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        size_t avail = carry + (size_t)n;
+        const char *p = m->chunk;
+        const char *end = m->chunk + avail;
+
+        for (;;) {
+            const char *nl = memchr(p, '\n', (size_t)(end - p));
+            if (!nl) break;
+            if (parse_line(m, p, nl) < 0) return -1;
+            p = nl + 1;
+        }
+
+        carry = (size_t)(end - p);
+        if (n == 0) {
+            if (carry > 0 && parse_line(m, p, end) < 0) return -1;  // última línea sin '\n'
+            break;
+        }
+        memmove(m->chunk, p, carry);
+    }
+
+    // El kernel ya entrega las regiones ordenadas; ordenar solo si no lo están
+    for (size_t i = 1; i < m->nregions; i++) {
+        if (m->regions[i].start < m->regions[i - 1].start) {
+            qsort(m->regions, m->nregions, sizeof(*m->regions), cmp_region);
+            break;
+        }
+    }
+    return 0;
+}
+
+int proc_maps_load_path(proc_maps_t *m, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int ret = proc_maps_load_fd(m, fd);
+    close(fd);
+    return ret;
+}
+
+int proc_maps_load(proc_maps_t *m, pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+    return proc_maps_load_path(m, path);
+}
+
+// ========== CONSULTAS ==========
+
+const maps_region_t *proc_maps_find(const proc_maps_t *m, uintptr_t addr) {
+    size_t lo = 0, hi = m->nregions;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m->regions[mid].start <= addr) lo = mid + 1;
+        else hi = mid;
+    }
+    // lo = primera región con start > addr; la candidata es la anterior
+    if (lo == 0) return NULL;
+    const maps_region_t *r = &m->regions[lo - 1];
+    return addr < r->end ? r : NULL;
+}
+
+const maps_region_t *proc_maps_find_kind(const proc_maps_t *m, maps_kind_t kind) {
+    for (size_t i = 0; i < m->nregions; i++) {
+        if (m->regions[i].kind == kind) return &m->regions[i];
+    }
+    return NULL;
+}
+
+void proc_maps_perm_str(const maps_region_t *r, char out[5]) {
+    out[0] = (r->perms & MAPS_PERM_READ) ? 'r' : '-';
+    out[1] = (r->perms & MAPS_PERM_WRITE) ? 'w' : '-';
+    out[2] = (r->perms & MAPS_PERM_EXEC) ? 'x' : '-';
+    out[3] = (r->perms & MAPS_PERM_SHARED) ? 's' : 'p';
+    out[4] = '\0';
+}
+
+int proc_maps_format_region(const proc_maps_t *m, const maps_region_t *r, char *buf, size_t len) {
+    char perms[5];
+    proc_maps_perm_str(r, perms);
+    return snprintf(buf, len, "%lx-%lx %s %08llx %02x:%02x %llu  %s",
+                    (unsigned long)r->start, (unsigned long)r->end, perms,
+                    (unsigned long long)r->offset, r->dev_major, r->dev_minor,
+                    (unsigned long long)r->inode, proc_maps_name(m, r));
+}
+
+void proc_maps_print_region(const proc_maps_t *m, const maps_region_t *r) {
+    char line[MAPS_LINE_MAX];
+    proc_maps_format_region(m, r, line, sizeof(line));
+    printf("%s\n", line);
+}
@@ -0,0 +1,81 @@
+// proc_maps.h - Parser de /proc/<pid>/maps por bloques con índice de regiones
+#ifndef PROC_MAPS_H
+#define PROC_MAPS_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Permisos de la región (columna "rwxp")
+#define MAPS_PERM_READ   0x1
+#define MAPS_PERM_WRITE  0x2
+#define MAPS_PERM_EXEC   0x4
+#define MAPS_PERM_SHARED 0x8
+
+// Tipo de región deducido del nombre
+typedef enum {
+    MAPS_KIND_ANON = 0,     // sin nombre (mmap anónimo)
+    MAPS_KIND_FILE,         // respaldada por archivo
+    MAPS_KIND_HEAP,         // [heap]
+    MAPS_KIND_STACK,        // [stack]
+    MAPS_KIND_VDSO,         // [vdso], [vvar], [vsyscall]
+    MAPS_KIND_OTHER,        // otros pseudo-nombres ([anon:...], [uprobes], ...)
+} maps_kind_t;
+
+typedef struct {
+    uintptr_t start;
+    uintptr_t end;          // exclusivo
+    uint64_t offset;
+    uint64_t inode;
+    uint32_t dev_major;
+    uint32_t dev_minor;
+    uint32_t name_off;      // offset en proc_maps_t.names
+    uint32_t name_len;
+    uint8_t perms;
+    uint8_t kind;
+} maps_region_t;
+
+// Todos los buffers se reutilizan entre cargas: recargar el mismo proceso
+// no vuelve a reservar memoria salvo que el mapa crezca.
+typedef struct {
+    maps_region_t *regions; // ordenadas por start, sin solapes
+    size_t nregions;
+    size_t regions_cap;
+
+    char *names;            // nombres concatenados (terminados en '\0')
+    size_t names_len;
+    size_t names_cap;
+
+    char *chunk;            // buffer de lectura
+    size_t chunk_cap;
+} proc_maps_t;
+
+void proc_maps_init(proc_maps_t *m);
+int  proc_maps_load(proc_maps_t *m, pid_t pid);                // 0 ok, -1 error
+int  proc_maps_load_path(proc_maps_t *m, const char *path);
+int  proc_maps_load_fd(proc_maps_t *m, int fd);
+void proc_maps_free(proc_maps_t *m);
+
+// Región que contiene addr, o NULL. O(log n).
+const maps_region_t *proc_maps_find(const proc_maps_t *m, uintptr_t addr);
+
+// Primera región de un tipo dado ([heap], [stack], ...), o NULL
+const maps_region_t *proc_maps_find_kind(const proc_maps_t *m, maps_kind_t kind);
+
+static inline const char *proc_maps_name(const proc_maps_t *m, const maps_region_t *r) {
+    return m->names + r->name_off;
+}
+
+// "rwxp" legible para imprimir
+void proc_maps_perm_str(const maps_region_t *r, char out[5]);
+
+// Imprime una región en el mismo formato que /proc/<pid>/maps
+void proc_maps_print_region(const proc_maps_t *m, const maps_region_t *r);
+
+// Igual, pero a buf (sin '\n'); devuelve lo mismo que snprintf.
+// MAPS_LINE_MAX basta para cualquier región: la ruta puede llegar a PATH_MAX
+#define MAPS_LINE_MAX (PATH_MAX + 128)
+int  proc_maps_format_region(const proc_maps_t *m, const maps_region_t *r, char *buf, size_t len);
+
+#endif // PROC_MAPS_H
@@ -0,0 +1,73 @@
+// proc_monitor.h - Muestreo continuo por thread de /proc/<pid>/task/*/{stat,schedstat}
+#ifndef PROC_MONITOR_H
+#define PROC_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_snapshot.h"
+
+// Estado de un thread entre muestras: los fds quedan abiertos y cada
+// muestra es un pread() en offset 0
+typedef struct {
+    pid_t tid;
+    int fd_stat;
+    int fd_schedstat;
+
+    // Valores absolutos de la última muestra
+    uint64_t run_ns;            // schedstat: tiempo en CPU
+    uint64_t wait_ns;           // schedstat: tiempo en la run-queue
+    uint64_t slices;            // schedstat: veces que entró a la CPU
+    unsigned long minflt;
+    unsigned long majflt;
+    char state;
+    char comm[16];
+
+    // Tasas calculadas con el delta de la última muestra
+    double cpu_pct;
+    double wait_pct;
+    double switch_rate;         // entradas a CPU por segundo
+    double minflt_rate;
+
+    uint64_t last_ns;           // cuándo se leyó schedstat: las tasas son desde entonces
+    uint64_t last_stat_ns;
+    uint64_t stat_run_ns;       // run_ns al leer stat: si no cambió, no corrió y stat tampoco
+    int has_prev;               // primera muestra: sin delta todavía
+    int has_stat;               // ya se leyó stat al menos una vez
+    int hot;                    // pasó de MONITOR_HOT_PCT en su última lectura: se lee cada muestra
+} monitor_thread_t;
+
+#define MONITOR_HOT_PCT 0.5     // CPU% a partir del cual un thread se lee en cada muestra
+
+typedef struct {
+    pid_t pid;
+    unsigned stat_every;        // threads fríos: schedstat (y stat si corrió) cada N muestras
+    int fd_status;              // /proc/<pid>/status: Threads para decidir si releer task/
+    int need_rescan;
+    unsigned long rescans;
+
+    monitor_thread_t *threads;  // ordenado por tid
+    size_t nthreads;
+    size_t threads_cap;
+
+    proc_dir_buf_t dir;
+    pid_t *tids;
+    size_t tids_cap;
+
+    uint64_t last_ns;
+    uint64_t self_cpu_ns;       // CPU consumida por la última muestra
+    size_t reads;               // threads leídos en la última muestra
+    double interval_s;          // duración real del último intervalo
+    unsigned long samples;
+} proc_monitor_t;
+
+int  proc_monitor_init(proc_monitor_t *m, pid_t pid, unsigned stat_every);
+int  proc_monitor_sample(proc_monitor_t *m);           // 0 ok, -1 si el proceso terminó
+void proc_monitor_print(const proc_monitor_t *m, size_t top);
+void proc_monitor_free(proc_monitor_t *m);
+
+// Bucle completo: muestrea cada interval_ms hasta count muestras (0 = infinito) o SIGINT
+int proc_monitor_run(pid_t pid, unsigned interval_ms, unsigned long count, size_t top, unsigned stat_every);
+
+#endif // PROC_MONITOR_H
@@ -0,0 +1,599 @@
+// proc_mtrack.c - Interposición de malloc/free con contadores por thread y pilas muestreadas
+//
+// Se enlaza en el programa (las definiciones de malloc del ejecutable tapan
+// las de glibc, también para las llamadas desde libc) o se compila aparte
+// como biblioteca para LD_PRELOAD:
+//
+//   gcc -O2 -shared -fPIC -DMTRACK_PRELOAD -o libproc_mtrack.so proc_mtrack.c -lpthread
+//
+// Cada hook llama a __libc_malloc y compañía y solo después cuenta. El camino
+// rápido es: comprobar el flag global, leer el tamaño de la cabecera del
+// chunk, dos load+store relaxed en la ranura del thread y restar del
+// contador de muestreo. Cada ~periodo bytes (intervalo aleatorio, como tcmalloc) se
+// guarda la pila con backtrace() y la dirección, para descontarla en su free.
+//
+// fork(): el hijo hereda la copia de la región del padre, pero debe contar
+// aparte; pthread_atfork crea su propia región, arranca los contadores a
+// cero y guarda como "heredados" los bytes vivos del padre. En el hijo solo
+// existe el thread que llamó a fork, así que basta con olvidar su ranura. Nada de esto
+// toma locks, así que es seguro aunque otro thread estuviera en malloc.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "proc_mtrack.h"
+
+// Las implementaciones de glibc (exportadas desde siempre con estos nombres)
+extern void *__libc_malloc(size_t n);
+extern void  __libc_free(void *p);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t n);
+extern void *__libc_memalign(size_t align, size_t n);
+extern void *__libc_valloc(size_t n);
+extern void *__libc_pvalloc(size_t n);
+
+static mtrack_shared_t *g_shm;
+static _Atomic uint32_t g_enabled;
+static uint64_t g_period = MTRACK_DEFAULT_PERIOD;
+static int g_export;
+static int g_keep;
+static char g_path[64];
+static pthread_key_t g_key;
+static int g_key_ok;
+
+// initial-exec: sin __tls_get_addr (que puede llamar a malloc) también en la .so
+typedef struct {
+    mtrack_thread_t *slot;      // ranura propia; NULL = camino lento
+    int no_slot;                // registrándose, sin ranura libre o ya terminado: cuenta en overflow
+    int64_t until_sample;
+    uint32_t rng;
+} mtrack_tls_t;
+
+static __thread mtrack_tls_t tls __attribute__((tls_model("initial-exec")));
+
+// ========== REGIÓN ==========
+
+static void fmt_path(char *out, pid_t pid) {
+    // Sin snprintf: se llama desde el hijo de un fork
+    static const char prefix[] = MTRACK_DIR "/" MTRACK_PREFIX;
+    char digits[16];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + pid % 10);
+        pid /= 10;
+    } while (pid > 0);
+    memcpy(out, prefix, sizeof(prefix) - 1);
+    char *p = out + sizeof(prefix) - 1;
+    while (n) *p++ = digits[--n];
+    *p = '\0';
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static mtrack_shared_t *region_create(pid_t tgid) {
+    void *m = MAP_FAILED;
+    if (g_export) {
+        fmt_path(g_path, tgid);
+        int fd = open(g_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd >= 0) {
+            if (ftruncate(fd, sizeof(mtrack_shared_t)) == 0) {
+                m = mmap(NULL, sizeof(mtrack_shared_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (m == MAP_FAILED) unlink(g_path);
+        }
+        if (m == MAP_FAILED) g_path[0] = '\0';
+    }
+    // Sin exportar (o si /dev/shm falla): privada, para que un fork no la comparta
+    if (m == MAP_FAILED) {
+        m = mmap(NULL, sizeof(mtrack_shared_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED) return NULL;
+    }
+    return m;
+}
+
+static void region_release(mtrack_shared_t *s) {
+    munmap(s, sizeof(*s));
+}
+
+static void region_init(mtrack_shared_t *s, pid_t tgid) {
+    s->magic = MTRACK_MAGIC;
+    s->version = MTRACK_VERSION;
+    s->tgid = tgid;
+    s->period = g_period;
+    s->start_ns = mono_ns();
+}
+
+// ========== RANURA DEL THREAD ==========
+
+static inline uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+// Uniforme en [1, 2 * periodo): media = periodo y sin patrón fijo que un
+// bucle de asignaciones iguales pueda esquivar siempre
+static int64_t next_interval(void) {
+    return 1 + (int64_t)(xorshift32(&tls.rng) % (2 * g_period));
+}
+
+// Solo el dueño escribe su ranura: load + store, sin lock
+static inline void bump(_Atomic uint64_t *c, uint64_t v) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+static void thread_exit(void *arg) {
+    (void)arg;
+    mtrack_shared_t *s = g_shm;
+    mtrack_thread_t *t = tls.slot;
+    tls.no_slot = 1;
+    tls.slot = NULL;
+    if (!s || !t) return;
+    // Sus totales pasan a los de threads terminados y la ranura queda libre
+    atomic_fetch_add_explicit(&s->dead_allocs, atomic_load_explicit(&t->allocs, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->dead_frees, atomic_load_explicit(&t->frees, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->dead_alloc_bytes, atomic_load_explicit(&t->alloc_bytes, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->dead_free_bytes, atomic_load_explicit(&t->free_bytes, memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(&t->allocs, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->frees, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->alloc_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->free_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->samples, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->tid, 0, memory_order_release);
+}
+
+// Primera asignación del thread: toma una ranura libre. Lo que asigne
+// pthread_setspecific mientras tanto (no_slot ya puesto) va a overflow.
+static mtrack_thread_t *thread_register(mtrack_shared_t *s) {
+    if (!tls.rng) {
+        tls.rng = (uint32_t)syscall(SYS_gettid) * 0x9e3779b9u | 1;
+        tls.until_sample = next_interval();
+    }
+    if (tls.no_slot) return &s->overflow;
+    tls.no_slot = 1;
+
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    for (int i = 0; i < MTRACK_MAX_THREADS; i++) {
+        pid_t expected = 0;
+        mtrack_thread_t *t = &s->threads[i];
+        if (atomic_load_explicit(&t->tid, memory_order_relaxed) != 0) continue;
+        if (!atomic_compare_exchange_strong(&t->tid, &expected, tid)) continue;
+        prctl(PR_GET_NAME, t->comm, 0, 0, 0);
+        // El destructor de la clave devuelve la ranura al terminar el thread
+        if (g_key_ok && !pthread_getspecific(g_key)) pthread_setspecific(g_key, (void *)1);
+        tls.slot = t;
+        tls.no_slot = 0;
+        return t;
+    }
+    return &s->overflow;
+}
+
+// Sin ranura propia todavía (o sin ranura libre): con fetch_add
+static __attribute__((noinline)) void count_slow(size_t n, int is_free) {
+    mtrack_thread_t *t = thread_register(g_shm);
+    atomic_fetch_add_explicit(is_free ? &t->frees : &t->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(is_free ? &t->free_bytes : &t->alloc_bytes, n, memory_order_relaxed);
+}
+
+// ========== MUESTREO ==========
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static int site_get(mtrack_shared_t *s, pid_t tid, void *const *pcs, int depth) {
+    uint64_t key = mix64((uint64_t)tid);
+    for (int i = 0; i < depth; i++) key = mix64(key ^ (uintptr_t)pcs[i]);
+    if (key == 0) key = 1;
+    for (uint32_t probe = 0; probe < 64; probe++) {
+        uint32_t idx = (uint32_t)(key + probe) & (MTRACK_SITES - 1);
+        mtrack_site_t *st = &s->sites[idx];
+        uint64_t cur = atomic_load_explicit(&st->key, memory_order_acquire);
+        if (cur == key) return (int)idx;
+        if (cur != 0) continue;
+        if (!atomic_compare_exchange_strong(&st->key, &cur, key)) {
+            if (cur == key) return (int)idx;
+            continue;
+        }
+        st->tid = tid;
+        st->depth = (uint32_t)depth;
+        for (int i = 0; i < depth; i++) st->pc[i] = (uintptr_t)pcs[i];
+        atomic_store_explicit(&st->ready, 1, memory_order_release);
+        return (int)idx;
+    }
+    atomic_fetch_add_explicit(&s->dropped_sites, 1, memory_order_relaxed);
+    return -1;
+}
+
+// Hash de Fibonacci: una multiplicación, que se paga en cada free
+static inline uint32_t live_bucket(const void *p) {
+    return (uint32_t)(((uintptr_t)p >> 4) * 0x9e3779b97f4a7c15ull >> 32) & (MTRACK_BUCKETS - 1);
+}
+
+static __attribute__((noinline)) void sample(mtrack_shared_t *s, void *p, size_t n, void *caller) {
+    void *pcs[MTRACK_DEPTH + 8];
+    int got = backtrace(pcs, MTRACK_DEPTH + 8);
+    // Se descartan los marcos de los hooks: la pila empieza en quien llamó a malloc
+    int first = 0;
+    for (int i = 0; i < got; i++) {
+        if (pcs[i] == caller) {
+            first = i;
+            break;
+        }
+    }
+    int depth = got - first < MTRACK_DEPTH ? got - first : MTRACK_DEPTH;
+    mtrack_thread_t *t = tls.slot ? tls.slot : &s->overflow;
+    pid_t tid = atomic_load_explicit(&t->tid, memory_order_relaxed);
+    int site = site_get(s, tid, pcs + first, depth);
+    atomic_fetch_add_explicit(&t->samples, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->samples, 1, memory_order_relaxed);
+    if (site < 0) return;
+
+    uint64_t weight = n > g_period ? n : g_period;
+    mtrack_site_t *st = &s->sites[site];
+    atomic_fetch_add_explicit(&st->samples, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->bytes, n, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->est_bytes, weight, memory_order_relaxed);
+
+    // Un bucket de 4 direcciones (una línea de caché): el free mira solo ese
+    uint32_t bi = live_bucket(p);
+    mtrack_sample_t *b = s->live[bi];
+    // Se reserva la entrada con 1 (ninguna dirección de malloc lo es) antes
+    // de rellenarla: otro thread que compita por ella no la pisa
+    for (int i = 0; i < 4; i++) {
+        uintptr_t expected = 0;
+        if (atomic_load_explicit(&b[i].ptr, memory_order_relaxed) != 0) continue;
+        if (!atomic_compare_exchange_strong(&b[i].ptr, &expected, 1)) continue;
+        b[i].site = (uint32_t)site;
+        b[i].weight_kb = (uint32_t)((weight + 1023) >> 10);
+        atomic_store_explicit(&b[i].ptr, (uintptr_t)p, memory_order_release);
+        atomic_fetch_add_explicit(&s->live_used[bi], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->live, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->est_live, (uint64_t)b[i].weight_kb << 10, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->live_samples, 1, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&s->dropped_live, 1, memory_order_relaxed);
+}
+
+static __attribute__((noinline)) void sample_forget(mtrack_shared_t *s, void *p, uint32_t bi) {
+    mtrack_sample_t *b = s->live[bi];
+    for (int i = 0; i < 4; i++) {
+        uintptr_t expected = (uintptr_t)p;
+        if (atomic_load_explicit(&b[i].ptr, memory_order_relaxed) != expected) continue;
+        uint32_t site = b[i].site;
+        uint64_t weight = (uint64_t)b[i].weight_kb << 10;
+        if (!atomic_compare_exchange_strong(&b[i].ptr, &expected, 0)) return;
+        atomic_fetch_sub_explicit(&s->live_used[bi], 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&s->sites[site].live, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&s->sites[site].est_live, weight, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&s->live_samples, 1, memory_order_relaxed);
+        return;
+    }
+}
+
+// ========== HOOKS ==========
+
+static inline int tracking(void) {
+    return __builtin_expect(atomic_load_explicit(&g_enabled, memory_order_relaxed) != 0, 0);
+}
+
+// Tamaño del chunk de glibc (cabecera incluida) justo antes del puntero, como
+// en alloc_origin: lo que ocupa de verdad y sin la llamada ni las
+// comprobaciones de malloc_usable_size, que mira también el chunk siguiente
+static inline size_t chunk_bytes(const void *p) {
+    return ((const size_t *)p)[-1] & ~(size_t)7;
+}
+
+// El siguiente intervalo se fija antes de muestrear: lo que asigne
+// backtrace() dentro de sample() se cuenta como cualquier otro malloc
+static inline void on_alloc(void *p, void *caller) {
+    mtrack_thread_t *t = tls.slot;
+    size_t n = chunk_bytes(p);
+    if (__builtin_expect(t != NULL, 1)) {
+        bump(&t->allocs, 1);
+        bump(&t->alloc_bytes, n);
+    } else {
+        count_slow(n, 0);
+    }
+    tls.until_sample -= (int64_t)n;
+    if (__builtin_expect(tls.until_sample < 0, 0)) {
+        tls.until_sample = next_interval();
+        sample(g_shm, p, n, caller);
+    }
+}
+
+static inline void on_free(void *p) {
+    mtrack_thread_t *t = tls.slot;
+    size_t n = chunk_bytes(p);
+    if (__builtin_expect(t != NULL, 1)) {
+        bump(&t->frees, 1);
+        bump(&t->free_bytes, n);
+    } else {
+        count_slow(n, 1);
+    }
+    // Sin muestras vivas no hay nada que buscar: ni hash ni live_used. Si
+    // las hay, casi nunca en su bucket: live_used (2 KB) se queda en caché
+    // y evita ir a buscar la línea del bucket en cada free
+    if (atomic_load_explicit(&g_shm->live_samples, memory_order_relaxed) != 0) {
+        uint32_t bi = live_bucket(p);
+        if (atomic_load_explicit(&g_shm->live_used[bi], memory_order_relaxed)) sample_forget(g_shm, p, bi);
+    }
+}
+
+void *malloc(size_t n) {
+    void *p = __libc_malloc(n);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+void free(void *p) {
+    if (p && tracking()) on_free(p);
+    __libc_free(p);
+}
+
+void *calloc(size_t n, size_t size) {
+    void *p = __libc_calloc(n, size);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+void *realloc(void *p, size_t n) {
+    if (!tracking()) return __libc_realloc(p, n);
+    if (p) on_free(p);
+    void *q = __libc_realloc(p, n);
+    if (q) on_alloc(q, __builtin_return_address(0));
+    else if (p && n) on_alloc(p, __builtin_return_address(0));    // falló: p sigue vivo
+    return q;
+}
+
+void *reallocarray(void *p, size_t n, size_t size) {
+    size_t bytes;
+    if (__builtin_mul_overflow(n, size, &bytes)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(p, bytes);
+}
+
+void *memalign(size_t align, size_t n) {
+    void *p = __libc_memalign(align, n);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+void *aligned_alloc(size_t align, size_t n) {
+    void *p = __libc_memalign(align, n);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+int posix_memalign(void **out, size_t align, size_t n) {
+    if (align % sizeof(void *) != 0 || (align & (align - 1)) != 0) return EINVAL;
+    void *p = __libc_memalign(align, n);
+    if (!p) return ENOMEM;
+    if (tracking()) on_alloc(p, __builtin_return_address(0));
+    *out = p;
+    return 0;
+}
+
+void *valloc(size_t n) {
+    void *p = __libc_valloc(n);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+void *pvalloc(size_t n) {
+    void *p = __libc_pvalloc(n);
+    if (p && tracking()) on_alloc(p, __builtin_return_address(0));
+    return p;
+}
+
+void *mtrack_libc_malloc(size_t n) {
+    return __libc_malloc(n);
+}
+
+void mtrack_libc_free(void *p) {
+    __libc_free(p);
+}
+
+// ========== FORK, INICIO Y FIN ==========
+
+static void totals_raw(const mtrack_shared_t *s, mtrack_totals_t *out);
+
+static void fork_child(void) {
+    mtrack_shared_t *old = g_shm;
+    if (!old) return;
+    mtrack_totals_t t;
+    totals_raw(old, &t);
+    mtrack_shared_t *s = region_create(getpid());
+    if (!s) {
+        atomic_store_explicit(&g_enabled, 0, memory_order_relaxed);
+        return;
+    }
+    // La copia del heap del padre sigue aquí: las pilas y direcciones
+    // muestreadas vivas siguen valiendo, los contadores empiezan de cero
+    memcpy(s, old, sizeof(*s));
+    s->parent = old->tgid;
+    s->tgid = getpid();
+    s->start_ns = mono_ns();
+    atomic_store_explicit(&s->inherited_bytes, t.live_bytes, memory_order_relaxed);
+    atomic_store_explicit(&s->dead_allocs, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->dead_frees, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->dead_alloc_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->dead_free_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->samples, 0, memory_order_relaxed);
+    memset(&s->overflow, 0, sizeof(s->overflow));
+    memset(s->threads, 0, sizeof(s->threads));
+    for (int i = 0; i < MTRACK_SITES; i++) {
+        atomic_store_explicit(&s->sites[i].samples, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->sites[i].bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->sites[i].est_bytes, 0, memory_order_relaxed);
+    }
+    region_release(old);
+    g_shm = s;
+    tls.slot = NULL;
+    tls.no_slot = 0;
+}
+
+int mtrack_start(uint64_t period, int export_region) {
+    if (period) g_period = period;
+    if (g_shm) g_shm->period = g_period;
+    if (!g_shm) {
+        // backtrace() carga libgcc_s la primera vez: mejor aquí que dentro de un malloc
+        void *warm[2];
+        backtrace(warm, 2);
+        g_export = export_region;
+        mtrack_shared_t *s = region_create(getpid());
+        if (!s) return -1;
+        region_init(s, getpid());
+        g_shm = s;
+    }
+    atomic_store_explicit(&g_shm->enabled, 1, memory_order_relaxed);
+    atomic_store_explicit(&g_enabled, 1, memory_order_release);
+    return 0;
+}
+
+void mtrack_stop(void) {
+    atomic_store_explicit(&g_enabled, 0, memory_order_relaxed);
+    if (g_shm) atomic_store_explicit(&g_shm->enabled, 0, memory_order_relaxed);
+}
+
+int mtrack_enabled(void) {
+    return atomic_load_explicit(&g_enabled, memory_order_relaxed) != 0;
+}
+
+const mtrack_shared_t *mtrack_self(void) {
+    return g_shm;
+}
+
+const char *mtrack_path(void) {
+    return g_path;
+}
+
+__attribute__((constructor)) static void mtrack_init(void) {
+    g_key_ok = pthread_key_create(&g_key, thread_exit) == 0;
+    pthread_atfork(NULL, NULL, fork_child);
+    g_keep = getenv("PROC_MTRACK_KEEP") && atoi(getenv("PROC_MTRACK_KEEP")) > 0;
+
+    const char *env = getenv("PROC_MTRACK");
+#ifdef MTRACK_PRELOAD
+    int on = !env || strcmp(env, "0") != 0;
+#else
+    int on = env && strcmp(env, "0") != 0;
+#endif
+    if (!on) return;
+    // "1" = periodo por defecto; otro número = bytes entre muestras
+    unsigned long long period = env ? strtoull(env, NULL, 10) : 0;
+    mtrack_start(period > 1 ? period : 0, 1);
+}
+
+// Con PROC_MTRACK_KEEP el lector no podrá leer maps después: se copia al lado
+static void save_maps(void) {
+    char path[80];
+    size_t len = strlen(g_path);
+    memcpy(path, g_path, len);
+    memcpy(path + len, MTRACK_MAPS_SUFFIX, sizeof(MTRACK_MAPS_SUFFIX));
+    int in = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    int out = in >= 0 ? open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600) : -1;
+    char buf[4096];
+    ssize_t n;
+    while (out >= 0 && (n = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, (size_t)n) != n) break;
+    }
+    if (out >= 0) close(out);
+    if (in >= 0) close(in);
+}
+
+__attribute__((destructor)) static void mtrack_fini(void) {
+    if (!g_shm) return;
+    atomic_store_explicit(&g_shm->exited, 1, memory_order_release);
+    if (!g_path[0]) return;
+    if (g_keep) save_maps();
+    else unlink(g_path);
+}
+
+// ========== LECTURA ==========
+
+static void totals_raw(const mtrack_shared_t *s, mtrack_totals_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->allocs = atomic_load_explicit(&s->dead_allocs, memory_order_relaxed);
+    out->frees = atomic_load_explicit(&s->dead_frees, memory_order_relaxed);
+    out->alloc_bytes = atomic_load_explicit(&s->dead_alloc_bytes, memory_order_relaxed);
+    out->free_bytes = atomic_load_explicit(&s->dead_free_bytes, memory_order_relaxed);
+    for (int i = -1; i < MTRACK_MAX_THREADS; i++) {
+        const mtrack_thread_t *t = i < 0 ? &s->overflow : &s->threads[i];
+        if (i >= 0 && atomic_load_explicit(&t->tid, memory_order_acquire) == 0) continue;
+        out->threads += i >= 0;
+        out->allocs += atomic_load_explicit(&t->allocs, memory_order_relaxed);
+        out->frees += atomic_load_explicit(&t->frees, memory_order_relaxed);
+        out->alloc_bytes += atomic_load_explicit(&t->alloc_bytes, memory_order_relaxed);
+        out->free_bytes += atomic_load_explicit(&t->free_bytes, memory_order_relaxed);
+    }
+    out->samples = atomic_load_explicit(&s->samples, memory_order_relaxed);
+    out->live_bytes = atomic_load_explicit(&s->inherited_bytes, memory_order_relaxed) +
+                      (int64_t)(out->alloc_bytes - out->free_bytes);
+}
+
+void mtrack_totals(const mtrack_shared_t *s, mtrack_totals_t *out) {
+    totals_raw(s, out);
+}
+
+const mtrack_thread_t *mtrack_thread_find(const mtrack_shared_t *s, pid_t tid) {
+    for (int i = 0; i < MTRACK_MAX_THREADS; i++) {
+        if (atomic_load_explicit(&s->threads[i].tid, memory_order_acquire) == tid) return &s->threads[i];
+    }
+    return NULL;
+}
+
+int mtrack_open(pid_t pid, const mtrack_shared_t **out) {
+    char path[64];
+    fmt_path(path, pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size != sizeof(mtrack_shared_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *m = mmap(NULL, sizeof(mtrack_shared_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return -1;
+    const mtrack_shared_t *s = m;
+    if (s->magic != MTRACK_MAGIC || s->version != MTRACK_VERSION || s->tgid != pid) {
+        munmap(m, sizeof(mtrack_shared_t));
+        errno = EINVAL;
+        return -1;
+    }
+    *out = s;
+    return 0;
+}
+
+void mtrack_close(const mtrack_shared_t *s) {
+    if (s) munmap((void *)s, sizeof(*s));
+}
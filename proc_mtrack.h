@@ -0,0 +1,122 @@
+// proc_mtrack.h - Seguimiento de malloc/free por interposición: contadores por
+// thread sin locks, pilas muestreadas cada N bytes y región compartida que
+// otro proceso lee (proc_analysis --mtrack <pid>)
+#ifndef PROC_MTRACK_H
+#define PROC_MTRACK_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Enlazado en el programa se activa con PROC_MTRACK=1 (o =<bytes por muestra>);
+// como biblioteca (-DMTRACK_PRELOAD, LD_PRELOAD=./libproc_mtrack.so) está
+// activo salvo PROC_MTRACK=0. PROC_MTRACK_KEEP=1 conserva el archivo al salir.
+#define MTRACK_MAGIC          0x314b43544d435250ull     // "PRCMTCK1"
+#define MTRACK_VERSION        1
+#define MTRACK_DIR            "/dev/shm"
+#define MTRACK_PREFIX         "proc_mtrack."
+#define MTRACK_MAPS_SUFFIX    ".maps"                 // copia de maps al salir con PROC_MTRACK_KEEP
+#define MTRACK_DEFAULT_PERIOD (512 * 1024)      // una muestra cada ~512 KB pedidos (como tcmalloc)
+#define MTRACK_DEPTH          12                // marcos guardados por pila
+#define MTRACK_MAX_THREADS    256               // threads con contadores propios a la vez
+#define MTRACK_SITES          2048              // pilas distintas (por thread) muestreadas
+#define MTRACK_BUCKETS        2048              // direcciones muestreadas vivas: buckets de 4
+
+// Un thread escribe solo en su ranura (load + store relaxed, sin instrucciones
+// con lock); los lectores de otro proceso ven valores como mucho una
+// operación atrasados. Una línea de caché por ranura: sin false sharing.
+typedef struct {
+    _Alignas(64) _Atomic pid_t tid;     // 0 = libre
+    char comm[16];                      // nombre al registrarse
+    _Atomic uint64_t allocs;
+    _Atomic uint64_t frees;
+    _Atomic uint64_t alloc_bytes;       // tamaño del chunk de glibc: el mismo valor en alloc y free
+    _Atomic uint64_t free_bytes;
+    _Atomic uint64_t samples;
+} mtrack_thread_t;
+
+// Pila de asignación muestreada de un thread. Cada muestra representa
+// max(tamaño, periodo) bytes: est_* es una estimación, no una cuenta exacta.
+typedef struct {
+    _Atomic uint64_t key;               // hash(tid, pila); 0 = libre
+    _Atomic uint32_t ready;             // pc[] ya escrito
+    pid_t tid;
+    uint32_t depth;
+    uint32_t pad;
+    uintptr_t pc[MTRACK_DEPTH];         // direcciones de retorno, la primera es quien llamó a malloc
+    _Atomic uint64_t samples;
+    _Atomic uint64_t live;              // muestras aún sin free
+    _Atomic uint64_t bytes;             // bytes reales de las muestras
+    _Atomic uint64_t est_bytes;
+    _Atomic uint64_t est_live;
+} mtrack_site_t;
+
+typedef struct {
+    _Atomic uintptr_t ptr;              // 0 = libre
+    uint32_t site;
+    uint32_t weight_kb;
+} mtrack_sample_t;
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    pid_t tgid;
+    pid_t parent;                       // si se creó en el hijo de un fork(): TGID del padre
+    uint32_t pad;
+    uint64_t period;
+    uint64_t start_ns;                  // CLOCK_MONOTONIC (el mismo para el lector)
+    _Atomic uint32_t enabled;
+    _Atomic uint32_t exited;
+    _Atomic int64_t inherited_bytes;    // vivos del padre al hacer fork
+    _Atomic uint64_t dead_allocs, dead_frees;           // threads ya terminados
+    _Atomic uint64_t dead_alloc_bytes, dead_free_bytes;
+    _Atomic uint64_t samples;
+    _Atomic uint64_t live_samples;
+    _Atomic uint64_t dropped_sites;     // tabla de pilas llena
+    _Atomic uint64_t dropped_live;      // bucket lleno: la muestra no se sigue hasta su free
+    mtrack_thread_t overflow;           // threads sin ranura y los que ya pasaron su destructor (fetch_add)
+    mtrack_thread_t threads[MTRACK_MAX_THREADS];
+    mtrack_site_t sites[MTRACK_SITES];
+    _Atomic uint8_t live_used[MTRACK_BUCKETS];     // entradas ocupadas por bucket
+    mtrack_sample_t live[MTRACK_BUCKETS][4];
+} mtrack_shared_t;
+
+// ========== CONTROL (en el propio proceso) ==========
+
+// Crea la región si no existe (exportada en MTRACK_DIR si export) y activa
+// el seguimiento. period: bytes entre muestras (0 = el actual, al principio
+// MTRACK_DEFAULT_PERIOD); cambiarlo no altera las muestras ya tomadas.
+int  mtrack_start(uint64_t period, int export_region);
+// Deja de contar; los bloques que se liberen después no descuentan sus bytes
+void mtrack_stop(void);
+int  mtrack_enabled(void);
+
+// glibc sin pasar por los hooks: la referencia para medir lo que cuestan
+void *mtrack_libc_malloc(size_t n);
+void  mtrack_libc_free(void *p);
+
+// Región de este proceso (NULL si nunca se activó) y su archivo ("" si no se exporta)
+const mtrack_shared_t *mtrack_self(void);
+const char *mtrack_path(void);
+
+// ========== LECTURA (este u otro proceso) ==========
+
+typedef struct {
+    uint64_t allocs, frees;
+    uint64_t alloc_bytes, free_bytes;
+    int64_t live_bytes;                 // heredados + asignados - liberados
+    uint64_t samples;
+    int threads;                        // ranuras ocupadas
+} mtrack_totals_t;
+
+void mtrack_totals(const mtrack_shared_t *s, mtrack_totals_t *out);
+
+// Ranura del thread tid, o NULL
+const mtrack_thread_t *mtrack_thread_find(const mtrack_shared_t *s, pid_t tid);
+
+// Región exportada por pid, de solo lectura
+int  mtrack_open(pid_t pid, const mtrack_shared_t **out);
+void mtrack_close(const mtrack_shared_t *s);
+
+#endif // PROC_MTRACK_H
@@ -0,0 +1,344 @@
+// proc_numa.c - Afinidad de CPU, ubicación NUMA de páginas y latencia local/remota
+//
+// Sin libnuma: la topología sale de /sys/devices/system/node, la ubicación de
+// cada página de move_pages en modo consulta (nodes == NULL) o, para VMAs
+// enteras de otro proceso, de /proc/<pid>/numa_maps. El fijado es
+// sched_setaffinity más set_mempolicy(MPOL_PREFERRED) cuando el destino es un
+// nodo, para que las páginas que se toquen después también queden en él.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_maps.h"
+#include "proc_numa.h"
+
+// De <linux/mempolicy.h>
+#define MPOL_PREFERRED  1
+#define MPOL_MF_MOVE    (1 << 1)
+
+#define NODE_DIR "/sys/devices/system/node"
+#define CACHE_LINE 64
+#define MOVE_BATCH 1024     // páginas por llamada a move_pages
+
+// ========== TOPOLOGÍA ==========
+
+// Lee un fichero de sysfs con formato cpulist ("0-3,8") en set; también sirve
+// para las listas de nodos (online, has_memory), que usan el mismo formato
+static int load_list(proc_file_t *f, const char *path, cpu_set_t *set) {
+    CPU_ZERO(set);
+    if (proc_file_load(f, path) < 0) return -1;
+    return cpu_list_parse(f->buf, set);
+}
+
+int numa_topo_load(numa_topo_t *t) {
+    memset(t, 0, sizeof(*t));
+    proc_file_t f;
+    proc_file_init(&f);
+    char path[96];
+    cpu_set_t online, mem;
+    if (load_list(&f, NODE_DIR "/online", &online) < 0) {
+        // Kernel sin CONFIG_NUMA: un único nodo con todas las CPUs
+        t->nnodes = 1;
+        long n = sysconf(_SC_NPROCESSORS_CONF);
+        for (long c = 0; c < n && c < CPU_SETSIZE; c++) CPU_SET(c, &t->cpus[0]);
+        t->has_memory[0] = 1;
+        proc_file_free(&f);
+        return 0;
+    }
+    if (load_list(&f, NODE_DIR "/has_memory", &mem) < 0) mem = online;
+
+    for (int n = 0; n < NUMA_MAX_NODES; n++) {
+        if (!CPU_ISSET(n, &online)) continue;
+        t->nodes[t->nnodes++] = n;
+        t->has_memory[n] = CPU_ISSET(n, &mem);
+        snprintf(path, sizeof(path), NODE_DIR "/node%d/cpulist", n);
+        load_list(&f, path, &t->cpus[n]);
+    }
+    proc_file_free(&f);
+    return t->nnodes > 0 ? 0 : -1;
+}
+
+int numa_cpu_node(const numa_topo_t *t, int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return -1;
+    for (int i = 0; i < t->nnodes; i++) {
+        if (CPU_ISSET(cpu, &t->cpus[t->nodes[i]])) return t->nodes[i];
+    }
+    return -1;
+}
+
+// ========== LISTAS DE CPU Y FIJADO ==========
+
+int cpu_list_parse(const char *s, cpu_set_t *set) {
+    CPU_ZERO(set);
+    int count = 0;
+    while (*s && *s != '\n') {
+        char *end;
+        long a = strtol(s, &end, 10);
+        if (end == s || a < 0) return -1;
+        long b = a;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            if (end == s + 1 || b < a) return -1;
+            s = end;
+        }
+        for (long c = a; c <= b && c < CPU_SETSIZE; c++, count++) CPU_SET(c, set);
+        if (*s == ',') s++;
+        else if (*s && *s != '\n') return -1;
+    }
+    return count;
+}
+
+int cpu_list_format(const cpu_set_t *set, char *buf, size_t len) {
+    size_t h = 0;
+    buf[0] = '\0';
+    for (int c = 0; c < CPU_SETSIZE && h + 1 < len; c++) {
+        if (!CPU_ISSET(c, set)) continue;
+        int last = c;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) last++;
+        int w = last > c ? snprintf(buf + h, len - h, "%s%d-%d", h ? "," : "", c, last)
+                         : snprintf(buf + h, len - h, "%s%d", h ? "," : "", c);
+        if (w < 0 || (size_t)w >= len - h) break;
+        h += (size_t)w;
+        c = last;
+    }
+    return (int)h;
+}
+
+int numa_pin_parse(const numa_topo_t *t, const char *spec, numa_pin_t *out) {
+    out->node = -1;
+    if (spec[0] == 'n' || spec[0] == 'N') {
+        char *end;
+        long n = strtol(spec + 1, &end, 10);
+        if (end == spec + 1 || *end || n < 0 || n >= NUMA_MAX_NODES || CPU_COUNT(&t->cpus[n]) == 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        out->node = (int)n;
+        out->cpus = t->cpus[n];
+        return 0;
+    }
+    if (cpu_list_parse(spec, &out->cpus) <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int numa_pin_format(const numa_pin_t *pin, char *buf, size_t len) {
+    char cpus[128];
+    cpu_list_format(&pin->cpus, cpus, sizeof(cpus));
+    if (pin->node >= 0) return snprintf(buf, len, "nodo %d (CPUs %s)", pin->node, cpus);
+    return snprintf(buf, len, "CPUs %s", cpus);
+}
+
+int numa_pin_self(const numa_pin_t *pin) {
+    if (sched_setaffinity(0, sizeof(pin->cpus), &pin->cpus) < 0) return -1;
+    if (pin->node < 0) return 0;
+    unsigned long mask[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    mask[pin->node / (8 * sizeof(unsigned long))] = 1ul << (pin->node % (8 * sizeof(unsigned long)));
+    // maxnode cuenta un bit de más (mm/mempolicy.c: get_nodes hace --maxnode)
+    return (int)syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, (unsigned long)NUMA_MAX_NODES + 1);
+}
+
+// ========== UBICACIÓN DE PÁGINAS ==========
+
+int numa_page_nodes(pid_t pid, const void *const *pages, size_t n, int *status) {
+    return (int)syscall(SYS_move_pages, pid, n, pages, NULL, status, 0);
+}
+
+int numa_addr_node(pid_t pid, const void *addr) {
+    const void *page = (const void *)((uintptr_t)addr & ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1));
+    int status;
+    if (numa_page_nodes(pid, &page, 1, &status) < 0) return -errno;
+    return status;
+}
+
+long numa_move_range(void *addr, size_t len, int node) {
+    uintptr_t psz = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(psz - 1);
+    uintptr_t end = ((uintptr_t)addr + len + psz - 1) & ~(psz - 1);
+    void *pages[MOVE_BATCH];
+    int nodes[MOVE_BATCH], status[MOVE_BATCH];
+    long moved = 0;
+    for (uintptr_t p = start; p < end;) {
+        size_t n = 0;
+        for (; n < MOVE_BATCH && p < end; n++, p += psz) {
+            pages[n] = (void *)p;
+            nodes[n] = node;
+        }
+        // < 0 si ninguna se pudo mover; > 0 = cuántas fallaron
+        if (syscall(SYS_move_pages, 0, n, pages, nodes, status, MPOL_MF_MOVE) < 0 && errno != ENOENT) return -1;
+        for (size_t i = 0; i < n; i++) moved += status[i] == node;
+    }
+    return moved;
+}
+
+int numa_maps_lookup(pid_t pid, uintptr_t addr, numa_vma_t *out) {
+    // numa_maps solo trae el inicio de cada VMA: el final sale de maps, y
+    // una dirección en un hueco entre dos VMAs no es de ninguna
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    const maps_region_t *r = proc_maps_load(&maps, pid) == 0 ? proc_maps_find(&maps, addr) : NULL;
+    if (!r) {
+        proc_maps_free(&maps);
+        errno = ENOENT;
+        return -1;
+    }
+    uintptr_t vstart = r->start, vend = r->end;
+    proc_maps_free(&maps);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/numa_maps", pid);
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, path) < 0) {
+        proc_file_free(&f);
+        return -1;
+    }
+
+    const char *best = NULL;
+    const char *p = f.buf, *end = f.buf + f.len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        uintptr_t start = strtoull(p, NULL, 16);
+        if (start == vstart) {
+            best = p;
+            break;
+        }
+        if (start > vstart) break;
+        p = nl + 1;
+    }
+    int ret = -1;
+    if (best) {
+        memset(out, 0, sizeof(*out));
+        const char *nl = memchr(best, '\n', (size_t)(end - best));
+        if (!nl) nl = end;
+        char *q;
+        out->start = strtoull(best, &q, 16);
+        out->end = vend;
+        while (*q == ' ') q++;
+        size_t plen = strcspn(q, " \n");
+        if (plen >= sizeof(out->policy)) plen = sizeof(out->policy) - 1;
+        memcpy(out->policy, q, plen);
+        for (q += plen; q < nl; q++) {
+            // Campos "N<nodo>=<páginas>"
+            if (q[0] == ' ' && q[1] == 'N' && q[2] >= '0' && q[2] <= '9') {
+                char *eq;
+                long n = strtol(q + 2, &eq, 10);
+                if (*eq == '=' && n < NUMA_MAX_NODES) {
+                    out->pages[n] = strtoul(eq + 1, NULL, 10);
+                    out->total += out->pages[n];
+                }
+            }
+        }
+        ret = 0;
+    } else {
+        errno = ENOENT;     // la VMA cambió entre las dos lecturas
+    }
+    proc_file_free(&f);
+    return ret;
+}
+
+int numa_vma_format(const numa_vma_t *v, char *buf, size_t len) {
+    size_t h = 0;
+    buf[0] = '\0';
+    for (int n = 0; n < NUMA_MAX_NODES && h + 1 < len; n++) {
+        if (!v->pages[n]) continue;
+        int w = snprintf(buf + h, len - h, "%sN%d=%lu", h ? " " : "", n, v->pages[n]);
+        if (w < 0 || (size_t)w >= len - h) break;
+        h += (size_t)w;
+    }
+    if (h == 0) h = (size_t)snprintf(buf, len, "sin páginas presentes");
+    return (int)h;
+}
+
+// ========== THREADS ==========
+
+int numa_task_info(const numa_topo_t *t, pid_t tgid, pid_t tid, numa_task_t *out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", tgid, tid);
+    proc_file_t f;
+    proc_file_init(&f);
+    proc_stat_t st;
+    int ok = proc_file_load(&f, path) == 0 && proc_parse_stat(f.buf, f.len, &st) == 0;
+    proc_file_free(&f);
+    if (!ok) return -1;
+
+    memset(out, 0, sizeof(*out));
+    out->tid = tid;
+    memcpy(out->comm, st.comm, sizeof(out->comm));
+    out->last_cpu = st.processor;
+    out->node = numa_cpu_node(t, st.processor);
+    if (sched_getaffinity(tid, sizeof(out->allowed), &out->allowed) < 0) CPU_ZERO(&out->allowed);
+    return 0;
+}
+
+// ========== LATENCIA ==========
+
+double numa_chase_ns(void *buf, size_t len, size_t loads) {
+    size_t nlines = len / CACHE_LINE;
+    if (nlines < 2 || loads == 0) return 0;
+    size_t *perm = malloc(nlines * sizeof(*perm));
+    if (!perm) return 0;
+
+    // Ciclo único en orden aleatorio (Sattolo)
+    for (size_t i = 0; i < nlines; i++) perm[i] = i;
+    uint64_t seed = 0x9e3779b97f4a7c15ull;
+    for (size_t i = nlines - 1; i > 0; i--) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        size_t j = (size_t)(seed % i);
+        size_t tmp = perm[i]; perm[i] = perm[j]; perm[j] = tmp;
+    }
+    char *base = buf;
+    for (size_t i = 0; i < nlines; i++) {
+        *(void **)(base + perm[i] * CACHE_LINE) = base + perm[(i + 1) % nlines] * CACHE_LINE;
+    }
+    free(perm);
+
+    void *volatile *p = (void *volatile *)base;
+    for (size_t i = 0; i < nlines; i++) p = (void *volatile *)*p;     // calentar TLB
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < loads; i++) p = (void *volatile *)*p;
+    uint64_t dt = now_ns() - t0;
+    __asm__ volatile("" : : "r"(p));
+    return (double)dt / (double)loads;
+}
+
+double numa_flush_load_ns(const volatile char *p, int reps) {
+#if defined(__x86_64__) || defined(__i386__)
+    static char other[2 * CACHE_LINE];
+    volatile char sink = 0;
+    uint64_t t0 = now_ns();
+    for (int r = 0; r < reps; r++) {
+        __builtin_ia32_clflush((const void *)p);
+        __builtin_ia32_mfence();
+        sink += *p;
+        __builtin_ia32_lfence();
+    }
+    uint64_t cold = now_ns() - t0;
+    // Mismo bucle vaciando otra línea: descuenta el coste de clflush y las barreras
+    t0 = now_ns();
+    for (int r = 0; r < reps; r++) {
+        __builtin_ia32_clflush(other + CACHE_LINE);
+        __builtin_ia32_mfence();
+        sink += *p;
+        __builtin_ia32_lfence();
+    }
+    uint64_t warm = now_ns() - t0;
+    (void)sink;
+    return cold > warm ? (double)(cold - warm) / reps : 0.0;
+#else
+    (void)p;
+    (void)reps;
+    return 0.0;
+#endif
+}
@@ -0,0 +1,90 @@
+// proc_numa.h - Afinidad de CPU, ubicación NUMA de páginas y latencia local/remota
+// (cpu_set_t: compilar con _GNU_SOURCE definido antes del primer #include)
+#ifndef PROC_NUMA_H
+#define PROC_NUMA_H
+
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define NUMA_MAX_NODES 64
+
+// Topología leída de /sys/devices/system/node (sin libnuma)
+typedef struct {
+    int nnodes;                         // nodos online
+    int nodes[NUMA_MAX_NODES];          // sus números (pueden tener huecos)
+    cpu_set_t cpus[NUMA_MAX_NODES];     // CPUs de cada nodo, indexado por número de nodo
+    int has_memory[NUMA_MAX_NODES];
+} numa_topo_t;
+
+// Sin /sys/devices/system/node (kernel sin NUMA) se simula un nodo 0 con todas las CPUs
+int  numa_topo_load(numa_topo_t *t);
+int  numa_cpu_node(const numa_topo_t *t, int cpu);     // -1 si no se conoce
+
+// ========== LISTAS DE CPU Y FIJADO ==========
+
+// Formato de cpulist del kernel: "0-3,8,10-11"
+int  cpu_list_parse(const char *s, cpu_set_t *set);
+int  cpu_list_format(const cpu_set_t *set, char *buf, size_t len);
+
+// Destino de fijado: lista de CPUs ("0-3,8") o nodo ("n1"): sus CPUs y, para
+// que las páginas nuevas caigan en él, política de memoria preferida
+typedef struct {
+    cpu_set_t cpus;
+    int node;                           // -1 si se dieron CPUs sueltas
+} numa_pin_t;
+
+int  numa_pin_parse(const numa_topo_t *t, const char *spec, numa_pin_t *out);
+int  numa_pin_format(const numa_pin_t *pin, char *buf, size_t len);
+
+// Fija el thread que llama (afinidad + MPOL_PREFERRED si pin->node >= 0)
+int  numa_pin_self(const numa_pin_t *pin);
+
+// ========== UBICACIÓN DE PÁGINAS ==========
+
+// move_pages en modo consulta: status[i] = nodo de pages[i] o -errno
+// (-ENOENT si no está presente). pid 0 = el proceso actual.
+int  numa_page_nodes(pid_t pid, const void *const *pages, size_t n, int *status);
+int  numa_addr_node(pid_t pid, const void *addr);      // nodo, o -errno
+
+// Migra las páginas de [addr, addr+len) del proceso actual a node.
+// Devuelve cuántas quedaron allí (las compartidas con otro proceso no se mueven).
+long numa_move_range(void *addr, size_t len, int node);
+
+// Entrada de /proc/<pid>/numa_maps de la VMA que contiene una dirección
+typedef struct {
+    uintptr_t start;
+    uintptr_t end;                      // exclusivo (de /proc/<pid>/maps)
+    char policy[32];                    // "default", "bind:1", "prefer:0", ...
+    unsigned long pages[NUMA_MAX_NODES];// páginas presentes por nodo (N<x>=)
+    unsigned long total;
+} numa_vma_t;
+
+int  numa_maps_lookup(pid_t pid, uintptr_t addr, numa_vma_t *out);
+// "N0=12 N1=3" con los nodos que tienen páginas
+int  numa_vma_format(const numa_vma_t *v, char *buf, size_t len);
+
+// ========== THREADS ==========
+
+typedef struct {
+    pid_t tid;
+    char comm[16];
+    cpu_set_t allowed;                  // sched_getaffinity
+    int last_cpu;                       // campo 39 de stat: CPU donde corrió por última vez
+    int node;                           // nodo de last_cpu
+} numa_task_t;
+
+int  numa_task_info(const numa_topo_t *t, pid_t tgid, pid_t tid, numa_task_t *out);
+
+// ========== LATENCIA ==========
+
+// Recorrido de punteros por buf (un salto por línea de caché en orden
+// aleatorio, así el prefetcher no ayuda): ns por carga dependiente
+double numa_chase_ns(void *buf, size_t len, size_t loads);
+
+// Latencia de cargar p tras vaciar su línea de caché (clflush), menos la
+// de la misma carga con la línea en caché. 0 si la arquitectura no tiene clflush.
+double numa_flush_load_ns(const volatile char *p, int reps);
+
+#endif // PROC_NUMA_H
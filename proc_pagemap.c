@@ -0,0 +1,261 @@
+// proc_pagemap.c - Medición de páginas compartidas (COW) con /proc/<pid>/pagemap
+//
+// demonstrate_cow_difference() solo describe COW. Aquí se mide: se leen las
+// entradas de pagemap de padre e hijo en lotes (un pread por cada 4096
+// páginas) y se comparan los PFN. Mismo PFN = la página sigue compartida.
+// Sin CAP_SYS_ADMIN el kernel pone el PFN a 0; entonces se usa el bit 56
+// (mapeada en exclusiva) como aproximación.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_pagemap.h"
+
+// ========== LECTURA DE PAGEMAP ==========
+
+int pagemap_open(pagemap_t *pm, pid_t pid) {
+    char path[64];
+    pm->pid = pid;
+    pm->buf = NULL;
+    snprintf(path, sizeof(path), "/proc/%d/pagemap", pid);
+    pm->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (pm->fd < 0) return -1;
+    pm->buf = malloc(PAGEMAP_BATCH * sizeof(uint64_t));
+    if (!pm->buf) {
+        close(pm->fd);
+        pm->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void pagemap_close(pagemap_t *pm) {
+    if (pm->fd >= 0) close(pm->fd);
+    free(pm->buf);
+    pm->fd = -1;
+    pm->buf = NULL;
+}
+
+int pagemap_read(pagemap_t *pm, uintptr_t start, size_t npages, uint64_t *out) {
+    long page = sysconf(_SC_PAGESIZE);
+    uint64_t *dst = out ? out : pm->buf;
+    off_t off = (off_t)(start / (uintptr_t)page) * (off_t)sizeof(uint64_t);
+    size_t want = npages * sizeof(uint64_t);
+    size_t got = 0;
+
+    while (got < want) {
+        ssize_t n = pread(pm->fd, (char *)dst + got, want - got, off + (off_t)got);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    // Lo no leído (fuera del espacio de direcciones) cuenta como ausente
+    if (got < want) memset((char *)dst + got, 0, want - got);
+    return 0;
+}
+
+// ========== COMPARACIÓN ==========
+
+int cow_compare(pagemap_t *a, pagemap_t *b, uintptr_t start, uintptr_t end, cow_stats_t *st) {
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t first = start & ~((uintptr_t)page - 1);
+    size_t total = (end - first + (uintptr_t)page - 1) / (uintptr_t)page;
+
+    memset(st, 0, sizeof(*st));
+    st->pages = total;
+
+    // Un lote de b se guarda aparte para no pisar el buffer de a
+    uint64_t *eb = malloc(PAGEMAP_BATCH * sizeof(uint64_t));
+    if (!eb) return -1;
+
+    for (size_t done = 0; done < total; done += PAGEMAP_BATCH) {
+        size_t n = total - done < PAGEMAP_BATCH ? total - done : PAGEMAP_BATCH;
+        uintptr_t addr = first + done * (uintptr_t)page;
+        if (pagemap_read(a, addr, n, NULL) < 0 || pagemap_read(b, addr, n, eb) < 0) {
+            free(eb);
+            return -1;
+        }
+        const uint64_t *ea = a->buf;
+
+        for (size_t i = 0; i < n; i++) {
+            int pa = (ea[i] & PM_PRESENT) != 0;
+            int pb = (eb[i] & PM_PRESENT) != 0;
+            // Un PFN solo vale con la página presente: en swap esos bits son tipo/offset
+            uint64_t pfa = pa ? ea[i] & PM_PFN_MASK : 0;
+            uint64_t pfb = pb ? eb[i] & PM_PFN_MASK : 0;
+            if (pfa || pfb) st->pfn_known = 1;
+
+            st->present_a += (size_t)pa;
+            st->present_b += (size_t)pb;
+            if (!pa || !pb) {
+                st->private_a += (size_t)pa;
+                st->private_b += (size_t)pb;
+                continue;
+            }
+
+            int shared;
+            if (pfa || pfb) {
+                shared = pfa == pfb;
+            } else {
+                // Sin PFN: presente en ambos y ninguno la tiene en exclusiva
+                shared = !(ea[i] & PM_MMAP_EXCLUSIVE) && !(eb[i] & PM_MMAP_EXCLUSIVE);
+            }
+            if (shared) {
+                st->shared++;
+            } else {
+                st->private_a++;
+                st->private_b++;
+            }
+        }
+    }
+
+    free(eb);
+    return 0;
+}
+
+// ========== smaps_rollup ==========
+
+static const struct {
+    const char *key;
+    size_t len;
+    size_t off;
+} smaps_fields[] = {
+    { "Rss:",           4,  offsetof(smaps_rollup_t, rss_kb) },
+    { "Pss:",           4,  offsetof(smaps_rollup_t, pss_kb) },
+    { "Pss_Anon:",      9,  offsetof(smaps_rollup_t, pss_anon_kb) },
+    { "Pss_File:",      9,  offsetof(smaps_rollup_t, pss_file_kb) },
+    { "Pss_Shmem:",     10, offsetof(smaps_rollup_t, pss_shmem_kb) },
+    { "Shared_Clean:",  13, offsetof(smaps_rollup_t, shared_clean_kb) },
+    { "Shared_Dirty:",  13, offsetof(smaps_rollup_t, shared_dirty_kb) },
+    { "Private_Clean:", 14, offsetof(smaps_rollup_t, private_clean_kb) },
+    { "Private_Dirty:", 14, offsetof(smaps_rollup_t, private_dirty_kb) },
+    { "Anonymous:",     10, offsetof(smaps_rollup_t, anonymous_kb) },
+    { "Swap:",          5,  offsetof(smaps_rollup_t, swap_kb) },
+    { "SwapPss:",       8,  offsetof(smaps_rollup_t, swap_pss_kb) },
+};
+
+int smaps_rollup_field(const char *line, size_t len, smaps_rollup_t *out) {
+    for (size_t i = 0; i < sizeof(smaps_fields) / sizeof(smaps_fields[0]); i++) {
+        if (len > smaps_fields[i].len && memcmp(line, smaps_fields[i].key, smaps_fields[i].len) == 0) {
+            *(unsigned long *)((char *)out + smaps_fields[i].off) += strtoul(line + smaps_fields[i].len, NULL, 10);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int smaps_rollup_read(pid_t pid, smaps_rollup_t *out) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, path) < 0) {
+        // Las cabeceras de región no coinciden con ningún campo: sumar todo el archivo
+        snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+        if (errno != ENOENT || proc_file_load(&f, path) < 0) {
+            proc_file_free(&f);
+            return -1;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    const char *p = f.buf;
+    const char *end = f.buf + f.len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        smaps_rollup_field(p, (size_t)(nl - p), out);
+        p = nl + 1;
+    }
+
+    proc_file_free(&f);
+    return 0;
+}
+
+// ========== COSTE DE ROMPER COW ==========
+
+int cow_break_bench(size_t npages, cow_break_t *out) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t len = npages * (size_t)page;
+    memset(out, 0, sizeof(*out));
+    out->pages = npages;
+
+    // volatile: las escrituras de medición no deben eliminarse
+    volatile char *mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return -1;
+    // Páginas normales: con THP un solo fallo copiaría 2 MB y falsearía el coste por página
+    madvise((void *)mem, len, MADV_NOHUGEPAGE);
+    for (size_t i = 0; i < npages; i++) mem[i * (size_t)page] = 1;
+
+    // Tubería para que el hijo avise de que ya está en pausa
+    int ready[2];
+    if (pipe(ready) < 0) {
+        munmap((void *)mem, len);
+        return -1;
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        close(ready[0]);
+        close(ready[1]);
+        munmap((void *)mem, len);
+        return -1;
+    }
+    if (child == 0) {
+        close(ready[0]);
+        if (write(ready[1], "x", 1) < 0) _exit(1);
+        pause();
+        _exit(0);
+    }
+    close(ready[1]);
+    char c;
+    if (read(ready[0], &c, 1) < 0) c = 0;
+    close(ready[0]);
+
+    pagemap_t pa, pb;
+    int have_pm = pagemap_open(&pa, getpid()) == 0;
+    have_pm = pagemap_open(&pb, child) == 0 && have_pm;
+    cow_stats_t st;
+    if (have_pm && cow_compare(&pa, &pb, (uintptr_t)mem, (uintptr_t)mem + len, &st) == 0) {
+        out->shared_before = st.shared;
+    }
+
+    // Primera escritura: cada página provoca un fallo y una copia
+    struct rusage r0, r1;
+    getrusage(RUSAGE_SELF, &r0);
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < npages; i++) mem[i * (size_t)page] = 2;
+    out->touch_ns = now_ns() - t0;
+    getrusage(RUSAGE_SELF, &r1);
+    out->minflt = r1.ru_minflt - r0.ru_minflt;
+
+    // Segunda escritura: las páginas ya son privadas, sin fallos
+    t0 = now_ns();
+    for (size_t i = 0; i < npages; i++) mem[i * (size_t)page] = 3;
+    out->retouch_ns = now_ns() - t0;
+
+    if (have_pm && cow_compare(&pa, &pb, (uintptr_t)mem, (uintptr_t)mem + len, &st) == 0) {
+        out->shared_after = st.shared;
+        out->pfn_known = st.pfn_known;
+    }
+    pagemap_close(&pa);
+    pagemap_close(&pb);
+
+    kill(child, SIGTERM);
+    waitpid(child, NULL, 0);
+    munmap((void *)mem, len);
+    return 0;
+}
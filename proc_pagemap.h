@@ -0,0 +1,91 @@
+// proc_pagemap.h - Medición de páginas compartidas (COW) con /proc/<pid>/pagemap
+#ifndef PROC_PAGEMAP_H
+#define PROC_PAGEMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Bits de cada entrada de pagemap (Documentation/admin-guide/mm/pagemap.rst)
+#define PM_PFN_MASK        ((1ull << 55) - 1)   // 0-54: PFN (0 sin CAP_SYS_ADMIN)
+#define PM_SOFT_DIRTY      (1ull << 55)
+#define PM_MMAP_EXCLUSIVE  (1ull << 56)         // página mapeada por un solo proceso
+#define PM_FILE_OR_SHARED  (1ull << 61)
+#define PM_SWAPPED         (1ull << 62)
+#define PM_PRESENT         (1ull << 63)
+
+#define PAGEMAP_BATCH 4096   // entradas por pread (32 KB)
+
+// Lector de pagemap con fd abierto y buffer reutilizable
+typedef struct {
+    pid_t pid;
+    int fd;
+    uint64_t *buf;          // PAGEMAP_BATCH entradas
+} pagemap_t;
+
+int  pagemap_open(pagemap_t *pm, pid_t pid);
+void pagemap_close(pagemap_t *pm);
+
+// Lee npages entradas a partir de la página que contiene start.
+// Si out es NULL se devuelve un puntero a pm->buf (npages <= PAGEMAP_BATCH).
+int  pagemap_read(pagemap_t *pm, uintptr_t start, size_t npages, uint64_t *out);
+
+// ========== COMPARACIÓN PADRE/HIJO ==========
+
+typedef struct {
+    size_t pages;           // páginas del rango
+    size_t present_a;       // presentes en RAM en A
+    size_t present_b;
+    size_t shared;          // mismo marco físico en A y B (COW intacto)
+    size_t private_a;       // presentes en A y no compartidas con B
+    size_t private_b;
+    int pfn_known;          // 0: sin PFN, se usa el bit "exclusivo" como aproximación
+} cow_stats_t;
+
+// Compara [start, end) en dos procesos en lotes de PAGEMAP_BATCH páginas
+int cow_compare(pagemap_t *a, pagemap_t *b, uintptr_t start, uintptr_t end, cow_stats_t *st);
+
+// ========== smaps_rollup ==========
+
+// Campos en kB. Los mismos nombres aparecen por región en smaps; Pss_Anon,
+// Pss_File y Pss_Shmem solo en smaps_rollup
+typedef struct {
+    unsigned long rss_kb;
+    unsigned long pss_kb;
+    unsigned long pss_anon_kb;
+    unsigned long pss_file_kb;
+    unsigned long pss_shmem_kb;
+    unsigned long shared_clean_kb;
+    unsigned long shared_dirty_kb;
+    unsigned long private_clean_kb;
+    unsigned long private_dirty_kb;
+    unsigned long anonymous_kb;
+    unsigned long swap_kb;
+    unsigned long swap_pss_kb;
+} smaps_rollup_t;
+
+// Sin smaps_rollup (kernel < 4.14) suma las regiones de smaps
+int smaps_rollup_read(pid_t pid, smaps_rollup_t *out);
+
+// Suma a out una línea "Clave:   N kB" de smaps/smaps_rollup; 0 si no es un campo conocido
+int smaps_rollup_field(const char *line, size_t len, smaps_rollup_t *out);
+
+static inline unsigned long smaps_uss_kb(const smaps_rollup_t *r) {
+    return r->private_clean_kb + r->private_dirty_kb;
+}
+
+// ========== COSTE DE ROMPER COW ==========
+
+typedef struct {
+    size_t pages;
+    uint64_t touch_ns;          // escribir 1 byte por página tras fork()
+    long minflt;                // fallos menores durante la escritura
+    uint64_t retouch_ns;        // segunda escritura (ya privadas)
+    size_t shared_before;       // páginas compartidas con el hijo antes de escribir
+    size_t shared_after;
+    int pfn_known;
+} cow_break_t;
+
+int cow_break_bench(size_t npages, cow_break_t *out);
+
+#endif // PROC_PAGEMAP_H
@@ -0,0 +1,178 @@
+// proc_peek.c - Lectura de variables de otro proceso con process_vm_readv
+//
+// process_vm_readv copia directamente entre los dos espacios de direcciones:
+// el proceso remoto no se detiene (nada de ptrace attach), solo hace falta el
+// mismo permiso que para ptrace (PTRACE_MODE_ATTACH_REALCREDS). Todas las
+// variables van en un único vector de iovecs, así que leer N variables cuesta
+// una llamada al sistema, no N.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include "proc_common.h"
+#include "proc_maps.h"
+#include "proc_elf.h"
+#include "proc_peek.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+void peek_init(peek_t *p, pid_t pid) {
+    memset(p, 0, sizeof(*p));
+    p->pid = pid;
+}
+
+void peek_free(peek_t *p) {
+    free(p->vars);
+    free(p->buf);
+    free(p->local);
+    free(p->remote);
+    memset(p, 0, sizeof(*p));
+}
+
+int peek_add(peek_t *p, const char *name, uintptr_t addr, size_t size, uint8_t type) {
+    if (size > PEEK_MAX_VAR) size = PEEK_MAX_VAR;
+    if (addr == 0) size = 0;
+    if (p->nvars == p->cap) {
+        size_t cap = p->cap ? p->cap * 2 : 16;
+        peek_var_t *v = realloc(p->vars, cap * sizeof(*v));
+        struct iovec *l = v ? realloc(p->local, cap * sizeof(*l)) : NULL;
+        if (l) p->local = l;
+        struct iovec *r = l ? realloc(p->remote, cap * sizeof(*r)) : NULL;
+        if (v) p->vars = v;
+        if (!v || !l || !r) return -1;
+        p->remote = r;
+        p->cap = cap;
+    }
+    // Valores alineados a 8 dentro de buf
+    size_t off = (p->buf_len + 7) & ~(size_t)7;
+    if (off + size > p->buf_cap) {
+        size_t cap = p->buf_cap ? p->buf_cap : 256;
+        while (cap < off + size) cap *= 2;
+        uint8_t *b = realloc(p->buf, cap);
+        if (!b) return -1;
+        p->buf = b;
+        p->buf_cap = cap;
+        // buf pudo moverse: recolocar los iovecs locales
+        for (size_t i = 0; i < p->nvars; i++) p->local[i].iov_base = p->buf + p->vars[i].off;
+    }
+    memset(p->buf + off, 0, size);
+    p->buf_len = off + size;
+
+    peek_var_t *v = &p->vars[p->nvars];
+    v->name = name;
+    v->addr = addr;
+    v->size = (uint32_t)size;
+    v->off = (uint32_t)off;
+    v->type = type;
+    v->valid = 0;
+    p->local[p->nvars] = (struct iovec){ .iov_base = p->buf + off, .iov_len = size };
+    p->remote[p->nvars] = (struct iovec){ .iov_base = (void *)addr, .iov_len = size };
+    p->nvars++;
+    return 0;
+}
+
+int peek_add_symbols(peek_t *p, char *const *names, size_t n) {
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    elf_file_t e;
+    uintptr_t bias;
+    int ok = proc_maps_load(&maps, p->pid) == 0 && elf_open_process(&e, p->pid, &maps, &bias) == 0;
+    proc_maps_free(&maps);
+    if (!ok) return -1;
+
+    int resolved = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Elf64_Sym *s = elf_find_symbol(&e, names[i]);
+        if (!s || s->st_shndx == SHN_UNDEF) {
+            if (peek_add(p, names[i], 0, 0, STT_NOTYPE) < 0) break;
+            continue;
+        }
+        // Sin tamaño (etiquetas de ensamblador): al menos una palabra
+        size_t size = s->st_size ? s->st_size : sizeof(long);
+        if (peek_add(p, names[i], (uintptr_t)s->st_value + bias, size, ELF64_ST_TYPE(s->st_info)) < 0) break;
+        resolved++;
+    }
+    elf_close(&e);
+    return resolved;
+}
+
+int peek_read(peek_t *p) {
+    uint64_t t0 = now_ns();
+    int valid = 0;
+    size_t i = 0;
+    while (i < p->nvars) {
+        size_t cnt = p->nvars - i < IOV_MAX ? p->nvars - i : IOV_MAX;
+        ssize_t n = process_vm_readv(p->pid, &p->local[i], cnt, &p->remote[i], cnt, 0);
+        p->syscalls++;
+        if (n < 0) {
+            // EFAULT: la primera variable del tramo no está mapeada; el resto se reintenta
+            if (errno != EFAULT) return -1;
+            n = 0;
+        }
+        // Las variables cubiertas enteras son válidas; la primera incompleta no,
+        // y la siguiente llamada empieza justo detrás de ella
+        size_t left = (size_t)n;
+        size_t j = i;
+        for (; j < i + cnt && left >= p->vars[j].size; j++) {
+            left -= p->vars[j].size;
+            p->vars[j].valid = p->vars[j].addr != 0;
+            valid += p->vars[j].valid;
+        }
+        if (j < i + cnt) {
+            p->vars[j].valid = 0;
+            j++;
+        }
+        i = j;
+    }
+    p->reads++;
+    p->read_ns += now_ns() - t0;
+    return valid;
+}
+
+static int printable(const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (b[i] < 0x20 || b[i] >= 0x7f) return 0;
+    }
+    return 1;
+}
+
+int peek_format_value(const peek_t *p, size_t i, char *buf, size_t len) {
+    const peek_var_t *v = &p->vars[i];
+    if (v->addr == 0) return snprintf(buf, len, "(sin símbolo)");
+    if (!v->valid) return snprintf(buf, len, "(no legible)");
+    const uint8_t *b = peek_value(p, i);
+
+    // Texto: bytes imprimibles hasta un '\0' (char[] y similares)
+    const uint8_t *nul = memchr(b, '\0', v->size);
+    size_t slen = nul ? (size_t)(nul - b) : 0;
+    if (v->size > 8 && slen > 0 && printable(b, slen)) {
+        return snprintf(buf, len, "\"%.*s\"", (int)(slen > 48 ? 48 : slen), (const char *)b);
+    }
+
+    switch (v->size) {
+    case 1: return snprintf(buf, len, "%d (%#x)", (int8_t)b[0], b[0]);
+    case 2: { int16_t x; memcpy(&x, b, 2); return snprintf(buf, len, "%d (%#x)", x, (uint16_t)x); }
+    case 4: { int32_t x; memcpy(&x, b, 4); return snprintf(buf, len, "%d (%#x)", x, (uint32_t)x); }
+    case 8: { int64_t x; memcpy(&x, b, 8); return snprintf(buf, len, "%lld (%#llx)", (long long)x, (unsigned long long)x); }
+    default: break;
+    }
+
+    size_t h = 0;
+    size_t show = v->size < 16 ? v->size : 16;
+    for (size_t k = 0; k < show && h + 3 < len; k++) h += (size_t)snprintf(buf + h, len - h, "%02x", b[k]);
+    if (show < v->size && h + 4 < len) h += (size_t)snprintf(buf + h, len - h, "...");
+    return (int)h;
+}
+
+int peek_differs(const peek_t *a, const peek_t *b, size_t i) {
+    const peek_var_t *va = &a->vars[i], *vb = &b->vars[i];
+    if (va->valid != vb->valid || va->size != vb->size) return 1;
+    return va->valid && memcmp(peek_value(a, i), peek_value(b, i), va->size) != 0;
+}
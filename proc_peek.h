@@ -0,0 +1,62 @@
+// proc_peek.h - Lectura de variables de otro proceso con process_vm_readv (sin detenerlo)
+#ifndef PROC_PEEK_H
+#define PROC_PEEK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define PEEK_MAX_VAR 4096       // bytes leídos como máximo por variable
+
+typedef struct {
+    const char *name;           // no se copia: debe vivir tanto como el peek_t
+    uintptr_t addr;             // dirección en el proceso remoto (0 = sin resolver)
+    uint32_t size;
+    uint32_t off;               // posición del valor en peek_t.buf
+    uint8_t type;               // STT_* del símbolo (STT_NOTYPE si se añadió a mano)
+    uint8_t valid;              // la última lectura lo trajo completo
+} peek_var_t;
+
+// Conjunto de variables de un proceso: cada peek_read() es un único
+// process_vm_readv (o uno por cada IOV_MAX variables) sobre buf
+typedef struct {
+    pid_t pid;
+    peek_var_t *vars;
+    size_t nvars;
+    size_t cap;
+    uint8_t *buf;
+    size_t buf_len;
+    size_t buf_cap;
+    struct iovec *local;
+    struct iovec *remote;
+
+    unsigned long reads;
+    unsigned long syscalls;
+    uint64_t read_ns;           // acumulado de todas las lecturas
+} peek_t;
+
+void peek_init(peek_t *p, pid_t pid);
+void peek_free(peek_t *p);
+
+int  peek_add(peek_t *p, const char *name, uintptr_t addr, size_t size, uint8_t type);
+
+// Resuelve cada nombre en la tabla de símbolos de /proc/<pid>/exe (con el bias
+// de PIE del propio proceso). Los que no existen quedan con addr 0. Devuelve
+// cuántos se resolvieron, o -1 si no se pudo abrir el ejecutable.
+int  peek_add_symbols(peek_t *p, char *const *names, size_t n);
+
+// Lee todas las variables; devuelve cuántas llegaron completas, -1 si el
+// proceso no existe o no hay permiso (ptrace_may_access)
+int  peek_read(peek_t *p);
+
+static inline const uint8_t *peek_value(const peek_t *p, size_t i) {
+    return p->buf + p->vars[i].off;
+}
+
+// Entero (1/2/4/8 bytes), cadena si parece texto, o bytes en hex
+int  peek_format_value(const peek_t *p, size_t i, char *buf, size_t len);
+
+// ¿Valores distintos (o validez distinta) de la variable i en a y b?
+int  peek_differs(const peek_t *a, const peek_t *b, size_t i);
+
+#endif // PROC_PEEK_H
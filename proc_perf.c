@@ -0,0 +1,231 @@
+// proc_perf.c - Contadores de perf_event_open por thread
+//
+// Cada thread abre sus propios grupos (pid = 0, cpu = -1, sin inherit): los
+// contadores siguen al thread de CPU en CPU y no cuentan a nadie más, ni a
+// los threads que cree ni a los hijos de fork(). Para los hardware se mapea
+// la página de control de cada evento: si el kernel deja rdpmc
+// (cap_user_rdpmc) y el contador está en la PMU (index != 0), el valor es
+// offset + rdpmc(index - 1) sin ninguna syscall. Si no, o para los
+// software, una lectura PERF_FORMAT_GROUP trae todo el grupo en un read().
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PERF_HAVE_RDPMC 1
+#endif
+
+#include "proc_common.h"
+#include "proc_perf.h"
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+    const char *name;
+} perf_evs[PERF_NEV] = {
+    [PERF_EV_CYCLES]       = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,      "ciclos" },
+    [PERF_EV_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,    "instr" },
+    [PERF_EV_CACHE_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,    "cache-miss" },
+    [PERF_EV_PAGE_FAULTS]  = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS,     "fallos" },
+    [PERF_EV_CTX_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "cambios" },
+};
+
+const char *perf_ev_name(perf_ev_t ev) {
+    return (unsigned)ev < PERF_NEV ? perf_evs[ev].name : "?";
+}
+
+static int sys_perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd) {
+    return (int)syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Abre los eventos de [first, last] en un grupo; el líder es el primero que abre
+static void open_group(perf_group_t *g, int first, int last, int *err) {
+    int leader = -1;
+    for (int e = first; e <= last; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_evs[e].type;
+        attr.config = perf_evs[e].config;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Los cambios de contexto ocurren en el kernel: con exclude_kernel
+        // contarían 0. Los software se piden enteros y, si paranoid no lo
+        // deja (EACCES), solo usuario como los hardware.
+        attr.exclude_kernel = perf_evs[e].type == PERF_TYPE_HARDWARE;
+        int fd = sys_perf_event_open(&attr, g->tid, -1, leader);
+        if (fd < 0 && !attr.exclude_kernel && (errno == EACCES || errno == EPERM)) {
+            attr.exclude_kernel = 1;
+            fd = sys_perf_event_open(&attr, g->tid, -1, leader);
+        }
+        if (fd >= 0 && attr.exclude_kernel) g->user_only |= 1u << e;
+        if (fd < 0) {
+            if (err && !*err) *err = errno;
+            continue;
+        }
+        if (leader < 0) leader = fd;
+        g->fd[e] = fd;
+        g->avail |= 1u << e;
+    }
+}
+
+int perf_group_open(perf_group_t *g, pid_t tid) {
+    memset(g, 0, sizeof(*g));
+    for (int e = 0; e < PERF_NEV; e++) g->fd[e] = -1;
+    g->self = tid == 0 || tid == get_kernel_pid();
+    g->tid = g->self ? get_kernel_pid() : tid;
+
+    open_group(g, PERF_EV_CYCLES, PERF_EV_CACHE_MISSES, &g->hw_errno);
+    open_group(g, PERF_EV_PAGE_FAULTS, PERF_EV_CTX_SWITCHES, NULL);
+    if (!g->avail) {
+        errno = g->hw_errno ? g->hw_errno : ENOSYS;
+        return -1;
+    }
+
+#ifdef PERF_HAVE_RDPMC
+    // rdpmc solo tiene sentido desde el thread medido: lee la PMU de esta CPU
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (int e = PERF_EV_CYCLES; g->self && e <= PERF_EV_CACHE_MISSES; e++) {
+        if (g->fd[e] < 0) continue;
+        void *pg = mmap(NULL, page, PROT_READ, MAP_SHARED, g->fd[e], 0);
+        if (pg == MAP_FAILED) continue;
+        g->pg[e] = pg;
+        if (g->pg[e]->cap_user_rdpmc) g->rdpmc |= 1u << e;
+    }
+#endif
+    return 0;
+}
+
+void perf_group_close(perf_group_t *g) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (int e = 0; e < PERF_NEV; e++) {
+        if (!(g->avail & (1u << e))) continue;
+        if (g->pg[e]) munmap(g->pg[e], page);
+        close(g->fd[e]);
+        g->pg[e] = NULL;
+        g->fd[e] = -1;
+    }
+    g->avail = g->rdpmc = 0;
+}
+
+int perf_group_stale(const perf_group_t *g) {
+    return g->avail && g->self && g->tid != get_kernel_pid();
+}
+
+#ifdef PERF_HAVE_RDPMC
+// Protocolo de la página de control: reintentar si el kernel la actualizó
+// (reprogramó el contador o lo movió de CPU) mientras se leía
+static int read_rdpmc(volatile struct perf_event_mmap_page *pg, uint64_t *out) {
+    uint32_t seq, idx;
+    uint64_t count;
+    do {
+        seq = pg->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        idx = pg->index;
+        count = pg->offset;
+        if (!pg->cap_user_rdpmc || idx == 0) return -1;   // fuera de la PMU ahora mismo
+        uint16_t width = pg->pmc_width;
+        int64_t pmc = (int64_t)__rdpmc((int)idx - 1);
+        pmc <<= 64 - width;
+        pmc >>= 64 - width;
+        count += (uint64_t)pmc;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (pg->lock != seq);
+    *out = count;
+    return 0;
+}
+#endif
+
+// read() de un grupo: { nr, time_enabled, time_running, values[nr] } en el
+// orden en que se añadieron los miembros (el líder primero)
+static int read_group(perf_group_t *g, int first, int last, perf_counts_t *out) {
+    int leader = -1;
+    for (int e = first; e <= last && leader < 0; e++) leader = g->fd[e];
+    if (leader < 0) return 0;
+
+    uint64_t buf[3 + PERF_NEV];
+    ssize_t n = read(leader, buf, sizeof(buf));
+    if (n < (ssize_t)(3 * sizeof(uint64_t))) return -1;
+    uint64_t nr = buf[0], enabled = buf[1], running = buf[2];
+    size_t i = 0;
+    for (int e = first; e <= last; e++) {
+        if (g->fd[e] < 0) continue;
+        if (i >= nr) break;
+        uint64_t v = buf[3 + i++];
+        // Multiplexado: el grupo solo estuvo en la PMU parte del tiempo
+        if (running && running < enabled) {
+            v = (uint64_t)((double)v * enabled / running);
+            out->scaled |= 1u << e;
+        }
+        out->v[e] = v;
+        out->avail |= 1u << e;
+    }
+    return 0;
+}
+
+int perf_group_read(perf_group_t *g, perf_counts_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!g->avail || perf_group_stale(g)) {
+        errno = ESRCH;
+        return -1;
+    }
+
+    unsigned hw = g->avail & PERF_HW_MASK;
+    unsigned fast = 0;
+#ifdef PERF_HAVE_RDPMC
+    if (hw && (g->rdpmc & hw) == hw) {
+        for (int e = PERF_EV_CYCLES; e <= PERF_EV_CACHE_MISSES; e++) {
+            if (!(hw & (1u << e))) continue;
+            if (read_rdpmc(g->pg[e], &out->v[e]) < 0) break;
+            fast |= 1u << e;
+        }
+    }
+#endif
+    if (fast == hw) {
+        out->avail |= fast;
+    } else if (read_group(g, PERF_EV_CYCLES, PERF_EV_CACHE_MISSES, out) < 0) {
+        return -1;
+    }
+    return read_group(g, PERF_EV_PAGE_FAULTS, PERF_EV_CTX_SWITCHES, out);
+}
+
+void perf_counts_delta(const perf_counts_t *before, const perf_counts_t *after, perf_counts_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->avail = before->avail & after->avail;
+    out->scaled = before->scaled | after->scaled;
+    for (int e = 0; e < PERF_NEV; e++) {
+        if (!(out->avail & (1u << e))) continue;
+        out->v[e] = after->v[e] > before->v[e] ? after->v[e] - before->v[e] : 0;
+    }
+}
+
+static const char *fmt_count(uint64_t v, char *buf, size_t len) {
+    if (v >= 10000000000ull)  snprintf(buf, len, "%.1fG", v / 1e9);
+    else if (v >= 10000000)   snprintf(buf, len, "%.1fM", v / 1e6);
+    else if (v >= 10000)      snprintf(buf, len, "%.1fk", v / 1e3);
+    else                      snprintf(buf, len, "%llu", (unsigned long long)v);
+    return buf;
+}
+
+int perf_counts_format(const perf_counts_t *c, char *buf, size_t len) {
+    size_t off = 0;
+    buf[0] = '\0';
+    for (int e = 0; e < PERF_NEV && off < len; e++) {
+        if (!(c->avail & (1u << e))) continue;
+        char num[24];
+        off += (size_t)snprintf(buf + off, len - off, "%s%s=%s%s", off ? " " : "", perf_evs[e].name,
+                                fmt_count(c->v[e], num, sizeof(num)), c->scaled & (1u << e) ? "~" : "");
+        if (e == PERF_EV_INSTRUCTIONS && (c->avail & (1u << PERF_EV_CYCLES)) && c->v[PERF_EV_CYCLES] && off < len) {
+            off += (size_t)snprintf(buf + off, len - off, " IPC=%.2f",
+                                    (double)c->v[PERF_EV_INSTRUCTIONS] / c->v[PERF_EV_CYCLES]);
+        }
+    }
+    return off < len ? (int)off : (int)len - 1;
+}
@@ -0,0 +1,61 @@
+// proc_perf.h - Contadores de perf_event_open por thread: ciclos, instrucciones,
+// fallos de caché, fallos de página y cambios de contexto
+#ifndef PROC_PERF_H
+#define PROC_PERF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef enum {
+    PERF_EV_CYCLES = 0,         // hardware
+    PERF_EV_INSTRUCTIONS,       // hardware
+    PERF_EV_CACHE_MISSES,       // hardware (último nivel de caché)
+    PERF_EV_PAGE_FAULTS,        // software: también en VMs sin PMU virtual
+    PERF_EV_CTX_SWITCHES,       // software
+    PERF_NEV,
+} perf_ev_t;
+
+#define PERF_HW_MASK ((1u << PERF_EV_CYCLES) | (1u << PERF_EV_INSTRUCTIONS) | (1u << PERF_EV_CACHE_MISSES))
+
+const char *perf_ev_name(perf_ev_t ev);
+
+struct perf_event_mmap_page;
+
+// Dos grupos: los hardware (líder: ciclos) y los software (líder: fallos de
+// página). Así los hardware se pueden leer con rdpmc sin entrar al kernel
+// aunque los software necesiten read().
+typedef struct {
+    pid_t tid;                              // thread medido (el que abrió si se pasó 0)
+    int self;                               // lo abrió el propio thread: rdpmc posible
+    int fd[PERF_NEV];                       // -1 si el evento no está disponible
+    struct perf_event_mmap_page *pg[PERF_NEV];  // solo hardware y self
+    unsigned avail;                         // máscara de eventos abiertos
+    unsigned rdpmc;                         // los que se leen con rdpmc
+    unsigned user_only;                     // sin lo que pasa en el kernel (exclude_kernel)
+    int hw_errno;                           // por qué no hay hardware (ENOENT en una VM sin PMU)
+} perf_group_t;
+
+typedef struct {
+    uint64_t v[PERF_NEV];
+    unsigned avail;
+    unsigned scaled;            // eventos extrapolados por multiplexado (running < enabled)
+} perf_counts_t;
+
+// tid 0 = el thread que llama. Los hardware solo cuentan espacio de usuario
+// (exclude_kernel), lo que permite perf_event_paranoid=2; los software
+// incluyen el kernel si se puede. Vale con que abra un evento; -1 si ninguno.
+int  perf_group_open(perf_group_t *g, pid_t tid);
+void perf_group_close(perf_group_t *g);
+
+// Tras un fork() el hijo hereda los fd pero no los contadores: siguen
+// midiendo al padre. Devuelve 1 si g fue abierto por otro thread/proceso.
+int  perf_group_stale(const perf_group_t *g);
+
+int  perf_group_read(perf_group_t *g, perf_counts_t *out);
+void perf_counts_delta(const perf_counts_t *before, const perf_counts_t *after, perf_counts_t *out);
+
+// "ciclos=1.2M instr=3.4M IPC=2.83 cache-miss=12.0k fallos=34 cambios=2"
+int  perf_counts_format(const perf_counts_t *c, char *buf, size_t len);
+
+#endif // PROC_PERF_H
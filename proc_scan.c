@@ -0,0 +1,243 @@
+// proc_scan.c - Escaneo de todos los procesos del host con un pool fijo de pthreads
+//
+// Sustituye a `ps -eLf | grep` y `ps aux | grep`. El llamante enumera /proc
+// una vez; los workers se reparten la lista en bloques con un contador
+// atómico, leen /proc/<pid>/stat con un único pread y escriben en su propio
+// buffer. Con want_tasks (lo de ps -eLf) cada worker recorre además
+// task/* de sus procesos: una fila por thread, con el TGID de su status.
+// Al terminar, los buffers se concatenan y se ordenan por TGID y PID: no
+// hay ningún lock en el camino de lectura.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+
+#include "proc_common.h"
+#include "proc_scan.h"
+
+#define SCAN_CHUNK 64   // PIDs por bloque: equilibra reparto y contención del contador
+
+// ========== LECTURA DE UN PROCESO ==========
+
+static ssize_t read_small(const char *path, char *buf, size_t cap) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;  // el proceso terminó tras el getdents
+    ssize_t n = pread(fd, buf, cap - 1, 0);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    return n;
+}
+
+// tid == 0: el proceso (/proc/<pid>); si no, uno de sus threads (/proc/<pid>/task/<tid>)
+static int scan_one(pid_t pid, pid_t tid, scan_entry_t *e, long page_kb, int want_status) {
+    char path[64];
+    char buf[4096];             // status llega a ~1.5 KB; los cambios de contexto van al final
+    int base = tid ? snprintf(path, sizeof(path), "/proc/%d/task/%d/", pid, tid)
+                   : snprintf(path, sizeof(path), "/proc/%d/", pid);
+
+    strcpy(path + base, "stat");
+    ssize_t n = read_small(path, buf, sizeof(buf));
+    if (n < 0) return -1;
+
+    proc_stat_t st;
+    if (proc_parse_stat(buf, (size_t)n, &st) < 0) return -1;
+
+    e->pid = st.tid;
+    e->tgid = st.tid;   // líder de grupo (entrada de /proc); un thread lo toma de status
+    e->ppid = st.ppid;
+    e->threads = (int)st.num_threads;
+    e->rss_kb = st.rss_pages * page_kb;
+    e->state = st.state;
+    memcpy(e->comm, st.comm, sizeof(e->comm));
+    e->starttime = st.starttime;
+    e->minflt = st.minflt;
+    e->majflt = st.majflt;
+    e->vol_ctxt = e->nonvol_ctxt = 0;
+    if (!want_status && !tid) return 0;
+
+    // Los cambios de contexto y el Tgid de un thread solo están en status
+    strcpy(path + base, "status");
+    n = read_small(path, buf, sizeof(buf));
+    proc_status_t ps;
+    if (n > 0 && proc_parse_status(buf, (size_t)n, &ps) == 0) {
+        if (ps.tgid > 0) e->tgid = ps.tgid;
+        e->vol_ctxt = ps.vol_ctxt;
+        e->nonvol_ctxt = ps.nonvol_ctxt;
+    } else if (tid) {
+        return -1;      // el thread terminó entre stat y status
+    }
+    return 0;
+}
+
+static int bucket_reserve(scan_bucket_t *b, size_t extra) {
+    if (b->n + extra <= b->cap) return 0;
+    size_t ncap = b->cap ? b->cap : 256;
+    while (ncap < b->n + extra) ncap *= 2;
+    scan_entry_t *grown = realloc(b->entries, ncap * sizeof(*grown));
+    if (!grown) return -1;
+    b->entries = grown;
+    b->cap = ncap;
+    return 0;
+}
+
+// ========== WORKERS ==========
+
+static void scan_round(scan_worker_t *w, long page_kb) {
+    proc_scanner_t *s = w->owner;
+    scan_bucket_t *b = &w->bucket;
+    b->n = 0;
+
+    for (;;) {
+        size_t first = __atomic_fetch_add(&s->next, SCAN_CHUNK, __ATOMIC_RELAXED);
+        if (first >= s->npids) break;
+        size_t last = first + SCAN_CHUNK < s->npids ? first + SCAN_CHUNK : s->npids;
+
+        if (!s->want_tasks) {
+            if (bucket_reserve(b, last - first) < 0) break;
+            for (size_t i = first; i < last; i++) {
+                if (scan_one(s->pids[i], 0, &b->entries[b->n], page_kb, s->want_status) == 0) b->n++;
+            }
+            continue;
+        }
+        // Un getdents de task/ por proceso, con el buffer del worker
+        for (size_t i = first; i < last; i++) {
+            char path[32];
+            snprintf(path, sizeof(path), "/proc/%d/task", s->pids[i]);
+            ssize_t nt = proc_list_pids(path, &w->dir, &w->tids, &w->tids_cap);
+            if (nt <= 0 || bucket_reserve(b, (size_t)nt) < 0) continue;
+            for (ssize_t t = 0; t < nt; t++) {
+                if (scan_one(s->pids[i], w->tids[t], &b->entries[b->n], page_kb, s->want_status) == 0) b->n++;
+            }
+        }
+    }
+}
+
+static void *scan_worker_main(void *arg) {
+    scan_worker_t *w = arg;
+    proc_scanner_t *s = w->owner;
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    unsigned long seen = 0;
+
+    char name[16];
+    snprintf(name, sizeof(name), "SCAN-%u", w->index);
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (s->generation == seen && !s->shutdown) pthread_cond_wait(&s->start_cv, &s->lock);
+        if (s->shutdown) {
+            pthread_mutex_unlock(&s->lock);
+            return NULL;
+        }
+        seen = s->generation;
+        pthread_mutex_unlock(&s->lock);
+
+        scan_round(w, page_kb);
+
+        pthread_mutex_lock(&s->lock);
+        if (--s->pending == 0) pthread_cond_signal(&s->done_cv);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+// ========== API ==========
+
+int proc_scanner_init(proc_scanner_t *s, unsigned nworkers) {
+    memset(s, 0, sizeof(*s));
+    if (nworkers == 0) nworkers = 1;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->start_cv, NULL);
+    pthread_cond_init(&s->done_cv, NULL);
+
+    s->workers = calloc(nworkers, sizeof(*s->workers));
+    if (!s->workers) return -1;
+
+    for (unsigned i = 0; i < nworkers; i++) {
+        scan_worker_t *w = &s->workers[i];
+        w->owner = s;
+        w->index = i;
+        if (pthread_create(&w->thread, NULL, scan_worker_main, w) != 0) {
+            perror("Error creando worker de escaneo");
+            break;
+        }
+        s->nworkers++;
+    }
+    return s->nworkers > 0 ? 0 : -1;
+}
+
+// Por TGID y luego PID: los threads quedan bajo su proceso (sin want_tasks, TGID == PID)
+static int cmp_entry_pid(const void *a, const void *b) {
+    const scan_entry_t *ea = a, *eb = b;
+    if (ea->tgid != eb->tgid) return ea->tgid < eb->tgid ? -1 : 1;
+    return ea->pid < eb->pid ? -1 : ea->pid > eb->pid;
+}
+
+int proc_scanner_run(proc_scanner_t *s) {
+    ssize_t n = proc_list_pids("/proc", &s->dir, &s->pids, &s->pids_cap);
+    if (n < 0) return -1;
+    s->npids = (size_t)n;
+    s->next = 0;
+
+    pthread_mutex_lock(&s->lock);
+    s->pending = s->nworkers;
+    s->generation++;
+    pthread_cond_broadcast(&s->start_cv);
+    while (s->pending > 0) pthread_cond_wait(&s->done_cv, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    // Combinar: los workers ya terminaron, los buffers son de solo lectura
+    size_t total = 0;
+    for (unsigned i = 0; i < s->nworkers; i++) total += s->workers[i].bucket.n;
+    if (total > s->entries_cap) {
+        scan_entry_t *grown = realloc(s->entries, total * sizeof(*grown));
+        if (!grown) return -1;
+        s->entries = grown;
+        s->entries_cap = total;
+    }
+    s->nentries = 0;
+    for (unsigned i = 0; i < s->nworkers; i++) {
+        const scan_bucket_t *b = &s->workers[i].bucket;
+        memcpy(s->entries + s->nentries, b->entries, b->n * sizeof(*b->entries));
+        s->nentries += b->n;
+    }
+    qsort(s->entries, s->nentries, sizeof(*s->entries), cmp_entry_pid);
+    return 0;
+}
+
+void proc_scanner_free(proc_scanner_t *s) {
+    pthread_mutex_lock(&s->lock);
+    s->shutdown = 1;
+    pthread_cond_broadcast(&s->start_cv);
+    pthread_mutex_unlock(&s->lock);
+
+    for (unsigned i = 0; i < s->nworkers; i++) {
+        pthread_join(s->workers[i].thread, NULL);
+        free(s->workers[i].bucket.entries);
+        free(s->workers[i].tids);
+        proc_dir_buf_free(&s->workers[i].dir);
+    }
+    free(s->workers);
+    free(s->pids);
+    free(s->entries);
+    proc_dir_buf_free(&s->dir);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->start_cv);
+    pthread_cond_destroy(&s->done_cv);
+    memset(s, 0, sizeof(*s));
+}
+
+void proc_scan_print(const proc_scanner_t *s, const char *comm_filter) {
+    printf("  %7s %7s %7s %7s %10s %2s  %s\n",
+           "PID", "TGID", "PPID", "THREADS", "RSS(kB)", "S", "COMM");
+    for (size_t i = 0; i < s->nentries; i++) {
+        const scan_entry_t *e = &s->entries[i];
+        if (comm_filter && !strstr(e->comm, comm_filter)) continue;
+        printf("  %7d %7d %7d %7d %10ld %2c  %s\n",
+               e->pid, e->tgid, e->ppid, e->threads, e->rss_kb, e->state, e->comm);
+    }
+}
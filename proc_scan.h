@@ -0,0 +1,81 @@
+// proc_scan.h - Escaneo de todos los procesos del host con un pool fijo de pthreads
+#ifndef PROC_SCAN_H
+#define PROC_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "proc_snapshot.h"
+
+typedef struct {
+    pid_t pid;
+    pid_t tgid;
+    pid_t ppid;
+    int threads;
+    long rss_kb;
+    char state;
+    char comm[16];
+    unsigned long long starttime;   // distingue un PID reutilizado
+    unsigned long minflt;
+    unsigned long majflt;
+    unsigned long vol_ctxt;         // solo con want_status
+    unsigned long nonvol_ctxt;
+} scan_entry_t;
+
+// Resultados de un worker: buffer propio, sin compartir durante el escaneo
+typedef struct {
+    scan_entry_t *entries;
+    size_t n;
+    size_t cap;
+} scan_bucket_t;
+
+struct proc_scanner;
+
+typedef struct {
+    struct proc_scanner *owner;
+    pthread_t thread;
+    unsigned index;
+    scan_bucket_t bucket;
+    proc_dir_buf_t dir;         // task/ de cada proceso con want_tasks
+    pid_t *tids;
+    size_t tids_cap;
+} scan_worker_t;
+
+// Pool persistente: los threads se crean una vez y se reutilizan en cada
+// escaneo, así repetir el escaneo cada segundo no paga pthread_create
+typedef struct proc_scanner {
+    scan_worker_t *workers;
+    unsigned nworkers;
+
+    // Lista de PIDs del escaneo actual (leída con getdents por el llamante)
+    proc_dir_buf_t dir;
+    pid_t *pids;
+    size_t pids_cap;
+    size_t npids;
+    size_t next;                // siguiente bloque a repartir (atómico)
+    int want_status;            // leer también status (cambios de contexto): un pread más por proceso
+    int want_tasks;             // una fila por thread (task/*) con TGID de su status
+
+    // Arranque/fin de cada ronda
+    pthread_mutex_t lock;
+    pthread_cond_t start_cv;
+    pthread_cond_t done_cv;
+    unsigned long generation;
+    unsigned pending;
+    int shutdown;
+
+    // Resultado combinado, ordenado por TGID y PID
+    scan_entry_t *entries;
+    size_t nentries;
+    size_t entries_cap;
+} proc_scanner_t;
+
+int  proc_scanner_init(proc_scanner_t *s, unsigned nworkers);
+int  proc_scanner_run(proc_scanner_t *s);        // 0 ok; resultado en s->entries
+void proc_scanner_free(proc_scanner_t *s);
+
+void proc_scan_print(const proc_scanner_t *s, const char *comm_filter);
+
+#endif // PROC_SCAN_H
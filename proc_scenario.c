@@ -0,0 +1,510 @@
+// proc_scenario.c - Árboles de procesos y threads a medida para medir qué
+// cuesta cada tarea al kernel y a las herramientas que leen /proc
+//
+// Nada de sleep para ordenar: cada tarea (threads principales incluidos)
+// suma 1 a un contador en memoria compartida cuando termina su preparación
+// y la última despierta a la raíz con un futex. Si un fork() o un
+// pthread_create falla, quien lo intentó suma por las tareas que no llegarán
+// a existir, así la barrera se completa igual. La parada es una escritura y
+// un FUTEX_WAKE para todas; cada proceso recoge a sus threads e hijos.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_pagemap.h"
+#include "proc_scan.h"
+#include "proc_scenario.h"
+#include "proc_footprint.h"
+#include "proc_snapshot.h"
+
+// Sin _PRIVATE: las palabras viven en MAP_SHARED y las esperan otros procesos
+static inline int futex_wait_shared(_Atomic uint32_t *addr, uint32_t expected, const struct timespec *ts) {
+    return (int)syscall(SYS_futex, addr, FUTEX_WAIT, expected, ts, NULL, 0);
+}
+
+static inline void futex_wake_shared(_Atomic uint32_t *addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+// ========== CONFIGURACIÓN ==========
+
+void scn_config_default(scn_config_t *cfg) {
+    cfg->depth = 1;
+    cfg->fanout = 10;
+    cfg->threads = 4;
+    cfg->private_kb = 256;
+    cfg->shared_kb = 1024;
+    cfg->cow_kb = 1024;
+    cfg->stack_kb = 64;
+    cfg->timeout_s = 120;
+}
+
+int scn_config_set(scn_config_t *cfg, const char *key, const char *value) {
+    char *end;
+    errno = 0;
+    long v = strtol(value, &end, 10);
+    if (errno || end == value || *end != '\0' || v < 0) return -1;
+    if (strcmp(key, "depth") == 0 && v >= 1 && v <= SCN_MAX_DEPTH) cfg->depth = (int)v;
+    else if (strcmp(key, "fanout") == 0 && v >= 1 && v <= (long)SCN_MAX_TASKS) cfg->fanout = (int)v;
+    else if (strcmp(key, "threads") == 0 && v >= 1 && v <= (long)SCN_MAX_TASKS) cfg->threads = (int)v;
+    else if (strcmp(key, "private_kb") == 0) cfg->private_kb = (size_t)v;
+    else if (strcmp(key, "shared_kb") == 0) cfg->shared_kb = (size_t)v;
+    else if (strcmp(key, "cow_kb") == 0) cfg->cow_kb = (size_t)v;
+    else if (strcmp(key, "stack_kb") == 0 && v >= 16) cfg->stack_kb = (size_t)v;     // PTHREAD_STACK_MIN
+    else if (strcmp(key, "timeout") == 0 && v >= 1) cfg->timeout_s = (int)v;
+    else return -1;
+    return 0;
+}
+
+int scn_config_parse_line(scn_config_t *cfg, const char *line) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", line);
+    buf[strcspn(buf, "#\n")] = '\0';
+    int defined = 0;
+    char *save;
+    for (char *t = strtok_r(buf, " \t,", &save); t; t = strtok_r(NULL, " \t,", &save)) {
+        char *eq = strchr(t, '=');
+        if (!eq) return -1;
+        *eq = '\0';
+        if (scn_config_set(cfg, t, eq + 1) < 0) return -1;
+        defined = 1;
+    }
+    return defined;
+}
+
+int scn_tree_size(const scn_config_t *cfg, uint64_t *procs, uint64_t *tasks) {
+    uint64_t level = 1, total = 0;
+    for (int d = 1; d <= cfg->depth; d++) {
+        level *= (uint64_t)cfg->fanout;
+        total += level;
+        if (total > SCN_MAX_TASKS) return -1;
+    }
+    if (total * (uint64_t)cfg->threads > SCN_MAX_TASKS) return -1;
+    *procs = total;
+    *tasks = total * (uint64_t)cfg->threads;
+    return 0;
+}
+
+// ========== LÍMITES DEL HOST ==========
+
+static long read_long(const char *path) {
+    proc_file_t f;
+    proc_file_init(&f);
+    long v = -1;
+    if (proc_file_load(&f, path) == 0) {
+        v = strncmp(f.buf, "max", 3) == 0 ? -1 : strtol(f.buf, NULL, 10);
+    }
+    proc_file_free(&f);
+    return v;
+}
+
+// pids.max del cgroup de este proceso: v2 ("0::/ruta") o v1 ("N:pids:/ruta")
+static void cgroup_pids(long *max, long *cur) {
+    *max = *cur = -1;
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, "/proc/self/cgroup") < 0) {
+        proc_file_free(&f);
+        return;
+    }
+    char path[512], cg[256];
+    for (char *line = strtok(f.buf, "\n"); line; line = strtok(NULL, "\n")) {
+        const char *base = NULL;
+        char *rest = NULL;
+        if (strncmp(line, "0::", 3) == 0) {
+            base = "/sys/fs/cgroup";
+            rest = line + 3;
+        } else if ((rest = strstr(line, ":pids:")) != NULL) {
+            base = "/sys/fs/cgroup/pids";
+            rest += 6;
+        }
+        if (!base) continue;
+        snprintf(cg, sizeof(cg), "%s", strcmp(rest, "/") == 0 ? "" : rest);
+        snprintf(path, sizeof(path), "%s%s/pids.max", base, cg);
+        long m = read_long(path);
+        snprintf(path, sizeof(path), "%s%s/pids.current", base, cg);
+        long c = read_long(path);
+        if (c >= 0) {
+            *max = m;
+            *cur = c;
+            break;
+        }
+    }
+    proc_file_free(&f);
+}
+
+void scn_limits_read(scn_limits_t *out) {
+    out->pid_max = read_long("/proc/sys/kernel/pid_max");
+    out->threads_max = read_long("/proc/sys/kernel/threads-max");
+    out->max_map_count = read_long("/proc/sys/vm/max_map_count");
+    struct rlimit rl;
+    out->nproc = getrlimit(RLIMIT_NPROC, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY ? (long)rl.rlim_cur : -1;
+    // root (CAP_SYS_RESOURCE) no está sujeto a RLIMIT_NPROC
+    if (geteuid() == 0) out->nproc = -1;
+    cgroup_pids(&out->cgroup_pids_max, &out->cgroup_pids_cur);
+
+    // "0.01 0.19 1.13 2/71 16269": ejecutables/total de tareas
+    out->tasks_now = -1;
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, "/proc/loadavg") == 0) {
+        char *slash = strchr(f.buf, '/');
+        if (slash) out->tasks_now = strtol(slash + 1, NULL, 10);
+    }
+    proc_file_free(&f);
+}
+
+long scn_limits_headroom(const scn_limits_t *l) {
+    long room = -1;
+    long now = l->tasks_now > 0 ? l->tasks_now : 0;
+    long caps[3] = {
+        l->pid_max > 0 ? l->pid_max - now : -1,     // pid_max cuenta PIDs (uno por tarea)
+        l->threads_max > 0 ? l->threads_max - now : -1,
+        l->cgroup_pids_max >= 0 ? l->cgroup_pids_max - l->cgroup_pids_cur : -1,
+    };
+    for (int i = 0; i < 3; i++) {
+        if (caps[i] >= 0 && (room < 0 || caps[i] < room)) room = caps[i];
+    }
+    // RLIMIT_NPROC cuenta las tareas del usuario, no las del sistema: cota aproximada
+    if (l->nproc >= 0 && (room < 0 || l->nproc - now < room)) room = l->nproc - now > 0 ? l->nproc - now : 0;
+    return room;
+}
+
+// ========== MEMORIA DEL KERNEL ==========
+
+// Lo que crea cada fork()/pthread_create (los stacks de kernel con
+// CONFIG_VMAP_STACK no son slab: salen en KernelStack)
+static const char *const slab_names[SCN_NSLABS] = {
+    "task_struct", "signal_cache", "sighand_cache", "pid", "files_cache", "fs_cache",
+    "mm_struct", "vm_area_struct", "maple_node", "anon_vma", "anon_vma_chain",
+};
+
+const char *scn_slab_name(int i) {
+    return i >= 0 && i < SCN_NSLABS ? slab_names[i] : "?";
+}
+
+static long meminfo_field(const proc_file_t *f, const char *key) {
+    size_t klen = strlen(key);
+    const char *p = f->buf;
+    const char *end = f->buf + f->len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        if ((size_t)(nl - p) > klen && memcmp(p, key, klen) == 0) return strtol(p + klen, NULL, 10);
+        p = nl + 1;
+    }
+    return 0;
+}
+
+int scn_kmem_read(scn_kmem_t *out) {
+    memset(out, 0, sizeof(*out));
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, "/proc/meminfo") < 0) {
+        proc_file_free(&f);
+        return -1;
+    }
+    out->kstack_kb = meminfo_field(&f, "KernelStack:");
+    out->pagetables_kb = meminfo_field(&f, "PageTables:");
+    out->sunreclaim_kb = meminfo_field(&f, "SUnreclaim:");
+
+    // "nombre activos num_objs objsize ...": con SLUB algunas cachés se
+    // fusionan y no aparecen. Solo legible como root
+    if (proc_file_load(&f, "/proc/slabinfo") == 0) {
+        out->slab_readable = 1;
+        const char *p = f.buf;
+        const char *end = f.buf + f.len;
+        while (p < end) {
+            const char *nl = memchr(p, '\n', (size_t)(end - p));
+            if (!nl) nl = end;
+            char name[64];
+            long active, num, objsize;
+            if (sscanf(p, "%63s %ld %ld %ld", name, &active, &num, &objsize) == 4) {
+                for (int i = 0; i < SCN_NSLABS; i++) {
+                    if (strcmp(name, slab_names[i]) == 0) {
+                        out->slab_objs[i] = active;
+                        out->slab_kb[i] = active * objsize / 1024;
+                    }
+                }
+            }
+            p = nl + 1;
+        }
+    }
+    proc_file_free(&f);
+    return 0;
+}
+
+static void kmem_diff(const scn_kmem_t *a, const scn_kmem_t *b, scn_kmem_t *out) {
+    out->kstack_kb = b->kstack_kb - a->kstack_kb;
+    out->pagetables_kb = b->pagetables_kb - a->pagetables_kb;
+    out->sunreclaim_kb = b->sunreclaim_kb - a->sunreclaim_kb;
+    out->slab_readable = a->slab_readable && b->slab_readable;
+    for (int i = 0; i < SCN_NSLABS; i++) {
+        out->slab_objs[i] = b->slab_objs[i] - a->slab_objs[i];
+        out->slab_kb[i] = b->slab_kb[i] - a->slab_kb[i];
+    }
+}
+
+// ========== ÁRBOL ==========
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t arrived;      // tareas preparadas + las que no llegarán a existir
+    _Atomic uint32_t tasks;                     // solo las que existen
+    _Atomic uint32_t nprocs;
+    _Atomic uint32_t failed_forks;
+    _Atomic uint32_t failed_threads;
+    _Atomic int first_errno;
+    uint32_t expected;
+    uint64_t ready_ns;                          // cuándo llegó la última
+    _Alignas(64) _Atomic uint32_t all_in;       // futex: la raíz espera aquí
+    _Alignas(64) _Atomic uint32_t release;      // futex: todas esperan aquí
+    pid_t pids[];                               // procesos del árbol (para smaps_rollup)
+} scn_shared_t;
+
+// Heredado por fork(): lo fija la raíz antes de crear el árbol
+static scn_shared_t *g_sh;
+static const scn_config_t *g_cfg;
+static const volatile uint8_t *g_cow, *g_shared;
+static uint64_t g_subtree[SCN_MAX_DEPTH + 2];   // tareas del subárbol de un proceso de cada nivel
+
+static void scn_arrive(uint32_t n) {
+    scn_shared_t *sh = g_sh;
+    if (atomic_fetch_add_explicit(&sh->arrived, n, memory_order_acq_rel) + n == sh->expected) {
+        sh->ready_ns = now_ns();
+        atomic_store_explicit(&sh->all_in, 1, memory_order_release);
+        futex_wake_shared(&sh->all_in, 1);
+    }
+}
+
+static void scn_failed(_Atomic uint32_t *counter, int err, uint32_t missing) {
+    int zero = 0;
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+    atomic_compare_exchange_strong(&g_sh->first_errno, &zero, err);
+    scn_arrive(missing);
+}
+
+static void scn_wait_release(void) {
+    uint32_t w;
+    while ((w = atomic_load_explicit(&g_sh->release, memory_order_acquire)) == 0) {
+        futex_wait_shared(&g_sh->release, w, NULL);
+    }
+}
+
+static void *scn_thread(void *arg) {
+    (void)arg;
+    atomic_fetch_add_explicit(&g_sh->tasks, 1, memory_order_relaxed);
+    scn_arrive(1);
+    scn_wait_release();
+    return NULL;
+}
+
+static void scn_process(int level) __attribute__((noreturn));
+
+static void touch_read(const volatile uint8_t *p, size_t kb) {
+    uint8_t sum = 0;
+    for (size_t off = 0; off < kb * 1024; off += 4096) sum += p[off];
+    (void)sum;
+}
+
+// Hijos de un proceso de nivel level (la raíz es el nivel 0); devuelve cuántos arrancaron
+static int scn_spawn_children(int level, pid_t *kids) {
+    int n = 0;
+    for (int i = 0; i < g_cfg->fanout; i++) {
+        pid_t pid = fork();
+        if (pid == 0) scn_process(level + 1);
+        if (pid < 0) {
+            scn_failed(&g_sh->failed_forks, errno, (uint32_t)g_subtree[level + 1]);
+            continue;
+        }
+        kids[n++] = pid;
+    }
+    return n;
+}
+
+static void scn_process(int level) {
+    // Si la raíz muere (Ctrl+C) el árbol no queda bloqueado para siempre
+    pid_t parent = getppid();
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parent) _exit(1);
+    char name[16];      // TASK_COMM_LEN; level <= SCN_MAX_DEPTH
+    snprintf(name, sizeof(name), "scn-L%u", (unsigned)level & 0xff);
+    prctl(PR_SET_NAME, name);
+
+    uint32_t slot = atomic_fetch_add_explicit(&g_sh->nprocs, 1, memory_order_relaxed);
+    g_sh->pids[slot] = getpid();
+    atomic_fetch_add_explicit(&g_sh->tasks, 1, memory_order_relaxed);
+
+    // Datos privados (páginas propias), compartidos (shmem) y heredados sin escribir (COW)
+    if (g_cfg->private_kb) {
+        void *p = mmap(NULL, g_cfg->private_kb * 1024, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) memset(p, level, g_cfg->private_kb * 1024);
+    }
+    if (g_shared) touch_read(g_shared, g_cfg->shared_kb);
+    if (g_cow) touch_read(g_cow, g_cfg->cow_kb);
+
+    // Hijos antes que threads: fork() desde un proceso con un solo thread
+    pid_t *kids = level < g_cfg->depth ? calloc((size_t)g_cfg->fanout, sizeof(*kids)) : NULL;
+    int nkids = kids ? scn_spawn_children(level, kids) : 0;
+    if (!kids && level < g_cfg->depth) {
+        // Los subárboles que no se crean llegan igualmente: la raíz no espera al timeout
+        scn_failed(&g_sh->failed_forks, ENOMEM, (uint32_t)(g_subtree[level + 1] * (uint64_t)g_cfg->fanout));
+    }
+
+    int extra = g_cfg->threads - 1;
+    pthread_t *th = extra > 0 ? calloc((size_t)extra, sizeof(*th)) : NULL;
+    int nth = 0;
+    if (th) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, g_cfg->stack_kb * 1024);
+        for (int i = 0; i < extra; i++) {
+            int err = pthread_create(&th[nth], &attr, scn_thread, NULL);
+            if (err) scn_failed(&g_sh->failed_threads, err, 1);
+            else nth++;
+        }
+        pthread_attr_destroy(&attr);
+    } else if (extra > 0) {
+        for (int i = 0; i < extra; i++) scn_failed(&g_sh->failed_threads, ENOMEM, 1);
+    }
+
+    scn_arrive(1);
+    scn_wait_release();
+
+    for (int i = 0; i < nth; i++) pthread_join(th[i], NULL);
+    for (int i = 0; i < nkids; i++) waitpid(kids[i], NULL, 0);
+    _exit(0);
+}
+
+// Mejor de 3 escaneos con el pool (creado y destruido aquí: fuera de este
+// rato la raíz no tiene más threads que el principal)
+static double scan_best(unsigned workers, size_t *n) {
+    proc_scanner_t sc;
+    *n = 0;
+    if (proc_scanner_init(&sc, workers) < 0) return -1;
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < 3; r++) {
+        uint64_t t0 = now_ns();
+        if (proc_scanner_run(&sc) < 0) break;
+        uint64_t dt = now_ns() - t0;
+        if (dt < best) best = dt;
+        *n = sc.nentries;
+    }
+    proc_scanner_free(&sc);
+    return best == UINT64_MAX ? -1 : best / 1e6;
+}
+
+int scn_run(const scn_config_t *cfg, unsigned scan_workers, scn_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (scn_tree_size(cfg, &out->expected_procs, &out->expected_tasks) < 0) {
+        errno = E2BIG;
+        return -1;
+    }
+    g_subtree[cfg->depth + 1] = 0;
+    for (int d = cfg->depth; d >= 1; d--) {
+        g_subtree[d] = (uint64_t)cfg->threads + (uint64_t)cfg->fanout * g_subtree[d + 1];
+    }
+
+    size_t sh_size = sizeof(scn_shared_t) + out->expected_procs * sizeof(pid_t);
+    scn_shared_t *sh = mmap(NULL, sh_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *kids = calloc((size_t)cfg->fanout, sizeof(*kids));
+    uint8_t *cow = cfg->cow_kb ? mmap(NULL, cfg->cow_kb * 1024, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : NULL;
+    uint8_t *shared = cfg->shared_kb ? mmap(NULL, cfg->shared_kb * 1024, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_ANONYMOUS, -1, 0) : NULL;
+    if (sh == MAP_FAILED || !kids || cow == MAP_FAILED || shared == MAP_FAILED) {
+        if (sh != MAP_FAILED) munmap(sh, sh_size);
+        if (cow && cow != MAP_FAILED) munmap(cow, cfg->cow_kb * 1024);
+        if (shared && shared != MAP_FAILED) munmap(shared, cfg->shared_kb * 1024);
+        free(kids);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (cow) memset(cow, 0x5a, cfg->cow_kb * 1024);
+    if (shared) memset(shared, 0xa5, cfg->shared_kb * 1024);
+    sh->expected = (uint32_t)out->expected_tasks;
+    g_sh = sh;
+    g_cfg = cfg;
+    g_cow = cow;
+    g_shared = shared;
+
+    // Línea base con las regiones de la raíz ya creadas
+    out->scan_base_ms = scan_best(scan_workers, &out->scan_base_n);
+    scn_kmem_t before, after;
+    scn_kmem_read(&before);
+
+    uint64_t t0 = now_ns();
+    int nkids = scn_spawn_children(0, kids);
+
+    // Barrera: la última tarea pone all_in; el plazo solo cubre hijos muertos
+    // por el OOM killer o similares, que nunca llegarían
+    uint64_t deadline = t0 + (uint64_t)cfg->timeout_s * 1000000000ull;
+    uint32_t w;
+    while ((w = atomic_load_explicit(&sh->all_in, memory_order_acquire)) == 0) {
+        uint64_t now = now_ns();
+        if (now >= deadline) {
+            out->timed_out = 1;
+            break;
+        }
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = 100000000 };
+        futex_wait_shared(&sh->all_in, w, &ts);
+    }
+    out->setup_ms = ((out->timed_out ? now_ns() : sh->ready_ns) - t0) / 1e6;
+    out->procs = atomic_load(&sh->nprocs);
+    out->tasks = atomic_load(&sh->tasks);
+    out->failed_forks = atomic_load(&sh->failed_forks);
+    out->failed_threads = atomic_load(&sh->failed_threads);
+    out->first_errno = atomic_load(&sh->first_errno);
+
+    // Con todo el árbol bloqueado en el futex: nada cambia mientras se mide
+    scn_kmem_read(&after);
+    kmem_diff(&before, &after, &out->kmem);
+
+    uint64_t tp = now_ns();
+    for (uint32_t i = 0; i < out->procs && i < out->expected_procs; i++) {
+        smaps_rollup_t r;
+        if (smaps_rollup_read(sh->pids[i], &r) < 0) continue;
+        out->rss_kb += r.rss_kb;
+        out->pss_kb += r.pss_kb;
+        out->uss_kb += r.private_clean_kb + r.private_dirty_kb;
+    }
+    out->pss_ms = (now_ns() - tp) / 1e6;
+
+    // Comprobación de --footprint: recorre el árbol desde la raíz sin conocer
+    // los PIDs y debe encontrar todos los procesos creados
+    fp_tree_t ft;
+    if (fp_tree_measure(&ft, getpid()) == 0) {
+        for (size_t i = 1; i < ft.n; i++) out->fp_procs += ft.procs[i].ok;
+        fp_tree_free(&ft);
+    }
+
+    out->scan_ms = scan_best(scan_workers, &out->scan_n);
+
+    // Parada: una escritura y un FUTEX_WAKE para todas las tareas del árbol
+    uint64_t ts = now_ns();
+    atomic_store_explicit(&sh->release, 1, memory_order_release);
+    futex_wake_shared(&sh->release, INT_MAX);
+    for (int i = 0; i < nkids; i++) waitpid(kids[i], NULL, 0);
+    out->teardown_ms = (now_ns() - ts) / 1e6;
+
+    g_sh = NULL;
+    munmap(sh, sh_size);
+    if (cow) munmap(cow, cfg->cow_kb * 1024);
+    if (shared) munmap(shared, cfg->shared_kb * 1024);
+    free(kids);
+    return out->tasks == out->expected_tasks && !out->timed_out ? 0 : -1;
+}
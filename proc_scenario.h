@@ -0,0 +1,95 @@
+// proc_scenario.h - Generador de escenarios: árboles de procesos con N hijos
+// por nivel y M threads por proceso, sincronizados con una barrera en memoria
+// compartida, y lo que cuestan al kernel, en memoria y al escanear /proc
+#ifndef PROC_SCENARIO_H
+#define PROC_SCENARIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define SCN_MAX_DEPTH   16
+#define SCN_MAX_TASKS   (4u << 20)      // tope del generador (por encima de cualquier pid_max habitual)
+#define SCN_NSLABS      11              // cachés de /proc/slabinfo que se siguen
+
+// Un escenario. En archivo: una línea por escenario con pares clave=valor
+// ("depth=2 fanout=100 threads=10 private_kb=64"), '#' para comentarios.
+typedef struct {
+    int depth;                  // niveles de procesos bajo la raíz (1 = solo hijos)
+    int fanout;                 // hijos de cada proceso
+    int threads;                // threads por proceso, contando el principal
+    size_t private_kb;          // escritos por cada proceso en memoria propia
+    size_t shared_kb;           // MAP_SHARED creado en la raíz y leído por todos
+    size_t cow_kb;              // escritos por la raíz antes de fork() y solo leídos (COW intacto)
+    size_t stack_kb;            // stack de los threads extra
+    int timeout_s;              // espera máxima de la barrera de preparación
+} scn_config_t;
+
+void scn_config_default(scn_config_t *cfg);
+
+// Aplica "clave=valor" (o clave y valor por separado); -1 si no existe o no es válido
+int  scn_config_set(scn_config_t *cfg, const char *key, const char *value);
+
+// Línea de un archivo de escenarios: 1 si definió un escenario, 0 si está
+// vacía o es comentario, -1 si tiene una clave inválida
+int  scn_config_parse_line(scn_config_t *cfg, const char *line);
+
+// Procesos y tareas (threads) del árbol; -1 si supera SCN_MAX_TASKS
+int  scn_tree_size(const scn_config_t *cfg, uint64_t *procs, uint64_t *tasks);
+
+// ========== LÍMITES DEL HOST ==========
+
+typedef struct {
+    long pid_max;               // kernel.pid_max
+    long threads_max;           // kernel.threads-max
+    long max_map_count;         // vm.max_map_count: cada thread extra son 2 mapeos (stack + guarda)
+    long nproc;                 // RLIMIT_NPROC (-1 = ilimitado)
+    long cgroup_pids_max;       // pids.max del cgroup (-1 = sin límite o sin controlador)
+    long cgroup_pids_cur;
+    long tasks_now;             // tareas del sistema ahora (/proc/loadavg)
+} scn_limits_t;
+
+void scn_limits_read(scn_limits_t *out);
+
+// Tareas que aún caben: el menor de los límites menos lo ya usado (-1 = sin tope conocido)
+long scn_limits_headroom(const scn_limits_t *l);
+
+// ========== EJECUCIÓN ==========
+
+// Memoria del kernel: /proc/meminfo (legible siempre) y /proc/slabinfo (root)
+typedef struct {
+    long kstack_kb;             // KernelStack: stacks de kernel de cada tarea
+    long pagetables_kb;
+    long sunreclaim_kb;         // slab no recuperable (task_struct, mm_struct, ...)
+    int slab_readable;
+    long slab_objs[SCN_NSLABS];
+    long slab_kb[SCN_NSLABS];   // active_objs * objsize
+} scn_kmem_t;
+
+const char *scn_slab_name(int i);
+
+int scn_kmem_read(scn_kmem_t *out);
+
+typedef struct {
+    uint64_t expected_procs, expected_tasks;
+    uint64_t procs, tasks;          // los que llegaron a la barrera
+    uint32_t failed_forks, failed_threads;
+    int first_errno;                // de la primera fork()/pthread_create que falló
+    int timed_out;                  // la barrera no se completó a tiempo
+    double setup_ms;                // primer fork() → última tarea en la barrera
+    double teardown_ms;             // un FUTEX_WAKE → último waitpid
+    scn_kmem_t kmem;                // diferencia con el árbol arrancado
+    // smaps_rollup de cada proceso del árbol
+    uint64_t rss_kb, pss_kb, uss_kb;
+    double pss_ms;                  // leerlos todos
+    uint64_t fp_procs;              // procesos que fp_tree_measure encontró bajo la raíz (sin ella)
+    // Escaneo de /proc con el pool de proc_scan (mejor de 3)
+    size_t scan_base_n, scan_n;
+    double scan_base_ms, scan_ms;
+} scn_result_t;
+
+// Crea el árbol, espera a que todas las tareas lleguen a la barrera, mide
+// y lo para con una sola escritura + FUTEX_WAKE. 0 si se creó entero.
+int scn_run(const scn_config_t *cfg, unsigned scan_workers, scn_result_t *out);
+
+#endif // PROC_SCENARIO_H
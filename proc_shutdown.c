@@ -0,0 +1,351 @@
+// proc_shutdown.c - Avisos entre procesos y parada en paralelo de hijos y threads
+//
+// La parada clásica (kill + waitpid por hijo, pthread_cancel + join por thread)
+// es serie: cada waitpid espera a que ese hijo salga y a que el planificador
+// lo ejecute antes de avisar al siguiente, así que N hijos cuestan N latencias
+// de despertar y salida seguidas. Si todas las órdenes salen primero (o en
+// una sola syscall: kill(-pgid) o un FUTEX_WAKE sobre una palabra compartida)
+// los hijos terminan a la vez y lo que queda es recoger.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "proc_common.h"
+#include "proc_shutdown.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+// Sin _PRIVATE: las palabras viven en MAP_SHARED y las esperan otros procesos
+static inline void futex_wait_shared(_Atomic uint32_t *addr, uint32_t expected) {
+    syscall(SYS_futex, addr, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+static inline void futex_wake_shared(_Atomic uint32_t *addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+int sd_pidfd_open(pid_t pid) {
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+int sd_pidfd_send_signal(int pidfd, int sig) {
+    return (int)syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+}
+
+int sd_wait_signals(const int *sigs, int nsigs) {
+    sigset_t set;
+    sigemptyset(&set);
+    for (int i = 0; i < nsigs; i++) sigaddset(&set, sigs[i]);
+    // Bloqueadas: si llegan antes del read quedan pendientes y el signalfd las entrega
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    int fd = signalfd(-1, &set, SFD_CLOEXEC);
+    if (fd < 0) return -1;
+    struct signalfd_siginfo si;
+    ssize_t n;
+    do {
+        n = read(fd, &si, sizeof(si));
+    } while (n < 0 && errno == EINTR);
+    close(fd);
+    return n == (ssize_t)sizeof(si) ? (int)si.ssi_signo : -1;
+}
+
+// ========== LATENCIA POR MECANISMO ==========
+
+static const char *const mech_names[SD_NMECH] = {
+    "kill → handler", "tgkill → sigwaitinfo", "pidfd_send_signal → signalfd",
+    "futex compartido", "eventfd",
+};
+
+const char *sd_mech_name(sd_mech_t mech) {
+    return mech < SD_NMECH ? mech_names[mech] : "?";
+}
+
+// Página compartida padre/hijo
+typedef struct {
+    _Alignas(64) _Atomic uint64_t t_wake;   // cuándo volvió a correr el hijo
+    _Atomic uint32_t ack;                   // último aviso atendido
+    _Atomic uint32_t ready;
+    _Alignas(64) _Atomic uint32_t word;     // palabra futex: nº de avisos enviados
+} wake_shared_t;
+
+static wake_shared_t *handler_shared;
+
+static void wake_handler(int sig) {
+    (void)sig;
+    atomic_store_explicit(&handler_shared->t_wake, now_ns(), memory_order_relaxed);
+}
+
+static void wake_child(sd_mech_t mech, wake_shared_t *sh, int efd) {
+    sigset_t set, old;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &set, &old);
+    int sfd = -1;
+    if (mech == SD_KILL_HANDLER) {
+        handler_shared = sh;
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = wake_handler;
+        sigaction(SIGUSR1, &sa, NULL);
+        sigdelset(&old, SIGUSR1);   // máscara de sigsuspend: SIGUSR1 solo se entrega dentro
+    } else if (mech == SD_PIDFD_SIGNALFD) {
+        sfd = signalfd(-1, &set, SFD_CLOEXEC);
+    }
+    atomic_store_explicit(&sh->ready, 1, memory_order_release);
+
+    for (uint32_t i = 1;; i++) {
+        uint64_t t = 0;
+        switch (mech) {
+        case SD_KILL_HANDLER:
+            // sigsuspend y no pause(): sin ventana entre comprobar y dormir
+            sigsuspend(&old);
+            t = atomic_load_explicit(&sh->t_wake, memory_order_relaxed);
+            break;
+        case SD_TGKILL_SIGWAIT:
+            while (sigwaitinfo(&set, NULL) < 0 && errno == EINTR) {}
+            t = now_ns();
+            break;
+        case SD_PIDFD_SIGNALFD: {
+            struct signalfd_siginfo si;
+            while (read(sfd, &si, sizeof(si)) < 0 && errno == EINTR) {}
+            t = now_ns();
+            break;
+        }
+        case SD_FUTEX: {
+            uint32_t w;
+            while ((w = atomic_load_explicit(&sh->word, memory_order_acquire)) < i) futex_wait_shared(&sh->word, w);
+            t = now_ns();
+            break;
+        }
+        case SD_EVENTFD: {
+            uint64_t v;
+            while (read(efd, &v, sizeof(v)) < 0 && errno == EINTR) {}
+            t = now_ns();
+            break;
+        }
+        default:
+            _exit(1);
+        }
+        atomic_store_explicit(&sh->t_wake, t, memory_order_relaxed);
+        atomic_store_explicit(&sh->ack, i, memory_order_release);
+    }
+}
+
+int sd_wake_bench(sd_mech_t mech, unsigned long iters, lat_hist_t *lat) {
+    wake_shared_t *sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) return -1;
+    int efd = mech == SD_EVENTFD ? eventfd(0, EFD_CLOEXEC) : -1;
+    if (mech == SD_EVENTFD && efd < 0) {
+        munmap(sh, sizeof(*sh));
+        return -1;
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        if (efd >= 0) close(efd);
+        munmap(sh, sizeof(*sh));
+        return -1;
+    }
+    if (child == 0) wake_child(mech, sh, efd);
+
+    int pidfd = mech == SD_PIDFD_SIGNALFD ? sd_pidfd_open(child) : -1;
+    int err = mech == SD_PIDFD_SIGNALFD && pidfd < 0 ? errno : 0;
+    while (!err && !atomic_load_explicit(&sh->ready, memory_order_acquire)) sched_yield();
+
+    for (uint32_t i = 1; !err && i <= iters; i++) {
+        uint64_t t0 = now_ns();
+        int rc = 0;
+        switch (mech) {
+        case SD_KILL_HANDLER:   rc = kill(child, SIGUSR1); break;
+        case SD_TGKILL_SIGWAIT: rc = (int)syscall(SYS_tgkill, child, child, SIGUSR1); break;
+        case SD_PIDFD_SIGNALFD: rc = sd_pidfd_send_signal(pidfd, SIGUSR1); break;
+        case SD_FUTEX:
+            atomic_store_explicit(&sh->word, i, memory_order_release);
+            futex_wake_shared(&sh->word, 1);
+            break;
+        case SD_EVENTFD: {
+            uint64_t one = 1;
+            rc = write(efd, &one, sizeof(one)) == sizeof(one) ? 0 : -1;
+            break;
+        }
+        default:
+            rc = -1;
+            errno = EINVAL;
+        }
+        if (rc < 0) {
+            err = errno;
+            break;
+        }
+        // Una CPU: ceder deja correr al hijo; con varias es casi un sondeo
+        while (atomic_load_explicit(&sh->ack, memory_order_acquire) < i) sched_yield();
+        uint64_t t = atomic_load_explicit(&sh->t_wake, memory_order_relaxed);
+        lat_hist_record(lat, t > t0 ? t - t0 : 0);
+    }
+
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    if (pidfd >= 0) close(pidfd);
+    if (efd >= 0) close(efd);
+    munmap(sh, sizeof(*sh));
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// ========== PARADA DE UN POOL PREFORK ==========
+
+static const char *const stop_names[SD_NSTOP] = {
+    "serie (kill+waitpid)", "paralelo", "grupo (kill -pgid)", "futex compartido",
+};
+
+const char *sd_stop_name(sd_stop_t how) {
+    return how < SD_NSTOP ? stop_names[how] : "?";
+}
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t ready;
+    _Alignas(64) _Atomic uint32_t stop;     // palabra futex de SD_STOP_FUTEX
+} stop_shared_t;
+
+static _Atomic uint32_t thread_stop;
+static _Atomic uint32_t threads_ready;
+
+static void *stop_thread(void *arg) {
+    sd_stop_t how = (sd_stop_t)(intptr_t)arg;
+    atomic_fetch_add(&threads_ready, 1);
+    if (how == SD_STOP_SERIAL || how == SD_STOP_PARALLEL) {
+        for (;;) pause();   // punto de cancelación
+    }
+    uint32_t w;
+    while ((w = atomic_load(&thread_stop)) == 0) {
+        syscall(SYS_futex, &thread_stop, FUTEX_WAIT_PRIVATE, w, NULL, NULL, 0);
+    }
+    return NULL;
+}
+
+static void stop_child(sd_stop_t how, stop_shared_t *sh) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGTERM);
+    sigprocmask(SIG_UNBLOCK, &set, NULL);
+    signal(SIGTERM, SIG_DFL);
+    atomic_fetch_add_explicit(&sh->ready, 1, memory_order_release);
+    if (how != SD_STOP_FUTEX) {
+        for (;;) pause();   // SIGTERM con la acción por defecto los termina
+    }
+    uint32_t w;
+    while ((w = atomic_load_explicit(&sh->stop, memory_order_acquire)) == 0) futex_wait_shared(&sh->stop, w);
+    _exit(0);
+}
+
+int sd_stop_bench(sd_stop_t how, int nchildren, int nthreads, sd_stop_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    stop_shared_t *sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *pids = calloc((size_t)(nchildren > 0 ? nchildren : 1), sizeof(*pids));
+    pthread_t *th = calloc((size_t)(nthreads > 0 ? nthreads : 1), sizeof(*th));
+    if (sh == MAP_FAILED || !pids || !th) {
+        if (sh != MAP_FAILED) munmap(sh, sizeof(*sh));
+        free(pids);
+        free(th);
+        errno = ENOMEM;
+        return -1;
+    }
+    atomic_store(&thread_stop, 0);
+    atomic_store(&threads_ready, 0);
+
+    // Hijos antes que threads: fork() desde un proceso con un solo thread
+    uint64_t t_spawn = now_ns();
+    pid_t pgid = 0;
+    for (; out->children < nchildren; out->children++) {
+        pid_t pid = fork();
+        if (pid < 0) break;
+        if (pid == 0) {
+            if (how == SD_STOP_PGROUP) setpgid(0, pgid);
+            stop_child(how, sh);
+        }
+        // También desde el padre: el grupo existe antes de que el hijo corra
+        if (how == SD_STOP_PGROUP) {
+            setpgid(pid, pgid);
+            if (!pgid) pgid = pid;
+        }
+        pids[out->children] = pid;
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 64 << 10);
+    for (; out->threads < nthreads; out->threads++) {
+        if (pthread_create(&th[out->threads], &attr, stop_thread, (void *)(intptr_t)how) != 0) break;
+    }
+    pthread_attr_destroy(&attr);
+    while (atomic_load_explicit(&sh->ready, memory_order_acquire) < (uint32_t)out->children ||
+           atomic_load(&threads_ready) < (uint32_t)out->threads) {
+        usleep(1000);
+    }
+    usleep(10000);  // que todos lleguen a bloquearse
+    out->spawn_ms = (now_ns() - t_spawn) / 1e6;
+
+    uint64_t t0 = now_ns(), t_children, t_threads;
+    switch (how) {
+    case SD_STOP_SERIAL:
+        for (int i = 0; i < out->children; i++) {
+            kill(pids[i], SIGTERM);
+            waitpid(pids[i], NULL, 0);
+        }
+        t_children = now_ns();
+        for (int i = 0; i < out->threads; i++) {
+            pthread_cancel(th[i]);
+            pthread_join(th[i], NULL);
+        }
+        t_threads = now_ns();
+        break;
+    default:
+        // Todas las órdenes primero; hijos y threads terminan a la vez
+        if (how == SD_STOP_PARALLEL) {
+            for (int i = 0; i < out->children; i++) kill(pids[i], SIGTERM);
+            for (int i = 0; i < out->threads; i++) pthread_cancel(th[i]);
+        } else {
+            if (how == SD_STOP_PGROUP && out->children > 0) kill(-pgid, SIGTERM);
+            if (how == SD_STOP_FUTEX) {
+                atomic_store_explicit(&sh->stop, 1, memory_order_release);
+                futex_wake_shared(&sh->stop, INT_MAX);
+            }
+            atomic_store(&thread_stop, 1);
+            syscall(SYS_futex, &thread_stop, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+        }
+        for (int i = 0; i < out->children; i++) waitpid(pids[i], NULL, 0);
+        t_children = now_ns();
+        for (int i = 0; i < out->threads; i++) pthread_join(th[i], NULL);
+        t_threads = now_ns();
+        break;
+    }
+    out->children_ms = (t_children - t0) / 1e6;
+    out->threads_ms = (t_threads - t0) / 1e6;
+    out->stop_ms = ((t_threads > t_children ? t_threads : t_children) - t0) / 1e6;
+
+    munmap(sh, sizeof(*sh));
+    free(pids);
+    free(th);
+    return out->children < nchildren || out->threads < nthreads ? -1 : 0;
+}
@@ -0,0 +1,64 @@
+// proc_shutdown.h - Latencia de cada mecanismo de aviso (señales, futex, eventfd)
+// y parada de muchos hijos y threads en paralelo en lugar de uno a uno
+#ifndef PROC_SHUTDOWN_H
+#define PROC_SHUTDOWN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "lat_hist.h"
+
+// ========== AVISO A UN PROCESO ==========
+
+int sd_pidfd_open(pid_t pid);                       // -1 si el kernel no tiene pidfd (< 5.3)
+int sd_pidfd_send_signal(int pidfd, int sig);       // sin carrera con la reutilización del PID
+
+// Bloquea sigs en el thread que llama y espera a que llegue una: signalfd en
+// lugar de pause(), sin handler ni la ventana entre comprobar y dormir (las
+// que lleguen antes quedan pendientes). Devuelve la señal o -1.
+int sd_wait_signals(const int *sigs, int nsigs);
+
+// ========== LATENCIA POR MECANISMO ==========
+
+typedef enum {
+    SD_KILL_HANDLER = 0,        // kill → handler durante sigsuspend (el patrón de pause())
+    SD_TGKILL_SIGWAIT,          // tgkill → sigwaitinfo
+    SD_PIDFD_SIGNALFD,          // pidfd_send_signal → read(signalfd)
+    SD_FUTEX,                   // FUTEX_WAKE sobre una palabra en memoria compartida
+    SD_EVENTFD,                 // write → read(eventfd) heredado por fork()
+    SD_NMECH,
+} sd_mech_t;
+
+const char *sd_mech_name(sd_mech_t mech);
+
+// Hace fork() de un hijo que espera con mech; iters veces: el padre anota el
+// instante, avisa y espera el acuse. En lat queda envío → el hijo corre.
+int sd_wake_bench(sd_mech_t mech, unsigned long iters, lat_hist_t *lat);
+
+// ========== PARADA DE UN POOL PREFORK ==========
+
+typedef enum {
+    SD_STOP_SERIAL = 0,         // kill + waitpid por hijo, pthread_cancel + join por thread
+    SD_STOP_PARALLEL,           // todas las señales/cancel primero, luego se recoge
+    SD_STOP_PGROUP,             // kill(-pgid): una syscall para todos los hijos
+    SD_STOP_FUTEX,              // una palabra compartida + un FUTEX_WAKE para todos
+    SD_NSTOP,
+} sd_stop_t;
+
+const char *sd_stop_name(sd_stop_t how);
+
+typedef struct {
+    int children;               // hijos que llegaron a arrancar
+    int threads;
+    double spawn_ms;            // crear hijos y threads (no cuenta en la parada)
+    double stop_ms;             // desde la orden hasta el último waitpid/join
+    double children_ms;         // hasta recoger el último hijo
+    double threads_ms;          // hasta el join del último thread
+} sd_stop_result_t;
+
+// Arranca nchildren hijos (bloqueados como en un pool prefork) y nthreads
+// threads en este proceso, y los para todos con how
+int sd_stop_bench(sd_stop_t how, int nchildren, int nthreads, sd_stop_result_t *out);
+
+#endif // PROC_SHUTDOWN_H
@@ -0,0 +1,534 @@
+// proc_snapshot.c - Lectura de /proc sin fork/exec
+//
+// Sustituye a system("cat ... | grep"), system("ps -eLf | grep") y
+// system("pstree -p") en proc_analysis.c. Cada archivo se lee con pread()
+// sobre un buffer que se reutiliza entre snapshots: sin procesos hijos, sin
+// stdio y sin recorrer todas las tareas del host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+
+#define PROC_FILE_INITIAL_CAP 4096
+#define PROC_DIR_BUF_CAP      32768
+
+// ========== ARCHIVO DE /proc REUTILIZABLE ==========
+
+void proc_file_init(proc_file_t *f) {
+    f->fd = -1;
+    f->buf = NULL;
+    f->cap = 0;
+    f->len = 0;
+}
+
+int proc_file_open(proc_file_t *f, const char *path) {
+    if (f->fd >= 0) close(f->fd);
+    f->fd = open(path, O_RDONLY | O_CLOEXEC);
+    return f->fd < 0 ? -1 : 0;
+}
+
+ssize_t proc_file_read(proc_file_t *f) {
+    if (f->fd < 0) return -1;
+    if (!f->buf) {
+        f->cap = PROC_FILE_INITIAL_CAP;
+        f->buf = malloc(f->cap);
+        if (!f->buf) return -1;
+    }
+
+    // Muchos archivos de /proc son seq_file: cada read() entrega como mucho
+    // una página aunque quede más (task/*/children, smaps, numa_maps,
+    // slabinfo). Un read corto no es el final: seguir hasta que devuelva 0,
+    // duplicando el buffer cuando se llena.
+    size_t len = 0;
+    for (;;) {
+        if (len == f->cap - 1) {
+            char *bigger = realloc(f->buf, f->cap * 2);
+            if (!bigger) return -1;
+            f->buf = bigger;
+            f->cap *= 2;
+        }
+        ssize_t n = pread(f->fd, f->buf + len, f->cap - 1 - len, (off_t)len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+    }
+    f->len = len;
+    f->buf[len] = '\0';
+    return (ssize_t)len;
+}
+
+int proc_file_load(proc_file_t *f, const char *path) {
+    if (proc_file_open(f, path) < 0) return -1;
+    ssize_t n = proc_file_read(f);
+    proc_file_close(f);
+    return n < 0 ? -1 : 0;
+}
+
+void proc_file_close(proc_file_t *f) {
+    if (f->fd >= 0) close(f->fd);
+    f->fd = -1;
+}
+
+void proc_file_free(proc_file_t *f) {
+    proc_file_close(f);
+    free(f->buf);
+    f->buf = NULL;
+    f->cap = 0;
+    f->len = 0;
+}
+
+int proc_task_sp(pid_t pid, pid_t tid, proc_file_t *f, uintptr_t *sp) {
+    char path[96];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/syscall", pid, tid);
+    if (proc_file_load(f, path) < 0 || f->len == 0 || f->buf[0] == 'r') return -1;
+    const char *tok[9];
+    int ntok = 0;
+    const char *p = f->buf;
+    const char *e = f->buf + f->len;
+    while (p < e && ntok < 9) {
+        while (p < e && (*p == ' ' || *p == '\n')) p++;
+        if (p < e) tok[ntok++] = p;
+        while (p < e && *p != ' ' && *p != '\n') p++;
+    }
+    if (ntok < 3) return -1;
+    *sp = (uintptr_t)strtoull(tok[ntok - 2], NULL, 16);
+    return *sp ? 0 : -1;
+}
+
+// ========== LECTURA POR LÍNEAS ==========
+
+int proc_stream_open(proc_stream_t *s, const char *path) {
+    s->fd = open(path, O_RDONLY | O_CLOEXEC);
+    s->eof = s->err = 0;
+    s->len = s->pos = 0;
+    return s->fd < 0 ? -1 : 0;
+}
+
+char *proc_stream_line(proc_stream_t *s) {
+    for (;;) {
+        char *start = s->buf + s->pos;
+        char *nl = memchr(start, '\n', s->len - s->pos);
+        if (nl) {
+            *nl = '\0';
+            s->pos = (size_t)(nl - s->buf) + 1;
+            return start;
+        }
+        if (s->eof) {
+            if (s->pos == s->len) return NULL;
+            s->buf[s->len] = '\0';
+            s->pos = s->len;
+            return start;
+        }
+        memmove(s->buf, start, s->len - s->pos);
+        s->len -= s->pos;
+        s->pos = 0;
+        // Una línea más larga que el buffer (imposible con PATH_MAX) se corta
+        if (s->len == PROC_STREAM_BUF - 1) {
+            s->buf[s->len] = '\0';
+            s->pos = s->len;
+            return s->buf;
+        }
+        ssize_t n = read(s->fd, s->buf + s->len, PROC_STREAM_BUF - 1 - s->len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) s->err = 1;
+        if (n <= 0) s->eof = 1;
+        else s->len += (size_t)n;
+    }
+}
+
+void proc_stream_close(proc_stream_t *s) {
+    if (s->fd >= 0) close(s->fd);
+    s->fd = -1;
+}
+
+// ========== ENUMERACIÓN DE DIRECTORIOS ==========
+
+struct linux_dirent64 {
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+ssize_t proc_list_pids(const char *dir, proc_dir_buf_t *db, pid_t **out, size_t *out_cap) {
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    if (!db->buf) {
+        db->cap = PROC_DIR_BUF_CAP;
+        db->buf = malloc(db->cap);
+        if (!db->buf) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    size_t count = 0;
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, db->buf, db->cap);
+        if (n < 0) {
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break;
+
+        for (long off = 0; off < n; ) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(db->buf + off);
+            off += d->d_reclen;
+
+            const char *p = d->d_name;
+            if (*p < '0' || *p > '9') continue;  // solo entradas numéricas
+            pid_t pid = 0;
+            while (*p >= '0' && *p <= '9') pid = pid * 10 + (*p++ - '0');
+            if (*p) continue;
+
+            if (count == *out_cap) {
+                size_t ncap = *out_cap ? *out_cap * 2 : 256;
+                pid_t *grown = realloc(*out, ncap * sizeof(pid_t));
+                if (!grown) {
+                    close(fd);
+                    return -1;
+                }
+                *out = grown;
+                *out_cap = ncap;
+            }
+            (*out)[count++] = pid;
+        }
+    }
+
+    close(fd);
+    return (ssize_t)count;
+}
+
+void proc_dir_buf_free(proc_dir_buf_t *db) {
+    free(db->buf);
+    db->buf = NULL;
+    db->cap = 0;
+}
+
+// ========== PARSERS ==========
+
+// Avanza hasta el siguiente campo separado por espacios
+static inline const char *skip_fields(const char *p, const char *end, int n) {
+    while (n-- > 0 && p < end) {
+        while (p < end && *p != ' ') p++;
+        while (p < end && *p == ' ') p++;
+    }
+    return p;
+}
+
+static inline long long parse_ll(const char **pp, const char *end) {
+    const char *p = *pp;
+    int neg = 0;
+    if (p < end && *p == '-') {
+        neg = 1;
+        p++;
+    }
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (unsigned)(*p++ - '0');
+    while (p < end && *p == ' ') p++;
+    *pp = p;
+    return neg ? -(long long)v : (long long)v;
+}
+
+int proc_parse_stat(const char *buf, size_t len, proc_stat_t *out) {
+    const char *end = buf + len;
+    const char *p = buf;
+
+    memset(out, 0, sizeof(*out));
+    out->tid = (pid_t)parse_ll(&p, end);
+
+    // comm puede contener espacios y paréntesis: buscar el ÚLTIMO ')'
+    const char *lp = memchr(p, '(', (size_t)(end - p));
+    const char *rp = NULL;
+    for (const char *q = end - 1; q > p; q--) {
+        if (*q == ')') {
+            rp = q;
+            break;
+        }
+    }
+    if (!lp || !rp || rp < lp) return -1;
+
+    size_t clen = (size_t)(rp - lp - 1);
+    if (clen >= sizeof(out->comm)) clen = sizeof(out->comm) - 1;
+    memcpy(out->comm, lp + 1, clen);
+    out->comm[clen] = '\0';
+
+    p = rp + 2;  // ") "
+    if (p >= end) return -1;
+    out->state = *p;
+    p = skip_fields(p, end, 1);                          // -> (4)
+    out->ppid = (pid_t)parse_ll(&p, end);
+    p = skip_fields(p, end, 5);                          // -> (10)
+    out->minflt = (unsigned long)parse_ll(&p, end);
+    p = skip_fields(p, end, 1);                          // -> (12)
+    out->majflt = (unsigned long)parse_ll(&p, end);
+    p = skip_fields(p, end, 1);                          // -> (14)
+    out->utime = (unsigned long long)parse_ll(&p, end);
+    out->stime = (unsigned long long)parse_ll(&p, end);
+    p = skip_fields(p, end, 2);                          // -> (18)
+    out->priority = (long)parse_ll(&p, end);
+    out->nice = (long)parse_ll(&p, end);
+    out->num_threads = (long)parse_ll(&p, end);
+    p = skip_fields(p, end, 1);                          // -> (22)
+    out->starttime = (unsigned long long)parse_ll(&p, end);
+    out->vsize = (unsigned long)parse_ll(&p, end);
+    out->rss_pages = (long)parse_ll(&p, end);
+    p = skip_fields(p, end, 3);                          // -> (28)
+    out->startstack = (unsigned long)parse_ll(&p, end);
+    p = skip_fields(p, end, 10);                         // -> (39)
+    out->processor = (int)parse_ll(&p, end);
+    out->rt_priority = (unsigned int)parse_ll(&p, end);
+    out->policy = (unsigned int)parse_ll(&p, end);
+    return 0;
+}
+
+// Compara el inicio de la línea con una clave "Nombre:" de longitud conocida
+#define KEY_IS(line, lit) (strncmp((line), lit, sizeof(lit) - 1) == 0)
+
+static const char *status_value(const char *line, size_t keylen) {
+    const char *v = line + keylen;
+    while (*v == ' ' || *v == '\t') v++;
+    return v;
+}
+
+int proc_parse_status(const char *buf, size_t len, proc_status_t *out) {
+    const char *p = buf;
+    const char *end = buf + len;
+
+    memset(out, 0, sizeof(*out));
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+
+        if (KEY_IS(p, "Name:")) {
+            const char *v = status_value(p, 5);
+            size_t n = (size_t)(nl - v);
+            if (n >= sizeof(out->name)) n = sizeof(out->name) - 1;
+            memcpy(out->name, v, n);
+            out->name[n] = '\0';
+        } else if (KEY_IS(p, "State:")) {
+            out->state = *status_value(p, 6);
+        } else if (KEY_IS(p, "Tgid:")) {
+            out->tgid = (pid_t)strtol(status_value(p, 5), NULL, 10);
+        } else if (KEY_IS(p, "Pid:")) {
+            out->pid = (pid_t)strtol(status_value(p, 4), NULL, 10);
+        } else if (KEY_IS(p, "PPid:")) {
+            out->ppid = (pid_t)strtol(status_value(p, 5), NULL, 10);
+        } else if (KEY_IS(p, "Threads:")) {
+            out->threads = (int)strtol(status_value(p, 8), NULL, 10);
+        } else if (KEY_IS(p, "VmSize:")) {
+            out->vm_size_kb = strtoul(status_value(p, 7), NULL, 10);
+        } else if (KEY_IS(p, "VmRSS:")) {
+            out->vm_rss_kb = strtoul(status_value(p, 6), NULL, 10);
+        } else if (KEY_IS(p, "voluntary_ctxt_switches:")) {
+            out->vol_ctxt = strtoul(status_value(p, 24), NULL, 10);
+        } else if (KEY_IS(p, "nonvoluntary_ctxt_switches:")) {
+            out->nonvol_ctxt = strtoul(status_value(p, 27), NULL, 10);
+        }
+        p = nl + 1;
+    }
+    return out->pid ? 0 : -1;
+}
+
+// ========== SNAPSHOT ==========
+
+int proc_snapshot_init(proc_snapshot_t *s, pid_t root) {
+    memset(s, 0, sizeof(*s));
+    proc_file_init(&s->f_status);
+    proc_file_init(&s->f_stat);
+    proc_file_init(&s->f_scratch);
+    proc_file_init(&s->f_children);
+    s->root = root;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", root);
+    if (proc_file_open(&s->f_status, path) < 0) return -1;
+    snprintf(path, sizeof(path), "/proc/%d/stat", root);
+    if (proc_file_open(&s->f_stat, path) < 0) return -1;
+    return 0;
+}
+
+static proc_node_t *push_node(proc_snapshot_t *s) {
+    if (s->nnodes == s->nodes_cap) {
+        size_t ncap = s->nodes_cap ? s->nodes_cap * 2 : 16;
+        proc_node_t *grown = realloc(s->nodes, ncap * sizeof(*grown));
+        if (!grown) return NULL;
+        s->nodes = grown;
+        s->nodes_cap = ncap;
+    }
+    return &s->nodes[s->nnodes++];
+}
+
+static proc_stat_t *push_thread(proc_snapshot_t *s) {
+    if (s->nthreads == s->threads_cap) {
+        size_t ncap = s->threads_cap ? s->threads_cap * 2 : 64;
+        proc_stat_t *grown = realloc(s->threads, ncap * sizeof(*grown));
+        if (!grown) return NULL;
+        s->threads = grown;
+        s->threads_cap = ncap;
+    }
+    return &s->threads[s->nthreads++];
+}
+
+// Lee task/*/stat de un proceso y los añade al array de threads
+static void snapshot_threads(proc_snapshot_t *s, proc_node_t *node, pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+    node->first_thread = s->nthreads;
+    node->nthreads = 0;
+
+    ssize_t n = proc_list_pids(path, &s->dir, &s->tids, &s->tids_cap);
+    for (ssize_t i = 0; i < n; i++) {
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, s->tids[i]);
+        if (proc_file_load(&s->f_scratch, path) < 0) continue;  // el thread ya terminó
+        proc_stat_t *t = push_thread(s);
+        if (!t) return;
+        if (proc_parse_stat(s->f_scratch.buf, s->f_scratch.len, t) < 0) {
+            s->nthreads--;
+            continue;
+        }
+        node->nthreads++;
+    }
+}
+
+// Lee task/*/children de un proceso y encola los hijos como nuevos nodos
+static void snapshot_children(proc_snapshot_t *s, size_t node_idx, pid_t pid) {
+    char path[64];
+    size_t first = s->nodes[node_idx].first_thread;
+    size_t count = s->nodes[node_idx].nthreads;
+    int depth = s->nodes[node_idx].depth;
+
+    // Los hijos cuelgan del thread que hizo fork(): recorrer todos los threads
+    for (size_t t = 0; t < count; t++) {
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/children", pid, s->threads[first + t].tid);
+        if (proc_file_load(&s->f_children, path) < 0) continue;
+
+        const char *p = s->f_children.buf;
+        const char *end = p + s->f_children.len;
+        while (p < end) {
+            while (p < end && (*p < '0' || *p > '9')) p++;
+            if (p >= end) break;
+            pid_t child = (pid_t)parse_ll(&p, end);
+
+            proc_node_t *node = push_node(s);
+            if (!node) return;
+            memset(node, 0, sizeof(*node));
+            node->status.pid = child;
+            node->parent = (int)node_idx;
+            node->depth = depth + 1;
+        }
+    }
+}
+
+int proc_snapshot_take(proc_snapshot_t *s) {
+    s->nnodes = 0;
+    s->nthreads = 0;
+
+    // Raíz: fds persistentes, un pread() por archivo
+    if (proc_file_read(&s->f_status) < 0 || proc_file_read(&s->f_stat) < 0) return -1;
+
+    proc_node_t *root = push_node(s);
+    if (!root) return -1;
+    memset(root, 0, sizeof(*root));
+    root->parent = -1;
+    proc_parse_status(s->f_status.buf, s->f_status.len, &root->status);
+    proc_parse_stat(s->f_stat.buf, s->f_stat.len, &root->stat);
+
+    // Recorrido en anchura: nodes[] crece mientras se recorre
+    for (size_t i = 0; i < s->nnodes; i++) {
+        pid_t pid = s->nodes[i].status.pid;
+        char path[64];
+
+        if (i > 0) {
+            proc_node_t *node = &s->nodes[i];
+            snprintf(path, sizeof(path), "/proc/%d/status", pid);
+            if (proc_file_load(&s->f_scratch, path) < 0) continue;  // ya terminó
+            proc_parse_status(s->f_scratch.buf, s->f_scratch.len, &node->status);
+            snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+            if (proc_file_load(&s->f_scratch, path) == 0) {
+                proc_parse_stat(s->f_scratch.buf, s->f_scratch.len, &node->stat);
+            }
+        }
+
+        snapshot_threads(s, &s->nodes[i], pid);
+        snapshot_children(s, i, pid);
+    }
+    return 0;
+}
+
+void proc_snapshot_free(proc_snapshot_t *s) {
+    proc_file_free(&s->f_status);
+    proc_file_free(&s->f_stat);
+    proc_file_free(&s->f_scratch);
+    proc_file_free(&s->f_children);
+    proc_dir_buf_free(&s->dir);
+    free(s->tids);
+    free(s->nodes);
+    free(s->threads);
+    memset(s, 0, sizeof(*s));
+}
+
+// ========== IMPRESIÓN ==========
+
+void proc_snapshot_print_status(const proc_snapshot_t *s) {
+    if (s->nnodes == 0) return;
+    const proc_status_t *st = &s->nodes[0].status;
+    printf("--- /proc/%d/status ---\n", s->root);
+    printf("State:\t%c\n", st->state);
+    printf("Tgid:\t%d\n", st->tgid);
+    printf("Pid:\t%d\n", st->pid);
+    printf("PPid:\t%d\n", st->ppid);
+    printf("VmSize:\t%8lu kB\n", st->vm_size_kb);
+    printf("VmRSS:\t%8lu kB\n", st->vm_rss_kb);
+    printf("Threads:\t%d\n", st->threads);
+}
+
+void proc_snapshot_print_threads(const proc_snapshot_t *s) {
+    printf("--- threads del árbol (task/*/stat) ---\n");
+    printf("  %7s %7s %7s %4s %2s %3s %5s  %s\n",
+           "TGID", "TID", "PPID", "NLWP", "S", "CPU", "NICE", "COMM");
+    for (size_t i = 0; i < s->nnodes; i++) {
+        const proc_node_t *n = &s->nodes[i];
+        for (size_t t = 0; t < n->nthreads; t++) {
+            const proc_stat_t *th = &s->threads[n->first_thread + t];
+            printf("  %7d %7d %7d %4zu %2c %3d %5ld  %s\n",
+                   n->status.tgid, th->tid, n->status.ppid, n->nthreads,
+                   th->state, th->processor, th->nice, th->comm);
+        }
+    }
+}
+
+static void print_tree_node(const proc_snapshot_t *s, size_t idx) {
+    const proc_node_t *n = &s->nodes[idx];
+    for (int d = 0; d < n->depth; d++) printf("  ");
+    printf("%s%s(%d)", n->depth ? "└─" : "", n->status.name, n->status.pid);
+
+    // Threads distintos del principal, como hace pstree -p: {nombre}(tid)
+    for (size_t t = 0; t < n->nthreads; t++) {
+        const proc_stat_t *th = &s->threads[n->first_thread + t];
+        if (th->tid != n->status.pid) printf(" {%s}(%d)", th->comm, th->tid);
+    }
+    printf("\n");
+
+    for (size_t c = idx + 1; c < s->nnodes; c++) {
+        if (s->nodes[c].parent == (int)idx) print_tree_node(s, c);
+    }
+}
+
+void proc_snapshot_print_tree(const proc_snapshot_t *s) {
+    if (s->nnodes > 0) print_tree_node(s, 0);
+}
@@ -0,0 +1,140 @@
+// proc_snapshot.h - Lectura de /proc sin fork/exec (status, stat, task/*/stat, children)
+#ifndef PROC_SNAPSHOT_H
+#define PROC_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// ========== ARCHIVO DE /proc REUTILIZABLE ==========
+
+// Un archivo de /proc con su propio buffer. El fd queda abierto y cada
+// lectura empieza con un pread() en offset 0 (el kernel regenera el
+// contenido) y sigue hasta EOF: los seq_file entregan una página por read.
+typedef struct {
+    int fd;
+    char *buf;
+    size_t cap;
+    size_t len;
+} proc_file_t;
+
+void    proc_file_init(proc_file_t *f);
+int     proc_file_open(proc_file_t *f, const char *path);   // 0 ok, -1 error
+ssize_t proc_file_read(proc_file_t *f);                     // bytes leídos o -1
+int     proc_file_load(proc_file_t *f, const char *path);   // open + read + close
+void    proc_file_close(proc_file_t *f);                    // cierra el fd, conserva el buffer
+void    proc_file_free(proc_file_t *f);
+
+// SP de un thread según /proc/<pid>/task/<tid>/syscall, leído con f: es el
+// penúltimo campo tanto dentro de una syscall ("nr a1..a6 sp pc") como
+// bloqueado fuera de ella ("-1 sp pc"). -1 si está corriendo ("running"),
+// ya no existe o no hay permiso
+int     proc_task_sp(pid_t pid, pid_t tid, proc_file_t *f, uintptr_t *sp);
+
+// Lectura por líneas con un buffer fijo para archivos que pueden ser muy
+// grandes (smaps de un proceso con miles de regiones): nunca están enteros
+// en memoria. Las líneas partidas entre dos read() se recomponen.
+#define PROC_STREAM_BUF 8192
+
+typedef struct {
+    int fd;
+    int eof;
+    int err;
+    size_t len, pos;
+    char buf[PROC_STREAM_BUF];
+} proc_stream_t;
+
+int   proc_stream_open(proc_stream_t *s, const char *path);    // 0 ok, -1 error
+char *proc_stream_line(proc_stream_t *s);   // línea sin '\n' (válida hasta la siguiente llamada) o NULL al final
+void  proc_stream_close(proc_stream_t *s);
+
+// Enumerar entradas numéricas de un directorio (/proc o /proc/<pid>/task)
+// con getdents64 sobre un buffer reutilizable. Devuelve el número de PIDs.
+typedef struct {
+    char *buf;
+    size_t cap;
+} proc_dir_buf_t;
+
+ssize_t proc_list_pids(const char *dir, proc_dir_buf_t *db, pid_t **out, size_t *out_cap);
+void    proc_dir_buf_free(proc_dir_buf_t *db);
+
+// ========== CAMPOS PARSEADOS ==========
+
+// Subconjunto de /proc/<pid>/stat (ver proc(5) para la numeración)
+typedef struct {
+    pid_t tid;                  // (1)
+    char comm[16];              // (2)
+    char state;                 // (3)
+    pid_t ppid;                 // (4)
+    unsigned long minflt;       // (10)
+    unsigned long majflt;       // (12)
+    unsigned long long utime;   // (14) en ticks
+    unsigned long long stime;   // (15) en ticks
+    long priority;              // (18)
+    long nice;                  // (19)
+    long num_threads;           // (20)
+    unsigned long long starttime; // (22)
+    unsigned long vsize;        // (23) bytes
+    long rss_pages;             // (24)
+    unsigned long startstack;   // (28)
+    int processor;              // (39)
+    unsigned int rt_priority;   // (40)
+    unsigned int policy;        // (41)
+} proc_stat_t;
+
+// Subconjunto de /proc/<pid>/status
+typedef struct {
+    char name[16];
+    char state;
+    pid_t pid;
+    pid_t tgid;
+    pid_t ppid;
+    int threads;
+    unsigned long vm_size_kb;
+    unsigned long vm_rss_kb;
+    unsigned long vol_ctxt;
+    unsigned long nonvol_ctxt;
+} proc_status_t;
+
+int proc_parse_stat(const char *buf, size_t len, proc_stat_t *out);
+int proc_parse_status(const char *buf, size_t len, proc_status_t *out);
+
+// ========== SNAPSHOT DEL ÁRBOL DE PROCESOS ==========
+
+// Un proceso del árbol: su status/stat y un rango dentro del array de threads
+typedef struct {
+    proc_status_t status;
+    proc_stat_t stat;
+    int parent;                 // índice del padre en nodes[], -1 para la raíz
+    int depth;
+    size_t first_thread;        // índice en threads[]
+    size_t nthreads;
+} proc_node_t;
+
+// Motor de snapshots: todos los buffers se reutilizan entre llamadas
+typedef struct {
+    proc_file_t f_status;       // status de la raíz (fd persistente)
+    proc_file_t f_stat;         // stat de la raíz (fd persistente)
+    proc_file_t f_scratch;      // status/stat de descendientes y task/*/stat
+    proc_file_t f_children;
+    proc_dir_buf_t dir;
+    pid_t *tids;
+    size_t tids_cap;
+    pid_t root;
+
+    proc_node_t *nodes;
+    size_t nnodes, nodes_cap;
+    proc_stat_t *threads;
+    size_t nthreads, threads_cap;
+} proc_snapshot_t;
+
+int  proc_snapshot_init(proc_snapshot_t *s, pid_t root);
+int  proc_snapshot_take(proc_snapshot_t *s);     // 0 ok, -1 si la raíz no existe
+void proc_snapshot_free(proc_snapshot_t *s);
+
+// Reemplazos de `grep /proc/<pid>/status`, `ps -eLf | grep` y `pstree -p`
+void proc_snapshot_print_status(const proc_snapshot_t *s);
+void proc_snapshot_print_threads(const proc_snapshot_t *s);
+void proc_snapshot_print_tree(const proc_snapshot_t *s);
+
+#endif // PROC_SNAPSHOT_H
@@ -0,0 +1,298 @@
+// proc_stack.c - Tamaño, guarda y marca de agua del stack de cada thread
+//
+// El stack de un thread es la región de maps que contiene su SP (el de un
+// thread bloqueado sale de task/<tid>/syscall; el del que llama, de su propio
+// frame). La marca de agua es la página presente más baja según pagemap:
+// una página de stack que se tocó una vez sigue residente aunque el thread
+// ya no baje tanto, así que es justo la profundidad máxima alcanzada (con
+// precisión de página). En los threads de glibc el TCB y el TLS estático
+// ocupan la parte alta del mismo mapeo y cuentan como usados.
+//
+// Para los threads propios hay además precisión de byte: se pinta el stack
+// bajo el SP con un patrón y luego se busca desde abajo el primer byte que
+// ya no lo tiene (la técnica clásica de los RTOS). Pintar hace residente la
+// ventana, así que para esos threads la marca combina la de antes de pintar
+// con lo sobrescrito.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_stack.h"
+
+static void task_comm(pid_t pid, pid_t tid, proc_file_t *f, char out[16]) {
+    char path[96];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/comm", pid, tid);
+    out[0] = '\0';
+    if (proc_file_load(f, path) < 0) return;
+    size_t n = f->len < 15 ? f->len : 15;
+    memcpy(out, f->buf, n);
+    out[n] = '\0';
+    char *nl = strchr(out, '\n');
+    if (nl) *nl = '\0';
+}
+
+// Páginas presentes de [lo, hi) y la más baja de ellas
+static int residency_pagemap(pagemap_t *pm, uintptr_t lo, uintptr_t hi, size_t page,
+                             size_t *resident, size_t *lowest) {
+    size_t npages = (hi - lo) / page;
+    *resident = 0;
+    *lowest = npages;
+    for (size_t done = 0; done < npages; done += PAGEMAP_BATCH) {
+        size_t batch = npages - done < PAGEMAP_BATCH ? npages - done : PAGEMAP_BATCH;
+        if (pagemap_read(pm, lo + done * page, batch, NULL) < 0) return -1;
+        for (size_t i = 0; i < batch; i++) {
+            if (!(pm->buf[i] & (PM_PRESENT | PM_SWAPPED))) continue;
+            (*resident)++;
+            if (*lowest == npages) *lowest = done + i;
+        }
+    }
+    return 0;
+}
+
+static int residency_mincore(uintptr_t lo, uintptr_t hi, size_t page, size_t *resident, size_t *lowest) {
+    size_t npages = (hi - lo) / page;
+    unsigned char *vec = malloc(npages ? npages : 1);
+    if (!vec) return -1;
+    if (mincore((void *)lo, hi - lo, vec) < 0) {
+        free(vec);
+        return -1;
+    }
+    *resident = 0;
+    *lowest = npages;
+    for (size_t i = 0; i < npages; i++) {
+        if (!(vec[i] & 1)) continue;
+        (*resident)++;
+        if (*lowest == npages) *lowest = i;
+    }
+    free(vec);
+    return 0;
+}
+
+// ========== PINTADO ==========
+
+// Los pintados de este proceso por tid: stack_usage_measure los consulta
+// para que las páginas que solo tocó memset no cuenten como profundidad
+#define STACK_PAINT_SLOTS 64
+
+static struct {
+    pid_t tid;
+    stack_paint_t st;
+} paint_reg[STACK_PAINT_SLOTS];
+static unsigned paint_next;
+static pthread_mutex_t paint_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread stack_paint_t paint_state;
+static __thread int painted;
+
+// Primer byte sin el patrón desde abajo: profundidad con precisión de byte
+static void paint_scan(stack_paint_t *p) {
+    const uint8_t *end = (const uint8_t *)(p->from - STACK_PAINT_GAP);
+    const uint8_t *start = end - p->painted;
+    const uint8_t *q = start;
+    while (q < end && *(const volatile uint8_t *)q == STACK_PAINT_BYTE) q++;
+    p->overflow = q == start;
+    // Sin bytes sobrescritos solo se sabe que llegó hasta el SP del pintado
+    p->depth = p->top - (q < end ? (uintptr_t)q : p->from);
+}
+
+static int paint_lookup(pid_t tid, uintptr_t lo, uintptr_t hi, stack_paint_t *out) {
+    int found = 0;
+    pthread_mutex_lock(&paint_lock);
+    for (int i = 0; i < STACK_PAINT_SLOTS && !found; i++) {
+        // El stack de un thread que terminó se reutiliza con otro tid
+        if (paint_reg[i].tid != tid || paint_reg[i].st.from <= lo || paint_reg[i].st.from > hi) continue;
+        *out = paint_reg[i].st;
+        found = 1;
+    }
+    pthread_mutex_unlock(&paint_lock);
+    return found;
+}
+
+static void paint_register(pid_t tid, const stack_paint_t *st) {
+    pthread_mutex_lock(&paint_lock);
+    int slot = -1;
+    for (int i = 0; i < STACK_PAINT_SLOTS && slot < 0; i++) {
+        if (paint_reg[i].tid == tid) slot = i;
+    }
+    if (slot < 0) slot = (int)(paint_next++ % STACK_PAINT_SLOTS);
+    paint_reg[slot].tid = tid;
+    paint_reg[slot].st = *st;
+    pthread_mutex_unlock(&paint_lock);
+}
+
+__attribute__((noinline))
+int stack_paint_self(size_t window) {
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return -1;
+    int rc = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) return -1;
+
+    uintptr_t lo = (uintptr_t)addr;
+    uintptr_t from = (uintptr_t)__builtin_frame_address(0);
+    uintptr_t end = from - STACK_PAINT_GAP;
+    if (end <= lo) return -1;
+    uintptr_t start = window && end - lo > window ? end - window : lo;
+
+    // Marca antes de pintar: memset hace residente toda la ventana. En el
+    // principal lo de debajo de [stack] aún no está mapeado; entonces se
+    // mira solo la ventana
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t top = lo + size;
+    uintptr_t hi_page = (from + page - 1) & ~(uintptr_t)(page - 1);
+    size_t resident, lowest;
+    uintptr_t base = lo & ~(uintptr_t)(page - 1);
+    if (residency_mincore(base, hi_page, page, &resident, &lowest) < 0) {
+        base = start & ~(uintptr_t)(page - 1);
+        if (residency_mincore(base, hi_page, page, &resident, &lowest) < 0) return -1;
+    }
+    size_t npages = (hi_page - base) / page;
+    paint_state.hwm_before = lowest < npages ? top - (base + lowest * page) : top - from;
+
+    // El frame de memset queda dentro del margen: solo se escribe por debajo
+    memset((void *)start, STACK_PAINT_BYTE, end - start);
+    paint_state.top = top;
+    paint_state.from = from;
+    paint_state.painted = end - start;
+    paint_state.depth = 0;
+    paint_state.overflow = 0;
+    painted = 1;
+    paint_register(get_kernel_pid(), &paint_state);
+    return 0;
+}
+
+int stack_painted_usage(stack_paint_t *out) {
+    if (!painted) return -1;
+    *out = paint_state;
+    paint_scan(out);
+    return 0;
+}
+
+// noinline: el SP tiene que ser el de este frame, dentro del stack medido
+__attribute__((noinline))
+int stack_usage_measure(pid_t pid, pid_t tid, const proc_maps_t *maps, pagemap_t *pm, stack_usage_t *out) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    int self = pid == getpid();
+    proc_file_t f;
+    proc_file_init(&f);
+    memset(out, 0, sizeof(*out));
+    out->tid = tid;
+    task_comm(pid, tid, &f, out->comm);
+
+    if (self && tid == get_kernel_pid()) {
+        out->sp = (uintptr_t)__builtin_frame_address(0);
+    } else {
+        if (proc_task_sp(pid, tid, &f, &out->sp) < 0) out->sp = 0;
+    }
+    if (!out->sp && tid == pid) {
+        // Principal corriendo: startstack cae en el mismo [stack]
+        char path[64];
+        proc_stat_t st;
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        if (proc_file_load(&f, path) == 0 && proc_parse_stat(f.buf, f.len, &st) == 0) {
+            out->sp = (uintptr_t)st.startstack;
+        }
+    }
+    proc_file_free(&f);
+
+    const maps_region_t *r = out->sp ? proc_maps_find(maps, out->sp) : NULL;
+    if (!r) {
+        errno = ESRCH;
+        return -1;
+    }
+    out->lo = r->start;
+    out->hi = r->end;
+    out->main = r->kind == MAPS_KIND_STACK;
+    if (out->main) {
+        struct rlimit rl;
+        if (prlimit(pid, RLIMIT_STACK, NULL, &rl) == 0) {
+            out->limit = rl.rlim_cur == RLIM_INFINITY ? 0 : (size_t)rl.rlim_cur;
+        }
+    } else {
+        out->limit = out->hi - out->lo;
+        if (r > maps->regions && r[-1].end == r->start && r[-1].perms == 0) {
+            out->guard = r[-1].end - r[-1].start;
+        }
+    }
+
+    size_t lowest;
+    if (pm) {
+        out->method = STACK_BY_PAGEMAP;
+        if (residency_pagemap(pm, out->lo, out->hi, page, &out->resident, &lowest) < 0) return -1;
+    } else if (self) {
+        out->method = STACK_BY_MINCORE;
+        if (residency_mincore(out->lo, out->hi, page, &out->resident, &lowest) < 0) return -1;
+    } else {
+        errno = EACCES;
+        return -1;
+    }
+    size_t npages = (out->hi - out->lo) / page;
+    out->hwm = lowest < npages ? out->hi - (out->lo + lowest * page) : 0;
+    out->resident *= page;
+
+    // Pintado en este proceso: las páginas de la ventana las tocó memset. Si
+    // el thread no bajó de lo pintado, la marca es la de antes de pintar o
+    // lo sobrescrito desde entonces; si bajó más, la de las páginas vale
+    stack_paint_t ps;
+    if (self && paint_lookup(tid, out->lo, out->hi, &ps)) {
+        paint_scan(&ps);
+        out->painted = ps.painted;
+        if (!ps.overflow) out->hwm = ps.depth > ps.hwm_before ? ps.depth : ps.hwm_before;
+    }
+    return 0;
+}
+
+ssize_t stack_usage_scan(pid_t pid, stack_usage_t **out, size_t *cap) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    proc_dir_buf_t db = { 0 };
+    pid_t *tids = NULL;
+    size_t tids_cap = 0;
+    ssize_t n = proc_list_pids(path, &db, &tids, &tids_cap);
+    proc_dir_buf_free(&db);
+    if (n < 0) return -1;
+
+    if ((size_t)n > *cap) {
+        stack_usage_t *grown = realloc(*out, (size_t)n * sizeof(**out));
+        if (!grown) {
+            free(tids);
+            return -1;
+        }
+        *out = grown;
+        *cap = (size_t)n;
+    }
+
+    proc_maps_t maps;
+    proc_maps_init(&maps);
+    if (proc_maps_load(&maps, pid) < 0) {
+        proc_maps_free(&maps);
+        free(tids);
+        return -1;
+    }
+    pagemap_t pm;
+    int have_pm = pagemap_open(&pm, pid) == 0;
+    for (ssize_t i = 0; i < n; i++) {
+        stack_usage_measure(pid, tids[i], &maps, have_pm ? &pm : NULL, &(*out)[i]);
+    }
+    if (have_pm) pagemap_close(&pm);
+    proc_maps_free(&maps);
+    free(tids);
+    return n;
+}
+
+size_t stack_suggest_size(size_t max_hwm) {
+    const size_t step = 64u << 10;
+    size_t s = (2 * max_hwm + step - 1) / step * step;
+    return s < step ? step : s;
+}
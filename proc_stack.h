@@ -0,0 +1,70 @@
+// proc_stack.h - Tamaño, guarda y marca de agua (high-water mark) del stack de cada thread
+#ifndef PROC_STACK_H
+#define PROC_STACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_maps.h"
+#include "proc_pagemap.h"
+
+#define STACK_PAINT_BYTE   0xA5
+#define STACK_PAINT_GAP    4096         // margen bajo el SP que no se pinta (frame de memset, señales)
+#define STACK_PAINT_WINDOW (64u << 10)  // ventana por defecto de stack_paint_self
+
+typedef enum {
+    STACK_BY_PAGEMAP = 0,   // páginas presentes o en swap de /proc/<pid>/pagemap
+    STACK_BY_MINCORE,       // mincore: solo para el propio proceso, sin ver el swap
+} stack_method_t;
+
+typedef struct {
+    pid_t tid;
+    char comm[16];
+    int main;               // [stack] del thread principal: crece bajo demanda
+    uintptr_t sp;           // 0 si el thread estaba corriendo (task/<tid>/syscall = "running")
+    uintptr_t lo, hi;       // mapeo del stack [lo, hi)
+    size_t guard;           // región ---p justo debajo (0 en el principal: lo separa stack_guard_gap)
+    size_t limit;           // principal: RLIMIT_STACK (0 = ilimitado); thread: hi - lo
+    size_t resident;        // bytes presentes o en swap dentro de [lo, hi)
+    size_t hwm;             // hi - página tocada más baja: la profundidad máxima alcanzada
+    size_t painted;         // bytes pintados (threads propios): hwm sale del pintado, no de las páginas
+    stack_method_t method;
+} stack_usage_t;
+
+// Un thread de pid. maps debe estar cargado para pid; pm puede ser NULL
+// (entonces, si pid es este proceso, se usa mincore). Para el thread que
+// llama no hace falta task/<tid>/syscall: el SP es el suyo.
+int  stack_usage_measure(pid_t pid, pid_t tid, const proc_maps_t *maps, pagemap_t *pm, stack_usage_t *out);
+
+// Todos los threads de pid. Devuelve cuántos se midieron (los que corrían
+// sin SP visible quedan con sp = 0 y sin mapeo) o -1.
+ssize_t stack_usage_scan(pid_t pid, stack_usage_t **out, size_t *cap);
+
+// Tamaño de stack recomendable para pthread_attr_setstacksize: el doble de la
+// mayor marca vista, redondeado a 64 KB y nunca por debajo de 64 KB
+size_t stack_suggest_size(size_t max_hwm);
+
+// ========== PINTADO (solo el thread que llama) ==========
+
+// Rellena con STACK_PAINT_BYTE hasta window bytes por debajo del SP actual
+// (0 = hasta el final utilizable del stack). Las páginas pintadas pasan a
+// ser residentes, por eso la ventana por defecto es pequeña; la marca de
+// antes de pintar queda en hwm_before y stack_usage_measure la usa para los
+// threads pintados de este proceso.
+int  stack_paint_self(size_t window);
+
+typedef struct {
+    uintptr_t top;          // hi del stack del thread
+    uintptr_t from;         // SP al pintar
+    size_t painted;         // bytes pintados bajo from - STACK_PAINT_GAP
+    size_t hwm_before;      // marca de mincore justo antes de pintar
+    size_t depth;           // hi - byte más bajo sobrescrito (precisión de byte)
+    int overflow;           // se usó toda la ventana: depth es una cota inferior
+} stack_paint_t;
+
+// Marca de agua desde el último stack_paint_self: busca desde abajo el primer
+// byte que ya no tiene el patrón. -1 si este thread no pintó su stack.
+int  stack_painted_usage(stack_paint_t *out);
+
+#endif // PROC_STACK_H
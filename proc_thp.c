@@ -0,0 +1,297 @@
+// proc_thp.c - Cobertura de huge pages por región y experimento de TLB
+//
+// smaps da por cada VMA cuánto está mapeado con PMD (AnonHugePages para
+// THP anónimas, ShmemPmdMapped/FilePmdMapped para tmpfs y archivos,
+// *_Hugetlb para hugetlbfs), si el kernel la considera elegible
+// (THPeligible) y los madvise aplicados (VmFlags hg/nh). Con eso se ve qué
+// regiones del programa usan huge pages y, si no, por qué.
+//
+// El experimento recorre un array grande con lecturas aleatorias
+// dependientes: cada una cae en otra página, así que con 4 KB casi todas
+// fallan en la TLB y esperan un page walk; con 2 MB el mismo array cabe en
+// unas pocas entradas de la STLB.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "proc_common.h"
+#include "proc_snapshot.h"
+#include "proc_thp.h"
+
+// ========== CONFIGURACIÓN DEL SISTEMA ==========
+
+// Valor activo de un archivo de sysfs con el formato "always [madvise] never"
+static void read_bracketed(const char *path, char *out, size_t len) {
+    proc_file_t f;
+    proc_file_init(&f);
+    snprintf(out, len, "?");
+    if (proc_file_load(&f, path) == 0) {
+        char *open = memchr(f.buf, '[', f.len);
+        char *close = open ? memchr(open, ']', f.len - (size_t)(open - f.buf)) : NULL;
+        if (close && (size_t)(close - open - 1) < len) {
+            memcpy(out, open + 1, (size_t)(close - open - 1));
+            out[close - open - 1] = '\0';
+        }
+    }
+    proc_file_free(&f);
+}
+
+static unsigned long meminfo_field(const proc_file_t *f, const char *key) {
+    size_t klen = strlen(key);
+    const char *p = f->buf;
+    const char *end = f->buf + f->len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        if ((size_t)(nl - p) > klen && memcmp(p, key, klen) == 0) return strtoul(p + klen, NULL, 10);
+        p = nl + 1;
+    }
+    return 0;
+}
+
+int thp_config_read(thp_config_t *out) {
+    memset(out, 0, sizeof(*out));
+    read_bracketed("/sys/kernel/mm/transparent_hugepage/enabled", out->enabled, sizeof(out->enabled));
+    read_bracketed("/sys/kernel/mm/transparent_hugepage/defrag", out->defrag, sizeof(out->defrag));
+
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size") == 0) {
+        out->pmd_size = strtoul(f.buf, NULL, 10);
+    }
+    if (proc_file_load(&f, "/proc/meminfo") < 0) {
+        proc_file_free(&f);
+        return -1;
+    }
+    out->hugetlb_total = meminfo_field(&f, "HugePages_Total:");
+    out->hugetlb_free = meminfo_field(&f, "HugePages_Free:");
+    out->hugetlb_kb = meminfo_field(&f, "Hugepagesize:");
+    proc_file_free(&f);
+    return 0;
+}
+
+// ========== smaps POR REGIÓN ==========
+
+static const struct {
+    const char *key;
+    size_t len;
+    size_t off;
+} smaps_fields[] = {
+    { "Rss:",             4,  offsetof(smaps_vma_t, rss_kb) },
+    { "Pss:",             4,  offsetof(smaps_vma_t, pss_kb) },
+    { "Swap:",            5,  offsetof(smaps_vma_t, swap_kb) },
+    { "Anonymous:",       10, offsetof(smaps_vma_t, anon_kb) },
+    { "AnonHugePages:",   14, offsetof(smaps_vma_t, anon_huge_kb) },
+    { "KernelPageSize:",  15, offsetof(smaps_vma_t, kernel_page_kb) },
+};
+
+// Cabecera de región: "start-end perms ..." (las líneas de campos empiezan por "Clave:")
+static int parse_header(const char *p, const char *nl, smaps_vma_t *v) {
+    char *e;
+    unsigned long long start = strtoull(p, &e, 16);
+    if (e >= nl || *e != '-') return -1;
+    unsigned long long end = strtoull(e + 1, &e, 16);
+    if (e >= nl || *e != ' ') return -1;
+    memset(v, 0, sizeof(*v));
+    v->start = (uintptr_t)start;
+    v->end = (uintptr_t)end;
+    v->thp_eligible = -1;
+    return 0;
+}
+
+static void parse_vmflags(const char *p, const char *nl, smaps_vma_t *v) {
+    for (; p + 1 < nl; p++) {
+        if (p[-1] != ' ' || (p + 2 < nl && p[2] != ' ')) continue;
+        if (p[0] == 'h' && p[1] == 'g') v->vmflags |= SMAPS_VM_HG;
+        else if (p[0] == 'n' && p[1] == 'h') v->vmflags |= SMAPS_VM_NH;
+        else if (p[0] == 'h' && p[1] == 't') v->vmflags |= SMAPS_VM_HT;
+    }
+}
+
+ssize_t smaps_load(pid_t pid, smaps_vma_t **out, size_t *cap) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+    proc_file_t f;
+    proc_file_init(&f);
+    if (proc_file_load(&f, path) < 0) {
+        proc_file_free(&f);
+        return -1;
+    }
+
+    size_t n = 0;
+    smaps_vma_t *v = NULL;
+    const char *p = f.buf;
+    const char *end = f.buf + f.len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        const char *colon = memchr(p, ':', (size_t)(nl - p));
+        const char *space = memchr(p, ' ', (size_t)(nl - p));
+        if (!colon || (space && space < colon)) {
+            if (n == *cap) {
+                size_t ncap = *cap ? *cap * 2 : 256;
+                smaps_vma_t *grown = realloc(*out, ncap * sizeof(**out));
+                if (!grown) {
+                    proc_file_free(&f);
+                    return -1;
+                }
+                *out = grown;
+                *cap = ncap;
+            }
+            v = parse_header(p, nl, &(*out)[n]) == 0 ? &(*out)[n++] : NULL;
+        } else if (v) {
+            size_t klen = (size_t)(colon - p) + 1;
+            if (klen == 8 && memcmp(p, "VmFlags:", 8) == 0) {
+                parse_vmflags(colon + 1, nl, v);
+            } else if (klen == 12 && memcmp(p, "THPeligible:", 12) == 0) {
+                v->thp_eligible = atoi(colon + 1);
+            } else if ((klen == 15 && memcmp(p, "ShmemPmdMapped:", 15) == 0) ||
+                       (klen == 14 && memcmp(p, "FilePmdMapped:", 14) == 0)) {
+                v->file_huge_kb += strtoul(colon + 1, NULL, 10);
+            } else if ((klen == 16 && memcmp(p, "Private_Hugetlb:", 16) == 0) ||
+                       (klen == 15 && memcmp(p, "Shared_Hugetlb:", 15) == 0)) {
+                v->hugetlb_kb += strtoul(colon + 1, NULL, 10);
+            } else {
+                for (size_t i = 0; i < sizeof(smaps_fields) / sizeof(smaps_fields[0]); i++) {
+                    if (klen == smaps_fields[i].len && memcmp(p, smaps_fields[i].key, klen) == 0) {
+                        *(unsigned long *)((char *)v + smaps_fields[i].off) = strtoul(colon + 1, NULL, 10);
+                        break;
+                    }
+                }
+            }
+        }
+        p = nl + 1;
+    }
+
+    proc_file_free(&f);
+    return (ssize_t)n;
+}
+
+const char *thp_gap_reason(const smaps_vma_t *v, const thp_config_t *cfg) {
+    unsigned long huge = smaps_huge_kb(v);
+    if (v->vmflags & SMAPS_VM_HT) return NULL;
+    if (v->rss_kb == 0) return "sin páginas residentes";
+    if (huge >= v->rss_kb) return NULL;
+
+    uintptr_t pmd = cfg->pmd_size ? cfg->pmd_size : THP_PMD_SIZE;
+    uintptr_t first = (v->start + pmd - 1) & ~(pmd - 1);
+    uintptr_t last = v->end & ~(pmd - 1);
+    if (first >= last) return "no contiene 2 MB alineados";
+    if (v->vmflags & SMAPS_VM_NH) return "MADV_NOHUGEPAGE";
+    if (strcmp(cfg->enabled, "never") == 0) return "THP desactivado (enabled=never)";
+    // Con enabled=madvise THPeligible es 0 en todo lo que no tenga hg
+    if (strcmp(cfg->enabled, "madvise") == 0 && !(v->vmflags & SMAPS_VM_HG)) {
+        return "enabled=madvise: falta MADV_HUGEPAGE";
+    }
+    if (v->thp_eligible == 0) return "no elegible (archivo o permisos)";
+    if (huge) return "parcial: bordes sin alinear o sin memoria contigua";
+    return "elegible sin THP: fragmentación (khugepaged puede colapsarla)";
+}
+
+// ========== EXPERIMENTO DE TLB ==========
+
+const char *thp_bench_name(thp_bench_mode_t mode) {
+    switch (mode) {
+        case THP_BENCH_4K:      return "4 KB (MADV_NOHUGEPAGE)";
+        case THP_BENCH_MADVISE: return "THP (MADV_HUGEPAGE)";
+        case THP_BENCH_HUGETLB: return "hugetlbfs (MAP_HUGETLB)";
+        default:                return "?";
+    }
+}
+
+// Huge pages de [start, start + len) según smaps (madvise parte la VMA en el rango)
+static unsigned long range_huge_kb(uintptr_t start, size_t len) {
+    smaps_vma_t *v = NULL;
+    size_t cap = 0;
+    ssize_t n = smaps_load(getpid(), &v, &cap);
+    unsigned long kb = 0;
+    for (ssize_t i = 0; i < n; i++) {
+        if (v[i].end > start && v[i].start < start + len) kb += smaps_huge_kb(&v[i]);
+    }
+    free(v);
+    return kb;
+}
+
+static inline uint64_t xorshift64(uint64_t x) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+int thp_bench_run(thp_bench_mode_t mode, size_t bytes, uint64_t accesses, thp_bench_result_t *out) {
+    const size_t pmd = THP_PMD_SIZE;
+    memset(out, 0, sizeof(*out));
+    bytes = (bytes + pmd - 1) & ~(pmd - 1);
+    if (bytes == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    out->bytes = bytes;
+
+    // THP solo cubre rangos alineados a 2 MB: se reserva de más y se alinea
+    void *map;
+    size_t map_len;
+    uint64_t *buf;
+    if (mode == THP_BENCH_HUGETLB) {
+        map_len = bytes;
+        map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map == MAP_FAILED) return -1;   // ENOMEM sin vm.nr_hugepages suficientes
+        buf = map;
+    } else {
+        map_len = bytes + pmd;
+        map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (map == MAP_FAILED) return -1;
+        buf = (uint64_t *)(((uintptr_t)map + pmd - 1) & ~(uintptr_t)(pmd - 1));
+        if (madvise(buf, bytes, mode == THP_BENCH_MADVISE ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) < 0 &&
+            mode == THP_BENCH_MADVISE) {
+            munmap(map, map_len);
+            return -1;                      // EINVAL: kernel sin THP
+        }
+    }
+
+    // Primera escritura: un fallo por página de 4 KB o uno por cada 2 MB
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    struct rusage r0, r1;
+    getrusage(RUSAGE_THREAD, &r0);
+    uint64_t t0 = now_ns();
+    for (size_t off = 0; off < bytes; off += page) ((volatile char *)buf)[off] = 1;
+    out->touch_ms = (now_ns() - t0) / 1e6;
+    getrusage(RUSAGE_THREAD, &r1);
+    out->minflt = r1.ru_minflt - r0.ru_minflt;
+    out->huge_kb = range_huge_kb((uintptr_t)buf, bytes);
+
+    size_t nwords = bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < nwords; i++) buf[i] = i * 0x9E3779B97F4A7C15ull;
+
+    // Secuencial: el prefetcher hace casi irrelevante el tamaño de página
+    uint64_t sum = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < nwords; i++) sum += buf[i];
+    uint64_t seq_ns = now_ns() - t0;
+    out->seq_gbs = seq_ns ? (double)bytes / seq_ns : 0;
+
+    // Aleatorio dependiente: la dirección siguiente depende del valor leído
+    uint64_t x = 0x2545F4914F6CDD1Dull;
+    uint64_t v = 0;
+    t0 = now_ns();
+    for (uint64_t i = 0; i < accesses; i++) {
+        x = xorshift64(x ^ (v & 1));
+        v = buf[(size_t)(((unsigned __int128)x * nwords) >> 64)];
+    }
+    uint64_t rnd_ns = now_ns() - t0;
+    out->accesses = accesses;
+    out->access_ns = accesses ? (double)rnd_ns / accesses : 0;
+    out->maccess_s = rnd_ns ? accesses * 1e3 / rnd_ns : 0;
+
+    // Que el compilador no descarte los recorridos
+    __asm__ volatile("" : : "r"(sum), "r"(v));
+    munmap(map, map_len);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// proc_thp.h - Cobertura de huge pages (THP y hugetlbfs) por región de smaps
+// y coste de la TLB con páginas de 4 KB, MADV_HUGEPAGE y MAP_HUGETLB
+#ifndef PROC_THP_H
+#define PROC_THP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define THP_PMD_SIZE (2u << 20)     // huge page de x86-64/arm64 con páginas de 4 KB
+
+// ========== CONFIGURACIÓN DEL SISTEMA ==========
+
+typedef struct {
+    char enabled[16];           // /sys/kernel/mm/transparent_hugepage/enabled: always, madvise, never
+    char defrag[24];            // always, defer, defer+madvise, madvise, never
+    unsigned long pmd_size;     // hpage_pmd_size (0 si no hay THP)
+    unsigned long hugetlb_total;    // HugePages_Total de meminfo (reservadas con vm.nr_hugepages)
+    unsigned long hugetlb_free;
+    unsigned long hugetlb_kb;   // Hugepagesize
+} thp_config_t;
+
+int thp_config_read(thp_config_t *out);
+
+// ========== smaps POR REGIÓN ==========
+
+#define SMAPS_VM_HG  0x1        // VmFlags "hg": madvise(MADV_HUGEPAGE)
+#define SMAPS_VM_NH  0x2        // "nh": MADV_NOHUGEPAGE
+#define SMAPS_VM_HT  0x4        // "ht": hugetlbfs
+
+typedef struct {
+    uintptr_t start, end;
+    unsigned long rss_kb;
+    unsigned long pss_kb;
+    unsigned long swap_kb;
+    unsigned long anon_kb;
+    unsigned long anon_huge_kb;     // AnonHugePages: THP anónimas mapeadas con PMD
+    unsigned long file_huge_kb;     // ShmemPmdMapped + FilePmdMapped
+    unsigned long hugetlb_kb;       // Private_Hugetlb + Shared_Hugetlb
+    unsigned long kernel_page_kb;   // KernelPageSize (2048 en hugetlbfs)
+    int thp_eligible;               // THPeligible (-1 en kernels sin el campo)
+    unsigned vmflags;               // SMAPS_VM_*
+} smaps_vma_t;
+
+// Todas las regiones de /proc/<pid>/smaps, en el orden de maps. Devuelve
+// cuántas o -1. El array crece con realloc y se reutiliza entre llamadas.
+ssize_t smaps_load(pid_t pid, smaps_vma_t **out, size_t *cap);
+
+// Bytes de huge pages de la región (THP + hugetlbfs)
+static inline unsigned long smaps_huge_kb(const smaps_vma_t *v) {
+    return v->anon_huge_kb + v->file_huge_kb + v->hugetlb_kb;
+}
+
+// Por qué una región no está (del todo) en huge pages, o NULL si lo está
+const char *thp_gap_reason(const smaps_vma_t *v, const thp_config_t *cfg);
+
+// ========== EXPERIMENTO DE TLB ==========
+
+typedef enum {
+    THP_BENCH_4K = 0,           // MADV_NOHUGEPAGE: una entrada de TLB cada 4 KB
+    THP_BENCH_MADVISE,          // MADV_HUGEPAGE antes de tocar: THP si hay memoria contigua
+    THP_BENCH_HUGETLB,          // MAP_HUGETLB: del pool reservado, o ENOMEM
+    THP_BENCH_NMODES,
+} thp_bench_mode_t;
+
+const char *thp_bench_name(thp_bench_mode_t mode);
+
+typedef struct {
+    size_t bytes;
+    double touch_ms;            // primera escritura de todo el array
+    long minflt;                // fallos durante esa escritura
+    unsigned long huge_kb;      // huge pages que quedaron (smaps) tras tocar
+    uint64_t accesses;
+    double access_ns;           // por lectura aleatoria dependiente (limitada por la TLB)
+    double maccess_s;           // millones de lecturas/s
+    double seq_gbs;             // lectura secuencial (la TLB apenas importa)
+} thp_bench_result_t;
+
+// bytes se redondea a 2 MB; accesses lecturas aleatorias con dependencia
+// (cada dirección depende de la lectura anterior, sin paralelismo de memoria)
+int thp_bench_run(thp_bench_mode_t mode, size_t bytes, uint64_t accesses, thp_bench_result_t *out);
+
+#endif // PROC_THP_H
@@ -0,0 +1,466 @@
+// proc_tsdb.c - Serie temporal de métricas por proceso en un espacio fijo
+//
+// Los bloques están alineados al contador global de muestras: el bloque b
+// cubre las muestras [b * TSDB_BLOCK, (b + 1) * TSDB_BLOCK) de todas las
+// series, así que cerrar bloques es un paso común al empezar cada bloque y
+// el descriptor del bloque b de una columna está en b % nblocks. Dentro de
+// un bloque se guarda el valor en la primera posición válida (base) y un
+// delta zigzag por posición; el valor en p es base + suma de deltas hasta p.
+//
+// El muestreador solo hace una mezcla de dos listas ordenadas por PID (las
+// series activas y la salida de proc_scanner_run): sin tablas hash y sin
+// tocar /proc aquí. Las consultas solo leen la región, que es la misma en
+// memoria y en el archivo volcado.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "proc_common.h"
+#include "proc_tsdb.h"
+
+#define DESC_VALID      (1ull << 63)
+#define DESC_POS_MASK   ((1ull << 48) - 1)
+#define DESC_WIDTH(d)   ((unsigned)(((d) >> 48) & 0x7f))
+
+static const char *const metric_names[TSDB_NMETRICS] = {
+    [TSDB_RSS_KB]      = "rss",
+    [TSDB_THREADS]     = "threads",
+    [TSDB_VOL_CTXT]    = "vol_ctxt",
+    [TSDB_NONVOL_CTXT] = "nonvol_ctxt",
+    [TSDB_MINFLT]      = "minflt",
+    [TSDB_MAJFLT]      = "majflt",
+};
+
+const char *tsdb_metric_name(tsdb_metric_t m) {
+    return (unsigned)m < TSDB_NMETRICS ? metric_names[m] : "?";
+}
+
+int tsdb_metric_parse(const char *name) {
+    for (int m = 0; m < TSDB_NMETRICS; m++) {
+        if (strcmp(name, metric_names[m]) == 0) return m;
+    }
+    return -1;
+}
+
+// ========== DISPOSICIÓN ==========
+
+static size_t align64(size_t n) {
+    return (n + 63) & ~(size_t)63;
+}
+
+typedef struct {
+    uint32_t nblocks;
+    uint64_t span;
+    size_t off_times, off_series, off_desc, off_stage, off_arena, total;
+} tsdb_layout_t;
+
+static void layout(uint32_t max_series, uint64_t span, uint64_t arena_size, tsdb_layout_t *l) {
+    l->span = (span + TSDB_BLOCK - 1) / TSDB_BLOCK * TSDB_BLOCK;
+    // Un bloque más que la ventana: el más viejo puede estar a medias dentro
+    l->nblocks = (uint32_t)(l->span / TSDB_BLOCK + 1);
+    size_t cols = (size_t)max_series * TSDB_NMETRICS;
+    l->off_times = align64(sizeof(tsdb_header_t));
+    l->off_series = align64(l->off_times + (size_t)l->nblocks * TSDB_BLOCK * sizeof(uint64_t));
+    l->off_desc = align64(l->off_series + (size_t)max_series * sizeof(tsdb_series_t));
+    l->off_stage = align64(l->off_desc + cols * l->nblocks * sizeof(uint64_t));
+    l->off_arena = align64(l->off_stage + cols * TSDB_BLOCK * sizeof(uint32_t));
+    l->total = align64(l->off_arena + arena_size);
+}
+
+static uint64_t default_arena(uint32_t max_series, uint32_t nblocks) {
+    // 8 bytes de base + ~4 de deltas de media por bloque y columna
+    return (uint64_t)max_series * TSDB_NMETRICS * nblocks * 12;
+}
+
+size_t tsdb_size_for(uint32_t max_series, uint64_t span, uint64_t arena_size) {
+    tsdb_layout_t l;
+    layout(max_series, span, 0, &l);
+    if (!arena_size) arena_size = default_arena(max_series, l.nblocks);
+    layout(max_series, span, (arena_size + 7) & ~7ull, &l);
+    return l.total;
+}
+
+static void bind(tsdb_t *db) {
+    tsdb_header_t *h = (tsdb_header_t *)db->base;
+    db->hdr = h;
+    db->times = (uint64_t *)(db->base + h->off_times);
+    db->series = (tsdb_series_t *)(db->base + h->off_series);
+    db->desc = (uint64_t *)(db->base + h->off_desc);
+    db->stage = (uint32_t *)(db->base + h->off_stage);
+    db->arena = db->base + h->off_arena;
+}
+
+int tsdb_create(tsdb_t *db, uint32_t max_series, uint64_t span, uint64_t interval_ns, uint64_t arena_size) {
+    memset(db, 0, sizeof(*db));
+    if (max_series == 0 || span == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    tsdb_layout_t l;
+    layout(max_series, span, 0, &l);
+    if (!arena_size) arena_size = default_arena(max_series, l.nblocks);
+    arena_size = (arena_size + 7) & ~7ull;
+    layout(max_series, span, arena_size, &l);
+
+    // Anónima y NORESERVE: las páginas de series que nunca se usan no ocupan RAM
+    void *m = mmap(NULL, l.total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (m == MAP_FAILED) return -1;
+    db->active = malloc((size_t)max_series * sizeof(uint32_t));
+    db->scratch = malloc((size_t)max_series * sizeof(uint32_t));
+    if (!db->active || !db->scratch) {
+        free(db->active);
+        free(db->scratch);
+        munmap(m, l.total);
+        return -1;
+    }
+    db->base = m;
+    db->size = l.total;
+
+    tsdb_header_t *h = m;
+    h->magic = TSDB_MAGIC;
+    h->version = TSDB_VERSION;
+    h->block = TSDB_BLOCK;
+    h->max_series = max_series;
+    h->nblocks = l.nblocks;
+    h->span = l.span;
+    h->interval_ns = interval_ns;
+    h->arena_size = arena_size;
+    h->off_times = l.off_times;
+    h->off_series = l.off_series;
+    h->off_desc = l.off_desc;
+    h->off_stage = l.off_stage;
+    h->off_arena = l.off_arena;
+    h->total_size = l.total;
+    bind(db);
+    return 0;
+}
+
+void tsdb_free(tsdb_t *db) {
+    if (db->base) munmap(db->base, db->size);
+    free(db->active);
+    free(db->scratch);
+    memset(db, 0, sizeof(*db));
+}
+
+static inline uint64_t *col_desc(const tsdb_t *db, uint32_t s, int m) {
+    return db->desc + ((size_t)s * TSDB_NMETRICS + (size_t)m) * db->hdr->nblocks;
+}
+
+static inline uint32_t *col_stage(const tsdb_t *db, uint32_t s, int m) {
+    return db->stage + ((size_t)s * TSDB_NMETRICS + (size_t)m) * TSDB_BLOCK;
+}
+
+// ========== ESCRITURA ==========
+
+static inline uint32_t zigzag(int64_t d) {
+    // Un delta que no cabe en 32 bits (imposible a 1 Hz) se satura
+    if (d > INT32_MAX) d = INT32_MAX;
+    if (d < INT32_MIN) d = INT32_MIN;
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t z) {
+    return (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+}
+
+// Comprime el bloque abierto de cada columna de s y lo añade al log circular
+static void seal(tsdb_t *db, uint32_t s, uint64_t blk) {
+    tsdb_header_t *h = db->hdr;
+    tsdb_series_t *se = &db->series[s];
+    for (int m = 0; m < TSDB_NMETRICS; m++) {
+        const uint32_t *st = col_stage(db, s, m);
+        uint32_t any = 0;
+        for (int i = 0; i < TSDB_BLOCK; i++) any |= st[i];
+        unsigned w = any ? 32 - (unsigned)__builtin_clz(any) : 0;
+        size_t len = 8 + 8 * (size_t)w;     // base + 64 valores de w bits
+
+        uint64_t pos = h->arena_head % h->arena_size;
+        if (pos + len > h->arena_size) h->arena_head += h->arena_size - pos;   // sin partir un bloque
+        uint64_t off = h->arena_head;
+        uint64_t *out = (uint64_t *)(db->arena + off % h->arena_size);
+        out[0] = se->open_base[m];
+        memset(out + 1, 0, 8 * w);
+        for (unsigned i = 0; w && i < TSDB_BLOCK; i++) {
+            unsigned bit = i * w;
+            out[1 + bit / 64] |= (uint64_t)st[i] << (bit % 64);
+            if (bit % 64 + w > 64) out[1 + bit / 64 + 1] |= (uint64_t)st[i] >> (64 - bit % 64);
+        }
+        h->arena_head += len;
+        col_desc(db, s, m)[blk % h->nblocks] = DESC_VALID | ((uint64_t)w << 48) | (off & DESC_POS_MASK);
+    }
+}
+
+static void entry_values(const scan_entry_t *e, uint64_t v[TSDB_NMETRICS]) {
+    v[TSDB_RSS_KB] = e->rss_kb > 0 ? (uint64_t)e->rss_kb : 0;
+    v[TSDB_THREADS] = e->threads > 0 ? (uint64_t)e->threads : 0;
+    v[TSDB_VOL_CTXT] = e->vol_ctxt;
+    v[TSDB_NONVOL_CTXT] = e->nonvol_ctxt;
+    v[TSDB_MINFLT] = e->minflt;
+    v[TSDB_MAJFLT] = e->majflt;
+}
+
+static void record(tsdb_t *db, uint32_t s, uint64_t t, const scan_entry_t *e) {
+    tsdb_series_t *se = &db->series[s];
+    unsigned pos = (unsigned)(t % TSDB_BLOCK);
+    int opens = t == se->first_tick || pos == 0;
+    uint64_t v[TSDB_NMETRICS];
+    entry_values(e, v);
+    for (int m = 0; m < TSDB_NMETRICS; m++) {
+        uint32_t *st = col_stage(db, s, m);
+        if (opens) {
+            memset(st, 0, TSDB_BLOCK * sizeof(*st));
+            se->open_base[m] = v[m];
+        } else {
+            st[pos] = zigzag((int64_t)(v[m] - se->prev[m]));
+        }
+        se->prev[m] = v[m];
+    }
+    se->last_tick = t;
+    memcpy(se->comm, e->comm, sizeof(se->comm));
+}
+
+// Ranura para una serie nueva: una sin usar o una muerta fuera de la ventana
+static int64_t slot_alloc(tsdb_t *db, uint64_t t) {
+    tsdb_header_t *h = db->hdr;
+    uint32_t s;
+    if (h->nseries < h->max_series) {
+        s = h->nseries++;
+    } else {
+        for (s = 0; s < h->nseries; s++) {
+            const tsdb_series_t *se = &db->series[s];
+            if (!se->active && se->last_tick + h->span < t) break;
+        }
+        if (s == h->nseries) return -1;
+    }
+    memset(&db->series[s], 0, sizeof(db->series[s]));
+    memset(col_desc(db, s, 0), 0, (size_t)TSDB_NMETRICS * h->nblocks * sizeof(uint64_t));
+    return s;
+}
+
+size_t tsdb_append(tsdb_t *db, const scan_entry_t *e, size_t n, uint64_t time_ns) {
+    tsdb_header_t *h = db->hdr;
+    uint64_t t = h->tick;
+    uint64_t blk = t / TSDB_BLOCK;
+    size_t dropped = 0;
+
+    // Empieza un bloque: se cierran los de todas las series vivas
+    if (t % TSDB_BLOCK == 0 && t > 0) {
+        for (size_t i = 0; i < db->nactive; i++) seal(db, db->active[i], blk - 1);
+    }
+    db->times[t % ((uint64_t)h->nblocks * TSDB_BLOCK)] = time_ns;
+
+    size_t i = 0, j = 0, out = 0;
+    while (i < db->nactive || j < n) {
+        tsdb_series_t *se = i < db->nactive ? &db->series[db->active[i]] : NULL;
+        const scan_entry_t *en = j < n ? &e[j] : NULL;
+        if (se && en && se->pid == en->pid && se->starttime == en->starttime) {
+            record(db, db->active[i], t, en);
+            db->scratch[out++] = db->active[i];
+            i++, j++;
+        } else if (se && (!en || se->pid <= en->pid)) {
+            // Terminó (o su PID ya es de otro proceso): su último bloque sigue abierto
+            if (se->last_tick / TSDB_BLOCK == blk) seal(db, db->active[i], blk);
+            se->active = 0;
+            i++;
+        } else {
+            int64_t s = slot_alloc(db, t);
+            if (s < 0) {
+                dropped++;
+            } else {
+                tsdb_series_t *ns = &db->series[s];
+                ns->pid = en->pid;
+                ns->starttime = en->starttime;
+                ns->first_tick = t;
+                ns->active = 1;
+                record(db, (uint32_t)s, t, en);
+                db->scratch[out++] = (uint32_t)s;
+            }
+            j++;
+        }
+    }
+    uint32_t *tmp = db->active;
+    db->active = db->scratch;
+    db->scratch = tmp;
+    db->nactive = out;
+    h->tick = t + 1;
+    return dropped;
+}
+
+// ========== ARCHIVO ==========
+
+int tsdb_save(const tsdb_t *db, const char *path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    // Las páginas nunca tocadas de la región anónima salen como ceros
+    size_t done = 0;
+    while (done < db->size) {
+        ssize_t w = write(fd, db->base + done, db->size - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) {
+            close(fd);
+            unlink(tmp);
+            return -1;
+        }
+        done += (size_t)w;
+    }
+    if (fsync(fd) < 0 || close(fd) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return rename(tmp, path);
+}
+
+int tsdb_open_file(tsdb_t *db, const char *path) {
+    memset(db, 0, sizeof(*db));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(tsdb_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return -1;
+    const tsdb_header_t *h = m;
+    if (h->magic != TSDB_MAGIC || h->version != TSDB_VERSION || h->block != TSDB_BLOCK ||
+        h->total_size != (uint64_t)st.st_size) {
+        munmap(m, (size_t)st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+    db->base = m;
+    db->size = (size_t)st.st_size;
+    db->ro = 1;
+    bind(db);
+    return 0;
+}
+
+// ========== CONSULTAS ==========
+
+int tsdb_find(const tsdb_t *db, pid_t pid) {
+    int best = -1;
+    for (uint32_t s = 0; s < db->hdr->nseries; s++) {
+        const tsdb_series_t *se = &db->series[s];
+        if (se->pid != pid) continue;
+        if (best < 0 || se->last_tick > db->series[best].last_tick) best = (int)s;
+    }
+    return best;
+}
+
+// Primera muestra aún retenida: la ventana y lo que no pisó la arena
+static uint64_t oldest_tick(const tsdb_t *db) {
+    return db->hdr->tick > db->hdr->span ? db->hdr->tick - db->hdr->span : 0;
+}
+
+// Valores absolutos del bloque blk de (s, m) en vals[p0..63]; p0 es la primera posición válida
+static int decode_block(const tsdb_t *db, uint32_t s, int m, uint64_t blk, uint64_t vals[TSDB_BLOCK], unsigned *p0) {
+    const tsdb_header_t *h = db->hdr;
+    const tsdb_series_t *se = &db->series[s];
+    *p0 = se->first_tick / TSDB_BLOCK == blk ? (unsigned)(se->first_tick % TSDB_BLOCK) : 0;
+
+    uint64_t base;
+    uint32_t d[TSDB_BLOCK];
+    if (se->active && blk == se->last_tick / TSDB_BLOCK) {
+        base = se->open_base[m];
+        memcpy(d, col_stage(db, s, m), sizeof(d));
+    } else {
+        uint64_t desc = col_desc(db, s, m)[blk % h->nblocks];
+        if (!(desc & DESC_VALID)) return -1;
+        // Posición absoluta en el log: si el escritor ya dio la vuelta, se perdió
+        uint64_t off = desc & DESC_POS_MASK;
+        uint64_t head_lo = h->arena_head & DESC_POS_MASK;
+        if (((head_lo - off) & DESC_POS_MASK) > h->arena_size) return -1;
+        const uint64_t *in = (const uint64_t *)(db->arena + off % h->arena_size);
+        unsigned w = DESC_WIDTH(desc);
+        uint64_t mask = w == 64 ? ~0ull : (1ull << w) - 1;
+        base = in[0];
+        for (unsigned i = 0; i < TSDB_BLOCK; i++) {
+            if (!w) {
+                d[i] = 0;
+                continue;
+            }
+            unsigned bit = i * w;
+            uint64_t v = in[1 + bit / 64] >> (bit % 64);
+            if (bit % 64 + w > 64) v |= in[1 + bit / 64 + 1] << (64 - bit % 64);
+            d[i] = (uint32_t)(v & mask);
+        }
+    }
+    uint64_t v = base;
+    vals[*p0] = v;
+    for (unsigned i = *p0 + 1; i < TSDB_BLOCK; i++) {
+        v += (uint64_t)unzigzag(d[i]);
+        vals[i] = v;
+    }
+    return 0;
+}
+
+int tsdb_value(const tsdb_t *db, uint32_t s, tsdb_metric_t m, uint64_t tick, uint64_t *out) {
+    if (s >= db->hdr->nseries) return -1;
+    const tsdb_series_t *se = &db->series[s];
+    if (tick < se->first_tick || tick > se->last_tick || tick < oldest_tick(db)) return -1;
+    uint64_t vals[TSDB_BLOCK];
+    unsigned p0;
+    if (decode_block(db, s, (int)m, tick / TSDB_BLOCK, vals, &p0) < 0) return -1;
+    *out = vals[tick % TSDB_BLOCK];
+    return 0;
+}
+
+int tsdb_window(const tsdb_t *db, uint32_t s, tsdb_metric_t m, uint64_t window, tsdb_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (s >= db->hdr->nseries) return -1;
+    const tsdb_series_t *se = &db->series[s];
+    uint64_t to = se->last_tick;
+    uint64_t from = se->first_tick;
+    if (from < oldest_tick(db)) from = oldest_tick(db);
+    if (window && to + 1 > from + window) from = to + 1 - window;
+    if (from > to) return -1;
+
+    uint64_t ring = (uint64_t)db->hdr->nblocks * TSDB_BLOCK;
+    double sum = 0;
+    uint64_t count = 0;
+    int have = 0;
+    for (uint64_t blk = from / TSDB_BLOCK; blk <= to / TSDB_BLOCK; blk++) {
+        uint64_t vals[TSDB_BLOCK];
+        unsigned p0;
+        if (decode_block(db, s, (int)m, blk, vals, &p0) < 0) continue;   // bloque perdido: hueco
+        uint64_t lo = blk * TSDB_BLOCK + p0 > from ? blk * TSDB_BLOCK + p0 : from;
+        uint64_t hi = blk * TSDB_BLOCK + TSDB_BLOCK - 1 < to ? blk * TSDB_BLOCK + TSDB_BLOCK - 1 : to;
+        for (uint64_t t = lo; t <= hi; t++) {
+            uint64_t v = vals[t % TSDB_BLOCK];
+            if (!have) {
+                out->from_tick = t;
+                out->first = out->min = out->max = v;
+                have = 1;
+            }
+            if (v < out->min) out->min = v;
+            if (v > out->max) out->max = v;
+            out->last = v;
+            out->to_tick = t;
+            sum += (double)v;
+            count++;
+        }
+    }
+    if (!have) return -1;
+    out->mean = sum / count;
+    out->delta = (int64_t)(out->last - out->first);
+    uint64_t t0 = db->times[out->from_tick % ring];
+    uint64_t t1 = db->times[out->to_tick % ring];
+    out->seconds = t1 > t0 ? (t1 - t0) / 1e9 : 0;
+    out->rate = out->seconds > 0 ? out->delta / out->seconds : 0;
+    return 0;
+}
+
+uint64_t tsdb_arena_used(const tsdb_t *db) {
+    return db->hdr->arena_head < db->hdr->arena_size ? db->hdr->arena_head : db->hdr->arena_size;
+}
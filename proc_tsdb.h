@@ -0,0 +1,131 @@
+// proc_tsdb.h - Serie temporal en memoria de métricas por proceso: columnas
+// comprimidas por bloques en un espacio fijo, consultas de delta/tasa sin
+// releer /proc y volcado a un archivo que se abre con mmap
+#ifndef PROC_TSDB_H
+#define PROC_TSDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "proc_scan.h"
+
+#define TSDB_MAGIC   0x3142445354435250ull     // "PRCTSDB1"
+#define TSDB_VERSION 1
+#define TSDB_BLOCK   64         // muestras por bloque comprimido
+
+typedef enum {
+    TSDB_RSS_KB = 0,            // nivel (puede bajar)
+    TSDB_THREADS,               // nivel
+    TSDB_VOL_CTXT,              // contador
+    TSDB_NONVOL_CTXT,           // contador
+    TSDB_MINFLT,                // contador
+    TSDB_MAJFLT,                // contador
+    TSDB_NMETRICS,
+} tsdb_metric_t;
+
+const char *tsdb_metric_name(tsdb_metric_t m);
+int tsdb_metric_parse(const char *name);        // -1 si no existe
+
+// ========== FORMATO (en memoria y en el archivo, idéntico) ==========
+//
+// Una sola región contigua; todo se referencia por offsets desde su inicio:
+//
+//   cabecera | tiempos[ring] | series[max_series] | descriptores | staging | arena
+//
+// Cada (serie, métrica) es una columna. El bloque abierto vive sin
+// comprimir en staging (deltas zigzag); al cerrarse cada TSDB_BLOCK
+// muestras se escribe en la arena como [base u64][64 deltas de w bits], con
+// w la anchura del mayor delta: un proceso parado ocupa 8 bytes por bloque
+// y métrica. La arena es un log circular de tamaño fijo: si se llena, se
+// pierden los bloques más viejos (la consulta lo ve por su posición).
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t block;             // TSDB_BLOCK
+    uint32_t max_series;
+    uint32_t nblocks;           // anillo de bloques por columna (span / block + 1)
+    uint64_t span;              // muestras retenidas
+    uint64_t interval_ns;       // periodo nominal del muestreo
+    uint64_t tick;              // muestras tomadas (la siguiente es la número tick)
+    uint64_t arena_size;
+    uint64_t arena_head;        // posición absoluta de escritura en el log
+    uint64_t off_times, off_series, off_desc, off_stage, off_arena;
+    uint64_t total_size;
+    uint32_t nseries;           // ranuras usadas (activas o con historia aún en la ventana)
+    uint32_t pad;
+} tsdb_header_t;
+
+typedef struct {
+    pid_t pid;
+    int32_t active;             // visto en la última muestra
+    uint64_t starttime;
+    char comm[16];
+    uint64_t first_tick;        // primera muestra de esta serie
+    uint64_t last_tick;         // última muestra (inclusive)
+    uint64_t prev[TSDB_NMETRICS];       // último valor absoluto (para el siguiente delta)
+    uint64_t open_base[TSDB_NMETRICS];  // valor en la primera posición válida del bloque abierto
+} tsdb_series_t;
+
+// Manejador: la región y punteros a sus partes. ro = abierto desde archivo.
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    int ro;
+    tsdb_header_t *hdr;
+    uint64_t *times;            // ns CLOCK_REALTIME de cada muestra, anillo de nblocks * block
+    tsdb_series_t *series;
+    uint64_t *desc;             // [serie][métrica][nblocks]: 63 válido | 48-54 anchura | 0-47 posición
+    uint32_t *stage;            // [serie][métrica][block]
+    uint8_t *arena;
+
+    // Solo en memoria (no va al archivo): series activas ordenadas por PID
+    uint32_t *active;
+    size_t nactive;
+    uint32_t *scratch;
+} tsdb_t;
+
+// Bytes que ocupará un almacén (para elegir parámetros antes de crear)
+size_t tsdb_size_for(uint32_t max_series, uint64_t span, uint64_t arena_size);
+
+// arena_size 0 = 12 bytes por bloque y columna (procesos casi quietos)
+int  tsdb_create(tsdb_t *db, uint32_t max_series, uint64_t span, uint64_t interval_ns, uint64_t arena_size);
+void tsdb_free(tsdb_t *db);
+
+// Añade una muestra con la salida de proc_scanner_run (ordenada por PID).
+// Los procesos que faltan terminan su serie; los nuevos toman una ranura
+// libre (o la de una serie muerta cuya historia ya salió de la ventana).
+// Devuelve cuántos procesos no cupieron.
+size_t tsdb_append(tsdb_t *db, const scan_entry_t *e, size_t n, uint64_t time_ns);
+
+// Volcado atómico (archivo temporal + rename) y apertura de solo lectura
+// con mmap: las consultas leen el archivo directamente
+int  tsdb_save(const tsdb_t *db, const char *path);
+int  tsdb_open_file(tsdb_t *db, const char *path);
+
+// ========== CONSULTAS (sin /proc) ==========
+
+// Serie más reciente de pid, o -1
+int  tsdb_find(const tsdb_t *db, pid_t pid);
+
+// Valor en la muestra tick de la serie s (0 ok, -1 fuera de su vida o ya perdido)
+int  tsdb_value(const tsdb_t *db, uint32_t s, tsdb_metric_t m, uint64_t tick, uint64_t *out);
+
+typedef struct {
+    uint64_t from_tick, to_tick;    // ventana efectiva dentro de la vida de la serie
+    uint64_t first, last;           // valores en los extremos
+    uint64_t min, max;
+    double mean;
+    int64_t delta;                  // last - first
+    double rate;                    // delta por segundo (con los tiempos reales de muestra)
+    double seconds;
+} tsdb_stats_t;
+
+// Estadísticas de las últimas window muestras (0 = toda la historia retenida)
+int  tsdb_window(const tsdb_t *db, uint32_t s, tsdb_metric_t m, uint64_t window, tsdb_stats_t *out);
+
+// Bytes de arena ocupados (como mucho arena_size: a partir de ahí se pisan los más viejos)
+uint64_t tsdb_arena_used(const tsdb_t *db);
+
+#endif // PROC_TSDB_H
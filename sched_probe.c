@@ -0,0 +1,325 @@
+// sched_probe.c - Latencia de despertar por política de planificación y nice
+//
+// Un thread temporizador duerme con clock_nanosleep(TIMER_ABSTIME) hasta cada
+// periodo y despierta a todos los threads medidos, uno a uno: apunta now_ns()
+// en la ranura del thread y hace FUTEX_WAKE (o write en su eventfd). El
+// thread, al volver a correr, resta esa marca: es el tiempo que el
+// planificador tardó en darle CPU. Todas las clases corren a la vez y con la
+// misma carga (hogs incluidos), así la comparación es justa; el orden en que
+// se despiertan rota en cada periodo para no favorecer a ninguna.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "proc_common.h"
+#include "sched_probe.h"
+
+// Despertares recordados por thread: si el thread se retrasa, su latencia se
+// mide desde el primero que no atendió, no desde el último (sin "coordinated
+// omission")
+#define SPROBE_RING 64
+
+typedef struct sprobe_run sprobe_run_t;
+
+// Ranura de un thread medido; cada una en su propia línea de caché
+typedef struct {
+    _Alignas(64) atomic_uint seq;   // palabra futex: nº de despertares enviados
+    uint64_t sent_ns[SPROBE_RING];  // cuándo se envió cada uno (por seq)
+    int efd;
+    int cls;
+    int index;
+    lat_hist_t *hist;
+    unsigned long missed;
+    sprobe_run_t *run;
+    pthread_t thread;
+} sprobe_waiter_t;
+
+struct sprobe_run {
+    const sprobe_cfg_t *cfg;
+    sprobe_result_t *res;
+    sprobe_waiter_t *waiters;
+    int nwaiters;
+    atomic_int ready;
+    atomic_int stop;
+    atomic_int errors[SPROBE_MAX_CLASSES];
+};
+
+typedef struct {
+    sprobe_run_t *run;
+    int index;
+    pthread_t thread;
+} sprobe_hog_t;
+
+static inline void futex_wait(atomic_uint *addr, unsigned expected) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static inline void futex_wake(atomic_uint *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+// ========== CLASES ==========
+
+static const struct { const char *name; int policy; } policies[] = {
+    { "other", SCHED_OTHER }, { "batch", SCHED_BATCH }, { "idle", SCHED_IDLE },
+    { "fifo", SCHED_FIFO }, { "rr", SCHED_RR },
+};
+
+static const char *short_name(int policy) {
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (policies[i].policy == policy) return policies[i].name;
+    }
+    return "?";
+}
+
+static int is_rt(int policy) {
+    return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+const char *sprobe_policy_name(int policy) {
+    switch (policy) {
+    case SCHED_OTHER: return "SCHED_OTHER";
+    case SCHED_BATCH: return "SCHED_BATCH";
+    case SCHED_IDLE:  return "SCHED_IDLE";
+    case SCHED_FIFO:  return "SCHED_FIFO";
+    case SCHED_RR:    return "SCHED_RR";
+    default:          return "?";
+    }
+}
+
+int sprobe_parse_class(const char *spec, sprobe_class_t *out) {
+    const char *colon = strchr(spec, ':');
+    size_t nlen = colon ? (size_t)(colon - spec) : strlen(spec);
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (strlen(policies[i].name) != nlen || strncmp(spec, policies[i].name, nlen) != 0) continue;
+        out->policy = policies[i].policy;
+        out->prio = 0;
+        if (colon) {
+            char *end;
+            long v = strtol(colon + 1, &end, 10);
+            if (end == colon + 1 || *end) return -1;
+            out->prio = (int)v;
+        }
+        if (is_rt(out->policy)) {
+            if (out->prio < sched_get_priority_min(out->policy) || out->prio > sched_get_priority_max(out->policy)) return -1;
+            snprintf(out->label, sizeof(out->label), "%s prio %d", policies[i].name, out->prio);
+        } else if (out->policy == SCHED_IDLE) {
+            snprintf(out->label, sizeof(out->label), "idle");      // nice no cuenta en SCHED_IDLE
+        } else {
+            if (out->prio < -20 || out->prio > 19) return -1;
+            snprintf(out->label, sizeof(out->label), "%s nice %d", policies[i].name, out->prio);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+void sprobe_default_config(sprobe_cfg_t *cfg) {
+    static const char *const defaults[] = { "other:0", "other:19", "fifo:50", "rr:50" };
+    memset(cfg, 0, sizeof(*cfg));
+    for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++) {
+        sprobe_parse_class(defaults[i], &cfg->classes[cfg->nclasses++]);
+    }
+    cfg->threads = 2;
+    cfg->period_us = 1000;
+    cfg->samples = 2000;
+    cfg->hogs = 0;
+    cfg->wake = SPROBE_FUTEX;
+}
+
+// Política y nice son por thread en Linux: se aplican con el TID propio
+static int apply_class(const sprobe_class_t *c) {
+    struct sched_param sp = { .sched_priority = is_rt(c->policy) ? c->prio : 0 };
+    if (sched_setscheduler(0, c->policy, &sp) < 0) return errno;
+    if (!is_rt(c->policy) && setpriority(PRIO_PROCESS, (id_t)get_kernel_pid(), c->prio) < 0) return errno;
+    return 0;
+}
+
+// ========== THREADS ==========
+
+static void *waiter_main(void *arg) {
+    sprobe_waiter_t *w = arg;
+    sprobe_run_t *run = w->run;
+    const sprobe_class_t *c = &run->cfg->classes[w->cls];
+    char name[16];
+    // "SP-fifo50-1", "SP-other19-2": visible en ps/top junto al TID
+    snprintf(name, sizeof(name), "SP-%.5s%d-%u", short_name(c->policy), c->prio % 100, (unsigned)(w->index + 1) % 100);
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+
+    run->res->cls[w->cls].tids[w->index] = get_kernel_pid();
+    int err = apply_class(c);
+    if (err) atomic_store(&run->errors[w->cls], err);
+    atomic_fetch_add(&run->ready, 1);
+
+    unsigned last = 0;
+    for (;;) {
+        unsigned cur;
+        if (run->cfg->wake == SPROBE_EVENTFD) {
+            uint64_t n;
+            if (read(w->efd, &n, sizeof(n)) != sizeof(n)) continue;
+            cur = last + (unsigned)n;
+        } else {
+            while ((cur = atomic_load_explicit(&w->seq, memory_order_acquire)) == last) futex_wait(&w->seq, last);
+        }
+        uint64_t now = now_ns();
+        if (atomic_load(&run->stop)) break;
+        // Con más de SPROBE_RING pendientes la ranura ya se reutilizó: la más antigua que queda
+        unsigned first = cur - last > SPROBE_RING ? cur - SPROBE_RING + 1 : last + 1;
+        lat_hist_record(w->hist, now - w->sent_ns[first % SPROBE_RING]);
+        w->missed += cur - last - 1;
+        last = cur;
+    }
+    return NULL;
+}
+
+static void *hog_main(void *arg) {
+    sprobe_hog_t *h = arg;
+    char name[16];
+    snprintf(name, sizeof(name), "SP-HOG-%u", (unsigned)(h->index + 1) % 1000);
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+    h->run->res->hog_tids[h->index] = get_kernel_pid();
+    atomic_fetch_add(&h->run->ready, 1);
+    while (!atomic_load_explicit(&h->run->stop, memory_order_relaxed)) {
+        for (volatile int i = 0; i < 1000; i++) {
+        }
+    }
+    return NULL;
+}
+
+static void wake_waiter(sprobe_run_t *run, sprobe_waiter_t *w) {
+    // Solo el temporizador escribe seq: la marca va en la ranura del siguiente
+    unsigned next = atomic_load_explicit(&w->seq, memory_order_relaxed) + 1;
+    w->sent_ns[next % SPROBE_RING] = now_ns();
+    atomic_store_explicit(&w->seq, next, memory_order_release);
+    if (run->cfg->wake == SPROBE_EVENTFD) {
+        uint64_t one = 1;
+        if (write(w->efd, &one, sizeof(one)) < 0) return;
+    } else {
+        futex_wake(&w->seq);
+    }
+}
+
+// ========== EJECUCIÓN ==========
+
+int sprobe_run(const sprobe_cfg_t *cfg, sprobe_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    res->tgid = get_tgid();
+    res->driver_tid = get_kernel_pid();
+    lat_hist_init(&res->timer);
+    res->cls = calloc((size_t)cfg->nclasses, sizeof(*res->cls));
+    res->nclasses = res->cls ? cfg->nclasses : 0;
+    res->hog_tids = calloc((size_t)(cfg->hogs > 0 ? cfg->hogs : 1), sizeof(pid_t));
+    res->nhogs = cfg->hogs;
+
+    sprobe_run_t run = { .cfg = cfg, .res = res };
+    run.nwaiters = cfg->nclasses * cfg->threads;
+    run.waiters = aligned_alloc(64, ((size_t)run.nwaiters * sizeof(sprobe_waiter_t) + 63) & ~(size_t)63);
+    lat_hist_t *hists = calloc((size_t)run.nwaiters, sizeof(lat_hist_t));
+    sprobe_hog_t *hogs = calloc((size_t)(cfg->hogs > 0 ? cfg->hogs : 1), sizeof(*hogs));
+    if (!res->cls || !res->hog_tids || !run.waiters || !hists || !hogs) {
+        free(run.waiters);
+        free(hists);
+        free(hogs);
+        sprobe_result_free(res);
+        return -1;
+    }
+
+    int started = 0, nhogs = 0, ret = 0;
+    for (int c = 0; c < cfg->nclasses; c++) {
+        lat_hist_init(&res->cls[c].hist);
+        res->cls[c].tids = calloc((size_t)cfg->threads, sizeof(pid_t));
+        if (!res->cls[c].tids) ret = -1;
+    }
+    for (int i = 0; i < run.nwaiters && ret == 0; i++) {
+        sprobe_waiter_t *w = &run.waiters[i];
+        memset(w, 0, sizeof(*w));
+        w->cls = i / cfg->threads;
+        w->index = i % cfg->threads;
+        w->hist = &hists[i];
+        w->run = &run;
+        w->efd = cfg->wake == SPROBE_EVENTFD ? eventfd(0, EFD_CLOEXEC) : -1;
+        if ((cfg->wake == SPROBE_EVENTFD && w->efd < 0) || pthread_create(&w->thread, NULL, waiter_main, w) != 0) {
+            if (w->efd >= 0) close(w->efd);
+            ret = -1;
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < cfg->hogs && ret == 0; i++) {
+        hogs[i].run = &run;
+        hogs[i].index = i;
+        if (pthread_create(&hogs[i].thread, NULL, hog_main, &hogs[i]) != 0) {
+            ret = -1;
+            break;
+        }
+        nhogs++;
+    }
+    while (atomic_load(&run.ready) < started + nhogs) usleep(1000);
+
+    // El temporizador, como en cyclictest, con la máxima prioridad RT si hay permiso
+    int old_policy = sched_getscheduler(0);
+    struct sched_param old_param;
+    sched_getparam(0, &old_param);
+    struct sched_param top = { .sched_priority = sched_get_priority_max(SCHED_FIFO) };
+    res->driver_policy = sched_setscheduler(0, SCHED_FIFO, &top) == 0 ? SCHED_FIFO : old_policy;
+
+    uint64_t t0 = now_ns();
+    if (ret == 0) {
+        struct timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        for (unsigned long s = 0; s < cfg->samples; s++) {
+            next.tv_nsec += (long)cfg->period_us * 1000;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+            }
+            uint64_t deadline = (uint64_t)next.tv_sec * 1000000000ull + (uint64_t)next.tv_nsec;
+            uint64_t now = now_ns();
+            lat_hist_record(&res->timer, now > deadline ? now - deadline : 0);
+            int first = (int)(s % (unsigned long)run.nwaiters);
+            for (int k = 0; k < run.nwaiters; k++) wake_waiter(&run, &run.waiters[(first + k) % run.nwaiters]);
+        }
+    }
+    res->seconds = (now_ns() - t0) / 1e9;
+
+    // Parada: stop y un último despertar que ya no se mide
+    atomic_store(&run.stop, 1);
+    for (int i = 0; i < started; i++) wake_waiter(&run, &run.waiters[i]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(run.waiters[i].thread, NULL);
+        if (run.waiters[i].efd >= 0) close(run.waiters[i].efd);
+        sprobe_class_result_t *cr = &res->cls[run.waiters[i].cls];
+        lat_hist_merge(&cr->hist, run.waiters[i].hist);
+        cr->missed += run.waiters[i].missed;
+    }
+    for (int i = 0; i < nhogs; i++) pthread_join(hogs[i].thread, NULL);
+    for (int c = 0; c < cfg->nclasses; c++) res->cls[c].error = atomic_load(&run.errors[c]);
+    sched_setscheduler(0, old_policy, &old_param);
+
+    free(run.waiters);
+    free(hists);
+    free(hogs);
+    return ret;
+}
+
+void sprobe_result_free(sprobe_result_t *res) {
+    for (int c = 0; res->cls && c < res->nclasses; c++) free(res->cls[c].tids);
+    free(res->cls);
+    free(res->hog_tids);
+    memset(res, 0, sizeof(*res));
+}
@@ -0,0 +1,66 @@
+// sched_probe.h - Latencia de despertar por política de planificación y nice
+#ifndef SCHED_PROBE_H
+#define SCHED_PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "lat_hist.h"
+
+#define SPROBE_MAX_CLASSES 8
+
+// Cómo despierta el temporizador a los threads medidos
+typedef enum {
+    SPROBE_FUTEX = 0,
+    SPROBE_EVENTFD,
+} sprobe_wake_t;
+
+// Clase de planificación a medir: "other:0", "other:19", "batch:0", "idle",
+// "fifo:50", "rr:10" (para FIFO/RR el número es sched_priority, si no, nice)
+typedef struct {
+    int policy;
+    int prio;
+    char label[24];
+} sprobe_class_t;
+
+typedef struct {
+    sprobe_class_t classes[SPROBE_MAX_CLASSES];
+    int nclasses;
+    int threads;                // threads por clase
+    unsigned period_us;         // periodo del temporizador
+    unsigned long samples;      // despertares por thread
+    int hogs;                   // threads SCHED_OTHER que consumen CPU sin parar
+    sprobe_wake_t wake;
+} sprobe_cfg_t;
+
+typedef struct {
+    int error;                  // errno al aplicar política/nice (0 = aplicada)
+    unsigned long missed;       // despertares perdidos: llegó otro antes de correr
+    lat_hist_t hist;            // despertar → correr, todos los threads de la clase
+    pid_t *tids;                // cfg.threads TIDs
+} sprobe_class_result_t;
+
+typedef struct {
+    pid_t tgid;
+    pid_t driver_tid;
+    int driver_policy;          // SCHED_FIFO si se pudo subir la prioridad del temporizador
+    lat_hist_t timer;           // retraso del propio clock_nanosleep
+    sprobe_class_result_t *cls;
+    int nclasses;
+    pid_t *hog_tids;
+    int nhogs;
+    double seconds;
+} sprobe_result_t;
+
+// Clases por defecto: other:0, other:19, fifo:50, rr:50; 2 threads, 1 ms, 2000 muestras
+void sprobe_default_config(sprobe_cfg_t *cfg);
+int  sprobe_parse_class(const char *spec, sprobe_class_t *out);    // -1 si no se reconoce
+const char *sprobe_policy_name(int policy);
+
+// Lanza los threads (todos en este TGID), mide y hace join. 0 ok, -1 si no se
+// pudo crear algún thread.
+int  sprobe_run(const sprobe_cfg_t *cfg, sprobe_result_t *res);
+void sprobe_result_free(sprobe_result_t *res);
+
+#endif // SCHED_PROBE_H
@@ -0,0 +1,327 @@
+// thread_pool.c - Pool de threads con robo de trabajo y parada cooperativa
+//
+// Cada worker tiene una deque Chase-Lev. Las tareas que un worker envía van
+// a su propia deque (sin contención); las que llegan de fuera van a una cola
+// MPMC acotada. Un worker sin trabajo roba de la deque de otro y, si tampoco
+// hay nada, duerme en un futex. La parada no usa pthread_cancel: se marca
+// stop, se despierta a todos y cada worker sale al vaciar las colas.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+#include "proc_common.h"
+#include "thread_pool.h"
+
+#define TP_SPIN_ROUNDS 64   // intentos antes de dormir en el futex
+
+static __thread thread_pool_t *tp_current_pool;
+static __thread tp_worker_t *tp_current_worker;
+
+// ========== FUTEX ==========
+
+static inline void futex_wait(atomic_uint *addr, unsigned expected) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static inline void futex_wake(atomic_uint *addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+// ========== DEQUE CHASE-LEV ==========
+
+static int deque_init(tp_deque_t *d) {
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    d->buf = calloc(TP_DEQUE_CAP, sizeof(*d->buf));
+    return d->buf ? 0 : -1;
+}
+
+static int deque_push(tp_deque_t *d, tp_task_t *t) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - top >= TP_DEQUE_CAP) return -1;  // llena
+    atomic_store_explicit(&d->buf[b & (TP_DEQUE_CAP - 1)], t, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+static tp_task_t *deque_pop(tp_deque_t *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {  // vacía
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    tp_task_t *task = atomic_load_explicit(&d->buf[b & (TP_DEQUE_CAP - 1)], memory_order_relaxed);
+    if (t == b) {
+        // Último elemento: competir con los ladrones
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static tp_task_t *deque_steal(tp_deque_t *d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+
+    tp_task_t *task = atomic_load_explicit(&d->buf[t & (TP_DEQUE_CAP - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;  // otro ladrón (o el dueño) ganó
+    }
+    return task;
+}
+
+static int deque_nonempty(tp_deque_t *d) {
+    return atomic_load_explicit(&d->bottom, memory_order_relaxed) >
+           atomic_load_explicit(&d->top, memory_order_relaxed);
+}
+
+// ========== INBOX MPMC ==========
+
+static int inbox_init(tp_inbox_t *q) {
+    q->cells = malloc(TP_INBOX_CAP * sizeof(*q->cells));
+    if (!q->cells) return -1;
+    for (size_t i = 0; i < TP_INBOX_CAP; i++) atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->enq, 0);
+    atomic_init(&q->deq, 0);
+    return 0;
+}
+
+static int inbox_push(tp_inbox_t *q, tp_task_t *t) {
+    size_t pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+    for (;;) {
+        tp_cell_t *c = &q->cells[pos & (TP_INBOX_CAP - 1)];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enq, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                c->task = t;
+                atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (dif < 0) {
+            return -1;  // llena
+        } else {
+            pos = atomic_load_explicit(&q->enq, memory_order_relaxed);
+        }
+    }
+}
+
+static tp_task_t *inbox_pop(tp_inbox_t *q) {
+    size_t pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+    for (;;) {
+        tp_cell_t *c = &q->cells[pos & (TP_INBOX_CAP - 1)];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->deq, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                tp_task_t *t = c->task;
+                atomic_store_explicit(&c->seq, pos + TP_INBOX_CAP, memory_order_release);
+                return t;
+            }
+        } else if (dif < 0) {
+            return NULL;  // vacía
+        } else {
+            pos = atomic_load_explicit(&q->deq, memory_order_relaxed);
+        }
+    }
+}
+
+static int inbox_nonempty(tp_inbox_t *q) {
+    return atomic_load_explicit(&q->enq, memory_order_relaxed) !=
+           atomic_load_explicit(&q->deq, memory_order_relaxed);
+}
+
+// ========== WORKERS ==========
+
+static tp_task_t *find_task(thread_pool_t *p, tp_worker_t *w) {
+    tp_task_t *t = deque_pop(&w->deque);
+    if (t) return t;
+    t = inbox_pop(&p->inbox);
+    if (t) return t;
+
+    // Robar empezando por una víctima aleatoria (xorshift)
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    unsigned start = (unsigned)(w->rng % p->nworkers);
+    for (unsigned i = 0; i < p->nworkers; i++) {
+        tp_worker_t *victim = &p->workers[(start + i) % p->nworkers];
+        if (victim == w) continue;
+        t = deque_steal(&victim->deque);
+        if (t) return t;
+    }
+    return NULL;
+}
+
+static int has_work(thread_pool_t *p) {
+    if (inbox_nonempty(&p->inbox)) return 1;
+    for (unsigned i = 0; i < p->nworkers; i++) {
+        if (deque_nonempty(&p->workers[i].deque)) return 1;
+    }
+    return 0;
+}
+
+static void run_task(thread_pool_t *p, tp_task_t *t) {
+    t->fn(t->arg);
+    if (atomic_fetch_sub_explicit(&p->pending, 1, memory_order_acq_rel) == 1) {
+        atomic_fetch_add_explicit(&p->done_epoch, 1, memory_order_release);
+        futex_wake(&p->done_epoch, INT_MAX);
+    }
+}
+
+static void *worker_main(void *arg) {
+    tp_worker_t *w = arg;
+    thread_pool_t *p = w->pool;
+    tp_current_pool = p;
+    tp_current_worker = w;
+    atomic_store(&w->tid, (int)get_kernel_pid());
+
+    char name[16];
+    snprintf(name, sizeof(name), "%s-%u", p->name_prefix, w->index + 1);
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+
+    for (;;) {
+        tp_task_t *t = NULL;
+        for (int spin = 0; spin < TP_SPIN_ROUNDS && !t; spin++) t = find_task(p, w);
+        if (t) {
+            run_task(p, t);
+            continue;
+        }
+        if (atomic_load(&p->stop)) break;  // colas vacías y parada pedida
+
+        // Dormir: anunciar sleepers antes de volver a mirar las colas. El
+        // que envía publica la tarea antes de leer sleepers, así que uno de
+        // los dos ve al otro (ambos accesos son seq_cst)
+        unsigned epoch = atomic_load(&p->wake_epoch);
+        atomic_fetch_add(&p->sleepers, 1);
+        if (!has_work(p) && !atomic_load(&p->stop)) futex_wait(&p->wake_epoch, epoch);
+        atomic_fetch_sub(&p->sleepers, 1);
+    }
+    return NULL;
+}
+
+// ========== API ==========
+
+// Parada y liberación, también a medio construir: se unen los started
+// primeros workers y se libera lo que haya (deque e inbox sin crear son NULL)
+static void pool_teardown(thread_pool_t *p, unsigned started) {
+    atomic_store(&p->stop, 1);
+    atomic_fetch_add(&p->wake_epoch, 1);
+    futex_wake(&p->wake_epoch, INT_MAX);
+    futex_wake(&p->stop, INT_MAX);  // tareas en thread_pool_wait_for_stop()
+
+    for (unsigned i = 0; i < started; i++) pthread_join(p->workers[i].thread, NULL);
+    for (unsigned i = 0; p->workers && i < p->nworkers; i++) free(p->workers[i].deque.buf);
+    free(p->workers);
+    free(p->inbox.cells);
+    p->workers = NULL;
+    p->inbox.cells = NULL;
+    p->nworkers = 0;
+}
+
+int thread_pool_init(thread_pool_t *p, unsigned nworkers, const char *name_prefix) {
+    memset(p, 0, sizeof(*p));
+    if (nworkers == 0) nworkers = 1;
+    snprintf(p->name_prefix, sizeof(p->name_prefix), "%s", name_prefix ? name_prefix : "POOL");
+    atomic_init(&p->wake_epoch, 0);
+    atomic_init(&p->sleepers, 0);
+    atomic_init(&p->pending, 0);
+    atomic_init(&p->done_epoch, 0);
+    atomic_init(&p->stop, 0);
+
+    if (inbox_init(&p->inbox) < 0) return -1;
+    p->workers = calloc(nworkers, sizeof(*p->workers));
+    if (!p->workers) {
+        pool_teardown(p, 0);
+        return -1;
+    }
+    // nworkers debe ser definitivo antes de arrancar: find_task lo usa para robar
+    p->nworkers = nworkers;
+    for (unsigned i = 0; i < nworkers; i++) {
+        if (deque_init(&p->workers[i].deque) < 0) {
+            pool_teardown(p, 0);
+            return -1;
+        }
+        p->workers[i].pool = p;
+        p->workers[i].index = i;
+        p->workers[i].rng = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+
+    for (unsigned i = 0; i < nworkers; i++) {
+        if (pthread_create(&p->workers[i].thread, NULL, worker_main, &p->workers[i]) != 0) {
+            perror("Error creando worker del pool");
+            pool_teardown(p, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void thread_pool_submit(thread_pool_t *p, tp_task_t *task) {
+    atomic_fetch_add_explicit(&p->pending, 1, memory_order_relaxed);
+
+    int queued;
+    if (tp_current_pool == p) {
+        queued = deque_push(&tp_current_worker->deque, task) == 0 || inbox_push(&p->inbox, task) == 0;
+    } else {
+        queued = inbox_push(&p->inbox, task) == 0;
+    }
+    if (!queued) {
+        run_task(p, task);  // colas llenas: el llamante hace el trabajo
+        return;
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&p->sleepers, memory_order_relaxed) > 0) {
+        atomic_fetch_add(&p->wake_epoch, 1);
+        futex_wake(&p->wake_epoch, 1);
+    }
+}
+
+void thread_pool_wait(thread_pool_t *p) {
+    for (;;) {
+        unsigned epoch = atomic_load(&p->done_epoch);
+        if (atomic_load(&p->pending) == 0) return;
+        futex_wait(&p->done_epoch, epoch);
+    }
+}
+
+void thread_pool_shutdown(thread_pool_t *p) {
+    pool_teardown(p, p->nworkers);
+}
+
+thread_pool_t *thread_pool_current(void) {
+    return tp_current_pool;
+}
+
+int thread_pool_should_stop(void) {
+    return tp_current_pool && atomic_load_explicit(&tp_current_pool->stop, memory_order_relaxed);
+}
+
+void thread_pool_wait_for_stop(void) {
+    thread_pool_t *p = tp_current_pool;
+    if (!p) return;
+    while (!atomic_load(&p->stop)) futex_wait(&p->stop, 0);
+}
@@ -0,0 +1,83 @@
+// thread_pool.h - Pool de threads con robo de trabajo y parada cooperativa
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+// Tarea intrusiva: la memoria la pone quien la envía y debe vivir hasta que
+// se ejecute (así submit no reserva memoria)
+typedef struct tp_task {
+    void (*fn)(void *arg);
+    void *arg;
+} tp_task_t;
+
+#define TP_DEQUE_CAP  4096      // potencia de 2
+#define TP_INBOX_CAP  65536     // potencia de 2
+
+// Deque Chase-Lev: el dueño hace push/pop por abajo, los ladrones roban por arriba
+typedef struct {
+    _Alignas(64) atomic_long top;
+    _Alignas(64) atomic_long bottom;
+    _Atomic(tp_task_t *) *buf;
+} tp_deque_t;
+
+// Cola MPMC acotada (Vyukov) para envíos desde fuera del pool
+typedef struct {
+    atomic_size_t seq;
+    tp_task_t *task;
+} tp_cell_t;
+
+typedef struct {
+    tp_cell_t *cells;
+    _Alignas(64) atomic_size_t enq;
+    _Alignas(64) atomic_size_t deq;
+} tp_inbox_t;
+
+struct thread_pool;
+
+typedef struct {
+    struct thread_pool *pool;
+    pthread_t thread;
+    unsigned index;
+    atomic_int tid;             // TID del kernel, visible cuando arranca el worker
+    uint64_t rng;               // víctima aleatoria para robar
+    tp_deque_t deque;
+} tp_worker_t;
+
+typedef struct thread_pool {
+    tp_worker_t *workers;
+    unsigned nworkers;
+    tp_inbox_t inbox;
+    char name_prefix[12];
+
+    _Alignas(64) atomic_uint wake_epoch;   // palabra futex para workers dormidos
+    atomic_int sleepers;
+    _Alignas(64) atomic_long pending;      // tareas enviadas y no terminadas
+    atomic_uint done_epoch;                // palabra futex para thread_pool_wait()
+    atomic_uint stop;                      // palabra futex de la parada cooperativa
+} thread_pool_t;
+
+// Crea nworkers threads llamados "<prefix>-1", "<prefix>-2", ...
+int  thread_pool_init(thread_pool_t *p, unsigned nworkers, const char *name_prefix);
+
+// Desde un worker la tarea va a su propia deque; desde fuera, a la inbox.
+// Si ambas están llenas la tarea se ejecuta en el llamante.
+void thread_pool_submit(thread_pool_t *p, tp_task_t *task);
+
+// Espera a que todas las tareas enviadas hayan terminado
+void thread_pool_wait(thread_pool_t *p);
+
+// Parada cooperativa: marca stop, despierta a todos, deja terminar las
+// tareas en curso y encoladas, y hace join de los workers
+void thread_pool_shutdown(thread_pool_t *p);
+
+// Para el código que corre dentro de una tarea
+thread_pool_t *thread_pool_current(void);           // NULL fuera del pool
+int  thread_pool_should_stop(void);                 // 1 si se pidió la parada
+void thread_pool_wait_for_stop(void);               // bloquea hasta la parada
+
+#endif // THREAD_POOL_H